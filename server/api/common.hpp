@@ -10,6 +10,9 @@ typedef boost::beast::tcp_stream tcp_socket_t;
 typedef boost::beast::ssl_stream<tcp_socket_t> ssl_socket_t;
 typedef boost::beast::websocket::stream<tcp_socket_t> websocket_t;
 
+typedef boost::beast::http::request<boost::beast::http::string_body> http_request_t;
+typedef boost::beast::http::response<boost::beast::http::string_body> http_response_t;
+
 typedef boost::asio::ip::udp::socket udp_socket_t;
 
 #include <openssl/ssl.h>
\ No newline at end of file
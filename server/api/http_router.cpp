@@ -0,0 +1,78 @@
+#include "http_router.hpp"
+#include <common/metrics.hpp>
+
+namespace server
+{
+    namespace api
+    {
+        HttpRoute* HttpRouter::AddRoute(const std::string& path, HttpApiCallDefinition callback, bool authenticate)
+        {
+            assert(callback != nullptr);
+
+            metrics::Registry& registry = metrics::Registry::GetInstance();
+            std::string label = metrics::MakeLabel("route", path);
+
+            routes.push_back(HttpRoute{
+                .path = path,
+                .callback = callback,
+                .authenticate = authenticate,
+                .counter = &registry.GetCounter("home_http_requests_total", "Received http requests", label),
+                .histogram = &registry.GetHistogram("home_http_handler_duration_seconds",
+                                                    "Duration of http request handlers", label),
+            });
+
+            return &routes.back();
+        }
+
+        void HttpRouter::Add(const std::string& path, HttpApiCallDefinition callback, bool authenticate)
+        {
+            robin_hood::unordered_flat_map<std::string_view, HttpRoute*>::iterator it = exactRoutes.find(path);
+            if (it != exactRoutes.end())
+            {
+                // Replace handler
+                it->second->callback = callback;
+                it->second->authenticate = authenticate;
+                return;
+            }
+
+            HttpRoute* route = AddRoute(path, callback, authenticate);
+            exactRoutes[route->path] = route;
+        }
+        void HttpRouter::AddPrefix(const std::string& prefix, HttpApiCallDefinition callback, bool authenticate)
+        {
+            for (HttpRoute* route : prefixRoutes)
+            {
+                if (route->path == prefix)
+                {
+                    // Replace handler
+                    route->callback = callback;
+                    route->authenticate = authenticate;
+                    return;
+                }
+            }
+
+            HttpRoute* route = AddRoute(prefix, callback, authenticate);
+
+            // Keep longer prefixes first
+            boost::container::vector<HttpRoute*>::iterator it = prefixRoutes.begin();
+            while (it != prefixRoutes.end() && (*it)->path.size() >= prefix.size())
+                it++;
+            prefixRoutes.insert(it, route);
+        }
+
+        const HttpRoute* HttpRouter::Find(const std::string_view& path) const
+        {
+            robin_hood::unordered_flat_map<std::string_view, HttpRoute*>::const_iterator it = exactRoutes.find(path);
+            if (it != exactRoutes.end())
+                return it->second;
+
+            for (const HttpRoute* route : prefixRoutes)
+            {
+                if (path.starts_with(route->path))
+                    return route;
+            }
+
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "user.hpp"
+#include "common.hpp"
+
+namespace server
+{
+    namespace metrics
+    {
+        class Counter;
+        class Histogram;
+    }
+
+    namespace api
+    {
+        class HttpSession;
+
+        using HttpApiCallDefinition = void (*)(const Ref<api::User>&, const http_request_t&, http_response_t&,
+                                               const Ref<HttpSession>&);
+
+        struct HttpRoute
+        {
+            /// @brief Path (or path prefix) of the route
+            ///
+            std::string path;
+
+            HttpApiCallDefinition callback;
+
+            /// @brief Authenticate the user before calling the handler (otherwise the user is null)
+            ///
+            bool authenticate;
+
+            metrics::Counter* counter;
+            metrics::Histogram* histogram;
+        };
+
+        /// @brief Path dispatch table of the http sessions
+        ///
+        /// Routes are registered at startup (like the websocket api map) and only looked up afterwards. Exact routes
+        /// are preferred, otherwise the longest matching prefix route is used.
+        class HttpRouter
+        {
+          private:
+            /// @brief Registered routes (never moved, the maps view their paths)
+            ///
+            boost::container::list<HttpRoute> routes;
+
+            robin_hood::unordered_flat_map<std::string_view, HttpRoute*> exactRoutes;
+
+            /// @brief Prefix routes (the longest prefix is first)
+            ///
+            boost::container::vector<HttpRoute*> prefixRoutes;
+
+            HttpRoute* AddRoute(const std::string& path, HttpApiCallDefinition callback, bool authenticate);
+
+          public:
+            /// @brief Register exact route
+            ///
+            /// @param path Path (without query)
+            /// @param callback Handler
+            /// @param authenticate Authenticate the user before calling the handler
+            void Add(const std::string& path, HttpApiCallDefinition callback, bool authenticate = true);
+
+            /// @brief Register prefix route
+            ///
+            /// @param prefix Path prefix (e.g. "/api/")
+            /// @param callback Handler
+            /// @param authenticate Authenticate the user before calling the handler
+            void AddPrefix(const std::string& prefix, HttpApiCallDefinition callback, bool authenticate = true);
+
+            /// @brief Find route of a path
+            ///
+            /// @param path Path (without query)
+            /// @return Route or null if no route matches
+            const HttpRoute* Find(const std::string_view& path) const;
+        };
+    }
+}
@@ -1,12 +1,24 @@
 #include "http_session.hpp"
 #include "user_manager.hpp"
 #include "websocket_session.hpp"
+#include <common/metrics.hpp>
+#include <common/worker.hpp>
 #include <cppcodec/base64_rfc4648.hpp>
 
 namespace server
 {
     namespace api
     {
+        HttpRouter httpRouter = HttpRouter();
+
+        HttpRouter& HttpSession::GetRouter()
+        {
+            return httpRouter;
+        }
+
+        static metrics::Counter& unknownRouteCounter = metrics::Registry::GetInstance().GetCounter(
+            "home_http_requests_total", "Received http requests", metrics::MakeLabel("route", "unknown"));
+
         HttpSession::HttpSession(const Ref<tcp_socket_t>& socket) : strand(socket->get_executor()), socket(socket)
         {
         }
@@ -16,7 +28,16 @@ namespace server
 
         void HttpSession::Run()
         {
-            socket->expires_after(std::chrono::seconds(12));
+            DoRead();
+        }
+
+        void HttpSession::DoRead()
+        {
+            reading = true;
+
+            // Pipelined requests may already be in the buffer
+            request = {};
+            socket->expires_after(std::chrono::seconds(HTTP_SESSION_TIMEOUT));
             boost::beast::http::async_read(
                 *socket, buffer, request,
                 boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnRead, shared_from_this(),
@@ -25,224 +46,123 @@ namespace server
 
         void HttpSession::OnRead(const boost::system::error_code& ec, size_t size)
         {
+            (void)size;
+
+            reading = false;
+
             if (ec)
+            {
+                // Pending responses are still written
+                closing = true;
                 return;
+            }
 
-            try
+            // The connection can only be handed over when nothing is written anymore
+            if (responseCount != 0 && boost::beast::websocket::is_upgrade(request))
             {
+                waiting = true;
+                return;
+            }
 
-                std::string_view target = std::string_view(request.target().data(), request.target().size());
+            ProcessRequest();
+        }
 
-                // if (strncmp(target.data(), "/res/", 5) == 0)
-                // {
-                //     Ref<api::User> user = Authenticate();
-                //     if (user == nullptr)
-                //     {
-                //         WriteError("Invalid authentication token.");
-                //         return;
-                //     }
-
-                //     target.remove_prefix(5); // Remove /api/
-
-                //     // Create response
-                //     boost::shared_ptr<boost::beast::http::response<boost::beast::http::buffer_body>> response =
-                //         boost::make_shared<boost::beast::http::response<boost::beast::http::buffer_body>>();
-                //     response->version(request.version());
-                //     response->set(boost::beast::http::field::server, "HomeAutomation Server");
-
-                //     // Resource
-                //     std::string contentType = "text/plain";
-
-                //     responseBuffer.Clear();
-
-                //     if (JsonApi::ProcessResApiCallHTTP(request.method(), target, user,
-                //     std::string_view(request.body()),
-                //                                        responseBuffer, contentType))
-                //     {
-                //         response->result(boost::beast::http::status::ok);
-                //         response->keep_alive(request.keep_alive());
-                //     }
-                //     else
-                //     {
-                //         response->result(boost::beast::http::status::bad_request);
-                //         response->keep_alive(false);
-                //     }
-
-                //     if (responseBuffer.GetSize() == 0)
-                //     {
-                //         // A response cannot be empty
-                //         response->set(boost::beast::http::field::content_type, "test/plain");
-                //         memcpy(responseBuffer.Push(10), "NO CONTENT", 10);
-                //     }
-                //     else
-                //         response->set(boost::beast::http::field::content_type, contentType);
-
-                //     boost::beast::http::buffer_body::value_type& buf = response->body();
-                //     buf.data = (void*)responseBuffer.GetString();
-                //     buf.size = responseBuffer.GetSize();
-                //     buf.more = false;
-
-                //     response->prepare_payload();
-
-                //     buffer.consume(size);
-
-                //     // Send response
-                //     boost::beast::http::async_write(
-                //         *socket, *response,
-                //         boost::asio::bind_executor(strand, boost::bind(&HTTPSession::OnWriteBuffer,
-                //         shared_from_this(),
-                //                                                        boost::placeholders::_1,
-                //                                                        boost::placeholders::_2, response)));
-                // }
-                // else
-                if (strncmp(target.data(), "/auth", 5) == 0)
-                {
-                    Ref<api::User> user = Authenticate();
-                    if (user == nullptr)
-                    {
-                        WriteError("Invalid authentication token.");
-                        return;
-                    }
+        void HttpSession::ProcessRequest()
+        {
+            assert(responseCount < HTTP_SESSION_PIPELINE_SIZE);
 
-                    Ref<api::UserManager> userManager = api::UserManager::GetInstance();
-                    assert(userManager != nullptr);
-
-                    std::string token = userManager->GenerateJWTToken(user);
-
-                    // Create response
-                    boost::shared_ptr<boost::beast::http::response<boost::beast::http::string_body>> response =
-                        boost::make_shared<boost::beast::http::response<boost::beast::http::string_body>>();
-                    response->result(boost::beast::http::status::ok);
-                    response->version(request.version());
-                    response->keep_alive(request.keep_alive());
-                    response->set(boost::beast::http::field::server, "HomeAutomation Server");
-                    response->set(boost::beast::http::field::content_type, "application/json");
-                    std::string& body = response->body();
-                    body.reserve(12 + token.size());
-                    body += "{\"token\":\"";
-                    body += token;
-                    body += "\"}";
-
-                    response->prepare_payload();
-
-                    // Send response
-                    boost::beast::http::async_write(
-                        *socket, *response,
-                        boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnWriteString, shared_from_this(),
-                                                                       boost::placeholders::_1, boost::placeholders::_2,
-                                                                       response)));
-                }
-                else if (strncmp(target.data(), "/ws", 3) == 0)
-                {
-                    if (boost::beast::websocket::is_upgrade(request))
-                    {
-                        // Authenticate user before starting websocket connection
-                        Ref<api::User> user = Authenticate();
-                        if (user != nullptr)
-                        {
-                            socket->expires_never();
+            // Reuse pooled response
+            http_response_t& response = responses[(responseBegin + responseCount) % HTTP_SESSION_PIPELINE_SIZE];
+            response.clear();
+            response.body().clear();
+            response.result(boost::beast::http::status::ok);
+            response.version(request.version());
+            response.keep_alive(request.keep_alive());
+            response.set(boost::beast::http::field::server, "HomeAutomation Server");
 
-                            Ref<WebSocketSession> ws = boost::make_shared<WebSocketSession>(socket, user);
-                            ws->Run(request);
+            try
+            {
+                std::string_view target = std::string_view(request.target().data(), request.target().size());
+                std::string_view path = target.substr(0, target.find('?'));
 
-                            buffer.consume(size);
-                        }
-                    }
-                    else
-                    {
-                        WriteError("Invalid websocket upgrade. Please call /help for more details.");
-                        return;
-                    }
-                }
-                else if (strncmp(target.data(), "/ping", 5) == 0)
+                const HttpRoute* route = httpRouter.Find(path);
+                if (route != nullptr)
                 {
-                    // Create response
-                    boost::shared_ptr<boost::beast::http::response<boost::beast::http::string_body>> response =
-                        boost::make_shared<boost::beast::http::response<boost::beast::http::string_body>>();
-                    response->result(boost::beast::http::status::ok);
-                    response->version(request.version());
-                    response->keep_alive(request.keep_alive());
-                    response->set(boost::beast::http::field::server, "HomeAutomation Server");
-                    response->set(boost::beast::http::field::content_type, "application/json");
-                    std::string& body = response->body();
-                    body.reserve(38);
-                    body += R"({"pong":"57494c4c49414d4bd6484c4552"})";
-                    response->prepare_payload();
-
-                    // Send response
-                    boost::beast::http::async_write(
-                        *socket, *response,
-                        boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnWriteString, shared_from_this(),
-                                                                       boost::placeholders::_1, boost::placeholders::_2,
-                                                                       response)));
-                }
-                else if (strncmp(target.data(), "/help", 5) == 0)
-                {
-                    // Create response
-                    boost::shared_ptr<boost::beast::http::response<boost::beast::http::string_body>> response =
-                        boost::make_shared<boost::beast::http::response<boost::beast::http::string_body>>();
-                    response->result(boost::beast::http::status::ok);
-                    response->version(request.version());
-                    response->keep_alive(request.keep_alive());
-                    response->set(boost::beast::http::field::server, "HomeAutomation Server");
-                    response->set(boost::beast::http::field::content_type, "test/plain");
-
-                    // Write help log
-                    {
-                        std::stringstream ss(response->body());
+                    route->counter->Increment();
 
-                        ss << "You called for help!\nWell currently nobody can help you...";
+                    Ref<api::User> user = nullptr;
+                    if (!route->authenticate || (user = Authenticate(response)) != nullptr)
+                    {
+                        WorkerHandlerScope scope(WorkerHandlerKind::kHttpWorkerHandlerKind, route->path);
+                        boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+                        route->callback(user, request, response, shared_from_this());
+                        route->histogram->ObserveSince(begin);
                     }
-
-                    response->prepare_payload();
-
-                    // Send response
-                    boost::beast::http::async_write(
-                        *socket, *response,
-                        boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnWriteString, shared_from_this(),
-                                                                       boost::placeholders::_1, boost::placeholders::_2,
-                                                                       response)));
                 }
                 else
                 {
-                    buffer.consume(size);
-
-                    WriteError("Invalid method.");
+                    unknownRouteCounter.Increment();
+                    WriteError(response, boost::beast::http::status::not_found,
+                               "Invalid method. Please call /help for more details.");
                 }
             }
             catch (const std::exception& e)
             {
                 LOG_ERROR("Oops... Internal error :\n{0}", e.what());
 
-                buffer.clear();
-
-                WriteError("Internal error.");
+                WriteError(response, boost::beast::http::status::internal_server_error, "Internal error.");
             }
+
+            // The websocket session owns the connection now
+            if (upgraded)
+                return;
+
+            response.prepare_payload();
+
+            responseCount++;
+            if (responseCount == 1)
+                DoWrite();
+
+            if (!response.keep_alive())
+                closing = true;
+            else if (responseCount < HTTP_SESSION_PIPELINE_SIZE)
+                DoRead();
         }
-        Ref<api::User> HttpSession::Authenticate()
+
+        Ref<api::User> HttpSession::Authenticate(http_response_t& response)
         {
-            boost::beast::http::fields::iterator it = request.find(boost::beast::http::field::authorization);
+            http_request_t::const_iterator it = request.find(boost::beast::http::field::authorization);
             if (it == request.end())
             {
-                WriteError("Missing authorization field. Please call /api/help for more details.");
+                WriteError(response, boost::beast::http::status::unauthorized,
+                           "Missing authorization field. Please call /help for more details.");
                 return nullptr;
             }
 
             Ref<api::UserManager> userManager = api::UserManager::GetInstance();
             assert(userManager != nullptr);
 
+            Ref<api::User> user = nullptr;
+
             boost::beast::string_view authorization = it->value();
-            if (strncmp(authorization.data(), "Bearer ", 7) == 0)
+            if (authorization.starts_with("Bearer "))
             { // Authenticate using bearer token
                 authorization.remove_prefix(7);
 
-                identifier_t userID = userManager->VerifyJWTToken(std::string(authorization.data(), authorization.size()));
-                return userManager->GetUser(userID);
+                identifier_t userID =
+                    userManager->VerifyJWTToken(std::string(authorization.data(), authorization.size()));
+                user = userManager->GetUser(userID);
             }
-            else if (strncmp(authorization.data(), "Basic ", 6) == 0)
+            else if (authorization.starts_with("Basic "))
             { // Authenticate using basic token
                 authorization.remove_prefix(6);
 
+                // Reuse recent check of the same credentials
+                std::string_view credentials = std::string_view(authorization.data(), authorization.size());
+                user = userManager->GetCachedCredentials(credentials);
+                if (user != nullptr)
+                    return user;
+
                 try
                 {
                     std::vector<uint8_t> decoded = cppcodec::base64_rfc4648::decode<std::vector<uint8_t>>(
@@ -251,35 +171,34 @@ namespace server
                     std::string_view basic = std::string_view((const char*)decoded.data(), decoded.size());
 
                     size_t seperator = basic.find(':');
-                    if (seperator == std::string_view::npos)
+                    if (seperator != std::string_view::npos)
                     {
-                        WriteError("Invalid authorization field. Please call /api/help for more details.");
-                        return nullptr;
-                    }
-
-                    std::string_view name = basic.substr(0, seperator);
-                    std::string_view password = basic.substr(seperator + 1);
+                        std::string_view name = basic.substr(0, seperator);
+                        std::string_view password = basic.substr(seperator + 1);
 
-                    return userManager->Authenticate(name, password);
+                        user = userManager->Authenticate(name, password);
+                        if (user != nullptr)
+                            userManager->CacheCredentials(credentials, user);
+                    }
                 }
                 catch (std::exception)
                 {
                 }
             }
 
-            // Write error
-            WriteError("Invalid authorization field. Please call /api/help for more details.");
-            return nullptr;
+            if (user == nullptr)
+            {
+                WriteError(response, boost::beast::http::status::unauthorized,
+                           "Invalid authorization field. Please call /help for more details.");
+            }
+
+            return user;
         }
-        void HttpSession::WriteError(const char* error)
+        void HttpSession::WriteError(http_response_t& response, boost::beast::http::status status, const char* error)
         {
-            boost::shared_ptr<boost::beast::http::response<boost::beast::http::buffer_body>> response =
-                boost::make_shared<boost::beast::http::response<boost::beast::http::buffer_body>>();
-            response->result(boost::beast::http::status::bad_request);
-            response->version(request.version());
-            response->keep_alive(false);
-            response->set(boost::beast::http::field::server, "HomeAutomation Server");
-            response->set(boost::beast::http::field::content_type, "application/json");
+            response.result(status);
+            response.keep_alive(false);
+            response.set(boost::beast::http::field::content_type, "application/json");
 
             rapidjson::Document output = rapidjson::Document(rapidjson::kObjectType);
             rapidjson::Document::AllocatorType& allocator = output.GetAllocator();
@@ -290,109 +209,163 @@ namespace server
                 rapidjson::Writer<rapidjson::StringBuffer>(responseBuffer);
             output.Accept(writer);
 
-            boost::beast::http::buffer_body::value_type& buf = response->body();
-            buf.data = (void*)responseBuffer.GetString();
-            buf.size = responseBuffer.GetSize();
-            buf.more = false;
-
-            response->prepare_payload();
+            response.body().assign(responseBuffer.GetString(), responseBuffer.GetSize());
+        }
 
+        void HttpSession::DoWrite()
+        {
+            socket->expires_after(std::chrono::seconds(HTTP_SESSION_TIMEOUT));
             boost::beast::http::async_write(
-                *socket, *response,
-                boost::asio::bind_executor(strand,
-                                           boost::bind(&HttpSession::OnWriteBuffer, shared_from_this(),
-                                                       boost::placeholders::_1, boost::placeholders::_2, response)));
+                *socket, responses[responseBegin],
+                boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnWrite, shared_from_this(),
+                                                               boost::placeholders::_1, boost::placeholders::_2)));
         }
-
-        void HttpSession::OnWrite(
-            const boost::system::error_code& ec, size_t size,
-            const boost::shared_ptr<boost::beast::http::response<boost::beast::http::empty_body>>& response)
+        void HttpSession::OnWrite(const boost::system::error_code& ec, size_t size)
         {
             (void)size;
 
             if (ec)
                 return;
 
-            if (response->keep_alive())
+            responseBegin = (responseBegin + 1) % HTTP_SESSION_PIPELINE_SIZE;
+            responseCount--;
+
+            if (responseCount != 0)
             {
-                request = {};
-                socket->expires_after(std::chrono::seconds(12));
-                boost::beast::http::async_read(
-                    *socket, buffer, request,
-                    boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnRead, shared_from_this(),
-                                                                   boost::placeholders::_1, boost::placeholders::_2)));
+                DoWrite();
             }
-            else
+            else if (closing)
             {
-                // // Shutdown
-                // socket->expires_after(std::chrono::seconds(6));
-                // socket->async_shutdown(boost::asio::bind_executor(
-                //     strand, boost::bind(&HTTPSession::OnShutdown, shared_from_this(), boost::placeholders::_1)));
                 socket->close();
+                return;
             }
+            else if (waiting)
+            {
+                waiting = false;
+                ProcessRequest();
+                return;
+            }
+
+            // Continue reading after the pipeline was full
+            if (!reading && !closing && !waiting)
+                DoRead();
         }
-        void HttpSession::OnWriteString(
-            const boost::system::error_code& ec, size_t size,
-            const boost::shared_ptr<boost::beast::http::response<boost::beast::http::string_body>>& response)
+
+        void HttpSession::Upgrade(const Ref<api::User>& user)
         {
-            (void)size;
+            assert(responseCount == 0 && !reading);
 
-            if (ec)
-                return;
+            upgraded = true;
+            socket->expires_never();
 
-            if (response->keep_alive())
+            Ref<WebSocketSession> ws = boost::make_shared<WebSocketSession>(socket, user);
+            ws->Run(request);
+        }
+
+        //! Http Api
+        void HttpSession::HttpProcessApiRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                http_response_t& response, const Ref<HttpSession>& session)
+        {
+            if (request.method() != boost::beast::http::verb::post)
             {
-                request = {};
-                socket->expires_after(std::chrono::seconds(12));
-                boost::beast::http::async_read(
-                    *socket, buffer, request,
-                    boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnRead, shared_from_this(),
-                                                                   boost::placeholders::_1, boost::placeholders::_2)));
+                session->WriteError(response, boost::beast::http::status::method_not_allowed,
+                                    "Invalid method. Please call POST /api/<msg>.");
+                return;
             }
-            else
+
+            // Step 1: Parse request (the message type follows /api/)
+            std::string_view target = std::string_view(request.target().data(), request.target().size());
+            std::string_view type = target.substr(5, target.find('?') - 5); // Remove /api/
+
+            ApiRequestMessage apiRequest = ApiRequestMessage(std::string(type));
             {
-                // // Shutdown
-                // socket->next_layer().expires_after(std::chrono::seconds(6));
-                // socket->async_shutdown(boost::asio::bind_executor(
-                //     strand, boost::bind(&HTTPSession::OnShutdown, shared_from_this(), boost::placeholders::_1)));
-                socket->close();
-            }
-        }
-        void HttpSession::OnWriteBuffer(
-            const boost::system::error_code& ec, size_t size,
-            const boost::shared_ptr<boost::beast::http::response<boost::beast::http::buffer_body>>& response)
-        {
-            (void)size;
+                rapidjson::Document& requestDocument = apiRequest.GetJsonDocument();
 
-            if (ec)
-                return;
+                const std::string& body = request.body();
+                if (!body.empty())
+                {
+                    requestDocument.Parse(body.data(), body.size());
+                    if (requestDocument.HasParseError() || !requestDocument.IsObject())
+                    {
+                        session->WriteError(response, boost::beast::http::status::bad_request, "Invalid JSON");
+                        return;
+                    }
+                }
+            }
 
-            if (response->keep_alive())
+            // Step 2: Call websocket api handler (there is no websocket session to subscribe)
+            ApiResponseMessage apiResponse = ApiResponseMessage();
+            if (!WebSocketSession::ProcessMessage(user, apiRequest, apiResponse, nullptr))
             {
-                request = {};
-                socket->expires_after(std::chrono::seconds(12));
-                boost::beast::http::async_read(
-                    *socket, buffer, request,
-                    boost::asio::bind_executor(strand, boost::bind(&HttpSession::OnRead, shared_from_this(),
-                                                                   boost::placeholders::_1, boost::placeholders::_2)));
+                apiResponse.SetErrorCode(kApiErrorCode_InvalidArguments);
+                response.result(boost::beast::http::status::not_found);
             }
             else
             {
-                // // Shutdown
-                // socket->next_layer().expires_after(std::chrono::seconds(6));
-                // socket->async_shutdown(boost::asio::bind_executor(
-                //     strand, boost::bind(&HTTPSession::OnShutdown, shared_from_this(), boost::placeholders::_1)));
-                socket->close();
+                switch (apiResponse.GetErrorCode())
+                {
+                case kApiErrorCode_NoError:
+                    break;
+                case kApiErrorCode_InternalError:
+                    response.result(boost::beast::http::status::internal_server_error);
+                    break;
+                case kApiErrorCode_AccessLevelToLow:
+                    response.result(boost::beast::http::status::forbidden);
+                    break;
+                default:
+                    response.result(boost::beast::http::status::bad_request);
+                    break;
+                }
             }
-        }
 
-        void HttpSession::OnShutdown(const boost::system::error_code& ec)
+            // Step 3: Write response message
+            session->responseBuffer.Clear();
+            apiResponse.Write(session->responseBuffer);
+
+            response.set(boost::beast::http::field::content_type, "application/json");
+            response.body().assign(session->responseBuffer.GetString(), session->responseBuffer.GetSize());
+        }
+        void HttpSession::HttpProcessWebSocketRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                      http_response_t& response, const Ref<HttpSession>& session)
         {
-            if (ec)
+            if (!boost::beast::websocket::is_upgrade(request))
+            {
+                session->WriteError(response, boost::beast::http::status::bad_request,
+                                    "Invalid websocket upgrade. Please call /help for more details.");
                 return;
+            }
+
+            session->Upgrade(user);
+        }
+        void HttpSession::HttpProcessMetricsRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                    http_response_t& response, const Ref<HttpSession>& session)
+        {
+            (void)user;
+            (void)request;
+            (void)session;
+
+            response.set(boost::beast::http::field::content_type, "text/plain; version=0.0.4");
+            metrics::Registry::GetInstance().Write(response.body());
+        }
+        void HttpSession::HttpProcessPingRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                 http_response_t& response, const Ref<HttpSession>& session)
+        {
+            (void)user;
+            (void)request;
+            (void)session;
+
+            response.set(boost::beast::http::field::content_type, "application/json");
+            response.body() += R"({"pong":"57494c4c49414d4bd6484c4552"})";
+        }
+        void HttpSession::HttpProcessHelpRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                 http_response_t& response, const Ref<HttpSession>& session)
+        {
+            (void)user;
+            (void)request;
+            (void)session;
 
-            // // At this point the session will close itself
-            // socket->next_layer().close();
+            response.set(boost::beast::http::field::content_type, "text/plain");
+            response.body() += "You called for help!\nWell currently nobody can help you...";
         }
     }
-}
\ No newline at end of file
+}
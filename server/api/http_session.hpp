@@ -1,6 +1,13 @@
 #pragma once
-#include "common.hpp"
+#include "http_router.hpp"
 #include "user.hpp"
+#include "common.hpp"
+
+// Responses of pipelined requests waiting to be written (the session stops reading when all are in use)
+#define HTTP_SESSION_PIPELINE_SIZE 8
+
+// Time in seconds a connection may be idle
+#define HTTP_SESSION_TIMEOUT 12
 
 namespace server
 {
@@ -13,32 +20,70 @@ namespace server
 
             Ref<tcp_socket_t> socket;
             boost::beast::flat_buffer buffer;
-            boost::beast::http::request<boost::beast::http::string_body> request;
+            http_request_t request;
             rapidjson::StringBuffer responseBuffer;
 
+            /// @brief Pooled responses (a ring of responses waiting to be written in request order)
+            ///
+            std::array<http_response_t, HTTP_SESSION_PIPELINE_SIZE> responses;
+            size_t responseBegin = 0;
+            size_t responseCount = 0;
+
+            /// @brief A request is being read
+            ///
+            bool reading = false;
+
+            /// @brief No more requests are read (the connection is closed after the pending responses)
+            ///
+            bool closing = false;
+
+            /// @brief The request waits until the pending responses are written (e.g. a websocket upgrade)
+            ///
+            bool waiting = false;
+
+            /// @brief The connection was handed over to a websocket session
+            ///
+            bool upgraded = false;
+
+            void DoRead();
             void OnRead(const boost::system::error_code& ec, size_t size);
 
-            Ref<api::User> Authenticate();
+            void ProcessRequest();
 
-            void WriteError(const char* error);
+            Ref<api::User> Authenticate(http_response_t& response);
 
-            void OnWrite(
-                const boost::system::error_code& ec, size_t size,
-                const boost::shared_ptr<boost::beast::http::response<boost::beast::http::empty_body>>& response);
-            void OnWriteString(
-                const boost::system::error_code& ec, size_t size,
-                const boost::shared_ptr<boost::beast::http::response<boost::beast::http::string_body>>& response);
-            void OnWriteBuffer(
-                const boost::system::error_code& ec, size_t size,
-                const boost::shared_ptr<boost::beast::http::response<boost::beast::http::buffer_body>>& response);
+            void WriteError(http_response_t& response, boost::beast::http::status status, const char* error);
 
-            void OnShutdown(const boost::system::error_code& ec);
+            void DoWrite();
+            void OnWrite(const boost::system::error_code& ec, size_t size);
 
           public:
             HttpSession(const Ref<tcp_socket_t>& socket);
             virtual ~HttpSession();
 
+            /// @brief Get http router
+            ///
+            /// @return HttpRouter& Router
+            static HttpRouter& GetRouter();
+
             void Run();
+
+            /// @brief Hand the connection over to a websocket session
+            ///
+            /// @param user Authenticated user
+            void Upgrade(const Ref<api::User>& user);
+
+            //! Http Api
+            static void HttpProcessApiRequest(const Ref<api::User>& user, const http_request_t& request,
+                                              http_response_t& response, const Ref<HttpSession>& session);
+            static void HttpProcessWebSocketRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                    http_response_t& response, const Ref<HttpSession>& session);
+            static void HttpProcessMetricsRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                  http_response_t& response, const Ref<HttpSession>& session);
+            static void HttpProcessPingRequest(const Ref<api::User>& user, const http_request_t& request,
+                                               http_response_t& response, const Ref<HttpSession>& session);
+            static void HttpProcessHelpRequest(const Ref<api::User>& user, const http_request_t& request,
+                                               http_response_t& response, const Ref<HttpSession>& session);
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "message.hpp"
+
+namespace server
+{
+    namespace api
+    {
+        /// @brief Write response members (type, error code and content)
+        ///
+        /// @param writer Writer of the buffer
+        /// @param buffer Output buffer
+        /// @param message Response message
+        static void WriteResponseMembers(rapidjson::Writer<rapidjson::StringBuffer>& writer,
+                                         rapidjson::StringBuffer& buffer, const ApiResponseMessage& message)
+        {
+            // Message type field
+            writer.Key("msg", 3);
+
+            if (message.GetErrorCode() == kApiErrorCode_NoError)
+                writer.String("ack", 3);
+            else
+                writer.String("nack", 4);
+
+            // Message error code field
+            writer.Key("error", 5);
+            writer.Uint64((uint64_t)message.GetErrorCode());
+
+            // Content field
+            const rapidjson::Document& document = message.GetJsonDocument();
+            for (rapidjson::Value::ConstMemberIterator memberIt = document.MemberBegin();
+                 memberIt != document.MemberEnd(); memberIt++)
+            {
+                writer.Key(memberIt->name.GetString(), memberIt->name.GetStringLength());
+                memberIt->value.Accept(writer);
+            }
+
+            // Pre-serialized content (there is always a preceding member)
+            rapidjson::PutRawMembers(buffer, message.GetRawMembers(), true);
+        }
+
+        void ApiResponseMessage::Write(rapidjson::StringBuffer& buffer, size_t id) const
+        {
+            rapidjson::Writer<rapidjson::StringBuffer> writer = rapidjson::Writer<rapidjson::StringBuffer>(buffer);
+
+            writer.StartObject();
+
+            // Message id field
+            writer.Key("msgid", 5);
+            writer.Uint64(id);
+
+            WriteResponseMembers(writer, buffer, *this);
+
+            writer.EndObject(3);
+        }
+        void ApiResponseMessage::Write(rapidjson::StringBuffer& buffer) const
+        {
+            rapidjson::Writer<rapidjson::StringBuffer> writer = rapidjson::Writer<rapidjson::StringBuffer>(buffer);
+
+            writer.StartObject();
+            WriteResponseMembers(writer, buffer, *this);
+            writer.EndObject(2);
+        }
+    }
+}
@@ -40,6 +40,10 @@ namespace server
           protected:
             rapidjson::Document document;
 
+            /// @brief Pre-serialized members that are appended after the json document members
+            ///
+            std::string rawMembers;
+
             ApiMessage() : document(rapidjson::kObjectType)
             {
             }
@@ -73,6 +77,45 @@ namespace server
             {
                 return document.GetAllocator();
             }
+
+            /// @brief Add pre-serialized member
+            /// @note The name is not escaped
+            ///
+            /// @param name Member name
+            /// @param json Serialized member value
+            inline void AddRawMember(const std::string_view& name, const std::string_view& json)
+            {
+                if (!rawMembers.empty())
+                    rawMembers += ',';
+
+                rawMembers += '"';
+                rawMembers.append(name);
+                rawMembers += "\":";
+                rawMembers.append(json);
+            }
+
+            /// @brief Add all members of a pre-serialized json object
+            ///
+            /// @param object Serialized json object
+            inline void AddRawMembers(const std::string_view& object)
+            {
+                std::string_view members = rapidjson::GetRawMembers(object);
+                if (members.empty())
+                    return;
+
+                if (!rawMembers.empty())
+                    rawMembers += ',';
+
+                rawMembers.append(members);
+            }
+
+            /// @brief Get pre-serialized members
+            ///
+            /// @return std::string_view Members (without braces)
+            inline std::string_view GetRawMembers() const
+            {
+                return rawMembers;
+            }
         };
 
         class ApiRequestMessage final : public ApiMessage
@@ -157,6 +200,17 @@ namespace server
             {
                 errorCode = v;
             }
+
+            /// @brief Serialize response of a websocket message
+            ///
+            /// @param buffer Output buffer
+            /// @param id Message id of the request
+            void Write(rapidjson::StringBuffer& buffer, size_t id) const;
+
+            /// @brief Serialize response of a http request (without message id)
+            ///
+            /// @param buffer Output buffer
+            void Write(rapidjson::StringBuffer& buffer) const;
         };
 
         class ApiBroadcastMessage final : public ApiMessage
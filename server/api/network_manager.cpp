@@ -52,6 +52,18 @@ namespace server
             //     return nullptr;
             // }
 
+            // Register http routes
+            {
+                HttpRouter& router = HttpSession::GetRouter();
+
+                router.AddPrefix("/api/", HttpSession::HttpProcessApiRequest);
+                router.Add("/ws", HttpSession::HttpProcessWebSocketRequest);
+                router.Add("/metrics", HttpSession::HttpProcessMetricsRequest);
+
+                router.Add("/ping", HttpSession::HttpProcessPingRequest, false);
+                router.Add("/help", HttpSession::HttpProcessHelpRequest, false);
+            }
+
             // Get worker
             Ref<Worker> worker = Worker::GetInstance();
             assert(worker != nullptr);
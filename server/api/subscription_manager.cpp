@@ -0,0 +1,250 @@
+#include "subscription_manager.hpp"
+#include "websocket_session.hpp"
+
+namespace server
+{
+    namespace api
+    {
+        WeakRef<SubscriptionManager> instanceSubscriptionManager;
+
+        SubscriptionManager::SubscriptionManager() : sessionList(1), sessionTopicList(1)
+        {
+        }
+        SubscriptionManager::~SubscriptionManager()
+        {
+        }
+        Ref<SubscriptionManager> SubscriptionManager::Create()
+        {
+            if (!instanceSubscriptionManager.expired())
+                return Ref<SubscriptionManager>(instanceSubscriptionManager);
+
+            Ref<SubscriptionManager> subscriptionManager = boost::make_shared<SubscriptionManager>();
+            if (subscriptionManager == nullptr)
+                return nullptr;
+
+            instanceSubscriptionManager = subscriptionManager;
+
+            return subscriptionManager;
+        }
+        Ref<SubscriptionManager> SubscriptionManager::GetInstance()
+        {
+            return Ref<SubscriptionManager>(instanceSubscriptionManager);
+        }
+
+        session_id_t SubscriptionManager::Register(const Ref<WebSocketSession>& session)
+        {
+            assert(session != nullptr);
+
+            boost::lock_guard lock(mutex);
+
+            // Reuse free slot
+            if (!freeSessionIdList.empty())
+            {
+                session_id_t sessionId = freeSessionIdList.back();
+                freeSessionIdList.pop_back();
+
+                sessionList[sessionId] = session;
+                return sessionId;
+            }
+
+            sessionList.push_back(session);
+            sessionTopicList.emplace_back();
+
+            return sessionList.size() - 1;
+        }
+
+        void SubscriptionManager::Unregister(session_id_t sessionId)
+        {
+            boost::lock_guard lock(mutex);
+
+            if (sessionId == 0 || sessionId >= sessionList.size() || sessionList[sessionId] == nullptr)
+                return;
+
+            // Remove subscriptions
+            for (topic_t topic : sessionTopicList[sessionId])
+            {
+                robin_hood::unordered_flat_map<topic_t, boost::container::vector<session_id_t>>::iterator it =
+                    topicMap.find(topic);
+                if (it == topicMap.end())
+                    continue;
+
+                boost::container::vector<session_id_t>& sessionIdList = it->second;
+                boost::container::vector<session_id_t>::iterator idIt =
+                    std::lower_bound(sessionIdList.begin(), sessionIdList.end(), sessionId);
+                if (idIt != sessionIdList.end() && *idIt == sessionId)
+                    sessionIdList.erase(idIt);
+
+                if (sessionIdList.empty())
+                    topicMap.erase(it);
+            }
+
+            sessionTopicList[sessionId].clear();
+            sessionList[sessionId] = nullptr;
+            freeSessionIdList.push_back(sessionId);
+        }
+
+        bool SubscriptionManager::Subscribe(session_id_t sessionId, topic_t topic)
+        {
+            boost::lock_guard lock(mutex);
+
+            if (sessionId == 0 || sessionId >= sessionList.size() || sessionList[sessionId] == nullptr)
+                return false;
+
+            // Insert sorted
+            boost::container::vector<session_id_t>& sessionIdList = topicMap[topic];
+            boost::container::vector<session_id_t>::iterator idIt =
+                std::lower_bound(sessionIdList.begin(), sessionIdList.end(), sessionId);
+            if (idIt != sessionIdList.end() && *idIt == sessionId)
+                return false;
+
+            sessionIdList.insert(idIt, sessionId);
+            sessionTopicList[sessionId].push_back(topic);
+
+            return true;
+        }
+
+        bool SubscriptionManager::Unsubscribe(session_id_t sessionId, topic_t topic)
+        {
+            boost::lock_guard lock(mutex);
+
+            if (sessionId == 0 || sessionId >= sessionList.size() || sessionList[sessionId] == nullptr)
+                return false;
+
+            robin_hood::unordered_flat_map<topic_t, boost::container::vector<session_id_t>>::iterator it =
+                topicMap.find(topic);
+            if (it == topicMap.end())
+                return false;
+
+            boost::container::vector<session_id_t>& sessionIdList = it->second;
+            boost::container::vector<session_id_t>::iterator idIt =
+                std::lower_bound(sessionIdList.begin(), sessionIdList.end(), sessionId);
+            if (idIt == sessionIdList.end() || *idIt != sessionId)
+                return false;
+
+            sessionIdList.erase(idIt);
+            if (sessionIdList.empty())
+                topicMap.erase(it);
+
+            boost::container::vector<topic_t>& topicList = sessionTopicList[sessionId];
+            topicList.erase(std::find(topicList.begin(), topicList.end(), topic));
+
+            return true;
+        }
+
+        bool SubscriptionManager::HasSubscribers(const topic_t* topics, size_t count)
+        {
+            boost::shared_lock_guard lock(mutex);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (topicMap.contains(topics[i]))
+                    return true;
+            }
+
+            return false;
+        }
+
+        void SubscriptionManager::GetSubscribers(const topic_t* topics, size_t count,
+                                                 boost::container::vector<session_id_t>& output)
+        {
+            output.clear();
+
+            boost::shared_lock_guard lock(mutex);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                robin_hood::unordered_flat_map<topic_t, boost::container::vector<session_id_t>>::const_iterator it =
+                    topicMap.find(topics[i]);
+                if (it == topicMap.end())
+                    continue;
+
+                if (output.empty())
+                    output.assign(it->second.begin(), it->second.end());
+                else
+                {
+                    // Merge sorted lists
+                    size_t middle = output.size();
+                    output.insert(output.end(), it->second.begin(), it->second.end());
+                    std::inplace_merge(output.begin(), output.begin() + middle, output.end());
+                    output.erase(std::unique(output.begin(), output.end()), output.end());
+                }
+            }
+        }
+
+        Ref<WebSocketSession> SubscriptionManager::GetSession(session_id_t sessionId)
+        {
+            boost::shared_lock_guard lock(mutex);
+
+            if (sessionId >= sessionList.size())
+                return nullptr;
+
+            return sessionList[sessionId];
+        }
+
+        void SubscriptionManager::Send(const boost::container::vector<session_id_t>& sessionIdList,
+                                       const Ref<rapidjson::StringBuffer>& message)
+        {
+            assert(message != nullptr);
+
+            boost::shared_lock_guard lock(mutex);
+
+            for (session_id_t sessionId : sessionIdList)
+            {
+                if (sessionId < sessionList.size() && sessionList[sessionId] != nullptr)
+                    sessionList[sessionId]->Send(message);
+            }
+        }
+
+        void SubscriptionManager::Send(const topic_t* topics, size_t count, const ApiBroadcastMessage& message)
+        {
+            boost::container::vector<session_id_t> sessionIdList;
+            GetSubscribers(topics, count, sessionIdList);
+            if (sessionIdList.empty())
+                return;
+
+            Ref<rapidjson::StringBuffer> buffer = boost::make_shared<rapidjson::StringBuffer>();
+            if (buffer != nullptr)
+            {
+                // Build message
+                {
+                    rapidjson::Writer<rapidjson::StringBuffer> writer =
+                        rapidjson::Writer<rapidjson::StringBuffer>(*buffer);
+
+                    writer.StartObject();
+
+                    // Message id field
+                    writer.Key("msgid", 5);
+                    writer.Uint64(0);
+
+                    // Message type field
+                    {
+                        writer.Key("msg", 3);
+                        const std::string& type = message.GetType();
+                        writer.String(type.data(), type.size(), true);
+                    }
+
+                    // Content field
+                    {
+                        const rapidjson::Document& document = message.GetJsonDocument();
+                        for (rapidjson::Value::ConstMemberIterator memberIt = document.MemberBegin();
+                             memberIt != document.MemberEnd(); memberIt++)
+                        {
+                            writer.Key(memberIt->name.GetString(), memberIt->name.GetStringLength());
+                            memberIt->value.Accept(writer);
+                        }
+
+                        // Pre-serialized content (there is always a preceding member)
+                        rapidjson::PutRawMembers(*buffer, message.GetRawMembers(), true);
+                    }
+                    writer.EndObject(3);
+                }
+
+                Send(sessionIdList, buffer);
+            }
+            else
+            {
+                LOG_ERROR("Failed to create string buffer.");
+            }
+        }
+    }
+}
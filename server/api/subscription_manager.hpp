@@ -0,0 +1,116 @@
+#pragma once
+#include "common.hpp"
+#include "message.hpp"
+
+namespace server
+{
+    namespace api
+    {
+        class WebSocketSession;
+
+        typedef uint32_t session_id_t;
+        typedef uint64_t topic_t;
+
+        enum class TopicType : uint8_t
+        {
+            kEntityTopic = 1,     // Single entity (entity id)
+            kRoomTopic = 2,       // All devices in a room (room id)
+            kEntityTypeTopic = 3, // All entities of a type (entity type)
+        };
+
+        /// @brief Build subscription topic
+        ///
+        /// @param type Topic type
+        /// @param value Topic value (e.g. entity id)
+        /// @return topic_t Topic
+        inline topic_t MakeTopic(TopicType type, uint64_t value)
+        {
+            return ((topic_t)type << 56) | (value & 0x00FFFFFFFFFFFFFF);
+        }
+
+        /// @brief Central registry of websocket sessions and their subscriptions
+        ///
+        /// Sessions are registered with a compact integer id when they are accepted and removed again when they
+        /// close. Every topic maps to a sorted list of session ids.
+        class SubscriptionManager : public boost::enable_shared_from_this<SubscriptionManager>
+        {
+          private:
+            boost::shared_mutex mutex;
+
+            /// @brief Sessions indexed by session id (slot 0 is never used)
+            ///
+            boost::container::vector<Ref<WebSocketSession>> sessionList;
+            boost::container::vector<boost::container::vector<topic_t>> sessionTopicList;
+            boost::container::vector<session_id_t> freeSessionIdList;
+
+            /// @brief Sorted session ids per topic
+            ///
+            robin_hood::unordered_flat_map<topic_t, boost::container::vector<session_id_t>> topicMap;
+
+          public:
+            SubscriptionManager();
+            virtual ~SubscriptionManager();
+            static Ref<SubscriptionManager> Create();
+            static Ref<SubscriptionManager> GetInstance();
+
+            /// @brief Register session
+            ///
+            /// @param session Websocket session
+            /// @return session_id_t Session id
+            session_id_t Register(const Ref<WebSocketSession>& session);
+
+            /// @brief Unregister session and remove all its subscriptions
+            ///
+            /// @param sessionId Session id
+            void Unregister(session_id_t sessionId);
+
+            /// @brief Subscribe session to topic
+            ///
+            /// @param sessionId Session id
+            /// @param topic Topic
+            /// @return Successfulness (false if already subscribed)
+            bool Subscribe(session_id_t sessionId, topic_t topic);
+
+            /// @brief Unsubscribe session from topic
+            ///
+            /// @param sessionId Session id
+            /// @param topic Topic
+            /// @return Successfulness (false if not subscribed)
+            bool Unsubscribe(session_id_t sessionId, topic_t topic);
+
+            /// @brief Check if any session is subscribed to one of the topics
+            ///
+            /// @param topics Topic list
+            /// @param count Topic count
+            /// @return Has subscribers
+            bool HasSubscribers(const topic_t* topics, size_t count);
+
+            /// @brief Get sorted and unique ids of all sessions subscribed to one of the topics
+            ///
+            /// @param topics Topic list
+            /// @param count Topic count
+            /// @param output Session id list
+            void GetSubscribers(const topic_t* topics, size_t count, boost::container::vector<session_id_t>& output);
+
+            /// @brief Get session
+            ///
+            /// @param sessionId Session id
+            /// @return Ref<WebSocketSession> Session or null
+            Ref<WebSocketSession> GetSession(session_id_t sessionId);
+
+            /// @brief Send message to sessions
+            ///
+            /// @param sessionIdList Session id list
+            /// @param message Serialized message
+            void Send(const boost::container::vector<session_id_t>& sessionIdList,
+                      const Ref<rapidjson::StringBuffer>& message);
+
+            /// @brief Send message to all sessions subscribed to one of the topics
+            ///
+            /// @param topics Topic list
+            /// @param count Topic count
+            /// @param message Message
+            void Send(const topic_t* topics, size_t count, const ApiBroadcastMessage& message);
+        };
+    }
+}
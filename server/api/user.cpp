@@ -1,5 +1,7 @@
 #include "user.hpp"
+#include "user_manager.hpp"
 #include <database/database.hpp>
+#include <openssl/crypto.h>
 
 namespace server
 {
@@ -57,23 +59,25 @@ namespace server
         }
         bool User::CompaireHash(uint8_t h[SHA256_SIZE])
         {
-            return memcmp(hash, h, SHA256_SIZE) == 0;
+            return CRYPTO_memcmp(hash, h, SHA256_SIZE) == 0;
         }
         bool User::SetHash(uint8_t h[SHA256_SIZE])
         {
             Ref<Database> database = Database::GetInstance();
             assert(database != nullptr);
 
-            // Update database
-            if (database->UpdateUserHash(id, h, salt))
-            {
-                // Assign new value
-                memcpy(hash, h, SHA256_SIZE);
-
-                return true;
-            }
+            // Assign new value
+            memcpy(hash, h, SHA256_SIZE);
 
-            return false;
+            // Update database
+            database->UpdateUserHashAsync(id, h, salt,
+                                          [id = id](bool result) -> void
+                                          {
+                                              if (!result)
+                                                  LOG_ERROR("Failed to save hash of user '{0}'.", id);
+                                          });
+
+            return true;
         }
 
         void User::GetSalt(uint8_t* s)
@@ -93,15 +97,23 @@ namespace server
             Ref<Database> database = Database::GetInstance();
             assert(database != nullptr);
 
-            // Update database
-            if (database->UpdateUserAccessLevel(id, StringifyUserAccessLevel(v)))
-            {
-                // Assign new value
-                accessLevel = v;
+            // Assign new value
+            accessLevel = v;
 
-                return true;
-            }
-            return false;
+            // Tokens verified with the old access level must be verified again
+            Ref<UserManager> userManager = UserManager::GetInstance();
+            if (userManager != nullptr)
+                userManager->InvalidateTokens(id);
+
+            // Update database
+            database->UpdateUserAccessLevelAsync(id, StringifyUserAccessLevel(v),
+                                                 [id = id](bool result) -> void
+                                                 {
+                                                     if (!result)
+                                                         LOG_ERROR("Failed to save access level of user '{0}'.", id);
+                                                 });
+
+            return true;
         }
 
         void User::JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const
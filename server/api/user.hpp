@@ -33,7 +33,7 @@ namespace server
             static Ref<User> Create(identifier_t id, const std::string& name, uint8_t hash[SHA256_SIZE],
                                     uint8_t salt[SALT_SIZE], UserAccessLevel accessLevel);
 
-            inline std::string GetName() const
+            inline const std::string& GetName() const
             {
                 return name;
             }
@@ -1,9 +1,13 @@
 #include "user_manager.hpp"
+#include "http_session.hpp"
 #include "user.hpp"
 #include "websocket_session.hpp"
+#include <common/metrics.hpp>
 #include <cppcodec/base64_rfc4648.hpp>
 #include <database/database.hpp>
 #include <jwt-cpp/traits/boost-json/traits.h>
+#include <openssl/crypto.h>
+#include <openssl/hmac.h>
 #include <openssl/rand.h>
 
 #define AUTHKEY_SIZE 128
@@ -28,11 +32,19 @@ namespace server
             }
         };
 
-        UserManager::UserManager(const std::string& issuer) : issuer(issuer)
+        UserManager::UserManager(const std::string& issuer)
+            : issuer(issuer),
+              tokenCacheHitCounter(metrics::Registry::GetInstance().GetCounter(
+                  "home_auth_token_cache_total", "Bearer token verifications by cache result",
+                  metrics::MakeLabel("result", "hit"))),
+              tokenCacheMissCounter(metrics::Registry::GetInstance().GetCounter(
+                  "home_auth_token_cache_total", "Bearer token verifications by cache result",
+                  metrics::MakeLabel("result", "miss")))
         {
         }
         UserManager::~UserManager()
         {
+            userNameMap.clear();
             userList.clear();
 
             SAFE_DELETE_ARRAY(authenticationKey);
@@ -59,6 +71,13 @@ namespace server
             }
 #endif
 
+            // Generate credential key
+            if (!RAND_bytes(userManager->credentialKey, USER_CREDENTIAL_KEY_SIZE))
+            {
+                LOG_ERROR("Generate credential key");
+                return nullptr;
+            }
+
             try
             {
                 // Create JWT verifier
@@ -106,6 +125,13 @@ namespace server
                 apiMap["set-user"] = &UserManager::WebSocketProcessSetUserMessage;
             }
 
+            // Register http user api
+            {
+                HttpRouter& router = HttpSession::GetRouter();
+
+                router.Add("/auth", &UserManager::HttpProcessAuthRequest);
+            }
+
             return userManager;
         }
         Ref<UserManager> UserManager::GetInstance()
@@ -130,6 +156,7 @@ namespace server
             if (user != nullptr)
             {
                 userList[id] = user;
+                userNameMap[user->GetName()] = user;
 
                 return true;
             }
@@ -166,8 +193,7 @@ namespace server
             }
 
             // Check name
-            if (boost::range::find_if(userList, [&name](const robin_hood::pair<const identifier_t, Ref<User>>& user)
-                                      { return name == user.second->GetName(); }) != userList.end())
+            if (userNameMap.find(name) != userNameMap.end())
             {
                 LOG_ERROR("User name already exists", name);
                 return nullptr;
@@ -191,7 +217,10 @@ namespace server
 
             // Add user
             if (user != nullptr)
+            {
                 userList[user->GetID()] = user;
+                userNameMap[user->GetName()] = user;
+            }
             else
             {
                 database->RemoveUser(id);
@@ -213,11 +242,9 @@ namespace server
         }
         Ref<User> UserManager::GetUserByName(const std::string_view& name)
         {
-            const robin_hood::unordered_node_map<identifier_t, Ref<User>>::const_iterator it =
-                boost::find_if(userList,
-                               [&name](const robin_hood::pair<const identifier_t, Ref<User>>& pair) -> bool
-                               { return pair.second->GetName() == name; });
-            if (it == userList.end())
+            const robin_hood::unordered_flat_map<std::string_view, Ref<User>>::const_iterator it =
+                userNameMap.find(name);
+            if (it == userNameMap.end())
                 return nullptr;
 
             return it->second;
@@ -227,11 +254,9 @@ namespace server
             // boost::shared_lock_guard lock(mutex);
 
             // Search for user
-            const robin_hood::unordered_node_map<identifier_t, Ref<User>>::const_iterator it =
-                boost::find_if(userList,
-                               [&name](const robin_hood::pair<const identifier_t, Ref<User>>& pair) -> bool
-                               { return pair.second->GetName() == name; });
-            if (it == userList.end())
+            const robin_hood::unordered_flat_map<std::string_view, Ref<User>>::const_iterator it =
+                userNameMap.find(name);
+            if (it == userNameMap.end())
                 return nullptr;
 
             Ref<User> user = it->second;
@@ -298,19 +323,29 @@ namespace server
                     return false;
             }
 
+            // The old password must not authenticate anymore
+            InvalidateCredentials(user->GetID());
+
             return true;
         }
 
         bool UserManager::RemoveUser(identifier_t userID)
         {
             // Remove user
-            if (userList.erase(userID))
+            const robin_hood::unordered_node_map<identifier_t, Ref<User>>::const_iterator it = userList.find(userID);
+            if (it != userList.end())
             {
+                userNameMap.erase(it->second->GetName());
+                userList.erase(it);
+
+                InvalidateTokens(userID);
+                InvalidateCredentials(userID);
+
                 Ref<Database> database = Database::GetInstance();
                 assert(database != nullptr);
 
                 // Remove user from database
-                database->RemoveScriptSource(userID);
+                database->RemoveUserAsync(userID);
 
                 return true;
             }
@@ -318,6 +353,82 @@ namespace server
                 return false;
         }
 
+        // Credential cache
+        void UserManager::CalculateCredentialDigest(const std::string_view& credentials, uint8_t* digest)
+        {
+            unsigned int digestLength = SHA256_DIGEST_LENGTH;
+            HMAC(EVP_sha256(), credentialKey, USER_CREDENTIAL_KEY_SIZE, (const uint8_t*)credentials.data(),
+                 credentials.size(), digest, &digestLength);
+        }
+        Ref<User> UserManager::GetCachedCredentials(const std::string_view& credentials)
+        {
+            uint8_t digest[SHA256_DIGEST_LENGTH];
+            CalculateCredentialDigest(credentials, digest);
+
+            uint64_t key;
+            memcpy(&key, digest, sizeof(key));
+
+            robin_hood::unordered_flat_map<uint64_t, CredentialCacheEntry>::iterator it = credentialCacheMap.find(key);
+            if (it == credentialCacheMap.end())
+                return nullptr;
+
+            // Compare the whole digest in constant time
+            if (CRYPTO_memcmp(it->second.digest, digest, SHA256_DIGEST_LENGTH) != 0)
+                return nullptr;
+
+            if (std::chrono::steady_clock::now() >= it->second.expiry)
+            {
+                credentialCacheMap.erase(it);
+                return nullptr;
+            }
+
+            return GetUser(it->second.userID);
+        }
+        void UserManager::CacheCredentials(const std::string_view& credentials, const Ref<User>& user)
+        {
+            assert(user != nullptr);
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+            // Drop expired credentials first, then every credential if the cache is still full
+            if (credentialCacheMap.size() >= USER_CREDENTIAL_CACHE_SIZE)
+            {
+                for (robin_hood::unordered_flat_map<uint64_t, CredentialCacheEntry>::iterator it =
+                         credentialCacheMap.begin();
+                     it != credentialCacheMap.end();)
+                {
+                    if (now >= it->second.expiry)
+                        it = credentialCacheMap.erase(it);
+                    else
+                        it++;
+                }
+
+                if (credentialCacheMap.size() >= USER_CREDENTIAL_CACHE_SIZE)
+                    credentialCacheMap.clear();
+            }
+
+            CredentialCacheEntry entry;
+            CalculateCredentialDigest(credentials, entry.digest);
+            entry.userID = user->GetID();
+            entry.expiry = now + std::chrono::seconds(USER_CREDENTIAL_CACHE_TTL);
+
+            uint64_t key;
+            memcpy(&key, entry.digest, sizeof(key));
+            credentialCacheMap[key] = entry;
+        }
+        void UserManager::InvalidateCredentials(identifier_t userID)
+        {
+            for (robin_hood::unordered_flat_map<uint64_t, CredentialCacheEntry>::iterator it =
+                     credentialCacheMap.begin();
+                 it != credentialCacheMap.end();)
+            {
+                if (it->second.userID == userID)
+                    it = credentialCacheMap.erase(it);
+                else
+                    it++;
+            }
+        }
+
         void UserManager::CalculateHash(const std::string_view& passwd, uint8_t* salt, uint8_t* digest)
         {
             // Create salted password
@@ -355,6 +466,34 @@ namespace server
         {
             // boost::shared_lock_guard lock(mutex);
 
+            // Step 1: Look up verified token
+            uint8_t digest[SHA256_DIGEST_LENGTH];
+            SHA256((const uint8_t*)token.data(), token.size(), digest);
+            std::string key = std::string((const char*)digest, SHA256_DIGEST_LENGTH);
+
+            robin_hood::unordered_flat_map<std::string, boost::container::list<TokenCacheEntry>::iterator>::iterator
+                cacheIt = tokenCacheMap.find(key);
+            if (cacheIt != tokenCacheMap.end())
+            {
+                boost::container::list<TokenCacheEntry>::iterator entryIt = cacheIt->second;
+                if (std::chrono::system_clock::now() < entryIt->expiry)
+                {
+                    tokenCacheHitCounter.Increment();
+
+                    // Mark as most recently used
+                    tokenCacheList.splice(tokenCacheList.begin(), tokenCacheList, entryIt);
+                    return entryIt->userID;
+                }
+
+                // Expired
+                tokenCacheList.erase(entryIt);
+                tokenCacheMap.erase(cacheIt);
+            }
+            tokenCacheMissCounter.Increment();
+
+            // Step 2: Verify token
+            identifier_t userID;
+            std::chrono::system_clock::time_point expiry = std::chrono::system_clock::time_point::max();
             try
             {
                 jwt::decoded_jwt decoded = jwt::decode<jwt::traits::boost_json>(token);
@@ -366,12 +505,43 @@ namespace server
                 // Verify token using verifier
                 verifier->verify(decoded); // Throws exception on fail
 
-                return decoded.get_payload_claim("id").as_int();
+                userID = decoded.get_payload_claim("id").as_int();
+                if (decoded.has_expires_at())
+                    expiry = decoded.get_expires_at();
             }
             catch (std::exception e)
             {
                 return 0;
             }
+
+            // Step 3: Cache verified token (evict the least recently used one)
+            if (userID != 0)
+            {
+                tokenCacheList.push_front({key, userID, expiry});
+                tokenCacheMap[key] = tokenCacheList.begin();
+
+                if (tokenCacheList.size() > USER_TOKEN_CACHE_SIZE)
+                {
+                    tokenCacheMap.erase(tokenCacheList.back().digest);
+                    tokenCacheList.pop_back();
+                }
+            }
+
+            return userID;
+        }
+        void UserManager::InvalidateTokens(identifier_t userID)
+        {
+            for (boost::container::list<TokenCacheEntry>::iterator it = tokenCacheList.begin();
+                 it != tokenCacheList.end();)
+            {
+                if (it->userID == userID)
+                {
+                    tokenCacheMap.erase(it->digest);
+                    it = tokenCacheList.erase(it);
+                }
+                else
+                    it++;
+            }
         }
         void UserManager::JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator)
         {
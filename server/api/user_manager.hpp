@@ -3,11 +3,25 @@
 #include "user.hpp"
 #include "common.hpp"
 
+// Verified bearer tokens kept to skip decoding and signature verification of repeated tokens
+#define USER_TOKEN_CACHE_SIZE 1024
+
+// Checked basic credentials kept to skip hashing of repeated credentials (and the time in seconds they are kept)
+#define USER_CREDENTIAL_CACHE_SIZE 1024
+#define USER_CREDENTIAL_CACHE_TTL 30
+#define USER_CREDENTIAL_KEY_SIZE 32
+
 namespace server
 {
+    namespace metrics
+    {
+        class Counter;
+    }
+
     namespace api
     {
         class Verifier;
+        class HttpSession;
 
         class UserManager : public boost::enable_shared_from_this<UserManager>
         {
@@ -16,12 +30,54 @@ namespace server
 
             robin_hood::unordered_node_map<identifier_t, Ref<User>> userList;
 
+            /// @brief Users by name (the key views the name of the user)
+            ///
+            robin_hood::unordered_flat_map<std::string_view, Ref<User>> userNameMap;
+
             // Authentication
             uint8_t* authenticationKey = nullptr;
             std::string issuer;
 
             Ref<Verifier> verifier;
 
+            // Verified token cache
+            struct TokenCacheEntry
+            {
+                std::string digest;
+                identifier_t userID;
+                std::chrono::system_clock::time_point expiry;
+            };
+
+            /// @brief Verified tokens (the most recently used is first)
+            ///
+            boost::container::list<TokenCacheEntry> tokenCacheList;
+
+            /// @brief Verified tokens by sha256 digest of the token
+            ///
+            robin_hood::unordered_flat_map<std::string, boost::container::list<TokenCacheEntry>::iterator>
+                tokenCacheMap;
+
+            metrics::Counter& tokenCacheHitCounter;
+            metrics::Counter& tokenCacheMissCounter;
+
+            // Checked credential cache
+            struct CredentialCacheEntry
+            {
+                uint8_t digest[SHA256_SIZE];
+                identifier_t userID;
+                std::chrono::steady_clock::time_point expiry;
+            };
+
+            /// @brief Random key of the credential digests (credentials are never kept in plain text)
+            ///
+            uint8_t credentialKey[USER_CREDENTIAL_KEY_SIZE];
+
+            /// @brief Checked credentials by the first bytes of their digest
+            ///
+            robin_hood::unordered_flat_map<uint64_t, CredentialCacheEntry> credentialCacheMap;
+
+            void CalculateCredentialDigest(const std::string_view& credentials, uint8_t* digest);
+
             void CalculateHash(const std::string_view& password, uint8_t* salt, uint8_t* digest);
 
             // Database
@@ -92,6 +148,23 @@ namespace server
             /// @return User or null if credentials are not valid
             Ref<User> Authenticate(const std::string_view& name, const std::string_view& password);
 
+            /// @brief Get user of recently checked basic credentials
+            ///
+            /// @param credentials Encoded credentials of the authorization header
+            /// @return User or null if the credentials were not checked recently
+            Ref<User> GetCachedCredentials(const std::string_view& credentials);
+
+            /// @brief Remember checked basic credentials for a short time
+            ///
+            /// @param credentials Encoded credentials of the authorization header
+            /// @param user Authenticated user
+            void CacheCredentials(const std::string_view& credentials, const Ref<User>& user);
+
+            /// @brief Forget checked credentials of a user (after its password changed or it was removed)
+            ///
+            /// @param userID User id
+            void InvalidateCredentials(identifier_t userID);
+
             /// @brief Remove user
             ///
             /// @param userID User id
@@ -108,10 +181,17 @@ namespace server
 
             /// @brief Verify JWT Token
             ///
+            /// Verified tokens are cached until they expire, so repeated tokens only cost a hash lookup.
+            ///
             /// @param decoded Decoded
             /// @return User id or null in case of an error
             identifier_t VerifyJWTToken(const std::string& token);
 
+            /// @brief Forget verified tokens of a user (after it was removed or its access level changed)
+            ///
+            /// @param userID User id
+            void InvalidateTokens(identifier_t userID);
+
             void JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator);
             void JsonSet(rapidjson::Value& input);
 
@@ -131,6 +211,10 @@ namespace server
             static void WebSocketProcessSetUserMessage(const Ref<api::User>& user, const ApiRequestMessage& request,
                                                        ApiResponseMessage& response,
                                                        const Ref<WebSocketSession>& session);
+
+            //! Http Api
+            static void HttpProcessAuthRequest(const Ref<api::User>& user, const http_request_t& request,
+                                               http_response_t& response, const Ref<HttpSession>& session);
         };
     }
 }
\ No newline at end of file
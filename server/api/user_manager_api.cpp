@@ -210,5 +210,25 @@ namespace server
                 }
             }
         }
+
+        //! Http Api
+        void UserManager::HttpProcessAuthRequest(const Ref<api::User>& user, const http_request_t& request,
+                                                 http_response_t& response, const Ref<HttpSession>& session)
+        {
+            (void)request;
+            (void)session;
+
+            Ref<api::UserManager> userManager = api::UserManager::GetInstance();
+            assert(userManager != nullptr);
+
+            std::string token = userManager->GenerateJWTToken(user);
+
+            response.set(boost::beast::http::field::content_type, "application/json");
+            std::string& body = response.body();
+            body.reserve(12 + token.size());
+            body += "{\"token\":\"";
+            body += token;
+            body += "\"}";
+        }
     }
 }
\ No newline at end of file
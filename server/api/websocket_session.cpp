@@ -1,5 +1,6 @@
 #include "websocket_session.hpp"
 #include "network_manager.hpp"
+#include <common/metrics.hpp>
 
 namespace server
 {
@@ -14,12 +15,70 @@ namespace server
             return webSocketApiMap;
         }
 
+        struct WebSocketMessageMetrics
+        {
+            metrics::Counter* counter;
+            metrics::Histogram* histogram;
+        };
+
+        /// @brief Get metrics of a message type (only called from the worker)
+        ///
+        /// @param type Message type (unknown types share a single label)
+        /// @return Message metrics
+        static const WebSocketMessageMetrics& GetMessageMetrics(const std::string& type)
+        {
+            static robin_hood::unordered_node_map<std::string, WebSocketMessageMetrics> messageMetricsMap;
+
+            robin_hood::unordered_node_map<std::string, WebSocketMessageMetrics>::const_iterator it =
+                messageMetricsMap.find(type);
+            if (it != messageMetricsMap.end())
+                return it->second;
+
+            metrics::Registry& registry = metrics::Registry::GetInstance();
+            std::string label = metrics::MakeLabel("type", type);
+            WebSocketMessageMetrics messageMetrics = {
+                .counter = &registry.GetCounter("home_websocket_messages_total", "Received websocket messages", label),
+                .histogram = &registry.GetHistogram("home_websocket_handler_duration_seconds",
+                                                    "Duration of websocket message handlers", label),
+            };
+
+            return messageMetricsMap[type] = messageMetrics;
+        }
+
+        bool WebSocketSession::ProcessMessage(const Ref<api::User>& user, const ApiRequestMessage& request,
+                                              ApiResponseMessage& response, const Ref<WebSocketSession>& session)
+        {
+            robin_hood::unordered_node_map<std::string, WebSocketApiCallDefinition>::const_iterator it =
+                webSocketApiMap.find(request.GetType());
+            if (it == webSocketApiMap.end())
+            {
+                GetMessageMetrics("unknown").counter->Increment();
+                return false;
+            }
+
+            const WebSocketMessageMetrics& messageMetrics = GetMessageMetrics(it->first);
+            messageMetrics.counter->Increment();
+
+            WorkerHandlerScope scope(WorkerHandlerKind::kWebSocketWorkerHandlerKind, it->first);
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            it->second(user, request, response, session);
+            messageMetrics.histogram->ObserveSince(begin);
+
+            return true;
+        }
+
+        static metrics::Gauge& sessionGauge =
+            metrics::Registry::GetInstance().GetGauge("home_websocket_sessions", "Open websocket sessions");
+        static metrics::Gauge& sendQueueGauge = metrics::Registry::GetInstance().GetGauge(
+            "home_websocket_send_queue_messages", "Messages waiting to be sent to websocket sessions");
+
         WebSocketSession::WebSocketSession(const Ref<tcp_socket_t>& socket, const Ref<api::User>& user)
             : strand(socket->get_executor()), user(user), socket(boost::make_shared<websocket_t>(std::move(*socket)))
         {
         }
         WebSocketSession::~WebSocketSession()
         {
+            sendQueueGauge.Decrement(messageQueue.size());
         }
 
         void WebSocketSession::Run(boost::beast::http::request<boost::beast::http::string_body>& request)
@@ -38,6 +97,15 @@ namespace server
             if (ec)
                 return;
 
+            // Register session
+            {
+                Ref<SubscriptionManager> subscriptionManager = SubscriptionManager::GetInstance();
+                assert(subscriptionManager != nullptr);
+
+                id = subscriptionManager->Register(shared_from_this());
+                sessionGauge.Increment();
+            }
+
             socket->next_layer().expires_never();
 
             socket->text(true);
@@ -49,7 +117,11 @@ namespace server
         void WebSocketSession::OnRead(const boost::system::error_code& ec, size_t receivedBytes)
         {
             if (ec)
+            {
+                // Connection closed
+                Unregister();
                 return;
+            }
 
             if (!socket->got_text())
             {
@@ -100,11 +172,7 @@ namespace server
             ApiResponseMessage response = ApiResponseMessage();
 
             // Call websocket message
-            robin_hood::unordered_node_map<std::string, WebSocketApiCallDefinition>::const_iterator it =
-                webSocketApiMap.find(request.GetType());
-            if (it != webSocketApiMap.end())
-                it->second(user, request, response, shared_from_this());
-            else
+            if (!ProcessMessage(user, request, response, shared_from_this()))
                 response.SetErrorCode(kApiErrorCode_InvalidArguments);
 
             Send(id, response);
@@ -120,44 +188,10 @@ namespace server
             Ref<rapidjson::StringBuffer> buffer = boost::make_shared<rapidjson::StringBuffer>();
             if (buffer != nullptr)
             {
-                // Build message
-                {
-                    rapidjson::Writer<rapidjson::StringBuffer> writer =
-                        rapidjson::Writer<rapidjson::StringBuffer>(*buffer);
-
-                    writer.StartObject();
-
-                    // Message id field
-                    writer.Key("msgid", 5);
-                    writer.Uint64(id);
-
-                    // Message type field
-                    writer.Key("msg", 3);
-
-                    if (message.GetErrorCode() == kApiErrorCode_NoError)
-                        writer.String("ack", 3);
-                    else
-                        writer.String("nack", 4);
-
-                    // Message error code field
-                    writer.Key("error", 5);
-                    writer.Uint64((uint64_t)message.GetErrorCode());
-
-                    // Content field
-                    {
-                        const rapidjson::Document& document = message.GetJsonDocument();
-                        for (rapidjson::Value::ConstMemberIterator memberIt = document.MemberBegin();
-                             memberIt != document.MemberEnd(); memberIt++)
-                        {
-                            writer.Key(memberIt->name.GetString(), memberIt->name.GetStringLength());
-                            memberIt->value.Accept(writer);
-                        }
-                    }
-
-                    writer.EndObject(3);
-                }
+                message.Write(*buffer, id);
 
                 messageQueue.push_back(buffer);
+                sendQueueGauge.Increment();
 
                 if (messageQueue.size() == 1)
                 {
@@ -179,6 +213,7 @@ namespace server
             if (buffer != nullptr)
             {
                 messageQueue.push_back(buffer);
+                sendQueueGauge.Increment();
 
                 if (messageQueue.size() == 1)
                 {
@@ -201,6 +236,7 @@ namespace server
                 return;
 
             messageQueue.erase(messageQueue.begin());
+            sendQueueGauge.Decrement();
 
             if (messageQueue.size())
             {
@@ -216,6 +252,8 @@ namespace server
 
         void WebSocketSession::DoWSShutdown(boost::beast::websocket::close_code code, const char* reason)
         {
+            Unregister();
+
             // Shutdown
             socket->next_layer().expires_after(std::chrono::seconds(6));
             socket->async_close(
@@ -240,5 +278,18 @@ namespace server
 
             socket->next_layer().close();
         }
+
+        void WebSocketSession::Unregister()
+        {
+            if (id != 0)
+            {
+                Ref<SubscriptionManager> subscriptionManager = SubscriptionManager::GetInstance();
+                if (subscriptionManager != nullptr)
+                    subscriptionManager->Unregister(id);
+                sessionGauge.Decrement();
+
+                id = 0;
+            }
+        }
     }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "message.hpp"
+#include "subscription_manager.hpp"
 #include "user.hpp"
 #include "common.hpp"
 
@@ -19,6 +20,10 @@ namespace server
 
             Ref<api::User> user;
 
+            /// @brief Subscription manager session id (zero if not registered)
+            ///
+            session_id_t id = 0;
+
             Ref<websocket_t> socket;
             boost::beast::flat_buffer buffer;
 
@@ -38,6 +43,10 @@ namespace server
             void DoSSLShutdown(const boost::system::error_code& ec);
             void OnShutdown(const boost::system::error_code& ec);
 
+            /// @brief Remove session from subscription manager
+            ///
+            void Unregister();
+
           public:
             WebSocketSession(const Ref<tcp_socket_t>& socket, const Ref<api::User>& user);
             virtual ~WebSocketSession();
@@ -47,6 +56,24 @@ namespace server
             /// @return robin_hood::unordered_node_map<std::string, WebSocketApiCallDefinition> Api map
             static robin_hood::unordered_node_map<std::string, WebSocketApiCallDefinition>& GetApiMap();
 
+            /// @brief Call websocket api handler of a message (also used by the http api)
+            ///
+            /// @param user Authenticated user
+            /// @param request Request message
+            /// @param response Response message
+            /// @param session Websocket session (null if the message was not received by a websocket session)
+            /// @return Whether a handler of the message type exists
+            static bool ProcessMessage(const Ref<api::User>& user, const ApiRequestMessage& request,
+                                       ApiResponseMessage& response, const Ref<WebSocketSession>& session);
+
+            /// @brief Get session id
+            ///
+            /// @return session_id_t Session id
+            inline session_id_t GetID() const
+            {
+                return id;
+            }
+
             void Run(boost::beast::http::request<boost::beast::http::string_body>& request);
 
             void Send(const Ref<rapidjson::StringBuffer>& message);
@@ -0,0 +1,194 @@
+#pragma once
+#include <common/common.hpp>
+
+namespace server
+{
+    namespace benchmark
+    {
+        /// @brief Collects latency samples of a benchmark scenario
+        ///
+        /// Samples are kept unaggregated so exact percentiles can be reported. The recorder is not thread safe, the
+        /// lock free variant is left out on purpose since every scenario records from a single thread.
+        class LatencyRecorder
+        {
+          private:
+            boost::container::vector<uint64_t> samples;
+            bool sorted = true;
+
+            boost::chrono::steady_clock::time_point begin;
+            boost::chrono::steady_clock::time_point end;
+
+          public:
+            /// @brief Reserve space for samples
+            ///
+            /// @param count Expected sample count
+            inline void Reserve(size_t count)
+            {
+                samples.reserve(count);
+            }
+
+            /// @brief Mark the begin of the measured time span (used for the throughput)
+            ///
+            inline void Start()
+            {
+                begin = boost::chrono::steady_clock::now();
+                end = begin;
+            }
+
+            /// @brief Mark the end of the measured time span (used for the throughput)
+            ///
+            inline void Stop()
+            {
+                end = boost::chrono::steady_clock::now();
+            }
+
+            /// @brief Record sample
+            ///
+            /// @param nanoseconds Latency in nanoseconds
+            inline void Record(uint64_t nanoseconds)
+            {
+                samples.push_back(nanoseconds);
+                sorted = false;
+            }
+
+            /// @brief Record sample
+            ///
+            /// @param from Start time of the operation
+            /// @param to End time of the operation
+            inline void Record(boost::chrono::steady_clock::time_point from, boost::chrono::steady_clock::time_point to)
+            {
+                Record(boost::chrono::duration_cast<boost::chrono::nanoseconds>(to - from).count());
+            }
+
+            /// @brief Merge samples of another recorder (the time span is extended to cover both)
+            ///
+            /// @param other Other recorder
+            void Merge(const LatencyRecorder& other)
+            {
+                if (other.samples.empty())
+                    return;
+
+                if (samples.empty() || other.begin < begin)
+                    begin = other.begin;
+                if (samples.empty() || other.end > end)
+                    end = other.end;
+
+                samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+                sorted = false;
+            }
+
+            /// @brief Get sample count
+            ///
+            /// @return Sample count
+            inline size_t GetCount() const
+            {
+                return samples.size();
+            }
+
+            /// @brief Get measured time span
+            ///
+            /// @return Time span in seconds
+            inline double GetDuration() const
+            {
+                return boost::chrono::duration_cast<boost::chrono::duration<double>>(end - begin).count();
+            }
+
+            /// @brief Get throughput
+            ///
+            /// @param operationsPerSample Operations represented by a single sample
+            /// @return Operations per second
+            inline double GetThroughput(size_t operationsPerSample = 1) const
+            {
+                double duration = GetDuration();
+                return duration > 0.0 ? (double)(samples.size() * operationsPerSample) / duration : 0.0;
+            }
+
+            /// @brief Get percentile (nearest rank)
+            ///
+            /// @param percentile Percentile between 0 and 100
+            /// @return Latency in nanoseconds
+            uint64_t GetPercentile(double percentile)
+            {
+                if (samples.empty())
+                    return 0;
+
+                if (!sorted)
+                {
+                    std::sort(samples.begin(), samples.end());
+                    sorted = true;
+                }
+
+                size_t rank = (size_t)std::ceil(percentile / 100.0 * samples.size());
+                return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+            }
+
+            /// @brief Get mean latency
+            ///
+            /// @return Latency in nanoseconds
+            uint64_t GetMean() const
+            {
+                if (samples.empty())
+                    return 0;
+
+                uint64_t sum = 0;
+                for (uint64_t sample : samples)
+                    sum += sample;
+                return sum / samples.size();
+            }
+
+            /// @brief Get histogram with power of two buckets (bucket n counts latencies below 2^n microseconds)
+            ///
+            /// @return Sample count per bucket (trailing empty buckets are omitted)
+            boost::container::vector<size_t> GetHistogram() const
+            {
+                boost::container::vector<size_t> histogram;
+                for (uint64_t sample : samples)
+                {
+                    size_t bucket = 0;
+                    for (uint64_t microseconds = sample / 1000; microseconds != 0; microseconds >>= 1)
+                        bucket++;
+
+                    if (histogram.size() <= bucket)
+                        histogram.resize(bucket + 1, 0);
+                    histogram[bucket]++;
+                }
+
+                return histogram;
+            }
+
+            /// @brief Write summary as json object
+            ///
+            /// @param writer Json writer
+            /// @param operationsPerSample Operations represented by a single sample
+            template <typename Writer>
+            void JsonGetSummary(Writer& writer, size_t operationsPerSample = 1)
+            {
+                writer.StartObject();
+
+                writer.Key("count");
+                writer.Uint64(samples.size());
+                writer.Key("duration");
+                writer.Double(GetDuration());
+                writer.Key("throughput");
+                writer.Double(GetThroughput(operationsPerSample));
+                writer.Key("mean");
+                writer.Uint64(GetMean());
+                writer.Key("p50");
+                writer.Uint64(GetPercentile(50.0));
+                writer.Key("p99");
+                writer.Uint64(GetPercentile(99.0));
+                writer.Key("p999");
+                writer.Uint64(GetPercentile(99.9));
+                writer.Key("max");
+                writer.Uint64(GetPercentile(100.0));
+                writer.Key("histogram");
+                writer.StartArray();
+                for (size_t count : GetHistogram())
+                    writer.Uint64(count);
+                writer.EndArray();
+
+                writer.EndObject();
+            }
+        };
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <common/common.hpp>
+
+namespace server
+{
+    namespace benchmark
+    {
+        /// @brief Paces operations to a fixed rate
+        ///
+        class RateLimiter
+        {
+          private:
+            size_t rate;
+            boost::chrono::steady_clock::time_point begin;
+            size_t index = 0;
+
+          public:
+            /// @brief Create rate limiter
+            ///
+            /// @param rate Operations per second (zero for unlimited)
+            RateLimiter(size_t rate) : rate(rate), begin(boost::chrono::steady_clock::now())
+            {
+            }
+
+            /// @brief Wait for the next slot
+            ///
+            void Wait()
+            {
+                if (rate == 0)
+                    return;
+
+                boost::this_thread::sleep_until(begin + boost::chrono::nanoseconds(1000000000ull * index++ / rate));
+            }
+        };
+    }
+}
@@ -0,0 +1,437 @@
+#include <benchmarks/common/latency.hpp>
+#include <benchmarks/common/rate_limiter.hpp>
+#include <common/common.hpp>
+#include <common/worker.hpp>
+#include <database/database.hpp>
+#include <database/sqlite/sqlite_database.hpp>
+
+using namespace server;
+using namespace server::benchmark;
+
+/// @brief SQLite pragma presets (the memory backend ignores pragmas)
+///
+static const std::pair<std::string, std::string> pragmaPresets[] = {
+    {"wal-normal", SQLITE_DATABASE_DEFAULT_PRAGMAS},
+    {"wal-full", "pragma journal_mode = wal; pragma synchronous = full"},
+    {"wal-off", "pragma journal_mode = wal; pragma synchronous = off"},
+    {"delete-full", "pragma journal_mode = delete; pragma synchronous = full"},
+};
+
+struct BenchmarkConfig
+{
+    boost::container::vector<DatabaseType> backends = {DatabaseType::kSQLiteDatabaseType,
+                                                       DatabaseType::kMemoryDatabaseType};
+    boost::container::vector<std::string> presets = {"wal-normal", "wal-full", "wal-off", "delete-full"};
+
+    size_t entityCount = 1000;
+    size_t updateCount = 10000;
+    size_t payloadSize = 64;
+    size_t historyCount = 1000;
+    size_t historyBlockSize = 4096;
+    size_t loadCount = 20;
+
+    /// @brief Updates per second (zero for unlimited)
+    ///
+    size_t rate = 0;
+
+    std::string path = "benchmark-database";
+    std::string json;
+};
+
+static std::string GeneratePayload(size_t size, uint32_t seed)
+{
+    std::string payload = std::string(size, '\0');
+    for (size_t i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        payload[i] = (char)(seed >> 16);
+    }
+
+    return payload;
+}
+
+/// @brief Write scenario summary to the console
+///
+static void PrintScenario(const std::string& backend, const std::string& preset, const std::string& scenario,
+                          LatencyRecorder& recorder, size_t operationsPerSample = 1)
+{
+    printf("%-8s %-12s %-28s %10zu %12.0f/s %10.1fus %10.1fus %10.1fus\n", backend.c_str(), preset.c_str(),
+           scenario.c_str(), recorder.GetCount(), recorder.GetThroughput(operationsPerSample),
+           recorder.GetPercentile(50.0) / 1000.0, recorder.GetPercentile(99.0) / 1000.0,
+           recorder.GetPercentile(99.9) / 1000.0);
+}
+
+/// @brief Run every scenario against one backend and preset
+///
+/// @param config Benchmark config
+/// @param type Database type
+/// @param preset Pragma preset name
+/// @param pragmas Pragmas
+/// @param writer Json result writer
+/// @return Successfulness
+static bool RunBenchmark(const BenchmarkConfig& config, DatabaseType type, const std::string& preset,
+                         const std::string& pragmas, rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer)
+{
+    std::string backend = StringifyDatabaseType(type);
+
+    // Start with an empty database
+    std::string path = boost::filesystem::absolute(config.path + "-" + backend + "-" + preset).string();
+    boost::filesystem::remove(path);
+    boost::filesystem::remove(path + "-wal");
+    boost::filesystem::remove(path + "-shm");
+
+    Ref<Database> database = Database::Create(type, path, "", "", pragmas);
+    if (database == nullptr)
+    {
+        LOG_ERROR("Failed to create {0} database with preset '{1}'.", backend, preset);
+        return false;
+    }
+
+    writer.StartObject();
+    writer.Key("backend");
+    writer.String(backend.c_str());
+    writer.Key("preset");
+    writer.String(preset.c_str());
+    writer.Key("pragmas");
+    writer.String(type == DatabaseType::kSQLiteDatabaseType ? pragmas.c_str() : "");
+    writer.Key("scenarios");
+    writer.StartObject();
+
+    boost::container::vector<std::string> payloads;
+    for (size_t i = 0; i < 16; i++)
+        payloads.push_back(GeneratePayload(config.payloadSize, i + 1));
+
+    // Step 1: Reserve entities
+    {
+        LatencyRecorder recorder;
+        recorder.Reserve(config.entityCount);
+        recorder.Start();
+        for (size_t i = 0; i < config.entityCount; i++)
+        {
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            if (database->ReserveEntity(2) == 0)
+                LOG_ERROR("Failed to reserve entity.");
+            recorder.Record(begin, boost::chrono::steady_clock::now());
+        }
+        recorder.Stop();
+
+        PrintScenario(backend, preset, "reserve-entity", recorder);
+        writer.Key("reserve-entity");
+        recorder.JsonGetSummary(writer);
+    }
+
+    // Step 2: Update entities
+    {
+        std::string attributes = R"({"roomid":1,"hidden":false})";
+
+        LatencyRecorder recorder;
+        recorder.Reserve(config.entityCount);
+        recorder.Start();
+        for (size_t i = 0; i < config.entityCount; i++)
+        {
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            database->UpdateEntity(i + 1, "entity " + std::to_string(i + 1), 0, attributes);
+            database->UpdateEntityState(i + 1, payloads[i % payloads.size()]);
+            recorder.Record(begin, boost::chrono::steady_clock::now());
+        }
+        recorder.Stop();
+
+        PrintScenario(backend, preset, "update-entity", recorder);
+        writer.Key("update-entity");
+        recorder.JsonGetSummary(writer);
+    }
+
+    // Step 3: Synchronous state updates
+    {
+        RateLimiter limiter = RateLimiter(config.rate);
+
+        LatencyRecorder recorder;
+        recorder.Reserve(config.updateCount);
+        recorder.Start();
+        for (size_t i = 0; i < config.updateCount; i++)
+        {
+            limiter.Wait();
+
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            database->UpdateEntityState(i % config.entityCount + 1, payloads[i % payloads.size()]);
+            recorder.Record(begin, boost::chrono::steady_clock::now());
+        }
+        recorder.Stop();
+
+        PrintScenario(backend, preset, "update-entity-state", recorder);
+        writer.Key("update-entity-state");
+        recorder.JsonGetSummary(writer);
+    }
+
+    // Step 4: Asynchronous state updates (latency until the callback runs on the worker)
+    {
+        RateLimiter limiter = RateLimiter(config.rate);
+
+        boost::mutex mutex;
+        boost::condition_variable condition;
+        size_t completed = 0;
+
+        LatencyRecorder recorder;
+        recorder.Reserve(config.updateCount);
+        recorder.Start();
+        for (size_t i = 0; i < config.updateCount; i++)
+        {
+            limiter.Wait();
+
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            database->UpdateEntityStateAsync(i % config.entityCount + 1, payloads[i % payloads.size()],
+                                             [&, begin](bool result) -> void
+                                             {
+                                                 if (!result)
+                                                     LOG_ERROR("Failed to update entity state.");
+
+                                                 // Recorded on the worker
+                                                 boost::lock_guard lock(mutex);
+                                                 recorder.Record(begin, boost::chrono::steady_clock::now());
+                                                 if (++completed == config.updateCount)
+                                                     condition.notify_all();
+                                             });
+        }
+
+        // Wait for pending writes
+        {
+            boost::unique_lock lock(mutex);
+            condition.wait(lock, [&]() -> bool { return completed == config.updateCount; });
+        }
+        recorder.Stop();
+
+        PrintScenario(backend, preset, "update-entity-state-async", recorder);
+        writer.Key("update-entity-state-async");
+        recorder.JsonGetSummary(writer);
+    }
+
+    // Step 5: History blocks
+    {
+        std::string block = GeneratePayload(config.historyBlockSize, 42);
+
+        LatencyRecorder recorder;
+        recorder.Reserve(config.historyCount);
+        recorder.Start();
+        for (size_t i = 0; i < config.historyCount; i++)
+        {
+            int64_t begin = i * 3600;
+
+            boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+            database->AddHistoryBlock(i % config.entityCount + 1, "value", 0, begin, begin + 3599, 360, block);
+            recorder.Record(start, boost::chrono::steady_clock::now());
+        }
+        recorder.Stop();
+
+        PrintScenario(backend, preset, "add-history-block", recorder);
+        writer.Key("add-history-block");
+        recorder.JsonGetSummary(writer);
+    }
+
+    // Step 6: Load all entities (throughput in rows per second)
+    {
+        LatencyRecorder recorder;
+        recorder.Reserve(config.loadCount);
+        recorder.Start();
+        for (size_t i = 0; i < config.loadCount; i++)
+        {
+            size_t bytes = 0;
+
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            database->LoadEntities(
+                [&bytes](identifier_t id, uint8_t type, const std::string_view& name, identifier_t scriptSourceID,
+                         const std::string_view& attributes, const std::string_view& state) -> bool
+                {
+                    (void)id;
+                    (void)type;
+                    (void)scriptSourceID;
+                    bytes += name.size() + attributes.size() + state.size();
+                    return true;
+                });
+            recorder.Record(begin, boost::chrono::steady_clock::now());
+        }
+        recorder.Stop();
+
+        PrintScenario(backend, preset, "load-entities", recorder, config.entityCount);
+        writer.Key("load-entities");
+        recorder.JsonGetSummary(writer, config.entityCount);
+    }
+
+    writer.EndObject();
+    writer.EndObject();
+
+    // Close database (executes pending writes)
+    database = nullptr;
+
+    boost::filesystem::remove(path);
+    boost::filesystem::remove(path + "-wal");
+    boost::filesystem::remove(path + "-shm");
+
+    return true;
+}
+
+static void PrintUsage()
+{
+    printf("Usage: benchmark-database [options]\n"
+           "  --backends <list>   Database backends (default: sqlite,memory)\n"
+           "  --presets <list>    SQLite pragma presets (default: wal-normal,wal-full,wal-off,delete-full)\n"
+           "  --entities <n>      Entity count (default: 1000)\n"
+           "  --updates <n>       State updates per scenario (default: 10000)\n"
+           "  --payload <bytes>   State payload size (default: 64)\n"
+           "  --history <n>       History blocks (default: 1000)\n"
+           "  --rate <n>          State updates per second, 0 for unlimited (default: 0)\n"
+           "  --path <file>       Database file prefix (default: benchmark-database)\n"
+           "  --json <file>       Write results as json\n");
+}
+
+static bool ParseArguments(int argc, char** argv, BenchmarkConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--help" || i + 1 >= argc)
+            return false;
+
+        std::string value = argv[++i];
+
+        try
+        {
+            if (argument == "--backends")
+            {
+                config.backends.clear();
+
+                boost::container::vector<std::string> names;
+                boost::split(names, value, boost::is_any_of(","));
+                for (const std::string& name : names)
+                {
+                    DatabaseType type = ParseDatabaseType(name);
+                    if (type == DatabaseType::kUnknownDatabaseType)
+                    {
+                        printf("Unknown backend '%s'.\n", name.c_str());
+                        return false;
+                    }
+                    config.backends.push_back(type);
+                }
+            }
+            else if (argument == "--presets")
+            {
+                config.presets.clear();
+                boost::split(config.presets, value, boost::is_any_of(","));
+            }
+            else if (argument == "--entities")
+                config.entityCount = std::max<size_t>(std::stoull(value), 1);
+            else if (argument == "--updates")
+                config.updateCount = std::stoull(value);
+            else if (argument == "--payload")
+                config.payloadSize = std::stoull(value);
+            else if (argument == "--history")
+                config.historyCount = std::stoull(value);
+            else if (argument == "--rate")
+                config.rate = std::stoull(value);
+            else if (argument == "--path")
+                config.path = value;
+            else if (argument == "--json")
+                config.json = value;
+            else
+            {
+                printf("Unknown option '%s'.\n", argument.c_str());
+                return false;
+            }
+        }
+        catch (const std::exception&)
+        {
+            printf("Invalid value '%s' for option '%s'.\n", value.c_str(), argument.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkConfig config;
+    if (!ParseArguments(argc, argv, config))
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    boost::filesystem::create_directories(config::GetLogDirectory());
+    Log::Create();
+
+    // Async write callbacks are posted to the worker
+    Ref<Worker> worker = Worker::Create();
+    if (worker == nullptr)
+        return -1;
+    boost::thread workerThread = boost::thread([worker]() -> void { worker->Run(); });
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer = rapidjson::PrettyWriter<rapidjson::StringBuffer>(buffer);
+
+    writer.StartObject();
+    writer.Key("config");
+    writer.StartObject();
+    writer.Key("entities");
+    writer.Uint64(config.entityCount);
+    writer.Key("updates");
+    writer.Uint64(config.updateCount);
+    writer.Key("payload");
+    writer.Uint64(config.payloadSize);
+    writer.Key("history");
+    writer.Uint64(config.historyCount);
+    writer.Key("rate");
+    writer.Uint64(config.rate);
+    writer.EndObject();
+    writer.Key("results");
+    writer.StartArray();
+
+    printf("%-8s %-12s %-28s %10s %14s %12s %12s %12s\n", "backend", "preset", "scenario", "count", "throughput",
+           "p50", "p99", "p999");
+
+    int result = 0;
+    for (DatabaseType type : config.backends)
+    {
+        if (type == DatabaseType::kSQLiteDatabaseType)
+        {
+            for (const std::string& preset : config.presets)
+            {
+                const std::pair<std::string, std::string>* it =
+                    std::find_if(std::begin(pragmaPresets), std::end(pragmaPresets),
+                                 [&preset](const std::pair<std::string, std::string>& entry) -> bool
+                                 { return entry.first == preset; });
+                if (it == std::end(pragmaPresets))
+                {
+                    LOG_ERROR("Unknown pragma preset '{0}'.", preset);
+                    result = -1;
+                    continue;
+                }
+
+                if (!RunBenchmark(config, type, it->first, it->second, writer))
+                    result = -1;
+            }
+        }
+        else if (!RunBenchmark(config, type, "default", "", writer))
+            result = -1;
+    }
+
+    writer.EndArray();
+    writer.EndObject();
+
+    // Write json results
+    if (!config.json.empty())
+    {
+        std::ofstream file = std::ofstream(config.json, std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_ERROR("Failed to write benchmark results to '{0}'.", config.json);
+            result = -1;
+        }
+        else
+            file.write(buffer.GetString(), buffer.GetSize());
+    }
+
+    worker->Stop();
+    workerThread.join();
+
+    return result;
+}
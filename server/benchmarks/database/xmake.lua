@@ -0,0 +1,16 @@
+target("benchmark-database")
+    set_kind("binary")
+    set_basename("benchmark-database")
+    add_files("./**.cpp")
+    add_packages(
+        "spdlog", 
+        "boost", 
+        "rapidjson", 
+        "robin-hood-hashing", 
+        "xxhash"
+    )
+
+    add_deps(
+        "server-common",
+        "server-database"
+    )
\ No newline at end of file
@@ -0,0 +1,471 @@
+#include <benchmarks/common/latency.hpp>
+#include <benchmarks/modbus_simulator/simulator.hpp>
+#include <common/common.hpp>
+#include <scripting_native_helper/modbus/modbus_client.hpp>
+#include <scripting_native_helper/modbus/modbus_gateway.hpp>
+#include <toolkit/modbus/modbus.hpp>
+
+using namespace server;
+using namespace server::benchmark;
+using namespace server::scripting::native::modbus;
+
+enum ModbusScenario
+{
+    kModbusScenario_Blocking,
+    kModbusScenario_Pipelined,
+    kModbusScenario_Gateway,
+    kModbusScenario_Count,
+};
+
+static const char* modbusScenarioNames[kModbusScenario_Count] = {
+    "blocking",
+    "pipelined",
+    "gateway",
+};
+
+struct BenchmarkConfig
+{
+    boost::container::vector<ModbusScenario> scenarios = {kModbusScenario_Blocking, kModbusScenario_Pipelined,
+                                                          kModbusScenario_Gateway};
+
+    /// @brief Connections per scenario (blocking clients use one thread each)
+    ///
+    size_t connectionCount = 1;
+
+    /// @brief Requests kept in flight per connection (pipelined scenarios only)
+    ///
+    size_t depth = 8;
+
+    size_t unitCount = 4;
+    size_t registerCount = 16;
+
+    /// @brief Measured time span per scenario in seconds
+    ///
+    size_t duration = 5;
+
+    /// @brief Use a running simulator instead of an in-process one
+    ///
+    bool external = false;
+    ModbusSimulatorConfig simulator;
+
+    std::string json;
+};
+
+struct ScenarioResult
+{
+    LatencyRecorder recorder;
+    size_t errorCount = 0;
+};
+
+/// @brief Get read address of a request (spreads requests over the tables)
+///
+/// @param config Benchmark config
+/// @param index Request index
+/// @return First register
+static uint16_t GetReadAddress(const BenchmarkConfig& config, size_t index)
+{
+    size_t range = config.simulator.addressCount > config.registerCount
+                       ? config.simulator.addressCount - config.registerCount
+                       : 1;
+    return (uint16_t)(index * config.registerCount % range);
+}
+
+/// @brief Read with the blocking toolkit client, one thread per connection
+///
+static void RunBlocking(const BenchmarkConfig& config, ScenarioResult& result)
+{
+    boost::container::vector<ScenarioResult> results = boost::container::vector<ScenarioResult>(config.connectionCount);
+    boost::chrono::steady_clock::time_point deadline =
+        boost::chrono::steady_clock::now() + boost::chrono::seconds(config.duration);
+
+    boost::thread_group threads;
+    for (size_t i = 0; i < config.connectionCount; i++)
+    {
+        threads.create_thread(
+            [&config, &results, i, deadline]() -> void
+            {
+                ScenarioResult& threadResult = results[i];
+                boost::container::vector<uint16_t> values = boost::container::vector<uint16_t>(config.registerCount);
+
+                Modbus modbus;
+                modbus.SetEndpoint(config.simulator.address, config.simulator.port);
+                modbus.SetSlaveID((uint8_t)(i % config.unitCount + 1));
+
+                threadResult.recorder.Start();
+                for (size_t index = i; boost::chrono::steady_clock::now() < deadline; index += config.connectionCount)
+                {
+                    if (!modbus.IsConnected() && !modbus.Connect())
+                    {
+                        threadResult.errorCount++;
+                        boost::this_thread::sleep_for(boost::chrono::milliseconds(MODBUS_CLIENT_MIN_BACKOFF));
+                        continue;
+                    }
+
+                    uint16_t address = GetReadAddress(config, index);
+
+                    boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+                    uint8_t error = modbus.ReadHoldingRegisters(address, config.registerCount, values.data());
+                    threadResult.recorder.Record(begin, boost::chrono::steady_clock::now());
+
+                    if (error != 0 || values[0] != address)
+                        threadResult.errorCount++;
+
+                    // A lost response leaves the connection out of sync
+                    if (error == NoConnection)
+                        modbus.Close();
+                }
+                threadResult.recorder.Stop();
+            });
+    }
+    threads.join_all();
+
+    for (const ScenarioResult& threadResult : results)
+    {
+        result.recorder.Merge(threadResult.recorder);
+        result.errorCount += threadResult.errorCount;
+    }
+}
+
+/// @brief Keeps a fixed number of reads in flight until the deadline
+///
+class PipelinedLoad
+{
+  public:
+    typedef boost::function<void(uint8_t unit, uint16_t address, const ModbusRegistersCallback& callback)> ReadFunction;
+
+  private:
+    const BenchmarkConfig& config;
+    ScenarioResult& result;
+    boost::container::vector<ReadFunction> readList;
+    boost::chrono::steady_clock::time_point deadline;
+
+    size_t index = 0;
+    size_t activeCount = 0;
+    boost::function<void()> onDone;
+
+    void Issue(size_t connection)
+    {
+        size_t requestIndex = index++;
+        uint8_t unit = (uint8_t)(requestIndex % config.unitCount + 1);
+        uint16_t address = GetReadAddress(config, requestIndex);
+
+        readList[connection](unit, address,
+                             boost::bind(&PipelinedLoad::OnRead, this, connection, address,
+                                         boost::chrono::steady_clock::now(), boost::placeholders::_1,
+                                         boost::placeholders::_2, boost::placeholders::_3));
+    }
+    void OnRead(size_t connection, uint16_t address, boost::chrono::steady_clock::time_point begin,
+                ModbusError error, const uint16_t* values, size_t count)
+    {
+        boost::chrono::steady_clock::time_point end = boost::chrono::steady_clock::now();
+        result.recorder.Record(begin, end);
+
+        if (error != ModbusError::kNoModbusError || count == 0 || values[0] != address)
+            result.errorCount++;
+
+        if (end < deadline)
+            Issue(connection);
+        else if (--activeCount == 0)
+        {
+            result.recorder.Stop();
+            onDone();
+        }
+    }
+
+  public:
+    PipelinedLoad(const BenchmarkConfig& config, ScenarioResult& result,
+                  const boost::container::vector<ReadFunction>& readList)
+        : config(config), result(result), readList(readList)
+    {
+    }
+
+    /// @brief Start reads (must be called on the context of the clients)
+    ///
+    /// @param onDone Called after the last read completed
+    void Start(const boost::function<void()>& onDone)
+    {
+        this->onDone = onDone;
+        deadline = boost::chrono::steady_clock::now() + boost::chrono::seconds(config.duration);
+
+        result.recorder.Start();
+        for (size_t connection = 0; connection < readList.size(); connection++)
+        {
+            for (size_t i = 0; i < config.depth; i++)
+            {
+                activeCount++;
+                Issue(connection);
+            }
+        }
+    }
+};
+
+/// @brief Read with the asynchronous client (one client per connection) or the pooled gateway
+///
+static void RunPipelined(const BenchmarkConfig& config, ScenarioResult& result, bool gateway)
+{
+    boost::asio::io_context context;
+
+    boost::container::vector<Ref<ModbusClient>> clients;
+    Ref<ModbusGateway> modbusGateway;
+    boost::container::vector<PipelinedLoad::ReadFunction> readList;
+
+    if (gateway)
+    {
+        // Every request goes through one gateway, the cache is bypassed
+        modbusGateway = ModbusGateway::Create(context, config.simulator.address, config.simulator.port,
+                                              config.connectionCount);
+        for (size_t i = 0; i < config.connectionCount; i++)
+        {
+            readList.push_back(
+                [&config, modbusGateway](uint8_t unit, uint16_t address, const ModbusRegistersCallback& callback)
+                { modbusGateway->ReadHoldingRegisters(unit, address, config.registerCount, callback, 0); });
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < config.connectionCount; i++)
+        {
+            Ref<ModbusClient> client = ModbusClient::Create(context, config.simulator.address, config.simulator.port);
+            clients.push_back(client);
+            readList.push_back(
+                [&config, client](uint8_t unit, uint16_t address, const ModbusRegistersCallback& callback)
+                { client->ReadHoldingRegisters(unit, address, config.registerCount, callback); });
+        }
+    }
+
+    PipelinedLoad load = PipelinedLoad(config, result, readList);
+    boost::asio::post(context,
+                      [&load, &clients, &modbusGateway]() -> void
+                      {
+                          load.Start(
+                              [&clients, &modbusGateway]() -> void
+                              {
+                                  // Close connections so the context runs out of work
+                                  for (const Ref<ModbusClient>& client : clients)
+                                      client->Close();
+                                  if (modbusGateway != nullptr)
+                                      modbusGateway->Close();
+                              });
+                      });
+    context.run();
+}
+
+static void PrintUsage()
+{
+    printf("Usage: benchmark-modbus [options]\n"
+           "  --scenarios <list>  Comma separated scenarios: blocking, pipelined, gateway (default: all)\n"
+           "  --connections <n>   Connections per scenario (default: 1)\n"
+           "  --depth <n>         Requests in flight per connection in pipelined scenarios (default: 8)\n"
+           "  --units <n>         Unit ids the requests are spread over (default: 4)\n"
+           "  --registers <n>     Registers per read (default: 16)\n"
+           "  --duration <s>      Measured time span per scenario in seconds (default: 5)\n"
+           "  --external <0|1>    Use a running simulator instead of an in-process one (default: 0)\n"
+           "  --address <ip>      Simulator address (default: 127.0.0.1)\n"
+           "  --port <n>          Simulator port (default: 1502)\n"
+           "  --addresses <n>     Addresses of every simulated table (default: 10000)\n"
+           "  --latency <min,max> Simulated latency range in microseconds (default: 0,0)\n"
+           "  --error-rate <r>    Fraction of requests answered with server busy (default: 0)\n"
+           "  --drop-rate <r>     Fraction of requests never answered (default: 0)\n"
+           "  --serial <0|1>      Simulate one request at a time per connection (default: 0)\n"
+           "  --json <file>       Write results as json\n");
+}
+
+static bool ParseArguments(int argc, char** argv, BenchmarkConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--help" || i + 1 >= argc)
+            return false;
+
+        std::string value = argv[++i];
+
+        try
+        {
+            if (argument == "--scenarios")
+            {
+                boost::container::vector<std::string> names;
+                boost::split(names, value, boost::is_any_of(","));
+
+                config.scenarios.clear();
+                for (const std::string& name : names)
+                {
+                    const char* const* it =
+                        std::find(std::begin(modbusScenarioNames), std::end(modbusScenarioNames), name);
+                    if (it == std::end(modbusScenarioNames))
+                    {
+                        printf("Unknown scenario '%s'.\n", name.c_str());
+                        return false;
+                    }
+                    config.scenarios.push_back((ModbusScenario)(it - std::begin(modbusScenarioNames)));
+                }
+            }
+            else if (argument == "--connections")
+                config.connectionCount = std::max<size_t>(std::stoull(value), 1);
+            else if (argument == "--depth")
+                config.depth = std::max<size_t>(std::stoull(value), 1);
+            else if (argument == "--units")
+                config.unitCount = std::clamp<size_t>(std::stoull(value), 1, 247);
+            else if (argument == "--registers")
+                config.registerCount = std::clamp<size_t>(std::stoull(value), 1, MODBUS_MAX_READ_REGISTERS);
+            else if (argument == "--duration")
+                config.duration = std::stoull(value);
+            else if (argument == "--external")
+                config.external = value != "0";
+            else if (argument == "--address")
+                config.simulator.address = value;
+            else if (argument == "--port")
+                config.simulator.port = std::stoul(value);
+            else if (argument == "--addresses")
+                config.simulator.addressCount = std::clamp<size_t>(std::stoull(value), 1, 65536);
+            else if (argument == "--latency")
+            {
+                boost::container::vector<std::string> range;
+                boost::split(range, value, boost::is_any_of(","));
+                if (range.size() != 2)
+                    return false;
+
+                config.simulator.minLatency = std::stoull(range[0]);
+                config.simulator.maxLatency = std::max<size_t>(std::stoull(range[1]), config.simulator.minLatency);
+            }
+            else if (argument == "--error-rate")
+                config.simulator.errorRate = std::stod(value);
+            else if (argument == "--drop-rate")
+                config.simulator.dropRate = std::stod(value);
+            else if (argument == "--serial")
+                config.simulator.serial = value != "0";
+            else if (argument == "--json")
+                config.json = value;
+            else
+            {
+                printf("Unknown option '%s'.\n", argument.c_str());
+                return false;
+            }
+        }
+        catch (const std::exception&)
+        {
+            printf("Invalid value '%s' for option '%s'.\n", value.c_str(), argument.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkConfig config;
+    if (!ParseArguments(argc, argv, config))
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    // Start in-process simulator
+    boost::asio::io_context simulatorContext;
+    Ref<ModbusSimulator> simulator;
+    boost::thread simulatorThread;
+    if (!config.external)
+    {
+        simulator = ModbusSimulator::Create(simulatorContext, config.simulator);
+        if (simulator == nullptr)
+            return -1;
+
+        simulatorThread = boost::thread([&simulatorContext]() -> void { simulatorContext.run(); });
+    }
+
+    // Run scenarios
+    ScenarioResult results[kModbusScenario_Count];
+
+    printf("%-12s %10s %14s %12s %12s %12s %10s\n", "scenario", "count", "throughput", "p50", "p99", "p999",
+           "errors");
+    for (ModbusScenario scenario : config.scenarios)
+    {
+        ScenarioResult& result = results[scenario];
+        switch (scenario)
+        {
+        case kModbusScenario_Blocking:
+            RunBlocking(config, result);
+            break;
+        case kModbusScenario_Pipelined:
+            RunPipelined(config, result, false);
+            break;
+        case kModbusScenario_Gateway:
+            RunPipelined(config, result, true);
+            break;
+        default:
+            break;
+        }
+
+        printf("%-12s %10zu %12.0f/s %10.1fus %10.1fus %10.1fus %10zu\n", modbusScenarioNames[scenario],
+               result.recorder.GetCount(), result.recorder.GetThroughput(),
+               result.recorder.GetPercentile(50.0) / 1000.0, result.recorder.GetPercentile(99.0) / 1000.0,
+               result.recorder.GetPercentile(99.9) / 1000.0, result.errorCount);
+    }
+
+    // Stop simulator
+    if (simulator != nullptr)
+    {
+        boost::asio::post(simulatorContext, [&simulator]() -> void { simulator->Close(); });
+        simulatorThread.join();
+    }
+
+    // Write json results
+    if (!config.json.empty())
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer =
+            rapidjson::PrettyWriter<rapidjson::StringBuffer>(buffer);
+
+        writer.StartObject();
+        writer.Key("config");
+        writer.StartObject();
+        writer.Key("connections");
+        writer.Uint64(config.connectionCount);
+        writer.Key("depth");
+        writer.Uint64(config.depth);
+        writer.Key("units");
+        writer.Uint64(config.unitCount);
+        writer.Key("registers");
+        writer.Uint64(config.registerCount);
+        writer.Key("duration");
+        writer.Uint64(config.duration);
+        writer.Key("external");
+        writer.Bool(config.external);
+        writer.Key("latency");
+        writer.StartArray();
+        writer.Uint64(config.simulator.minLatency);
+        writer.Uint64(config.simulator.maxLatency);
+        writer.EndArray();
+        writer.Key("error-rate");
+        writer.Double(config.simulator.errorRate);
+        writer.Key("drop-rate");
+        writer.Double(config.simulator.dropRate);
+        writer.Key("serial");
+        writer.Bool(config.simulator.serial);
+        writer.EndObject();
+
+        writer.Key("scenarios");
+        writer.StartObject();
+        for (ModbusScenario scenario : config.scenarios)
+        {
+            writer.Key(modbusScenarioNames[scenario]);
+            writer.StartObject();
+            writer.Key("latency");
+            results[scenario].recorder.JsonGetSummary(writer);
+            writer.Key("errors");
+            writer.Uint64(results[scenario].errorCount);
+            writer.EndObject();
+        }
+        writer.EndObject();
+        writer.EndObject();
+
+        std::ofstream file = std::ofstream(config.json, std::ios::trunc);
+        if (file.is_open())
+            file.write(buffer.GetString(), buffer.GetSize());
+        else
+            LOG_ERROR("Failed to write benchmark results to '{0}'.", config.json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+target("benchmark-modbus")
+    set_kind("binary")
+    set_basename("benchmark-modbus")
+    add_files("./**.cpp", "../modbus_simulator/simulator.cpp", "../../toolkit/modbus/modbus.cpp")
+    add_packages(
+        "spdlog", 
+        "boost", 
+        "rapidjson", 
+        "robin-hood-hashing", 
+        "xxhash"
+    )
+
+    add_deps(
+        "server-common",
+        "server-scripting-native-modbus"
+    )
@@ -0,0 +1,100 @@
+#include "simulator.hpp"
+
+using namespace server;
+using namespace server::benchmark;
+
+static void PrintUsage()
+{
+    printf("Usage: modbus-simulator [options]\n"
+           "  --address <ip>      Listen address (default: 127.0.0.1)\n"
+           "  --port <n>          Listen port (default: 1502)\n"
+           "  --addresses <n>     Addresses of every table (default: 10000)\n"
+           "  --latency <min,max> Response latency range in microseconds (default: 0,0)\n"
+           "  --error-rate <r>    Fraction of requests answered with server busy (default: 0)\n"
+           "  --drop-rate <r>     Fraction of requests never answered (default: 0)\n"
+           "  --serial <0|1>      Handle one request at a time per connection (default: 0)\n");
+}
+
+static bool ParseArguments(int argc, char** argv, ModbusSimulatorConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--help" || i + 1 >= argc)
+            return false;
+
+        std::string value = argv[++i];
+
+        try
+        {
+            if (argument == "--address")
+                config.address = value;
+            else if (argument == "--port")
+                config.port = std::stoul(value);
+            else if (argument == "--addresses")
+                config.addressCount = std::clamp<size_t>(std::stoull(value), 1, 65536);
+            else if (argument == "--latency")
+            {
+                boost::container::vector<std::string> range;
+                boost::split(range, value, boost::is_any_of(","));
+                if (range.size() != 2)
+                    return false;
+
+                config.minLatency = std::stoull(range[0]);
+                config.maxLatency = std::max<size_t>(std::stoull(range[1]), config.minLatency);
+            }
+            else if (argument == "--error-rate")
+                config.errorRate = std::stod(value);
+            else if (argument == "--drop-rate")
+                config.dropRate = std::stod(value);
+            else if (argument == "--serial")
+                config.serial = value != "0";
+            else
+            {
+                printf("Unknown option '%s'.\n", argument.c_str());
+                return false;
+            }
+        }
+        catch (const std::exception&)
+        {
+            printf("Invalid value '%s' for option '%s'.\n", value.c_str(), argument.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    ModbusSimulatorConfig config;
+    if (!ParseArguments(argc, argv, config))
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    boost::asio::io_context context;
+    Ref<ModbusSimulator> simulator = ModbusSimulator::Create(context, config);
+    if (simulator == nullptr)
+        return -1;
+
+    // Run until interrupted
+    boost::asio::signal_set signals = boost::asio::signal_set(context, SIGINT, SIGTERM);
+    signals.async_wait(
+        [&simulator](const boost::system::error_code& ec, int signal) -> void
+        {
+            (void)ec;
+            (void)signal;
+
+            simulator->Close();
+        });
+
+    printf("Simulating modbus slaves on %s:%u.\n", config.address.c_str(), config.port);
+    context.run();
+
+    printf("requests: %zu, errors: %zu, dropped: %zu\n", simulator->GetRequestCount(), simulator->GetErrorCount(),
+           simulator->GetDropCount());
+
+    return 0;
+}
@@ -0,0 +1,406 @@
+#include "simulator.hpp"
+
+// Modbus functions and exceptions handled by the simulator
+#define MODBUS_READ_COILS 0x01
+#define MODBUS_READ_DISCRETE_INPUTS 0x02
+#define MODBUS_READ_HOLDING_REGISTERS 0x03
+#define MODBUS_READ_INPUT_REGISTERS 0x04
+#define MODBUS_WRITE_SINGLE_COIL 0x05
+#define MODBUS_WRITE_SINGLE_REGISTER 0x06
+#define MODBUS_WRITE_MULTIPLE_COILS 0x0F
+#define MODBUS_WRITE_MULTIPLE_REGISTERS 0x10
+
+#define MODBUS_ILLEGAL_FUNCTION 0x01
+#define MODBUS_ILLEGAL_ADDRESS 0x02
+#define MODBUS_ILLEGAL_VALUE 0x03
+#define MODBUS_SERVER_BUSY 0x06
+
+namespace server
+{
+    namespace benchmark
+    {
+        /// @brief Simulated connection
+        ///
+        class ModbusSimulator::Session : public boost::enable_shared_from_this<ModbusSimulator::Session>
+        {
+          private:
+            Ref<ModbusSimulator> simulator;
+            boost::asio::ip::tcp::socket socket;
+
+            uint8_t header[7];
+            boost::container::vector<uint8_t> request;
+
+            boost::container::deque<Ref<boost::container::vector<uint8_t>>> writeQueue;
+            bool writing = false;
+
+            void OnReadHeader(const boost::system::error_code& ec, size_t receivedBytes)
+            {
+                (void)receivedBytes;
+
+                if (ec)
+                    return;
+
+                // Verify protocol and length
+                size_t length = (size_t)header[4] << 8 | (size_t)header[5];
+                if (header[2] != 0 || header[3] != 0 || length < 2 || length > 254)
+                {
+                    Close();
+                    return;
+                }
+
+                request.assign(header, header + sizeof(header));
+                request.resize(sizeof(header) + length - 1);
+                boost::asio::async_read(socket, boost::asio::buffer(request.data() + sizeof(header), length - 1),
+                                        boost::bind(&Session::OnReadBody, shared_from_this(), boost::placeholders::_1,
+                                                    boost::placeholders::_2));
+            }
+            void OnReadBody(const boost::system::error_code& ec, size_t receivedBytes)
+            {
+                (void)receivedBytes;
+
+                if (ec)
+                    return;
+
+                Ref<boost::container::vector<uint8_t>> response =
+                    boost::make_shared<boost::container::vector<uint8_t>>();
+                size_t latency = 0;
+                bool respond = simulator->Handle(request, *response, latency);
+                if (respond)
+                {
+                    if (latency != 0)
+                    {
+                        Ref<boost::asio::steady_timer> timer = boost::make_shared<boost::asio::steady_timer>(
+                            socket.get_executor(), std::chrono::microseconds(latency));
+                        timer->async_wait(boost::bind(&Session::OnLatency, shared_from_this(), boost::placeholders::_1,
+                                                      timer, response));
+                    }
+                    else
+                        Respond(response);
+                }
+
+                // Serial sessions read the next request once the response is sent
+                if (!simulator->config.serial || !respond)
+                    Read();
+            }
+
+            void OnLatency(const boost::system::error_code& ec, const Ref<boost::asio::steady_timer>& timer,
+                           const Ref<boost::container::vector<uint8_t>>& response)
+            {
+                (void)timer; // Kept alive until it expires
+
+                if (ec)
+                    return;
+
+                Respond(response);
+            }
+
+            void Respond(const Ref<boost::container::vector<uint8_t>>& response)
+            {
+                writeQueue.push_back(response);
+                if (!writing)
+                    DoWrite();
+            }
+
+            void DoWrite()
+            {
+                writing = true;
+                boost::asio::async_write(socket,
+                                         boost::asio::buffer(writeQueue.front()->data(), writeQueue.front()->size()),
+                                         boost::bind(&Session::OnWrite, shared_from_this(), boost::placeholders::_1,
+                                                     boost::placeholders::_2));
+            }
+            void OnWrite(const boost::system::error_code& ec, size_t sentBytes)
+            {
+                (void)sentBytes;
+
+                writing = false;
+                if (ec)
+                    return;
+
+                writeQueue.pop_front();
+                if (!writeQueue.empty())
+                    DoWrite();
+
+                if (simulator->config.serial)
+                    Read();
+            }
+
+          public:
+            Session(const Ref<ModbusSimulator>& simulator)
+                : simulator(simulator), socket(simulator->context)
+            {
+            }
+
+            inline boost::asio::ip::tcp::socket& GetSocket()
+            {
+                return socket;
+            }
+
+            void Read()
+            {
+                boost::asio::async_read(socket, boost::asio::buffer(header, sizeof(header)),
+                                        boost::bind(&Session::OnReadHeader, shared_from_this(), boost::placeholders::_1,
+                                                    boost::placeholders::_2));
+            }
+
+            void Close()
+            {
+                boost::system::error_code ec;
+                socket.close(ec);
+            }
+        };
+
+        ModbusSimulator::ModbusSimulator(boost::asio::io_context& context, const ModbusSimulatorConfig& config)
+            : context(context), config(config), acceptor(context), random(1)
+        {
+        }
+        ModbusSimulator::~ModbusSimulator()
+        {
+        }
+
+        Ref<ModbusSimulator> ModbusSimulator::Create(boost::asio::io_context& context,
+                                                     const ModbusSimulatorConfig& config)
+        {
+            Ref<ModbusSimulator> simulator = boost::make_shared<ModbusSimulator>(context, config);
+            if (simulator == nullptr)
+            {
+                LOG_ERROR("Create modbus simulator.");
+                return nullptr;
+            }
+
+            boost::system::error_code ec;
+            boost::asio::ip::tcp::endpoint endpoint =
+                boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address(config.address, ec), config.port);
+            if (ec)
+            {
+                LOG_ERROR("Invalid modbus simulator address '{0}'.", config.address);
+                return nullptr;
+            }
+
+            // Step 1: Listen
+            simulator->acceptor.open(endpoint.protocol(), ec);
+            if (!ec)
+                simulator->acceptor.set_option(boost::asio::socket_base::reuse_address(true), ec);
+            if (!ec)
+                simulator->acceptor.bind(endpoint, ec);
+            if (!ec)
+                simulator->acceptor.listen(boost::asio::socket_base::max_listen_connections, ec);
+            if (ec)
+            {
+                LOG_ERROR("Listen on '{0}:{1}': {2}", config.address, config.port, ec.message());
+                return nullptr;
+            }
+
+            // Step 2: Accept connections
+            simulator->Accept();
+
+            return simulator;
+        }
+
+        void ModbusSimulator::Accept()
+        {
+            Ref<Session> session = boost::make_shared<Session>(shared_from_this());
+            acceptor.async_accept(session->GetSocket(), boost::bind(&ModbusSimulator::OnAccept, shared_from_this(),
+                                                                    boost::placeholders::_1, session));
+        }
+        void ModbusSimulator::OnAccept(const boost::system::error_code& ec, const Ref<Session>& session)
+        {
+            if (ec)
+                return;
+
+            boost::system::error_code error;
+            session->GetSocket().set_option(boost::asio::ip::tcp::no_delay(true), error);
+            session->Read();
+
+            // Forget closed sessions
+            sessionList.erase(std::remove_if(sessionList.begin(), sessionList.end(),
+                                             [](const WeakRef<Session>& sessionRef) -> bool
+                                             { return sessionRef.expired(); }),
+                              sessionList.end());
+            sessionList.push_back(session);
+
+            Accept();
+        }
+
+        ModbusSimulator::Unit& ModbusSimulator::GetUnit(uint8_t id)
+        {
+            robin_hood::unordered_node_map<uint8_t, Unit>::iterator it = unitMap.find(id);
+            if (it != unitMap.end())
+                return it->second;
+
+            Unit& unit = unitMap[id];
+            unit.coils.resize(config.addressCount, false);
+            unit.discreteInputs.resize(config.addressCount, false);
+            unit.holdingRegisters.resize(config.addressCount, 0);
+            unit.inputRegisters.resize(config.addressCount, 0);
+            for (size_t address = 0; address < config.addressCount; address++)
+            {
+                unit.discreteInputs[address] = address & 1;
+                unit.holdingRegisters[address] = (uint16_t)address;
+                unit.inputRegisters[address] = (uint16_t)address;
+            }
+
+            return unit;
+        }
+
+        bool ModbusSimulator::Handle(const boost::container::vector<uint8_t>& request,
+                                     boost::container::vector<uint8_t>& response, size_t& latency)
+        {
+            requestCount++;
+
+            // Inject errors
+            std::uniform_real_distribution<double> rateDistribution = std::uniform_real_distribution<double>(0.0, 1.0);
+            if (config.dropRate > 0.0 && rateDistribution(random) < config.dropRate)
+            {
+                dropCount++;
+                return false;
+            }
+
+            latency = config.minLatency;
+            if (config.maxLatency > config.minLatency)
+                latency = std::uniform_int_distribution<size_t>(config.minLatency, config.maxLatency)(random);
+
+            const uint8_t* pdu = request.data() + 7;
+            size_t pduSize = request.size() - 7;
+            uint8_t function = pdu[0];
+
+            // Response header (the length is set below)
+            response.assign(request.begin(), request.begin() + 7);
+            response.push_back(function);
+
+            uint8_t exception = 0;
+            if (config.errorRate > 0.0 && rateDistribution(random) < config.errorRate)
+                exception = MODBUS_SERVER_BUSY;
+            else
+            {
+                Unit& unit = GetUnit(request[6]);
+
+                uint16_t address = pduSize >= 3 ? (uint16_t)pdu[1] << 8 | (uint16_t)pdu[2] : 0;
+                uint16_t value = pduSize >= 5 ? (uint16_t)pdu[3] << 8 | (uint16_t)pdu[4] : 0;
+
+                switch (function)
+                {
+                case MODBUS_READ_COILS:
+                case MODBUS_READ_DISCRETE_INPUTS: {
+                    const boost::container::vector<bool>& bits =
+                        function == MODBUS_READ_COILS ? unit.coils : unit.discreteInputs;
+
+                    if (pduSize != 5 || value == 0 || value > 2000)
+                        exception = MODBUS_ILLEGAL_VALUE;
+                    else if ((size_t)address + value > config.addressCount)
+                        exception = MODBUS_ILLEGAL_ADDRESS;
+                    else
+                    {
+                        size_t byteCount = (value + 7) / 8;
+                        response.push_back((uint8_t)byteCount);
+                        response.resize(response.size() + byteCount, 0);
+
+                        uint8_t* data = response.data() + response.size() - byteCount;
+                        for (size_t i = 0; i < value; i++)
+                            data[i / 8] |= (uint8_t)bits[address + i] << (i % 8);
+                    }
+                }
+                break;
+                case MODBUS_READ_HOLDING_REGISTERS:
+                case MODBUS_READ_INPUT_REGISTERS: {
+                    const boost::container::vector<uint16_t>& registers =
+                        function == MODBUS_READ_HOLDING_REGISTERS ? unit.holdingRegisters : unit.inputRegisters;
+
+                    if (pduSize != 5 || value == 0 || value > 125)
+                        exception = MODBUS_ILLEGAL_VALUE;
+                    else if ((size_t)address + value > config.addressCount)
+                        exception = MODBUS_ILLEGAL_ADDRESS;
+                    else
+                    {
+                        response.push_back((uint8_t)(value * 2));
+                        for (size_t i = 0; i < value; i++)
+                        {
+                            response.push_back((uint8_t)(registers[address + i] >> 8));
+                            response.push_back((uint8_t)registers[address + i]);
+                        }
+                    }
+                }
+                break;
+                case MODBUS_WRITE_SINGLE_COIL:
+                    if (pduSize != 5 || (value != 0xFF00 && value != 0x0000))
+                        exception = MODBUS_ILLEGAL_VALUE;
+                    else if (address >= config.addressCount)
+                        exception = MODBUS_ILLEGAL_ADDRESS;
+                    else
+                    {
+                        unit.coils[address] = value == 0xFF00;
+                        response.insert(response.end(), pdu + 1, pdu + 5);
+                    }
+                    break;
+                case MODBUS_WRITE_SINGLE_REGISTER:
+                    if (pduSize != 5)
+                        exception = MODBUS_ILLEGAL_VALUE;
+                    else if (address >= config.addressCount)
+                        exception = MODBUS_ILLEGAL_ADDRESS;
+                    else
+                    {
+                        unit.holdingRegisters[address] = value;
+                        response.insert(response.end(), pdu + 1, pdu + 5);
+                    }
+                    break;
+                case MODBUS_WRITE_MULTIPLE_COILS:
+                    if (pduSize < 6 || value == 0 || value > 1968 || pdu[5] != (value + 7) / 8 ||
+                        pduSize != 6 + (size_t)pdu[5])
+                        exception = MODBUS_ILLEGAL_VALUE;
+                    else if ((size_t)address + value > config.addressCount)
+                        exception = MODBUS_ILLEGAL_ADDRESS;
+                    else
+                    {
+                        for (size_t i = 0; i < value; i++)
+                            unit.coils[address + i] = (pdu[6 + i / 8] >> (i % 8)) & 1;
+                        response.insert(response.end(), pdu + 1, pdu + 5);
+                    }
+                    break;
+                case MODBUS_WRITE_MULTIPLE_REGISTERS:
+                    if (pduSize < 6 || value == 0 || value > 123 || pdu[5] != value * 2 ||
+                        pduSize != 6 + (size_t)pdu[5])
+                        exception = MODBUS_ILLEGAL_VALUE;
+                    else if ((size_t)address + value > config.addressCount)
+                        exception = MODBUS_ILLEGAL_ADDRESS;
+                    else
+                    {
+                        for (size_t i = 0; i < value; i++)
+                            unit.holdingRegisters[address + i] = (uint16_t)pdu[6 + i * 2] << 8 | pdu[7 + i * 2];
+                        response.insert(response.end(), pdu + 1, pdu + 5);
+                    }
+                    break;
+                default:
+                    exception = MODBUS_ILLEGAL_FUNCTION;
+                    break;
+                }
+            }
+
+            if (exception != 0)
+            {
+                errorCount++;
+                response.resize(7);
+                response.push_back(function | 0x80);
+                response.push_back(exception);
+            }
+
+            size_t length = response.size() - 6;
+            response[4] = (uint8_t)(length >> 8);
+            response[5] = (uint8_t)length;
+
+            return true;
+        }
+
+        void ModbusSimulator::Close()
+        {
+            boost::system::error_code ec;
+            acceptor.close(ec);
+
+            for (const WeakRef<Session>& sessionRef : sessionList)
+            {
+                if (Ref<Session> session = sessionRef.lock())
+                    session->Close();
+            }
+            sessionList.clear();
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <common/common.hpp>
+#include <random>
+
+namespace server
+{
+    namespace benchmark
+    {
+        struct ModbusSimulatorConfig
+        {
+            std::string address = "127.0.0.1";
+            uint16_t port = 1502;
+
+            /// @brief Addresses of every table (higher addresses answer with illegal address)
+            ///
+            size_t addressCount = 10000;
+
+            /// @brief Response latency range in microseconds (uniformly distributed)
+            ///
+            size_t minLatency = 0;
+            size_t maxLatency = 0;
+
+            /// @brief Fraction of requests answered with server busy
+            ///
+            double errorRate = 0.0;
+
+            /// @brief Fraction of requests never answered
+            ///
+            double dropRate = 0.0;
+
+            /// @brief Handle one request at a time per connection (like most serial gateways)
+            ///
+            bool serial = false;
+        };
+
+        /// @brief Modbus tcp slave simulator
+        ///
+        /// Every unit id has its own coils, discrete inputs, holding and input registers. Input registers and
+        /// holding registers start with their address as value, discrete inputs with the lowest address bit, so
+        /// clients can verify what they read. Responses are delayed by the configured latency, requests of a
+        /// connection are handled concurrently unless the simulator is serial. The simulator runs on the context it
+        /// is created on, which must be run by a single thread.
+        class ModbusSimulator : public boost::enable_shared_from_this<ModbusSimulator>
+        {
+          private:
+            struct Unit
+            {
+                boost::container::vector<bool> coils;
+                boost::container::vector<bool> discreteInputs;
+                boost::container::vector<uint16_t> holdingRegisters;
+                boost::container::vector<uint16_t> inputRegisters;
+            };
+
+            class Session;
+
+            boost::asio::io_context& context;
+            ModbusSimulatorConfig config;
+
+            boost::asio::ip::tcp::acceptor acceptor;
+            boost::container::vector<WeakRef<Session>> sessionList;
+            robin_hood::unordered_node_map<uint8_t, Unit> unitMap;
+            std::mt19937 random;
+
+            size_t requestCount = 0;
+            size_t errorCount = 0;
+            size_t dropCount = 0;
+
+            void Accept();
+            void OnAccept(const boost::system::error_code& ec, const Ref<Session>& session);
+
+            Unit& GetUnit(uint8_t id);
+
+            /// @brief Handle request
+            ///
+            /// @param request Request frame (header and pdu)
+            /// @param response Response frame
+            /// @param latency Response latency in microseconds
+            /// @return False if the request is dropped
+            bool Handle(const boost::container::vector<uint8_t>& request, boost::container::vector<uint8_t>& response,
+                        size_t& latency);
+
+          public:
+            ModbusSimulator(boost::asio::io_context& context, const ModbusSimulatorConfig& config);
+            virtual ~ModbusSimulator();
+
+            /// @brief Create simulator and start listening
+            ///
+            /// @param context IO context
+            /// @param config Simulator config
+            /// @return Simulator or null if the port cannot be bound
+            static Ref<ModbusSimulator> Create(boost::asio::io_context& context, const ModbusSimulatorConfig& config);
+
+            inline const ModbusSimulatorConfig& GetConfig() const
+            {
+                return config;
+            }
+
+            inline size_t GetRequestCount() const
+            {
+                return requestCount;
+            }
+            inline size_t GetErrorCount() const
+            {
+                return errorCount;
+            }
+            inline size_t GetDropCount() const
+            {
+                return dropCount;
+            }
+
+            /// @brief Stop listening and close every connection (must be called on the context)
+            ///
+            void Close();
+        };
+    }
+}
@@ -0,0 +1,15 @@
+target("modbus-simulator")
+    set_kind("binary")
+    set_basename("modbus-simulator")
+    add_files("./**.cpp")
+    add_packages(
+        "spdlog", 
+        "boost", 
+        "rapidjson", 
+        "robin-hood-hashing", 
+        "xxhash"
+    )
+
+    add_deps(
+        "server-common"
+    )
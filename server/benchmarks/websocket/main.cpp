@@ -0,0 +1,574 @@
+#include <benchmarks/common/latency.hpp>
+#include <benchmarks/common/rate_limiter.hpp>
+#include <common/common.hpp>
+#include <cppcodec/base64_rfc4648.hpp>
+#include <pthread.h>
+#include <random>
+#include <scripting/script_source.hpp>
+#include <server/core.hpp>
+#include <time.h>
+
+using namespace server;
+using namespace server::benchmark;
+
+enum LoadMessageType
+{
+    kLoadMessageType_GetEntity,
+    kLoadMessageType_SetEntityState,
+    kLoadMessageType_SubscribeToEntityState,
+    kLoadMessageType_InvokeEntity,
+    kLoadMessageType_Count,
+};
+
+static const char* loadMessageNames[kLoadMessageType_Count] = {
+    "get-entity",
+    "set-entity-state",
+    "sub-to-entity-state",
+    "inv-entiy",
+};
+
+/// @brief Script of the synthetic devices
+///
+static const char* deviceScript = R"(
+var attributes = {};
+var properties = { power: "boolean", brightness: "number" };
+
+function toggle(parameter) {
+    properties.power = !properties.power;
+}
+)";
+
+struct LoadConfig
+{
+    size_t roomCount = 4;
+    size_t deviceCount = 64;
+    size_t clientCount = 8;
+
+    /// @brief Measured time span in seconds
+    ///
+    size_t duration = 10;
+
+    /// @brief Messages per second and client (zero for unlimited)
+    ///
+    size_t rate = 0;
+
+    /// @brief Relative weight of every message type
+    ///
+    size_t weights[kLoadMessageType_Count] = {40, 40, 10, 10};
+
+    std::string address = "127.0.0.1";
+    uint16_t port = 8090;
+
+    std::string username = "admin";
+    std::string password = "admin";
+
+    std::string json;
+};
+
+/// @brief Synchronous websocket client (one thread per client)
+///
+class LoadClient
+{
+  private:
+    const LoadConfig& config;
+    size_t index;
+
+    boost::asio::io_context context;
+    boost::beast::websocket::stream<boost::beast::tcp_stream> socket;
+    boost::beast::flat_buffer buffer;
+
+    uint64_t messageId = 0;
+
+  public:
+    LatencyRecorder recorders[kLoadMessageType_Count];
+    size_t eventCount = 0;
+    size_t errorCount = 0;
+
+    LoadClient(const LoadConfig& config, size_t index) : config(config), index(index), socket(context)
+    {
+    }
+
+    /// @brief Authenticate via /auth and open websocket
+    ///
+    /// @return Successfulness
+    bool Connect()
+    {
+        try
+        {
+            boost::asio::ip::tcp::endpoint endpoint =
+                boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address(config.address), config.port);
+
+            // Request token
+            std::string token;
+            {
+                boost::beast::tcp_stream stream = boost::beast::tcp_stream(context);
+                stream.connect(endpoint);
+
+                boost::beast::http::request<boost::beast::http::empty_body> request =
+                    boost::beast::http::request<boost::beast::http::empty_body>(boost::beast::http::verb::get,
+                                                                                "/auth", 11);
+                request.set(boost::beast::http::field::host, config.address);
+                request.set(boost::beast::http::field::authorization,
+                            "Basic " + cppcodec::base64_rfc4648::encode(config.username + ":" + config.password));
+                request.keep_alive(false);
+                boost::beast::http::write(stream, request);
+
+                boost::beast::http::response<boost::beast::http::string_body> response;
+                boost::beast::http::read(stream, buffer, response);
+                buffer.clear();
+
+                rapidjson::Document document;
+                document.Parse(response.body().data(), response.body().size());
+                if (document.HasParseError() || !document.IsObject())
+                {
+                    LOG_ERROR("Client {0}: invalid /auth response.", index);
+                    return false;
+                }
+
+                rapidjson::Value::MemberIterator tokenIt = document.FindMember("token");
+                if (tokenIt == document.MemberEnd() || !tokenIt->value.IsString())
+                {
+                    LOG_ERROR("Client {0}: authentication failed.", index);
+                    return false;
+                }
+
+                token.assign(tokenIt->value.GetString(), tokenIt->value.GetStringLength());
+
+                boost::system::error_code ec;
+                stream.socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+            }
+
+            // Open websocket
+            boost::beast::get_lowest_layer(socket).connect(endpoint);
+            socket.set_option(boost::beast::websocket::stream_base::decorator(
+                [&token](boost::beast::websocket::request_type& request) -> void
+                { request.set(boost::beast::http::field::authorization, "Bearer " + token); }));
+            socket.handshake(config.address, "/ws");
+            socket.text(true);
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("Client {0}: failed to connect.\n{1}", index, std::string(e.what()));
+            return false;
+        }
+
+        return true;
+    }
+
+    /// @brief Send request and wait for the matching response
+    ///
+    /// @param type Message type
+    /// @param request Request members (without msgid and msg)
+    void Call(LoadMessageType type, const std::string& request)
+    {
+        uint64_t id = ++messageId;
+
+        std::string message = "{\"msgid\":" + std::to_string(id) + ",\"msg\":\"" + loadMessageNames[type] + "\"";
+        if (!request.empty())
+            message += "," + request;
+        message += "}";
+
+        boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+        socket.write(boost::asio::buffer(message));
+
+        // Skip published states until the response arrives
+        while (true)
+        {
+            socket.read(buffer);
+
+            rapidjson::Document document;
+            document.Parse((const char*)buffer.data().data(), buffer.size());
+            buffer.consume(buffer.size());
+
+            if (document.HasParseError() || !document.IsObject())
+            {
+                errorCount++;
+                continue;
+            }
+
+            rapidjson::Value::MemberIterator messageIdIt = document.FindMember("msgid");
+            if (messageIdIt == document.MemberEnd() || !messageIdIt->value.IsUint64() ||
+                messageIdIt->value.GetUint64() != id)
+            {
+                eventCount++;
+                continue;
+            }
+
+            recorders[type].Record(begin, boost::chrono::steady_clock::now());
+
+            rapidjson::Value::MemberIterator messageIt = document.FindMember("msg");
+            if (messageIt == document.MemberEnd() || !messageIt->value.IsString() ||
+                strcmp(messageIt->value.GetString(), "ack") != 0)
+                errorCount++;
+
+            return;
+        }
+    }
+
+    /// @brief Send mixed traffic until the deadline
+    ///
+    /// @param deadline End of the measurement
+    /// @param devices Device ids
+    void Run(boost::chrono::steady_clock::time_point deadline, const boost::container::vector<identifier_t>& devices)
+    {
+        std::mt19937 random = std::mt19937(index + 1);
+        std::discrete_distribution<size_t> typeDistribution =
+            std::discrete_distribution<size_t>(std::begin(config.weights), std::end(config.weights));
+        std::uniform_int_distribution<size_t> deviceDistribution =
+            std::uniform_int_distribution<size_t>(0, devices.size() - 1);
+
+        RateLimiter limiter = RateLimiter(config.rate);
+
+        for (LatencyRecorder& recorder : recorders)
+            recorder.Start();
+
+        try
+        {
+            while (boost::chrono::steady_clock::now() < deadline)
+            {
+                limiter.Wait();
+
+                LoadMessageType type = (LoadMessageType)typeDistribution(random);
+                std::string id = std::to_string(devices[deviceDistribution(random)]);
+
+                switch (type)
+                {
+                case kLoadMessageType_GetEntity:
+                case kLoadMessageType_SubscribeToEntityState:
+                    Call(type, "\"id\":" + id);
+                    break;
+                case kLoadMessageType_SetEntityState:
+                    Call(type, "\"id\":" + id + ",\"state\":{\"power\":" + (random() % 2 ? "true" : "false") +
+                                   ",\"brightness\":" + std::to_string(random() % 256) + "}");
+                    break;
+                case kLoadMessageType_InvokeEntity:
+                    Call(type, "\"id\":" + id + ",\"method\":\"toggle\",\"parameter\":null");
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+        catch (const std::exception& e)
+        {
+            LOG_ERROR("Client {0}: connection failed.\n{1}", index, std::string(e.what()));
+            errorCount++;
+        }
+
+        for (LatencyRecorder& recorder : recorders)
+            recorder.Stop();
+    }
+
+    /// @brief Close websocket
+    ///
+    void Close()
+    {
+        boost::system::error_code ec;
+        socket.close(boost::beast::websocket::close_code::normal, ec);
+    }
+};
+
+/// @brief Create rooms and devices with a javascript test script
+///
+/// @param config Load config
+/// @param devices Created device ids
+/// @return Successfulness
+static bool CreateHome(const LoadConfig& config, boost::container::vector<identifier_t>& devices)
+{
+    Ref<scripting::ScriptManager> scriptManager = scripting::ScriptManager::GetInstance();
+    assert(scriptManager != nullptr);
+
+    Ref<main::Home> home = main::Home::GetInstance();
+    assert(home != nullptr);
+
+    // Script source
+    Ref<scripting::ScriptSource> scriptSource =
+        scriptManager->AddScriptSource(scripting::ScriptLanguage::kJSScriptLanguage, "benchmark device");
+    if (scriptSource == nullptr)
+    {
+        LOG_ERROR("Failed to add script source.");
+        return false;
+    }
+    scriptSource->SetContent(deviceScript);
+    scriptSource->SaveContent();
+
+    // Rooms
+    boost::container::vector<identifier_t> rooms;
+    for (size_t i = 0; i < config.roomCount; i++)
+    {
+        Ref<main::Entity> room = home->AddEntity(main::EntityType::kRoomEntityType, "Room " + std::to_string(i + 1),
+                                                 0, rapidjson::Value(rapidjson::kObjectType));
+        if (room == nullptr)
+        {
+            LOG_ERROR("Failed to add room.");
+            return false;
+        }
+        rooms.push_back(room->GetID());
+    }
+
+    // Devices
+    for (size_t i = 0; i < config.deviceCount; i++)
+    {
+        rapidjson::Document attributesJson = rapidjson::Document(rapidjson::kObjectType);
+        if (!rooms.empty())
+            attributesJson.AddMember("roomid", rapidjson::Value(rooms[i % rooms.size()]),
+                                     attributesJson.GetAllocator());
+
+        Ref<main::Entity> device =
+            home->AddEntity(main::EntityType::kDeviceEntityType, "Device " + std::to_string(i + 1),
+                            scriptSource->GetID(), attributesJson);
+        if (device == nullptr)
+        {
+            LOG_ERROR("Failed to add device.");
+            return false;
+        }
+        devices.push_back(device->GetID());
+    }
+
+    return true;
+}
+
+/// @brief Get cpu time of a thread
+///
+/// @param thread Thread
+/// @return Cpu time in nanoseconds
+static uint64_t GetThreadCpuTime(boost::thread& thread)
+{
+    clockid_t clock;
+    if (pthread_getcpuclockid(thread.native_handle(), &clock) != 0)
+        return 0;
+
+    struct timespec time;
+    if (clock_gettime(clock, &time) != 0)
+        return 0;
+
+    return (uint64_t)time.tv_sec * 1000000000ull + time.tv_nsec;
+}
+
+static void PrintUsage()
+{
+    printf("Usage: benchmark-websocket [options]\n"
+           "  --rooms <n>         Room count (default: 4)\n"
+           "  --devices <n>       Device count (default: 64)\n"
+           "  --clients <n>       Websocket clients (default: 8)\n"
+           "  --duration <s>      Measured time span in seconds (default: 10)\n"
+           "  --rate <n>          Messages per second and client, 0 for unlimited (default: 0)\n"
+           "  --mix <g,s,u,i>     Weights of get-entity, set-entity-state, sub-to-entity-state and inv-entiy\n"
+           "                      (default: 40,40,10,10)\n"
+           "  --address <ip>      Server address (default: 127.0.0.1)\n"
+           "  --port <n>          Server port (default: 8090)\n"
+           "  --json <file>       Write results as json\n");
+}
+
+static bool ParseArguments(int argc, char** argv, LoadConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--help" || i + 1 >= argc)
+            return false;
+
+        std::string value = argv[++i];
+
+        try
+        {
+            if (argument == "--rooms")
+                config.roomCount = std::stoull(value);
+            else if (argument == "--devices")
+                config.deviceCount = std::max<size_t>(std::stoull(value), 1);
+            else if (argument == "--clients")
+                config.clientCount = std::max<size_t>(std::stoull(value), 1);
+            else if (argument == "--duration")
+                config.duration = std::stoull(value);
+            else if (argument == "--rate")
+                config.rate = std::stoull(value);
+            else if (argument == "--mix")
+            {
+                boost::container::vector<std::string> weights;
+                boost::split(weights, value, boost::is_any_of(","));
+                if (weights.size() != kLoadMessageType_Count)
+                    return false;
+
+                size_t sum = 0;
+                for (size_t j = 0; j < kLoadMessageType_Count; j++)
+                    sum += config.weights[j] = std::stoull(weights[j]);
+                if (sum == 0)
+                    return false;
+            }
+            else if (argument == "--address")
+                config.address = value;
+            else if (argument == "--port")
+                config.port = std::stoul(value);
+            else if (argument == "--json")
+                config.json = value;
+            else
+            {
+                printf("Unknown option '%s'.\n", argument.c_str());
+                return false;
+            }
+        }
+        catch (const std::exception&)
+        {
+            printf("Invalid value '%s' for option '%s'.\n", value.c_str(), argument.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    LoadConfig config;
+    if (!ParseArguments(argc, argv, config))
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    boost::filesystem::create_directories(config::GetDataDirectory());
+    boost::filesystem::create_directories(config::GetScriptDirectory());
+    boost::filesystem::create_directories(config::GetLogDirectory());
+    Log::Create();
+
+    // Start in-process server with a fresh in-memory database
+    CoreConfig coreConfig;
+    coreConfig.name = "benchmark";
+    coreConfig.database.type = DatabaseType::kMemoryDatabaseType;
+    coreConfig.networking.address = config.address;
+    coreConfig.networking.port = config.port;
+    coreConfig.networking.externalURL = config.address;
+
+    Ref<Core> core = Core::Create(coreConfig);
+    if (core == nullptr)
+    {
+        LOG_ERROR("Failed to create core.");
+        return -1;
+    }
+
+    boost::container::vector<identifier_t> devices;
+    if (!CreateHome(config, devices))
+        return -1;
+
+    boost::thread coreThread = boost::thread([core]() -> void { core->Run(); });
+
+    // Connect clients
+    boost::container::vector<Ref<LoadClient>> clients;
+    for (size_t i = 0; i < config.clientCount; i++)
+    {
+        Ref<LoadClient> client = boost::make_shared<LoadClient>(config, i);
+        if (!client->Connect())
+        {
+            core->Shutdown();
+            coreThread.join();
+            return -1;
+        }
+        clients.push_back(client);
+    }
+
+    // Run load
+    uint64_t cpuBegin = GetThreadCpuTime(coreThread);
+    boost::chrono::steady_clock::time_point deadline =
+        boost::chrono::steady_clock::now() + boost::chrono::seconds(config.duration);
+    {
+        boost::thread_group clientThreads;
+        for (const Ref<LoadClient>& client : clients)
+            clientThreads.create_thread([&client, deadline, &devices]() -> void { client->Run(deadline, devices); });
+        clientThreads.join_all();
+    }
+    uint64_t cpuEnd = GetThreadCpuTime(coreThread);
+
+    for (const Ref<LoadClient>& client : clients)
+        client->Close();
+
+    // Merge results
+    LatencyRecorder recorders[kLoadMessageType_Count];
+    LatencyRecorder total;
+    size_t eventCount = 0;
+    size_t errorCount = 0;
+    for (const Ref<LoadClient>& client : clients)
+    {
+        for (size_t i = 0; i < kLoadMessageType_Count; i++)
+        {
+            recorders[i].Merge(client->recorders[i]);
+            total.Merge(client->recorders[i]);
+        }
+        eventCount += client->eventCount;
+        errorCount += client->errorCount;
+    }
+
+    double cpuPerMessage = total.GetCount() != 0 ? (double)(cpuEnd - cpuBegin) / total.GetCount() / 1000.0 : 0.0;
+
+    printf("%-22s %10s %14s %12s %12s %12s\n", "message", "count", "throughput", "p50", "p99", "p999");
+    for (size_t i = 0; i < kLoadMessageType_Count; i++)
+    {
+        printf("%-22s %10zu %12.0f/s %10.1fus %10.1fus %10.1fus\n", loadMessageNames[i], recorders[i].GetCount(),
+               recorders[i].GetThroughput(), recorders[i].GetPercentile(50.0) / 1000.0,
+               recorders[i].GetPercentile(99.0) / 1000.0, recorders[i].GetPercentile(99.9) / 1000.0);
+    }
+    printf("%-22s %10zu %12.0f/s %10.1fus %10.1fus %10.1fus\n", "total", total.GetCount(), total.GetThroughput(),
+           total.GetPercentile(50.0) / 1000.0, total.GetPercentile(99.0) / 1000.0,
+           total.GetPercentile(99.9) / 1000.0);
+    printf("server cpu per message: %.1fus, published states: %zu, errors: %zu\n", cpuPerMessage, eventCount,
+           errorCount);
+
+    // Write json results
+    if (!config.json.empty())
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer =
+            rapidjson::PrettyWriter<rapidjson::StringBuffer>(buffer);
+
+        writer.StartObject();
+        writer.Key("config");
+        writer.StartObject();
+        writer.Key("rooms");
+        writer.Uint64(config.roomCount);
+        writer.Key("devices");
+        writer.Uint64(config.deviceCount);
+        writer.Key("clients");
+        writer.Uint64(config.clientCount);
+        writer.Key("duration");
+        writer.Uint64(config.duration);
+        writer.Key("rate");
+        writer.Uint64(config.rate);
+        writer.Key("mix");
+        writer.StartArray();
+        for (size_t weight : config.weights)
+            writer.Uint64(weight);
+        writer.EndArray();
+        writer.EndObject();
+
+        writer.Key("messages");
+        writer.StartObject();
+        for (size_t i = 0; i < kLoadMessageType_Count; i++)
+        {
+            writer.Key(loadMessageNames[i]);
+            recorders[i].JsonGetSummary(writer);
+        }
+        writer.EndObject();
+
+        writer.Key("total");
+        total.JsonGetSummary(writer);
+        writer.Key("server-cpu-per-message");
+        writer.Double(cpuPerMessage);
+        writer.Key("published-states");
+        writer.Uint64(eventCount);
+        writer.Key("errors");
+        writer.Uint64(errorCount);
+        writer.EndObject();
+
+        std::ofstream file = std::ofstream(config.json, std::ios::trunc);
+        if (file.is_open())
+            file.write(buffer.GetString(), buffer.GetSize());
+        else
+            LOG_ERROR("Failed to write benchmark results to '{0}'.", config.json);
+    }
+
+    // Stop server
+    core->Shutdown();
+    coreThread.join();
+    core = nullptr;
+
+    return errorCount == 0 ? 0 : -1;
+}
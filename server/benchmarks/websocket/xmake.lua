@@ -0,0 +1,23 @@
+target("benchmark-websocket")
+    set_kind("binary")
+    set_basename("benchmark-websocket")
+    add_files("./**.cpp", "../../server/core.cpp", "../../server/core_backup.cpp")
+    add_packages(
+        "spdlog", 
+        "openssl", 
+        "boost", 
+        "rapidjson", 
+        "robin-hood-hashing", 
+        "xxhash",
+        "cppcodec"
+    )
+
+    add_deps(
+        "server-common",
+        "server-database",
+        "server-main",
+        "server-scripting",
+        "server-scripting-javascript",
+        "server-scripting-native",
+        "server-api"
+    )
\ No newline at end of file
@@ -33,6 +33,16 @@ namespace server
             return GetRootDirectory() / "data";
         }
 
+        /// @brief Directory in which database backups are stored
+        /// @note A running backup needs free space of up to twice the database size (an uncompressed snapshot is
+        /// written next to the compressed backup)
+        ///
+        /// @return Directory path
+        inline boost::filesystem::path GetBackupDirectory()
+        {
+            return GetDataDirectory() / "backups";
+        }
+
         /// @brief Directory in which native scripts are stored
         ///
         /// @return Directory path
@@ -13,6 +13,7 @@
 
 // Container
 #include <boost/algorithm/string.hpp>
+#include <boost/container/deque.hpp>
 #include <boost/container/list.hpp>
 #include <boost/container/set.hpp>
 #include <boost/container/vector.hpp>
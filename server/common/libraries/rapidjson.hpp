@@ -7,6 +7,9 @@
 #include <rapidjson/writer.h>
 #include <rapidjson/istreamwrapper.h>
 #include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/stringbuffer.h>
+#include <cstring>
+#include <string_view>
 #define RAPIDJSON_BUFFER_SIZE_SMALL 1000
 #define RAPIDJSON_BUFFER_SIZE_MEDIUM 50000
 #define RAPIDJSON_BUFFER_SIZE_LARGE 100000
@@ -16,4 +19,46 @@ namespace rapidjson
 {
     typedef GenericDocument<UTF8<>, CrtAllocator> CrtDocument;
     typedef GenericValue<UTF8<>, CrtAllocator> CrtValue;
+}
+
+// Raw json splicing
+namespace rapidjson
+{
+    /// @brief Get members of a serialized json object without the enclosing braces
+    ///
+    /// @param object Serialized json object
+    /// @return std::string_view Members or empty if object is invalid
+    inline std::string_view GetRawMembers(const std::string_view& object)
+    {
+        size_t begin = object.find_first_not_of(" \t\r\n");
+        size_t end = object.find_last_not_of(" \t\r\n");
+        if (begin == std::string_view::npos || object[begin] != '{' || object[end] != '}')
+            return std::string_view();
+
+        std::string_view members = object.substr(begin + 1, end - begin - 1);
+
+        // Trim whitespaces
+        begin = members.find_first_not_of(" \t\r\n");
+        if (begin == std::string_view::npos)
+            return std::string_view();
+        end = members.find_last_not_of(" \t\r\n");
+
+        return members.substr(begin, end - begin + 1);
+    }
+
+    /// @brief Append serialized members to an object that is currently written into the buffer
+    /// @note Bypasses the writer, so only call between two complete members
+    ///
+    /// @param buffer Output buffer
+    /// @param members Serialized members (without braces)
+    /// @param comma Prepend separator
+    inline void PutRawMembers(StringBuffer& buffer, const std::string_view& members, bool comma)
+    {
+        if (members.empty())
+            return;
+
+        if (comma)
+            buffer.Put(',');
+        std::memcpy(buffer.Push(members.size()), members.data(), members.size());
+    }
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "metrics.hpp"
+
+namespace server
+{
+    namespace metrics
+    {
+        std::string MakeLabel(const std::string_view& name, const std::string_view& value)
+        {
+            std::string label;
+            label.reserve(name.size() + value.size() + 3);
+
+            label.append(name);
+            label += "=\"";
+            for (char c : value)
+            {
+                switch (c)
+                {
+                case '\\':
+                    label += "\\\\";
+                    break;
+                case '"':
+                    label += "\\\"";
+                    break;
+                case '\n':
+                    label += "\\n";
+                    break;
+                default:
+                    label += c;
+                    break;
+                }
+            }
+            label += '"';
+
+            return label;
+        }
+
+        Registry& Registry::GetInstance()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        Ref<Registry::Family> Registry::GetFamily(const std::string& name, const std::string& help, MetricType type)
+        {
+            for (const auto& [familyName, family] : familyList)
+            {
+                if (familyName == name)
+                {
+                    assert(family->type == type);
+                    return family;
+                }
+            }
+
+            Ref<Family> family = boost::make_shared<Family>();
+            family->type = type;
+            family->help = help;
+            familyList.push_back(std::make_pair(name, family));
+
+            return family;
+        }
+
+        template <typename T>
+        static T& GetMetric(boost::container::vector<std::pair<std::string, Ref<T>>>& metricList,
+                            const std::string& labels)
+        {
+            for (const auto& [metricLabels, metric] : metricList)
+            {
+                if (metricLabels == labels)
+                    return *metric;
+            }
+
+            Ref<T> metric = boost::make_shared<T>();
+            metricList.push_back(std::make_pair(labels, metric));
+
+            return *metric;
+        }
+
+        Counter& Registry::GetCounter(const std::string& name, const std::string& help, const std::string& labels)
+        {
+            boost::lock_guard lock(mutex);
+            return GetMetric(GetFamily(name, help, MetricType::kCounterMetricType)->counters, labels);
+        }
+        Gauge& Registry::GetGauge(const std::string& name, const std::string& help, const std::string& labels)
+        {
+            boost::lock_guard lock(mutex);
+            return GetMetric(GetFamily(name, help, MetricType::kGaugeMetricType)->gauges, labels);
+        }
+        Histogram& Registry::GetHistogram(const std::string& name, const std::string& help, const std::string& labels)
+        {
+            boost::lock_guard lock(mutex);
+            return GetMetric(GetFamily(name, help, MetricType::kHistogramMetricType)->histograms, labels);
+        }
+
+        static void WriteSeries(std::string& output, const std::string& name, const std::string_view& suffix,
+                                const std::string& labels, const std::string_view& extraLabel)
+        {
+            output += name;
+            output += suffix;
+            if (!labels.empty() || !extraLabel.empty())
+            {
+                output += '{';
+                output += labels;
+                if (!labels.empty() && !extraLabel.empty())
+                    output += ',';
+                output += extraLabel;
+                output += '}';
+            }
+            output += ' ';
+        }
+
+        void Registry::Write(std::string& output)
+        {
+            boost::lock_guard lock(mutex);
+
+            char number[32];
+
+            for (const auto& [name, family] : familyList)
+            {
+                output += "# HELP " + name + " " + family->help + "\n";
+
+                switch (family->type)
+                {
+                case MetricType::kCounterMetricType:
+                    output += "# TYPE " + name + " counter\n";
+                    for (const auto& [labels, counter] : family->counters)
+                    {
+                        WriteSeries(output, name, "", labels, "");
+                        output += std::to_string(counter->Get()) + "\n";
+                    }
+                    break;
+                case MetricType::kGaugeMetricType:
+                    output += "# TYPE " + name + " gauge\n";
+                    for (const auto& [labels, gauge] : family->gauges)
+                    {
+                        WriteSeries(output, name, "", labels, "");
+                        output += std::to_string(gauge->Get()) + "\n";
+                    }
+                    break;
+                case MetricType::kHistogramMetricType:
+                    output += "# TYPE " + name + " histogram\n";
+                    for (const auto& [labels, histogram] : family->histograms)
+                    {
+                        // Cumulative buckets at fixed bounds, so the series do not change when buckets get their
+                        // first values (the last bucket is unbounded)
+                        uint64_t count = 0;
+                        for (size_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKET_COUNT - 1; bucket++)
+                        {
+                            count += histogram->GetBucketCount(bucket);
+
+                            uint64_t bound = Histogram::GetUpperBound(bucket);
+                            if ((bound & (bound - 1)) != 0 || bound < (1ull << METRICS_HISTOGRAM_MIN_OUTPUT_EXPONENT))
+                                continue;
+
+                            snprintf(number, sizeof(number), "le=\"%.9g\"", bound / 1000000000.0);
+                            WriteSeries(output, name, "_bucket", labels, number);
+                            output += std::to_string(count) + "\n";
+                        }
+                        count += histogram->GetBucketCount(METRICS_HISTOGRAM_BUCKET_COUNT - 1);
+
+                        WriteSeries(output, name, "_bucket", labels, "le=\"+Inf\"");
+                        output += std::to_string(count) + "\n";
+
+                        snprintf(number, sizeof(number), "%.9g", histogram->GetSum() / 1000000000.0);
+                        WriteSeries(output, name, "_sum", labels, "");
+                        output += number;
+                        output += "\n";
+
+                        WriteSeries(output, name, "_count", labels, "");
+                        output += std::to_string(count) + "\n";
+                    }
+                    break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include "common.hpp"
+
+// Histogram buckets: four exact buckets for values below 4, then four linear sub-buckets per power of two up to 2^40
+#define METRICS_HISTOGRAM_SUB_BUCKETS 4
+#define METRICS_HISTOGRAM_MAX_EXPONENT 40
+#define METRICS_HISTOGRAM_BUCKET_COUNT                                                                                 \
+    (METRICS_HISTOGRAM_SUB_BUCKETS + (METRICS_HISTOGRAM_MAX_EXPONENT - 2) * METRICS_HISTOGRAM_SUB_BUCKETS)
+
+// Exposed histogram bounds: every power of two from 2^10 nanoseconds (about a microsecond)
+#define METRICS_HISTOGRAM_MIN_OUTPUT_EXPONENT 10
+
+namespace server
+{
+    namespace metrics
+    {
+        /// @brief Monotonic counter
+        ///
+        class Counter
+        {
+          private:
+            boost::atomic<uint64_t> value = 0;
+
+          public:
+            inline void Increment(uint64_t n = 1)
+            {
+                value.fetch_add(n, boost::memory_order_relaxed);
+            }
+
+            inline uint64_t Get() const
+            {
+                return value.load(boost::memory_order_relaxed);
+            }
+        };
+
+        /// @brief Value that can go up and down (e.g. active sessions, queue depth)
+        ///
+        class Gauge
+        {
+          private:
+            boost::atomic<int64_t> value = 0;
+
+          public:
+            inline void Increment(int64_t n = 1)
+            {
+                value.fetch_add(n, boost::memory_order_relaxed);
+            }
+
+            inline void Decrement(int64_t n = 1)
+            {
+                value.fetch_sub(n, boost::memory_order_relaxed);
+            }
+
+            inline void Set(int64_t v)
+            {
+                value.store(v, boost::memory_order_relaxed);
+            }
+
+            inline int64_t Get() const
+            {
+                return value.load(boost::memory_order_relaxed);
+            }
+        };
+
+        /// @brief Log-linear histogram of durations in nanoseconds (exposed in seconds)
+        ///
+        /// Observing a value increments its bucket and adds it to the sum, the count is derived from the buckets.
+        class Histogram
+        {
+          private:
+            boost::atomic<uint64_t> buckets[METRICS_HISTOGRAM_BUCKET_COUNT] = {};
+            boost::atomic<uint64_t> sum = 0;
+
+          public:
+            /// @brief Get bucket of a value
+            ///
+            /// @param value Value
+            /// @return Bucket index
+            static inline size_t GetBucket(uint64_t value)
+            {
+                if (value < METRICS_HISTOGRAM_SUB_BUCKETS)
+                    return value;
+
+                size_t exponent = 63 - __builtin_clzll(value);
+                if (exponent >= METRICS_HISTOGRAM_MAX_EXPONENT)
+                    return METRICS_HISTOGRAM_BUCKET_COUNT - 1;
+
+                return METRICS_HISTOGRAM_SUB_BUCKETS + (exponent - 2) * METRICS_HISTOGRAM_SUB_BUCKETS +
+                       ((value >> (exponent - 2)) & (METRICS_HISTOGRAM_SUB_BUCKETS - 1));
+            }
+
+            /// @brief Get exclusive upper bound of a bucket
+            ///
+            /// @param bucket Bucket index
+            /// @return Upper bound
+            static inline uint64_t GetUpperBound(size_t bucket)
+            {
+                if (bucket < METRICS_HISTOGRAM_SUB_BUCKETS)
+                    return bucket + 1;
+
+                size_t exponent = (bucket - METRICS_HISTOGRAM_SUB_BUCKETS) / METRICS_HISTOGRAM_SUB_BUCKETS + 2;
+                size_t subBucket = (bucket - METRICS_HISTOGRAM_SUB_BUCKETS) % METRICS_HISTOGRAM_SUB_BUCKETS;
+                return (METRICS_HISTOGRAM_SUB_BUCKETS + subBucket + 1) << (exponent - 2);
+            }
+
+            /// @brief Observe value
+            ///
+            /// @param nanoseconds Duration in nanoseconds
+            inline void Observe(uint64_t nanoseconds)
+            {
+                buckets[GetBucket(nanoseconds)].fetch_add(1, boost::memory_order_relaxed);
+                sum.fetch_add(nanoseconds, boost::memory_order_relaxed);
+            }
+
+            /// @brief Observe duration since a time point
+            ///
+            /// @param begin Begin of the measured duration
+            inline void ObserveSince(boost::chrono::steady_clock::time_point begin)
+            {
+                Observe(boost::chrono::duration_cast<boost::chrono::nanoseconds>(boost::chrono::steady_clock::now() -
+                                                                                 begin)
+                            .count());
+            }
+
+            inline uint64_t GetBucketCount(size_t bucket) const
+            {
+                return buckets[bucket].load(boost::memory_order_relaxed);
+            }
+
+            inline uint64_t GetSum() const
+            {
+                return sum.load(boost::memory_order_relaxed);
+            }
+        };
+
+        /// @brief Format label pair (value is escaped)
+        ///
+        /// @param name Label name
+        /// @param value Label value
+        /// @return Formatted label
+        std::string MakeLabel(const std::string_view& name, const std::string_view& value);
+
+        /// @brief Process wide metrics registry
+        ///
+        /// Metrics are created once and never removed, so references returned by the registry stay valid. Looking
+        /// up a metric takes a lock, hot paths keep the reference (e.g. in a function local static).
+        class Registry
+        {
+          private:
+            enum class MetricType
+            {
+                kCounterMetricType,
+                kGaugeMetricType,
+                kHistogramMetricType,
+            };
+
+            struct Family
+            {
+                MetricType type;
+                std::string help;
+                boost::container::vector<std::pair<std::string, Ref<Counter>>> counters;
+                boost::container::vector<std::pair<std::string, Ref<Gauge>>> gauges;
+                boost::container::vector<std::pair<std::string, Ref<Histogram>>> histograms;
+            };
+
+            boost::mutex mutex;
+            boost::container::vector<std::pair<std::string, Ref<Family>>> familyList;
+
+            Ref<Family> GetFamily(const std::string& name, const std::string& help, MetricType type);
+
+          public:
+            /// @brief Get registry instance (lives for the whole process)
+            ///
+            /// @return Registry
+            static Registry& GetInstance();
+
+            /// @brief Get or create counter
+            ///
+            /// @param name Metric name
+            /// @param help Metric description
+            /// @param labels Formatted labels (see MakeLabel, comma separated)
+            /// @return Counter
+            Counter& GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+
+            /// @brief Get or create gauge
+            ///
+            /// @param name Metric name
+            /// @param help Metric description
+            /// @param labels Formatted labels (see MakeLabel, comma separated)
+            /// @return Gauge
+            Gauge& GetGauge(const std::string& name, const std::string& help, const std::string& labels = "");
+
+            /// @brief Get or create histogram
+            ///
+            /// @param name Metric name (should end with _seconds)
+            /// @param help Metric description
+            /// @param labels Formatted labels (see MakeLabel, comma separated)
+            /// @return Histogram
+            Histogram& GetHistogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+            /// @brief Write metrics in the prometheus text format
+            ///
+            /// @param output Output
+            void Write(std::string& output);
+        };
+    }
+}
@@ -1,7 +1,64 @@
 #include "worker.hpp"
+#include "metrics.hpp"
 
 namespace server
 {
+    std::string StringifyWorkerHandlerKind(WorkerHandlerKind kind)
+    {
+        switch (kind)
+        {
+        case WorkerHandlerKind::kWebSocketWorkerHandlerKind:
+            return "websocket";
+        case WorkerHandlerKind::kHttpWorkerHandlerKind:
+            return "http";
+        case WorkerHandlerKind::kScriptWorkerHandlerKind:
+            return "script";
+        case WorkerHandlerKind::kTimerWorkerHandlerKind:
+            return "timer";
+        case WorkerHandlerKind::kDatabaseWorkerHandlerKind:
+            return "database";
+        case WorkerHandlerKind::kPublisherWorkerHandlerKind:
+            return "publisher";
+        default:
+            return "unknown";
+        }
+    }
+
+    /// @brief Get duration histogram of a handler kind
+    ///
+    /// @param kind Handler kind
+    /// @return Histogram
+    static metrics::Histogram& GetHandlerHistogram(WorkerHandlerKind kind)
+    {
+        static const std::array<metrics::Histogram*, (size_t)WorkerHandlerKind::kWorkerHandlerKindCount> histograms =
+            []() -> std::array<metrics::Histogram*, (size_t)WorkerHandlerKind::kWorkerHandlerKindCount>
+        {
+            std::array<metrics::Histogram*, (size_t)WorkerHandlerKind::kWorkerHandlerKindCount> histograms;
+            for (size_t i = 0; i < histograms.size(); i++)
+            {
+                histograms[i] = &metrics::Registry::GetInstance().GetHistogram(
+                    "home_worker_handler_duration_seconds", "Duration of worker handlers by kind",
+                    metrics::MakeLabel("kind", StringifyWorkerHandlerKind((WorkerHandlerKind)i)));
+            }
+            return histograms;
+        }();
+
+        return *histograms[(size_t)kind];
+    }
+
+    WorkerHandlerScope::~WorkerHandlerScope()
+    {
+        boost::chrono::nanoseconds duration = boost::chrono::steady_clock::now() - begin;
+        GetHandlerHistogram(kind).Observe(duration.count());
+
+        if (duration > boost::chrono::milliseconds(WORKER_HANDLER_WARNING_THRESHOLD))
+        {
+            LOG_WARNING("Worker handler {0} '{1}' (id {2}) blocked the worker for {3}ms.",
+                        StringifyWorkerHandlerKind(kind), std::string(name), id,
+                        boost::chrono::duration_cast<boost::chrono::milliseconds>(duration).count());
+        }
+    }
+
     WeakRef<Worker> instanceWorker;
 
     Worker::Worker() : running(false)
@@ -38,6 +95,14 @@ namespace server
             return nullptr;
         }
 
+        // Initialize heartbeat
+        worker->heartbeatTimer = boost::make_shared<boost::asio::steady_timer>(worker->GetContext());
+        if (worker->heartbeatTimer == nullptr)
+        {
+            LOG_ERROR("Create worker heartbeat timer.");
+            return nullptr;
+        }
+
         return worker;
     }
 
@@ -54,6 +119,10 @@ namespace server
 
             LOG_INFO("Starting worker.");
 
+            heartbeatTimer->expires_after(WORKER_HEARTBEAT_INTERVAL);
+            heartbeatTimer->async_wait(
+                boost::bind(&Worker::WaitHeartbeatTimer, WeakRef<Worker>(shared_from_this()), boost::placeholders::_1));
+
             while (running)
             {
                 try
@@ -71,6 +140,34 @@ namespace server
         }
     }
 
+    void Worker::WaitHeartbeatTimer(const WeakRef<Worker>& workerRef, const boost::system::error_code& ec)
+    {
+        static metrics::Histogram& lagHistogram = metrics::Registry::GetInstance().GetHistogram(
+            "home_worker_lag_seconds", "Delay between the scheduled and the actual worker heartbeat");
+
+        if (ec)
+            return;
+
+        Ref<Worker> worker = workerRef.lock();
+        if (worker == nullptr)
+            return;
+
+        // Time the heartbeat waited in the queue after its expiry
+        boost::asio::steady_timer::time_point now = boost::asio::steady_timer::clock_type::now();
+        std::chrono::nanoseconds lag = now - worker->heartbeatTimer->expiry();
+        lagHistogram.Observe(lag.count());
+
+        if (lag > std::chrono::milliseconds(WORKER_HANDLER_WARNING_THRESHOLD))
+        {
+            LOG_WARNING("Worker lagged {0}ms behind its heartbeat.",
+                        std::chrono::duration_cast<std::chrono::milliseconds>(lag).count());
+        }
+
+        worker->heartbeatTimer->expires_at(now + WORKER_HEARTBEAT_INTERVAL);
+        worker->heartbeatTimer->async_wait(
+            boost::bind(&Worker::WaitHeartbeatTimer, workerRef, boost::placeholders::_1));
+    }
+
     void Worker::Stop()
     {
         if (running)
@@ -1,8 +1,52 @@
 #pragma once
 #include "common.hpp"
 
+// Interval of the heartbeat measuring the scheduling lag of the worker
+#define WORKER_HEARTBEAT_INTERVAL std::chrono::milliseconds(100)
+
+// Handlers (and heartbeat lags) exceeding this duration (in milliseconds) are logged
+#define WORKER_HANDLER_WARNING_THRESHOLD 100
+
 namespace server
 {
+    enum class WorkerHandlerKind
+    {
+        kWebSocketWorkerHandlerKind,
+        kHttpWorkerHandlerKind,
+        kScriptWorkerHandlerKind,
+        kTimerWorkerHandlerKind,
+        kDatabaseWorkerHandlerKind,
+        kPublisherWorkerHandlerKind,
+        kWorkerHandlerKindCount,
+    };
+
+    std::string StringifyWorkerHandlerKind(WorkerHandlerKind kind);
+
+    /// @brief Measures a handler running on the worker
+    ///
+    /// The duration is recorded per handler kind, handlers exceeding the warning threshold are logged with their
+    /// origin. Scopes may be nested (e.g. a script invoked by a websocket message), each scope is measured on its own.
+    class WorkerHandlerScope
+    {
+      private:
+        WorkerHandlerKind kind;
+        std::string_view name;
+        identifier_t id;
+        boost::chrono::steady_clock::time_point begin;
+
+      public:
+        /// @brief Start measuring a handler
+        ///
+        /// @param kind Handler kind
+        /// @param name Handler name (e.g. message type or method name, must outlive the scope)
+        /// @param id Related object id (e.g. script source or entity id)
+        WorkerHandlerScope(WorkerHandlerKind kind, const std::string_view& name, identifier_t id = 0)
+            : kind(kind), name(name), id(id), begin(boost::chrono::steady_clock::now())
+        {
+        }
+        ~WorkerHandlerScope();
+    };
+
     class Worker : public boost::enable_shared_from_this<Worker>
     {
       private:
@@ -18,6 +62,12 @@ namespace server
         ///
         Ref<boost::asio::io_context::work> work = nullptr;
 
+        /// @brief Heartbeat timer
+        ///
+        Ref<boost::asio::steady_timer> heartbeatTimer = nullptr;
+
+        static void WaitHeartbeatTimer(const WeakRef<Worker>& workerRef, const boost::system::error_code& ec);
+
       public:
         Worker();
         virtual ~Worker();
@@ -38,6 +88,23 @@ namespace server
             return running;
         }
 
+        /// @brief Post measured handler
+        ///
+        /// @param kind Handler kind
+        /// @param name Handler name (string literal)
+        /// @param id Related object id
+        /// @param handler Handler
+        template <typename Handler>
+        inline void Post(WorkerHandlerKind kind, const char* name, identifier_t id, Handler&& handler)
+        {
+            boost::asio::post(*context,
+                              [kind, name, id, handler = std::forward<Handler>(handler)]() mutable -> void
+                              {
+                                  WorkerHandlerScope scope(kind, name, id);
+                                  handler();
+                              });
+        }
+
         /// @brief Start worker
         ///
         void Run();
@@ -0,0 +1,303 @@
+#include "binary_state.hpp"
+#include <scripting_sdk/message_buffer.hpp>
+#include <cfloat>
+#include <cmath>
+
+#define BINARY_STATE_MAX_DEPTH (32)
+
+namespace server
+{
+    template <typename T>
+    static inline void WriteFixed(std::string& output, FieldType type, T value)
+    {
+        output.push_back((char)type);
+        output.append((const char*)&value, sizeof(T));
+    }
+
+    static inline void WriteLength(std::string& output, size_t length)
+    {
+        // LEB128
+        do
+        {
+            uint8_t byte = length & 0x7F;
+            length >>= 7;
+            if (length != 0)
+                byte |= 0x80;
+            output.push_back((char)byte);
+        } while (length != 0);
+    }
+
+    void EncodeBinaryState(const rapidjson::Value& input, std::string& output)
+    {
+        switch (input.GetType())
+        {
+        case rapidjson::kNullType:
+            output.push_back((char)FieldType::kNull);
+            break;
+        case rapidjson::kFalseType:
+            output.push_back((char)FieldType::kFalse);
+            break;
+        case rapidjson::kTrueType:
+            output.push_back((char)FieldType::kTrue);
+            break;
+        case rapidjson::kNumberType:
+            if (input.IsUint64())
+            {
+                uint64_t value = input.GetUint64();
+                if (value <= UINT8_MAX)
+                    WriteFixed<uint8_t>(output, FieldType::kUint8, value);
+                else if (value <= UINT16_MAX)
+                    WriteFixed<uint16_t>(output, FieldType::kUint16, value);
+                else if (value <= UINT32_MAX)
+                    WriteFixed<uint32_t>(output, FieldType::kUint32, value);
+                else
+                    WriteFixed<uint64_t>(output, FieldType::kUint64, value);
+            }
+            else if (input.IsInt64())
+            {
+                int64_t value = input.GetInt64();
+                if (value >= INT8_MIN)
+                    WriteFixed<int8_t>(output, FieldType::kInt8, value);
+                else if (value >= INT16_MIN)
+                    WriteFixed<int16_t>(output, FieldType::kInt16, value);
+                else if (value >= INT32_MIN)
+                    WriteFixed<int32_t>(output, FieldType::kInt32, value);
+                else
+                    WriteFixed<int64_t>(output, FieldType::kInt64, value);
+            }
+            else
+            {
+                double value = input.GetDouble();
+                if (std::fabs(value) <= FLT_MAX && (double)(float)value == value)
+                    WriteFixed<float>(output, FieldType::kSingle, value);
+                else
+                    WriteFixed<double>(output, FieldType::kDouble, value);
+            }
+            break;
+        case rapidjson::kStringType:
+            output.push_back((char)FieldType::kString);
+            WriteLength(output, input.GetStringLength());
+            output.append(input.GetString(), input.GetStringLength());
+            break;
+        case rapidjson::kArrayType:
+            output.push_back((char)FieldType::kArray);
+            WriteLength(output, input.Size());
+            for (rapidjson::Value::ConstValueIterator it = input.Begin(); it != input.End(); it++)
+                EncodeBinaryState(*it, output);
+            break;
+        case rapidjson::kObjectType:
+            output.push_back((char)FieldType::kStructure);
+            WriteLength(output, input.MemberCount());
+            for (rapidjson::Value::ConstMemberIterator memberIt = input.MemberBegin(); memberIt != input.MemberEnd();
+                 memberIt++)
+            {
+                WriteLength(output, memberIt->name.GetStringLength());
+                output.append(memberIt->name.GetString(), memberIt->name.GetStringLength());
+                EncodeBinaryState(memberIt->value, output);
+            }
+            break;
+        }
+    }
+
+    class BinaryStateReader
+    {
+      private:
+        const std::string_view input;
+        size_t position = 0;
+
+      public:
+        BinaryStateReader(const std::string_view& input) : input(input)
+        {
+        }
+
+        inline bool IsEnd() const
+        {
+            return position == input.size();
+        }
+
+        template <typename T>
+        inline bool ReadFixed(T& value)
+        {
+            if (input.size() - position < sizeof(T))
+                return false;
+
+            std::memcpy(&value, input.data() + position, sizeof(T));
+            position += sizeof(T);
+            return true;
+        }
+
+        inline bool ReadLength(size_t& length)
+        {
+            length = 0;
+            for (uint8_t shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t byte;
+                if (!ReadFixed(byte))
+                    return false;
+
+                length |= (size_t)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+        inline bool ReadString(const char*& data, size_t& length)
+        {
+            if (!ReadLength(length) || input.size() - position < length)
+                return false;
+
+            data = input.data() + position;
+            position += length;
+            return true;
+        }
+
+        bool ReadValue(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator, size_t depth)
+        {
+            if (depth > BINARY_STATE_MAX_DEPTH)
+                return false;
+
+            uint8_t tag;
+            if (!ReadFixed(tag))
+                return false;
+
+            switch ((FieldType)tag)
+            {
+            case FieldType::kNull:
+                output.SetNull();
+                return true;
+            case FieldType::kFalse:
+                output.SetBool(false);
+                return true;
+            case FieldType::kTrue:
+                output.SetBool(true);
+                return true;
+            case FieldType::kInt8: {
+                int8_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetInt(value);
+                return true;
+            }
+            case FieldType::kInt16: {
+                int16_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetInt(value);
+                return true;
+            }
+            case FieldType::kInt32: {
+                int32_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetInt(value);
+                return true;
+            }
+            case FieldType::kInt64: {
+                int64_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetInt64(value);
+                return true;
+            }
+            case FieldType::kUint8: {
+                uint8_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetUint(value);
+                return true;
+            }
+            case FieldType::kUint16: {
+                uint16_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetUint(value);
+                return true;
+            }
+            case FieldType::kUint32: {
+                uint32_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetUint(value);
+                return true;
+            }
+            case FieldType::kUint64: {
+                uint64_t value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetUint64(value);
+                return true;
+            }
+            case FieldType::kSingle: {
+                float value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetDouble(value);
+                return true;
+            }
+            case FieldType::kDouble: {
+                double value;
+                if (!ReadFixed(value))
+                    return false;
+                output.SetDouble(value);
+                return true;
+            }
+            case FieldType::kString: {
+                const char* data;
+                size_t length;
+                if (!ReadString(data, length))
+                    return false;
+                output.SetString(data, length, allocator);
+                return true;
+            }
+            case FieldType::kArray: {
+                size_t count;
+                if (!ReadLength(count) || count > input.size() - position)
+                    return false;
+
+                output.SetArray();
+                output.Reserve(count, allocator);
+                for (size_t i = 0; i < count; i++)
+                {
+                    rapidjson::Value value;
+                    if (!ReadValue(value, allocator, depth + 1))
+                        return false;
+                    output.PushBack(value, allocator);
+                }
+                return true;
+            }
+            case FieldType::kStructure: {
+                size_t count;
+                if (!ReadLength(count) || count > input.size() - position)
+                    return false;
+
+                output.SetObject();
+                output.MemberReserve(count, allocator);
+                for (size_t i = 0; i < count; i++)
+                {
+                    const char* name;
+                    size_t nameLength;
+                    if (!ReadString(name, nameLength))
+                        return false;
+
+                    rapidjson::Value value;
+                    if (!ReadValue(value, allocator, depth + 1))
+                        return false;
+                    output.AddMember(rapidjson::Value(name, nameLength, allocator), value, allocator);
+                }
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+    };
+
+    bool DecodeBinaryState(const std::string_view& input, rapidjson::Value& output,
+                           rapidjson::Document::AllocatorType& allocator)
+    {
+        BinaryStateReader reader = BinaryStateReader(input);
+        return reader.ReadValue(output, allocator, 0) && reader.IsEnd();
+    }
+}
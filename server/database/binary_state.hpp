@@ -0,0 +1,21 @@
+#pragma once
+#include "common.hpp"
+
+namespace server
+{
+    /// @brief Encode json value into a compact binary representation
+    /// @note Every value is prefixed with its FieldType tag (see scripting_sdk/message_buffer.hpp)
+    ///
+    /// @param input Json value
+    /// @param output Binary output
+    void EncodeBinaryState(const rapidjson::Value& input, std::string& output);
+
+    /// @brief Decode binary representation into json value
+    ///
+    /// @param input Binary input
+    /// @param output Json value
+    /// @param allocator Json allocator
+    /// @return Successfulness
+    bool DecodeBinaryState(const std::string_view& input, rapidjson::Value& output,
+                           rapidjson::Document::AllocatorType& allocator);
+}
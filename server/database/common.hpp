@@ -1,2 +1,4 @@
 #pragma once
-#include <common/common.hpp>
\ No newline at end of file
+#include <common/common.hpp>
+
+#include <future>
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "database.hpp"
+#include <array>
 #include "empty/empty_database.hpp"
+#include "memory/memory_database.hpp"
 #include "sqlite/sqlite_database.hpp"
+#include <common/metrics.hpp>
+#include <common/worker.hpp>
 
 namespace server
 {
@@ -12,6 +16,8 @@ namespace server
             return "sqlite";
         case DatabaseType::kEmptyDatabaseType:
             return "empty";
+        case DatabaseType::kMemoryDatabaseType:
+            return "memory";
         default:
             return "unknown";
         }
@@ -24,11 +30,30 @@ namespace server
             return DatabaseType::kSQLiteDatabaseType;
         case CRC32("empty"):
             return DatabaseType::kEmptyDatabaseType;
+        case CRC32("memory"):
+            return DatabaseType::kMemoryDatabaseType;
         default:
             return DatabaseType::kUnknownDatabaseType;
         }
     }
 
+    std::string StringifyDatabaseBackupStatus(DatabaseBackupStatus status)
+    {
+        switch (status)
+        {
+        case DatabaseBackupStatus::kCopyingDatabaseBackupStatus:
+            return "copying";
+        case DatabaseBackupStatus::kCompressingDatabaseBackupStatus:
+            return "compressing";
+        case DatabaseBackupStatus::kFinishedDatabaseBackupStatus:
+            return "finished";
+        case DatabaseBackupStatus::kFailedDatabaseBackupStatus:
+            return "failed";
+        default:
+            return "unknown";
+        }
+    }
+
     WeakRef<Database> instanceDatabase;
 
     Database::Database()
@@ -36,10 +61,11 @@ namespace server
     }
     Database::~Database()
     {
+        StopIO();
     }
 
     Ref<Database> Database::Create(DatabaseType type, const std::string& db, const std::string& username,
-                                   const std::string& password)
+                                   const std::string& password, const std::string& pragmas)
     {
         // Currently not in use, but will later be used to authenticate to databases such as postgres, etc...
         (void)username;
@@ -54,19 +80,31 @@ namespace server
         switch (type)
         {
         case DatabaseType::kSQLiteDatabaseType:
-            database = SQLiteDatabase::Create(db);
+            database = SQLiteDatabase::Create(db, pragmas);
             break;
         case DatabaseType::kEmptyDatabaseType:
             database = EmptyDatabase::Create();
             break;
+        case DatabaseType::kMemoryDatabaseType:
+            database = MemoryDatabase::Create(db);
+            break;
         default:
             database = nullptr;
             break;
         }
 
+        if (database == nullptr)
+            return nullptr;
+
+        // Start database thread
+        if (!database->StartIO())
+        {
+            LOG_ERROR("Failed to start database thread.");
+            return nullptr;
+        }
+
         // Assign singleton reference
-        if (database != nullptr)
-            instanceDatabase = database;
+        instanceDatabase = database;
 
         return database;
     }
@@ -74,4 +112,182 @@ namespace server
     {
         return Ref<Database>(instanceDatabase);
     }
+
+    bool Database::StartIO()
+    {
+        // Initialize context
+        ioContext = boost::make_shared<boost::asio::io_context>(1);
+        if (ioContext == nullptr)
+            return false;
+
+        // Initialize notifier
+        ioWork = boost::make_shared<boost::asio::io_context::work>(*ioContext);
+        if (ioWork == nullptr)
+            return false;
+
+        ioThread = boost::thread(
+            [context = ioContext]() -> void
+            {
+                while (true)
+                {
+                    try
+                    {
+                        context->run();
+                        break;
+                    }
+                    catch (const std::exception& e)
+                    {
+                        LOG_ERROR("Database thread failed.\n{0}", std::string(e.what()));
+                    }
+                }
+            });
+
+        return true;
+    }
+    void Database::StopIO()
+    {
+        if (ioWork == nullptr)
+            return;
+
+        // Let the context run out of work and wait for the pending writes
+        ioWork = nullptr;
+        if (ioThread.joinable() && ioThread.get_id() != boost::this_thread::get_id())
+            ioThread.join();
+
+        ioContext = nullptr;
+    }
+
+    /// @brief Get duration histogram of an asynchronous write operation
+    ///
+    /// @param operation Operation name
+    /// @return Histogram
+    static metrics::Histogram& GetWriteHistogram(const char* operation)
+    {
+        return metrics::Registry::GetInstance().GetHistogram("home_database_write_duration_seconds",
+                                                             "Duration of asynchronous database writes",
+                                                             metrics::MakeLabel("operation", operation));
+    }
+
+    void Database::PostWrite(metrics::Histogram& histogram, boost::function<bool()>&& task,
+                             const boost::function<void(bool)>& callback)
+    {
+        static metrics::Gauge& queueDepth = metrics::Registry::GetInstance().GetGauge(
+            "home_database_write_queue_depth", "Pending asynchronous database writes");
+
+        // Execute synchronously once the database thread is stopped
+        if (ioWork == nullptr)
+        {
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            bool result = task();
+            histogram.ObserveSince(begin);
+
+            if (callback)
+                callback(result);
+            return;
+        }
+
+        queueDepth.Increment();
+        boost::asio::post(*ioContext,
+                          [&histogram, task = std::move(task), callback]() -> void
+                          {
+                              queueDepth.Decrement();
+
+                              boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+                              bool result = task();
+                              histogram.ObserveSince(begin);
+
+                              if (callback)
+                              {
+                                  Ref<Worker> worker = Worker::GetInstance();
+                                  if (worker != nullptr)
+                                      worker->Post(WorkerHandlerKind::kDatabaseWorkerHandlerKind, "write-callback", 0,
+                                                   boost::bind(callback, result));
+                              }
+                          });
+    }
+
+    //! Asynchronous writes
+
+    void Database::UpdateScriptSourceAsync(identifier_t id, const std::string& name, const std::string_view& config,
+                                           const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("update-script-source");
+        PostWrite(histogram, [this, id, name, config = std::string(config)]() -> bool
+                  { return UpdateScriptSource(id, name, config); },
+                  callback);
+    }
+    void Database::UpdateScriptSourceContentAsync(identifier_t id, const std::string_view& newValue,
+                                                  const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("update-script-source-content");
+        PostWrite(histogram, [this, id, newValue = std::string(newValue)]() -> bool
+                  { return UpdateScriptSourceContent(id, newValue); },
+                  callback);
+    }
+    void Database::RemoveScriptSourceAsync(identifier_t id, const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("remove-script-source");
+        PostWrite(histogram, [this, id]() -> bool { return RemoveScriptSource(id); }, callback);
+    }
+
+    void Database::UpdateEntityAsync(identifier_t id, const std::string& name, identifier_t scriptSourceId,
+                                     const std::string_view& attributes, const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("update-entity");
+        PostWrite(histogram, [this, id, name, scriptSourceId, attributes = std::string(attributes)]() -> bool
+                  { return UpdateEntity(id, name, scriptSourceId, attributes); },
+                  callback);
+    }
+    void Database::UpdateEntityStateAsync(identifier_t id, const std::string_view& state,
+                                          const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("update-entity-state");
+        PostWrite(histogram, [this, id, state = std::string(state)]() -> bool { return UpdateEntityState(id, state); },
+                  callback);
+    }
+    void Database::RemoveEntityAsync(identifier_t id, const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("remove-entity");
+        PostWrite(histogram, [this, id]() -> bool { return RemoveEntity(id); }, callback);
+    }
+
+    void Database::AddHistoryBlockAsync(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                        int64_t begin, int64_t end, size_t count, const std::string_view& data,
+                                        const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("add-history-block");
+        PostWrite(histogram, [this, entityId, property, resolution, begin, end, count, data = std::string(data)]() -> bool
+                  { return AddHistoryBlock(entityId, property, resolution, begin, end, count, data); },
+                  callback);
+    }
+    void Database::RemoveHistoryAsync(identifier_t entityId, const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("remove-history");
+        PostWrite(histogram, [this, entityId]() -> bool { return RemoveHistory(entityId); }, callback);
+    }
+
+    void Database::UpdateUserAccessLevelAsync(identifier_t id, const std::string& newValue,
+                                              const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("update-user-access-level");
+        PostWrite(histogram, [this, id, newValue]() -> bool { return UpdateUserAccessLevel(id, newValue); }, callback);
+    }
+    void Database::UpdateUserHashAsync(identifier_t id, uint8_t hash[SHA256_SIZE], uint8_t salt[SALT_SIZE],
+                                       const boost::function<void(bool)>& callback)
+    {
+        std::array<uint8_t, SHA256_SIZE> hashCopy;
+        std::array<uint8_t, SALT_SIZE> saltCopy;
+        memcpy(hashCopy.data(), hash, SHA256_SIZE);
+        memcpy(saltCopy.data(), salt, SALT_SIZE);
+
+        static metrics::Histogram& histogram = GetWriteHistogram("update-user-hash");
+        PostWrite(histogram, [this, id, hashCopy, saltCopy]() mutable -> bool
+                  { return UpdateUserHash(id, hashCopy.data(), saltCopy.data()); },
+                  callback);
+    }
+    void Database::RemoveUserAsync(identifier_t id, const boost::function<void(bool)>& callback)
+    {
+        static metrics::Histogram& histogram = GetWriteHistogram("remove-user");
+        PostWrite(histogram, [this, id]() -> bool { return RemoveUser(id); }, callback);
+    }
 }
\ No newline at end of file
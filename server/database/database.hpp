@@ -3,18 +3,101 @@
 
 namespace server
 {
+    namespace metrics
+    {
+        class Histogram;
+    }
+
     enum class DatabaseType
     {
         kUnknownDatabaseType,
         kEmptyDatabaseType,
         kSQLiteDatabaseType,
+        kMemoryDatabaseType,
     };
 
     std::string StringifyDatabaseType(DatabaseType type);
     DatabaseType ParseDatabaseType(const std::string& type);
 
+    enum class DatabaseBackupStatus
+    {
+        kCopyingDatabaseBackupStatus,
+        kCompressingDatabaseBackupStatus,
+        kFinishedDatabaseBackupStatus,
+        kFailedDatabaseBackupStatus,
+    };
+
+    std::string StringifyDatabaseBackupStatus(DatabaseBackupStatus status);
+
+    /// @brief Backup progress callback
+    ///
+    /// @param status Backup status
+    /// @param progress Copied pages or compressed bytes
+    /// @param total Total pages or bytes
+    using DatabaseBackupCallback = boost::function<void(DatabaseBackupStatus status, size_t progress, size_t total)>;
+
     class Database : public boost::enable_shared_from_this<Database>
     {
+      private:
+        /// @brief IO Context of the database thread
+        ///
+        Ref<boost::asio::io_context> ioContext = nullptr;
+
+        /// @brief IO Work (keeps the database thread alive)
+        ///
+        Ref<boost::asio::io_context::work> ioWork = nullptr;
+
+        /// @brief Database thread
+        ///
+        boost::thread ioThread;
+
+        /// @brief Run write task on the database thread
+        ///
+        /// @param histogram Duration histogram of the operation
+        /// @param task Task
+        /// @param callback Result callback (called on the worker)
+        void PostWrite(metrics::Histogram& histogram, boost::function<bool()>&& task,
+                       const boost::function<void(bool)>& callback);
+
+      protected:
+        /// @brief Get IO context of the database thread
+        ///
+        /// @return IO context
+        inline boost::asio::io_context& GetIOContext()
+        {
+            return *ioContext;
+        }
+
+        /// @brief Run task on the database thread and wait for its result
+        ///
+        /// The task runs after the pending writes, so it never interleaves with them on the write connection.
+        ///
+        /// @param task Task
+        /// @return Result of the task
+        template <class T>
+        T RunSync(const boost::function<T()>& task)
+        {
+            // Execute directly once the database thread is stopped (or when already on it)
+            if (ioWork == nullptr || ioThread.get_id() == boost::this_thread::get_id())
+                return task();
+
+            Ref<std::promise<T>> promise = boost::make_shared<std::promise<T>>();
+            std::future<T> future = promise->get_future();
+            boost::asio::post(*ioContext, [promise, task]() -> void { promise->set_value(task()); });
+
+            return future.get();
+        }
+
+        /// @brief Start database thread
+        ///
+        /// @return Successfulness
+        bool StartIO();
+
+        /// @brief Execute pending writes and stop database thread
+        ///
+        /// Has to be called by backends before closing their connections.
+        void StopIO();
+
       public:
         Database();
         virtual ~Database();
@@ -22,18 +105,47 @@ namespace server
         /// @brief Create database instance
         ///
         /// @param type Database type
-        /// @param db Database location
+        /// @param db Database location (snapshot file of memory databases, empty to disable snapshots)
         /// @param username Username (optional)
         /// @param password Password (optional)
+        /// @param pragmas Connection pragmas of sqlite databases (optional, empty for the defaults)
         /// @return Database singleton
         static Ref<Database> Create(DatabaseType type, const std::string& db = "home.sqlite3",
-                                    const std::string& username = "", const std::string& password = "");
+                                    const std::string& username = "", const std::string& password = "",
+                                    const std::string& pragmas = "");
 
         /// @brief Get database instance
         ///
         /// @return Database singleton
         static Ref<Database> GetInstance();
 
+        //! Asynchronous writes
+        //! Executed in order on the database thread, the callbacks are posted to the worker.
+
+        void UpdateScriptSourceAsync(identifier_t id, const std::string& name, const std::string_view& config,
+                                     const boost::function<void(bool)>& callback = {});
+        void UpdateScriptSourceContentAsync(identifier_t id, const std::string_view& newValue,
+                                            const boost::function<void(bool)>& callback = {});
+        void RemoveScriptSourceAsync(identifier_t id, const boost::function<void(bool)>& callback = {});
+
+        void UpdateEntityAsync(identifier_t id, const std::string& name, identifier_t scriptSourceId,
+                               const std::string_view& attributes,
+                               const boost::function<void(bool)>& callback = {});
+        void UpdateEntityStateAsync(identifier_t id, const std::string_view& state,
+                                    const boost::function<void(bool)>& callback = {});
+        void RemoveEntityAsync(identifier_t id, const boost::function<void(bool)>& callback = {});
+
+        void AddHistoryBlockAsync(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                  int64_t begin, int64_t end, size_t count, const std::string_view& data,
+                                  const boost::function<void(bool)>& callback = {});
+        void RemoveHistoryAsync(identifier_t entityId, const boost::function<void(bool)>& callback = {});
+
+        void UpdateUserAccessLevelAsync(identifier_t id, const std::string& newValue,
+                                        const boost::function<void(bool)>& callback = {});
+        void UpdateUserHashAsync(identifier_t id, uint8_t hash[SHA256_SIZE], uint8_t salt[SALT_SIZE],
+                                 const boost::function<void(bool)>& callback = {});
+        void RemoveUserAsync(identifier_t id, const boost::function<void(bool)>& callback = {});
+
         //! ScriptSource
 
         /// @brief Load script sources from database
@@ -80,18 +192,19 @@ namespace server
 
         /// @brief Load entities from database
         ///
-        /// @param callback Entry callback
+        /// @param callback Entry callback (views are only valid during the call, state is binary, see
+        /// DecodeBinaryState)
         /// @return Successfulness
         virtual bool LoadEntities(
-            const boost::function<bool(identifier_t id, const std::string& entityType, const std::string& name,
+            const boost::function<bool(identifier_t id, uint8_t type, const std::string_view& name,
                                        identifier_t scriptSourceID, const std::string_view& attributes,
                                        const std::string_view& state)>& callback) = 0;
 
         /// @brief Reserve entity entry in database
         ///
-        /// @param type Entity type
+        /// @param type Entity type (numeric value of main::EntityType)
         /// @return identifier_t Entity id or zero if reservation failed
-        virtual identifier_t ReserveEntity(const std::string& type) = 0;
+        virtual identifier_t ReserveEntity(uint8_t type) = 0;
 
         /// @brief Update entity without pushing to history
         ///
@@ -106,7 +219,7 @@ namespace server
         /// @brief Update entity state
         ///
         /// @param id Entity data
-        /// @param stat State
+        /// @param state Binary state (see EncodeBinaryState)
         /// @return Successfulness
         virtual bool UpdateEntityState(identifier_t id, const std::string_view& state) = 0;
 
@@ -121,6 +234,41 @@ namespace server
         /// @return size_t Entity count
         virtual size_t GetEntityCount() = 0;
 
+        //! History
+
+        /// @brief Add compressed history block
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param begin Timestamp of the first sample
+        /// @param end Timestamp of the last sample
+        /// @param count Sample count
+        /// @param data Compressed samples
+        /// @return Successfulness
+        virtual bool AddHistoryBlock(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                     int64_t begin, int64_t end, size_t count, const std::string_view& data) = 0;
+
+        /// @brief Load history blocks overlapping a time range
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param from Range begin
+        /// @param to Range end
+        /// @param callback Block callback (ordered by begin)
+        /// @return Successfulness
+        virtual bool LoadHistoryBlocks(
+            identifier_t entityId, const std::string& property, uint8_t resolution, int64_t from, int64_t to,
+            const boost::function<void(int64_t begin, int64_t end, size_t count, const std::string_view& data)>&
+                callback) = 0;
+
+        /// @brief Remove history of an entity
+        ///
+        /// @param entityId Entity id
+        /// @return Successfulness
+        virtual bool RemoveHistory(identifier_t entityId) = 0;
+
         //! User
 
         /// @brief Load users from database
@@ -162,5 +310,19 @@ namespace server
         ///
         /// @return size_t User count
         virtual size_t GetUserCount() = 0;
+
+        //! Backup
+
+        /// @brief Start online backup into a gzip compressed file
+        ///
+        /// The database is copied in small steps on the database thread, so writes are only delayed by single steps.
+        /// @note The copy is an uncompressed snapshot next to the output, which is compressed once the copy is
+        /// complete (pages copied earlier may still change). A backup therefore needs free space of up to twice the
+        /// database size while it runs.
+        ///
+        /// @param path Output file
+        /// @param callback Progress callback (called on the worker)
+        /// @return Backup was started (false if not supported or already running)
+        virtual bool Backup(const std::string& path, const DatabaseBackupCallback& callback) = 0;
     };
 }
\ No newline at end of file
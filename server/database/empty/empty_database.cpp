@@ -7,6 +7,7 @@ namespace server
     }
     EmptyDatabase::~EmptyDatabase()
     {
+        StopIO();
     }
     Ref<EmptyDatabase> EmptyDatabase::Create()
     {
@@ -54,7 +55,7 @@ namespace server
     }
 
     bool EmptyDatabase::LoadEntities(
-        const boost::function<bool(identifier_t id, const std::string& entityType, const std::string& name,
+        const boost::function<bool(identifier_t id, uint8_t type, const std::string_view& name,
                                    identifier_t scriptSourceID, const std::string_view& attributes,
                                    const std::string_view& state)>& callback)
     {
@@ -62,7 +63,7 @@ namespace server
         return true;
     }
 
-    identifier_t EmptyDatabase::ReserveEntity(const std::string& type)
+    identifier_t EmptyDatabase::ReserveEntity(uint8_t type)
     {
         (void)type;
         return ++entityIdCounter;
@@ -96,6 +97,38 @@ namespace server
         return 0;
     }
 
+    bool EmptyDatabase::AddHistoryBlock(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                        int64_t begin, int64_t end, size_t count, const std::string_view& data)
+    {
+        (void)entityId;
+        (void)property;
+        (void)resolution;
+        (void)begin;
+        (void)end;
+        (void)count;
+        (void)data;
+        return true;
+    }
+
+    bool EmptyDatabase::LoadHistoryBlocks(
+        identifier_t entityId, const std::string& property, uint8_t resolution, int64_t from, int64_t to,
+        const boost::function<void(int64_t begin, int64_t end, size_t count, const std::string_view& data)>& callback)
+    {
+        (void)entityId;
+        (void)property;
+        (void)resolution;
+        (void)from;
+        (void)to;
+        (void)callback;
+        return true;
+    }
+
+    bool EmptyDatabase::RemoveHistory(identifier_t entityId)
+    {
+        (void)entityId;
+        return true;
+    }
+
     bool EmptyDatabase::LoadUsers(
         const boost::function<void(identifier_t id, const std::string& name, uint8_t hash[SHA256_SIZE],
                                    uint8_t salt[SALT_SIZE], const std::string& accessLevel)>& callback)
@@ -130,4 +163,11 @@ namespace server
     {
         return 0;
     }
+
+    bool EmptyDatabase::Backup(const std::string& path, const DatabaseBackupCallback& callback)
+    {
+        (void)path;
+        (void)callback;
+        return false;
+    }
 }
\ No newline at end of file
@@ -62,18 +62,19 @@ namespace server
 
         /// @brief Load entities from database
         ///
-        /// @param callback Entry callback
+        /// @param callback Entry callback (views are only valid during the call, state is binary, see
+        /// DecodeBinaryState)
         /// @return Successfulness
         virtual bool LoadEntities(
-            const boost::function<bool(identifier_t id, const std::string& entityType, const std::string& name,
+            const boost::function<bool(identifier_t id, uint8_t type, const std::string_view& name,
                                        identifier_t scriptSourceID, const std::string_view& attributes,
                                        const std::string_view& state)>& callback) override;
 
         /// @brief Reserve entity entry in database
         ///
-        /// @param type Entity type
+        /// @param type Entity type (numeric value of main::EntityType)
         /// @return identifier_t Entity id or zero if reservation failed
-        virtual identifier_t ReserveEntity(const std::string& type) override;
+        virtual identifier_t ReserveEntity(uint8_t type) override;
 
         /// @brief Update entity without pushing to history
         ///
@@ -88,7 +89,7 @@ namespace server
         /// @brief Update entity state
         ///
         /// @param id Entity data
-        /// @param stat State
+        /// @param state Binary state (see EncodeBinaryState)
         /// @return Successfulness
         virtual bool UpdateEntityState(identifier_t id, const std::string_view& state) override;
 
@@ -103,6 +104,41 @@ namespace server
         /// @return size_t Entity count
         virtual size_t GetEntityCount() override;
 
+        //! History
+
+        /// @brief Add compressed history block
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param begin Timestamp of the first sample
+        /// @param end Timestamp of the last sample
+        /// @param count Sample count
+        /// @param data Compressed samples
+        /// @return Successfulness
+        virtual bool AddHistoryBlock(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                     int64_t begin, int64_t end, size_t count, const std::string_view& data) override;
+
+        /// @brief Load history blocks overlapping a time range
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param from Range begin
+        /// @param to Range end
+        /// @param callback Block callback (ordered by begin)
+        /// @return Successfulness
+        virtual bool LoadHistoryBlocks(
+            identifier_t entityId, const std::string& property, uint8_t resolution, int64_t from, int64_t to,
+            const boost::function<void(int64_t begin, int64_t end, size_t count, const std::string_view& data)>&
+                callback) override;
+
+        /// @brief Remove history of an entity
+        ///
+        /// @param entityId Entity id
+        /// @return Successfulness
+        virtual bool RemoveHistory(identifier_t entityId) override;
+
         //! User
 
         /// @brief Load users from database
@@ -144,5 +180,14 @@ namespace server
         ///
         /// @return size_t User count
         virtual size_t GetUserCount() override;
+
+        //! Backup
+
+        /// @brief Start online backup into a gzip compressed file
+        ///
+        /// @param path Output file
+        /// @param callback Progress callback (called on the worker)
+        /// @return Backup was started (false if not supported or already running)
+        virtual bool Backup(const std::string& path, const DatabaseBackupCallback& callback) override;
     };
 }
\ No newline at end of file
@@ -0,0 +1,590 @@
+#include "memory_database.hpp"
+#include <common/worker.hpp>
+#include <zlib.h>
+
+#define MEMORY_DATABASE_MAGIC "HMDB"
+#define MEMORY_DATABASE_VERSION 2
+
+namespace server
+{
+    //! Snapshot encoding (native byte order, snapshots are not portable between architectures)
+
+    template <typename T>
+    static void WriteValue(std::string& output, T value)
+    {
+        output.append((const char*)&value, sizeof(T));
+    }
+    static void WriteString(std::string& output, const std::string_view& value)
+    {
+        WriteValue<uint32_t>(output, value.size());
+        output.append(value.data(), value.size());
+    }
+
+    class SnapshotReader
+    {
+      private:
+        std::string_view input;
+        size_t offset = 0;
+
+      public:
+        SnapshotReader(const std::string_view& input) : input(input)
+        {
+        }
+
+        template <typename T>
+        bool Read(T& value)
+        {
+            if (input.size() - offset < sizeof(T))
+                return false;
+            memcpy(&value, input.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+        bool Read(void* value, size_t size)
+        {
+            if (input.size() - offset < size)
+                return false;
+            memcpy(value, input.data() + offset, size);
+            offset += size;
+            return true;
+        }
+        bool ReadString(std::string& value)
+        {
+            uint32_t size;
+            if (!Read(size) || input.size() - offset < size)
+                return false;
+            value.assign(input.data() + offset, size);
+            offset += size;
+            return true;
+        }
+    };
+
+    /// @brief Find id of the next reservation (same as the sql reservation: first id after an existing one that is
+    /// not in use, or one if the table is empty)
+    template <typename T>
+    static identifier_t FindFreeId(const robin_hood::unordered_flat_map<identifier_t, T>& map)
+    {
+        identifier_t id = 0;
+        for (const auto& [key, value] : map)
+        {
+            if ((id == 0 || key + 1 < id) && map.count(key + 1) == 0)
+                id = key + 1;
+        }
+
+        return id != 0 ? id : 1;
+    }
+
+    MemoryDatabase::MemoryDatabase()
+    {
+    }
+    MemoryDatabase::~MemoryDatabase()
+    {
+        StopIO();
+
+        if (!snapshotPath.empty())
+            Snapshot();
+    }
+    Ref<MemoryDatabase> MemoryDatabase::Create(const std::string& snapshot)
+    {
+        Ref<MemoryDatabase> database = boost::make_shared<MemoryDatabase>();
+        if (database != nullptr && !snapshot.empty())
+        {
+            database->snapshotPath = boost::filesystem::absolute(snapshot, config::GetDataDirectory()).string();
+
+            // Load snapshot
+            std::ifstream file = std::ifstream(database->snapshotPath, std::ios::binary);
+            if (file.is_open())
+            {
+                std::string content =
+                    std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                if (!database->Deserialize(content))
+                {
+                    LOG_ERROR("Failed to load memory database snapshot '{0}'.", database->snapshotPath);
+                    return nullptr;
+                }
+            }
+        }
+
+        return database;
+    }
+
+    void MemoryDatabase::Serialize(std::string& output)
+    {
+        boost::lock_guard lock(mutex);
+
+        output.append(MEMORY_DATABASE_MAGIC, 4);
+        WriteValue<uint32_t>(output, MEMORY_DATABASE_VERSION);
+
+        // Script sources
+        WriteValue<uint32_t>(output, scriptSourceMap.size());
+        for (const auto& [id, entry] : scriptSourceMap)
+        {
+            WriteValue<uint32_t>(output, id);
+            WriteString(output, entry.language);
+            WriteString(output, entry.name);
+            WriteString(output, entry.config);
+            WriteString(output, entry.content);
+        }
+
+        // Entities
+        WriteValue<uint32_t>(output, entityMap.size());
+        for (const auto& [id, entry] : entityMap)
+        {
+            WriteValue<uint32_t>(output, id);
+            WriteValue<uint8_t>(output, entry.type);
+            WriteString(output, entry.name);
+            WriteValue<uint32_t>(output, entry.scriptSourceId);
+            WriteString(output, entry.attributes);
+            WriteString(output, entry.state);
+        }
+
+        // History
+        WriteValue<uint32_t>(output, historyMap.size());
+        for (const auto& [entityId, blockList] : historyMap)
+        {
+            WriteValue<uint32_t>(output, entityId);
+            WriteValue<uint32_t>(output, blockList.size());
+            for (const HistoryBlockEntry& block : blockList)
+            {
+                WriteString(output, block.property);
+                WriteValue<uint8_t>(output, block.resolution);
+                WriteValue<int64_t>(output, block.begin);
+                WriteValue<int64_t>(output, block.end);
+                WriteValue<uint64_t>(output, block.count);
+                WriteString(output, block.data);
+            }
+        }
+
+        // Users
+        WriteValue<uint32_t>(output, userMap.size());
+        for (const auto& [id, entry] : userMap)
+        {
+            WriteValue<uint32_t>(output, id);
+            WriteString(output, entry.name);
+            output.append((const char*)entry.hash, SHA256_SIZE);
+            output.append((const char*)entry.salt, SALT_SIZE);
+            WriteValue<uint8_t>(output, entry.hashSet);
+            WriteString(output, entry.accessLevel);
+        }
+    }
+    bool MemoryDatabase::Deserialize(const std::string_view& input)
+    {
+        boost::lock_guard lock(mutex);
+
+        SnapshotReader reader = SnapshotReader(input);
+
+        char magic[4];
+        uint32_t version;
+        if (!reader.Read(magic, sizeof(magic)) || memcmp(magic, MEMORY_DATABASE_MAGIC, 4) != 0 ||
+            !reader.Read(version) || version != MEMORY_DATABASE_VERSION)
+            return false;
+
+        uint32_t count;
+        identifier_t id;
+
+        // Script sources
+        if (!reader.Read(count))
+            return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ScriptSourceEntry entry;
+            if (!reader.Read(id) || !reader.ReadString(entry.language) || !reader.ReadString(entry.name) ||
+                !reader.ReadString(entry.config) || !reader.ReadString(entry.content))
+                return false;
+            scriptSourceMap[id] = std::move(entry);
+        }
+
+        // Entities
+        if (!reader.Read(count))
+            return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            EntityEntry entry;
+            if (!reader.Read(id) || !reader.Read(entry.type) || !reader.ReadString(entry.name) ||
+                !reader.Read(entry.scriptSourceId) || !reader.ReadString(entry.attributes) ||
+                !reader.ReadString(entry.state))
+                return false;
+            entityMap[id] = std::move(entry);
+        }
+
+        // History
+        if (!reader.Read(count))
+            return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t blockCount;
+            if (!reader.Read(id) || !reader.Read(blockCount))
+                return false;
+
+            boost::container::vector<HistoryBlockEntry>& blockList = historyMap[id];
+            blockList.reserve(blockCount);
+            for (uint32_t j = 0; j < blockCount; j++)
+            {
+                HistoryBlockEntry block;
+                uint64_t sampleCount;
+                if (!reader.ReadString(block.property) || !reader.Read(block.resolution) ||
+                    !reader.Read(block.begin) || !reader.Read(block.end) || !reader.Read(sampleCount) ||
+                    !reader.ReadString(block.data))
+                    return false;
+                block.count = sampleCount;
+                blockList.push_back(std::move(block));
+            }
+        }
+
+        // Users
+        if (!reader.Read(count))
+            return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            UserEntry entry;
+            uint8_t hashSet;
+            if (!reader.Read(id) || !reader.ReadString(entry.name) || !reader.Read(entry.hash, SHA256_SIZE) ||
+                !reader.Read(entry.salt, SALT_SIZE) || !reader.Read(hashSet) || !reader.ReadString(entry.accessLevel))
+                return false;
+            entry.hashSet = hashSet != 0;
+            userMap[id] = std::move(entry);
+        }
+
+        return true;
+    }
+
+    bool MemoryDatabase::Snapshot()
+    {
+        if (snapshotPath.empty())
+            return false;
+
+        std::string content;
+        Serialize(content);
+
+        // Write to temporary file and replace snapshot
+        std::string temporaryPath = snapshotPath + ".tmp";
+        {
+            std::ofstream file = std::ofstream(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open() || !file.write(content.data(), content.size()))
+            {
+                LOG_ERROR("Failed to write memory database snapshot '{0}'.", temporaryPath);
+                return false;
+            }
+        }
+
+        boost::system::error_code ec;
+        boost::filesystem::rename(temporaryPath, snapshotPath, ec);
+        if (ec)
+        {
+            LOG_ERROR("Failed to replace memory database snapshot '{0}'.\n{1}", snapshotPath, ec.message());
+            return false;
+        }
+
+        return true;
+    }
+
+    //! ScriptSource
+
+    bool MemoryDatabase::LoadScriptSources(
+        const boost::function<void(identifier_t id, const std::string& language, const std::string& name,
+                                   const std::string_view& config, const std::string_view& content)>& callback)
+    {
+        boost::container::vector<std::pair<identifier_t, ScriptSourceEntry>> entryList;
+        {
+            boost::lock_guard lock(mutex);
+            entryList.assign(scriptSourceMap.begin(), scriptSourceMap.end());
+        }
+
+        for (const auto& [id, entry] : entryList)
+            callback(id, entry.language, entry.name, entry.config, entry.content);
+
+        return true;
+    }
+
+    identifier_t MemoryDatabase::ReserveScriptSource(const std::string& language)
+    {
+        boost::lock_guard lock(mutex);
+
+        identifier_t id = FindFreeId(scriptSourceMap);
+        scriptSourceMap[id].language = language;
+
+        return id;
+    }
+
+    bool MemoryDatabase::UpdateScriptSource(identifier_t id, const std::string& name, const std::string_view& config)
+    {
+        boost::lock_guard lock(mutex);
+
+        robin_hood::unordered_flat_map<identifier_t, ScriptSourceEntry>::iterator it = scriptSourceMap.find(id);
+        if (it != scriptSourceMap.end())
+        {
+            it->second.name = name;
+            it->second.config = config;
+        }
+
+        return true;
+    }
+
+    bool MemoryDatabase::UpdateScriptSourceContent(identifier_t id, const std::string_view& newValue)
+    {
+        boost::lock_guard lock(mutex);
+
+        robin_hood::unordered_flat_map<identifier_t, ScriptSourceEntry>::iterator it = scriptSourceMap.find(id);
+        if (it != scriptSourceMap.end())
+            it->second.content = newValue;
+
+        return true;
+    }
+
+    bool MemoryDatabase::RemoveScriptSource(identifier_t id)
+    {
+        boost::lock_guard lock(mutex);
+
+        scriptSourceMap.erase(id);
+        return true;
+    }
+
+    size_t MemoryDatabase::GetScriptSourceCount()
+    {
+        boost::lock_guard lock(mutex);
+        return scriptSourceMap.size();
+    }
+
+    //! Entity
+
+    bool MemoryDatabase::LoadEntities(
+        const boost::function<bool(identifier_t id, uint8_t type, const std::string_view& name,
+                                   identifier_t scriptSourceID, const std::string_view& attributes,
+                                   const std::string_view& state)>& callback)
+    {
+        boost::container::vector<std::pair<identifier_t, EntityEntry>> entryList;
+        {
+            boost::lock_guard lock(mutex);
+            entryList.assign(entityMap.begin(), entityMap.end());
+        }
+
+        for (const auto& [id, entry] : entryList)
+            callback(id, entry.type, entry.name, entry.scriptSourceId, entry.attributes, entry.state);
+
+        return true;
+    }
+
+    identifier_t MemoryDatabase::ReserveEntity(uint8_t type)
+    {
+        boost::lock_guard lock(mutex);
+
+        identifier_t id = FindFreeId(entityMap);
+        entityMap[id].type = type;
+
+        return id;
+    }
+
+    bool MemoryDatabase::UpdateEntity(identifier_t id, const std::string& name, identifier_t scriptSourceID,
+                                      const std::string_view& attributes)
+    {
+        boost::lock_guard lock(mutex);
+
+        robin_hood::unordered_flat_map<identifier_t, EntityEntry>::iterator it = entityMap.find(id);
+        if (it != entityMap.end())
+        {
+            it->second.name = name;
+            it->second.scriptSourceId = scriptSourceID;
+            it->second.attributes = attributes;
+        }
+
+        return true;
+    }
+
+    bool MemoryDatabase::UpdateEntityState(identifier_t id, const std::string_view& state)
+    {
+        boost::lock_guard lock(mutex);
+
+        robin_hood::unordered_flat_map<identifier_t, EntityEntry>::iterator it = entityMap.find(id);
+        if (it != entityMap.end())
+            it->second.state = state;
+
+        return true;
+    }
+
+    bool MemoryDatabase::RemoveEntity(identifier_t id)
+    {
+        boost::lock_guard lock(mutex);
+
+        entityMap.erase(id);
+        return true;
+    }
+
+    size_t MemoryDatabase::GetEntityCount()
+    {
+        boost::lock_guard lock(mutex);
+        return entityMap.size();
+    }
+
+    //! History
+
+    bool MemoryDatabase::AddHistoryBlock(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                         int64_t begin, int64_t end, size_t count, const std::string_view& data)
+    {
+        boost::lock_guard lock(mutex);
+
+        historyMap[entityId].push_back(HistoryBlockEntry{property, resolution, begin, end, count, std::string(data)});
+        return true;
+    }
+
+    bool MemoryDatabase::LoadHistoryBlocks(
+        identifier_t entityId, const std::string& property, uint8_t resolution, int64_t from, int64_t to,
+        const boost::function<void(int64_t begin, int64_t end, size_t count, const std::string_view& data)>& callback)
+    {
+        boost::container::vector<HistoryBlockEntry> blockList;
+        {
+            boost::lock_guard lock(mutex);
+
+            robin_hood::unordered_node_map<identifier_t, boost::container::vector<HistoryBlockEntry>>::const_iterator
+                it = historyMap.find(entityId);
+            if (it == historyMap.end())
+                return true;
+
+            for (const HistoryBlockEntry& block : it->second)
+            {
+                if (block.resolution == resolution && block.end >= from && block.begin <= to &&
+                    block.property == property)
+                    blockList.push_back(block);
+            }
+        }
+
+        std::sort(blockList.begin(), blockList.end(),
+                  [](const HistoryBlockEntry& a, const HistoryBlockEntry& b) -> bool { return a.begin < b.begin; });
+
+        for (const HistoryBlockEntry& block : blockList)
+            callback(block.begin, block.end, block.count, block.data);
+
+        return true;
+    }
+
+    bool MemoryDatabase::RemoveHistory(identifier_t entityId)
+    {
+        boost::lock_guard lock(mutex);
+
+        historyMap.erase(entityId);
+        return true;
+    }
+
+    //! User
+
+    bool MemoryDatabase::LoadUsers(
+        const boost::function<void(identifier_t id, const std::string& name, uint8_t hash[SHA256_SIZE],
+                                   uint8_t salt[SALT_SIZE], const std::string& accessLevel)>& callback)
+    {
+        boost::container::vector<std::pair<identifier_t, UserEntry>> entryList;
+        {
+            boost::lock_guard lock(mutex);
+            entryList.assign(userMap.begin(), userMap.end());
+        }
+
+        for (auto& [id, entry] : entryList)
+        {
+            // Users without a hash are skipped (like invalid rows in the sqlite backend)
+            if (!entry.hashSet)
+                continue;
+
+            callback(id, entry.name, entry.hash, entry.salt, entry.accessLevel);
+        }
+
+        return true;
+    }
+
+    identifier_t MemoryDatabase::ReserveUser(const std::string& name)
+    {
+        boost::lock_guard lock(mutex);
+
+        identifier_t id = FindFreeId(userMap);
+        userMap[id].name = name;
+
+        return id;
+    }
+
+    bool MemoryDatabase::UpdateUserAccessLevel(identifier_t id, const std::string& newValue)
+    {
+        boost::lock_guard lock(mutex);
+
+        robin_hood::unordered_flat_map<identifier_t, UserEntry>::iterator it = userMap.find(id);
+        if (it != userMap.end())
+            it->second.accessLevel = newValue;
+
+        return true;
+    }
+
+    bool MemoryDatabase::UpdateUserHash(identifier_t id, uint8_t hash[SHA256_SIZE], uint8_t salt[SALT_SIZE])
+    {
+        boost::lock_guard lock(mutex);
+
+        robin_hood::unordered_flat_map<identifier_t, UserEntry>::iterator it = userMap.find(id);
+        if (it != userMap.end())
+        {
+            memcpy(it->second.hash, hash, SHA256_SIZE);
+            memcpy(it->second.salt, salt, SALT_SIZE);
+            it->second.hashSet = true;
+        }
+
+        return true;
+    }
+
+    bool MemoryDatabase::RemoveUser(identifier_t id)
+    {
+        boost::lock_guard lock(mutex);
+
+        userMap.erase(id);
+        return true;
+    }
+
+    size_t MemoryDatabase::GetUserCount()
+    {
+        boost::lock_guard lock(mutex);
+        return userMap.size();
+    }
+
+    //! Backup
+
+    bool MemoryDatabase::Backup(const std::string& path, const DatabaseBackupCallback& callback)
+    {
+        if (backupActive.exchange(true))
+        {
+            LOG_ERROR("Backup is already running.");
+            return false;
+        }
+
+        boost::asio::post(GetIOContext(),
+                          [this, path, callback]() -> void
+                          {
+                              std::string content;
+                              Serialize(content);
+
+                              // Compress snapshot
+                              bool success = false;
+                              gzFile output = gzopen(path.c_str(), "wb");
+                              if (output != nullptr)
+                              {
+                                  success = gzwrite(output, content.data(), content.size()) == (int)content.size();
+                                  success = gzclose(output) == Z_OK && success;
+                              }
+
+                              if (!success)
+                              {
+                                  LOG_ERROR("Failed database backup '{0}'.", path);
+                                  boost::system::error_code ec;
+                                  boost::filesystem::remove(path, ec);
+                              }
+
+                              backupActive = false;
+
+                              if (callback)
+                              {
+                                  Ref<Worker> worker = Worker::GetInstance();
+                                  if (worker != nullptr)
+                                      worker->Post(WorkerHandlerKind::kDatabaseWorkerHandlerKind, "backup-callback", 0,
+                                                   boost::bind(callback,
+                                                               success
+                                                                   ? DatabaseBackupStatus::kFinishedDatabaseBackupStatus
+                                                                   : DatabaseBackupStatus::kFailedDatabaseBackupStatus,
+                                                               content.size(), content.size()));
+                              }
+                          });
+
+        return true;
+    }
+}
@@ -0,0 +1,265 @@
+#pragma once
+#include "../database.hpp"
+#include "../common.hpp"
+
+namespace server
+{
+    /// @brief Functional in-memory database (for benchmarks and tests)
+    ///
+    /// Honors the semantics of the SQLite backend. The content can optionally be stored in a snapshot file that is
+    /// loaded on creation and written on destruction.
+    class MemoryDatabase : public Database
+    {
+      private:
+        struct ScriptSourceEntry
+        {
+            std::string language;
+            std::string name = "no name";
+            std::string config;
+            std::string content;
+        };
+
+        struct EntityEntry
+        {
+            uint8_t type = 0;
+            std::string name = "no name";
+            identifier_t scriptSourceId = 0;
+            std::string attributes;
+            std::string state;
+        };
+
+        struct HistoryBlockEntry
+        {
+            std::string property;
+            uint8_t resolution;
+            int64_t begin;
+            int64_t end;
+            size_t count;
+            std::string data;
+        };
+
+        struct UserEntry
+        {
+            std::string name;
+            uint8_t hash[SHA256_SIZE] = {};
+            uint8_t salt[SALT_SIZE] = {};
+            bool hashSet = false;
+            std::string accessLevel;
+        };
+
+        boost::mutex mutex;
+
+        robin_hood::unordered_flat_map<identifier_t, ScriptSourceEntry> scriptSourceMap;
+        robin_hood::unordered_flat_map<identifier_t, EntityEntry> entityMap;
+        robin_hood::unordered_node_map<identifier_t, boost::container::vector<HistoryBlockEntry>> historyMap;
+        robin_hood::unordered_flat_map<identifier_t, UserEntry> userMap;
+
+        /// @brief Snapshot file (empty if snapshots are disabled)
+        ///
+        std::string snapshotPath;
+
+        /// @brief Backup is running
+        ///
+        boost::atomic_bool backupActive = false;
+
+        /// @brief Serialize database content
+        ///
+        /// @param output Output buffer
+        void Serialize(std::string& output);
+
+        /// @brief Deserialize database content
+        ///
+        /// @param input Input buffer
+        /// @return Successfulness
+        bool Deserialize(const std::string_view& input);
+
+      public:
+        MemoryDatabase();
+        virtual ~MemoryDatabase();
+
+        /// @brief Create memory database instance
+        ///
+        /// @param snapshot Snapshot file (optional)
+        /// @return Memory database
+        static Ref<MemoryDatabase> Create(const std::string& snapshot = "");
+
+        /// @brief Write snapshot file
+        ///
+        /// @return Successfulness
+        bool Snapshot();
+
+        /// @brief Load script sources from database
+        ///
+        /// @param callback Entry callback called once for every entry
+        /// @return Successfulness
+        virtual bool LoadScriptSources(
+            const boost::function<void(identifier_t id, const std::string& language, const std::string& name,
+                                       const std::string_view& config, const std::string_view& content)>& callback)
+            override;
+
+        /// @brief Reserve script source entry in database
+        ///
+        /// @param language Script source language
+        /// @return identifier_t Script source id or zero if reservation failed
+        virtual identifier_t ReserveScriptSource(const std::string& language) override;
+
+        /// @brief Update script source
+        ///
+        /// @param id Script source id
+        /// @param name Script source name
+        /// @param content Additional config
+        /// @return Successfulness
+        virtual bool UpdateScriptSource(identifier_t id, const std::string& name,
+                                        const std::string_view& config) override;
+
+        /// @brief Update script source content
+        ///
+        /// @param id Script source id
+        /// @param newValue New content
+        /// @return Successfulness
+        virtual bool UpdateScriptSourceContent(identifier_t id, const std::string_view& newValue) override;
+
+        /// @brief Remove script source
+        ///
+        /// @param id Script source id
+        /// @return Successfulness
+        virtual bool RemoveScriptSource(identifier_t id) override;
+
+        /// @brief Get script source count
+        ///
+        /// @return size_t Script source count
+        virtual size_t GetScriptSourceCount() override;
+
+        //! Entity
+
+        /// @brief Load entities from database
+        ///
+        /// @param callback Entry callback (views are only valid during the call, state is binary, see
+        /// DecodeBinaryState)
+        /// @return Successfulness
+        virtual bool LoadEntities(
+            const boost::function<bool(identifier_t id, uint8_t type, const std::string_view& name,
+                                       identifier_t scriptSourceID, const std::string_view& attributes,
+                                       const std::string_view& state)>& callback) override;
+
+        /// @brief Reserve entity entry in database
+        ///
+        /// @param type Entity type (numeric value of main::EntityType)
+        /// @return identifier_t Entity id or zero if reservation failed
+        virtual identifier_t ReserveEntity(uint8_t type) override;
+
+        /// @brief Update entity without pushing to history
+        ///
+        /// @param id Entity id
+        /// @param name Entity name
+        /// @param scriptSourceId Entity script source id
+        /// @param attributes Entity attributes
+        /// @return Successfulness
+        virtual bool UpdateEntity(identifier_t id, const std::string& name, identifier_t scriptSourceID,
+                                  const std::string_view& attributes) override;
+
+        /// @brief Update entity state
+        ///
+        /// @param id Entity data
+        /// @param state Binary state (see EncodeBinaryState)
+        /// @return Successfulness
+        virtual bool UpdateEntityState(identifier_t id, const std::string_view& state) override;
+
+        /// @brief Remove entity
+        ///
+        /// @param id Entity id
+        /// @return Successfulness
+        virtual bool RemoveEntity(identifier_t id) override;
+
+        /// @brief Get entity count
+        ///
+        /// @return size_t Entity count
+        virtual size_t GetEntityCount() override;
+
+        //! History
+
+        /// @brief Add compressed history block
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param begin Timestamp of the first sample
+        /// @param end Timestamp of the last sample
+        /// @param count Sample count
+        /// @param data Compressed samples
+        /// @return Successfulness
+        virtual bool AddHistoryBlock(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                     int64_t begin, int64_t end, size_t count, const std::string_view& data) override;
+
+        /// @brief Load history blocks overlapping a time range
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param from Range begin
+        /// @param to Range end
+        /// @param callback Block callback (ordered by begin)
+        /// @return Successfulness
+        virtual bool LoadHistoryBlocks(
+            identifier_t entityId, const std::string& property, uint8_t resolution, int64_t from, int64_t to,
+            const boost::function<void(int64_t begin, int64_t end, size_t count, const std::string_view& data)>&
+                callback) override;
+
+        /// @brief Remove history of an entity
+        ///
+        /// @param entityId Entity id
+        /// @return Successfulness
+        virtual bool RemoveHistory(identifier_t entityId) override;
+
+        //! User
+
+        /// @brief Load users from database
+        ///
+        /// @param callback Callback for each user
+        /// @return Successfulness
+        virtual bool LoadUsers(
+            const boost::function<void(identifier_t id, const std::string& name, uint8_t hash[SHA256_SIZE],
+                                       uint8_t salt[SALT_SIZE], const std::string& accessLevel)>& callback) override;
+
+        /// @brief Reserves new user entry in database
+        ///
+        /// @param name User name
+        /// @return Entry identifier or null in case of an error
+        virtual identifier_t ReserveUser(const std::string& name) override;
+
+        /// @brief Update user access level
+        ///
+        /// @param id User id
+        /// @param newValue New access level
+        /// @return Successfulness
+        virtual bool UpdateUserAccessLevel(identifier_t id, const std::string& newValue) override;
+
+        /// @brief Update user hash and salt
+        ///
+        /// @param id User id
+        /// @param hash New hash
+        /// @param salt New salt
+        /// @return Successfulness
+        virtual bool UpdateUserHash(identifier_t id, uint8_t hash[SHA256_SIZE], uint8_t salt[SALT_SIZE]) override;
+
+        /// @brief Remove user
+        ///
+        /// @param id User id
+        /// @return Successfulness
+        virtual bool RemoveUser(identifier_t id) override;
+
+        /// @brief Get user count
+        ///
+        /// @return size_t User count
+        virtual size_t GetUserCount() override;
+
+        //! Backup
+
+        /// @brief Write a gzip compressed snapshot
+        ///
+        /// @param path Output file
+        /// @param callback Progress callback (called on the worker)
+        /// @return Backup was started (false if already running)
+        virtual bool Backup(const std::string& path, const DatabaseBackupCallback& callback) override;
+    };
+}
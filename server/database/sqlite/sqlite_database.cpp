@@ -1,4 +1,5 @@
 #include "sqlite_database.hpp"
+#include "../binary_state.hpp"
 
 namespace server
 {
@@ -7,13 +8,21 @@ namespace server
     }
     SQLiteDatabase::~SQLiteDatabase()
     {
+        backupCancelled = true;
+        StopIO();
+
+        if (readConnection != nullptr)
+        {
+            sqlite3_close(readConnection);
+            readConnection = nullptr;
+        }
         if (connection != nullptr)
         {
             sqlite3_close(connection);
             connection = nullptr;
         }
     }
-    Ref<SQLiteDatabase> SQLiteDatabase::Create(std::string db)
+    Ref<SQLiteDatabase> SQLiteDatabase::Create(std::string db, const std::string& pragmas)
     {
         Ref<SQLiteDatabase> database = boost::make_shared<SQLiteDatabase>();
         if (database != nullptr)
@@ -24,16 +33,27 @@ namespace server
             db = boost::filesystem::absolute(db, config::GetDataDirectory()).string();
 
             // Open / Create database
-            if (sqlite3_open_v2(db.c_str(), &database->connection, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+            if (sqlite3_open_v2(db.c_str(), &database->connection,
+                                SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
                                 nullptr) != SQLITE_OK)
             {
                 LOG_ERROR("Failing to open/create sqlite database.\n{0}", sqlite3_errcode(database->connection));
                 return nullptr;
             }
 
-            // Create necessary tables
             char* err = nullptr;
 
+            // Enable write-ahead log by default (readers do not block the writer and vice versa)
+            if (sqlite3_exec(database->connection,
+                             pragmas.empty() ? SQLITE_DATABASE_DEFAULT_PRAGMAS : pragmas.c_str(), nullptr, nullptr,
+                             &err) != SQLITE_OK)
+            {
+                LOG_ERROR("Failing to set sqlite pragmas.\n{0}", err);
+                return nullptr;
+            }
+
+            // Create necessary tables
+
             // Scripting
             {
                 // Script Source Table
@@ -53,7 +73,7 @@ namespace server
                 // Entity table
                 if (sqlite3_exec(database->connection,
                                  R"(create table if not exists entities)"
-                                 R"((id integer not null primary key, type text not null, name text not null, scriptsourceid integer, attributes text, state text))",
+                                 R"((id integer not null primary key, type integer not null, name text not null, scriptsourceid integer, attributes text, state text))",
                                  nullptr, nullptr, &err) != SQLITE_OK)
                 {
                     LOG_ERROR("Failing to create 'entities' table.\n{0}", err);
@@ -61,6 +81,21 @@ namespace server
                 }
             }
 
+            // History
+            {
+                // History block table
+                if (sqlite3_exec(
+                        database->connection,
+                        R"(create table if not exists history)"
+                        R"((entityid integer not null, property text not null, resolution integer not null, firsttime integer not null, lasttime integer not null, count integer not null, data blob not null);)"
+                        R"(create index if not exists historyrange on history (entityid, property, resolution, lasttime))",
+                        nullptr, nullptr, &err) != SQLITE_OK)
+                {
+                    LOG_ERROR("Failing to create 'history' table.\n{0}", err);
+                    return nullptr;
+                }
+            }
+
             // User
             {
                 // User Table
@@ -74,8 +109,140 @@ namespace server
                     return nullptr;
                 }
             }
+
+            // Migrate existing data
+            if (!database->Migrate())
+            {
+                LOG_ERROR("Failing to migrate sqlite database.");
+                return nullptr;
+            }
+
+            // Open read-only connection
+            if (sqlite3_open_v2(db.c_str(), &database->readConnection, SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX,
+                                nullptr) != SQLITE_OK)
+            {
+                LOG_ERROR("Failing to open read-only sqlite connection.\n{0}",
+                          sqlite3_errcode(database->readConnection));
+                return nullptr;
+            }
         }
 
         return database;
     }
+
+    bool SQLiteDatabase::Migrate()
+    {
+        sqlite3_stmt* statement;
+
+        // Get database version
+        int version = 0;
+        {
+            if (sqlite3_prepare_v2(connection, R"(pragma user_version)", -1, &statement, nullptr) != SQLITE_OK)
+            {
+                LOG_ERROR("Failed to prepare sql database version statement.\n{0}", sqlite3_errmsg(connection));
+                sqlite3_finalize(statement);
+                return false;
+            }
+
+            if (sqlite3_step(statement) == SQLITE_ROW)
+                version = sqlite3_column_int(statement, 0);
+
+            sqlite3_finalize(statement);
+        }
+
+        if (version >= SQLITE_DATABASE_VERSION)
+            return true;
+
+        char* err = nullptr;
+        if (sqlite3_exec(connection, R"(begin transaction)", nullptr, nullptr, &err) != SQLITE_OK)
+        {
+            LOG_ERROR("Failed to begin migration.\n{0}", err);
+            return false;
+        }
+
+        // Version 1: Binary entity states
+        if (version < 1)
+        {
+            LOG_INFO("Migrating entity states to binary encoding.");
+
+            // Either statement may be left unprepared (finalizing null is a no-op)
+            statement = nullptr;
+            sqlite3_stmt* updateStatement = nullptr;
+            if (sqlite3_prepare_v2(connection, R"(select id, state from entities where typeof(state) = 'text')", -1,
+                                   &statement, nullptr) != SQLITE_OK ||
+                sqlite3_prepare_v2(connection, R"(update entities set state = ? where id = ?)", -1, &updateStatement,
+                                   nullptr) != SQLITE_OK)
+            {
+                LOG_ERROR("Failed to prepare sql migration statement.\n{0}", sqlite3_errmsg(connection));
+                sqlite3_finalize(statement);
+                sqlite3_finalize(updateStatement);
+                sqlite3_exec(connection, R"(rollback)", nullptr, nullptr, nullptr);
+                return false;
+            }
+
+            std::string state;
+            while (sqlite3_step(statement) == SQLITE_ROW)
+            {
+                identifier_t id = sqlite3_column_int64(statement, 0);
+
+                const char* json = (const char*)sqlite3_column_text(statement, 1);
+                size_t jsonSize = sqlite3_column_bytes(statement, 1);
+
+                // Convert state
+                rapidjson::Document document;
+                document.Parse(json, jsonSize);
+                if (document.HasParseError() || !document.IsObject())
+                {
+                    LOG_WARNING("Failed to parse state of entity '{0}'.", id);
+                    document.SetObject();
+                }
+
+                state.clear();
+                EncodeBinaryState(document, state);
+
+                if (sqlite3_bind_blob(updateStatement, 1, state.data(), state.size(), nullptr) != SQLITE_OK ||
+                    sqlite3_bind_int64(updateStatement, 2, id) != SQLITE_OK ||
+                    sqlite3_step(updateStatement) != SQLITE_DONE)
+                {
+                    LOG_ERROR("Failed to migrate state of entity '{0}'.\n{1}", id, sqlite3_errmsg(connection));
+                    sqlite3_finalize(statement);
+                    sqlite3_finalize(updateStatement);
+                    sqlite3_exec(connection, R"(rollback)", nullptr, nullptr, nullptr);
+                    return false;
+                }
+
+                sqlite3_reset(updateStatement);
+            }
+
+            sqlite3_finalize(statement);
+            sqlite3_finalize(updateStatement);
+        }
+
+        // Version 2: Integer entity types (values of main::EntityType)
+        if (version < 2)
+        {
+            LOG_INFO("Migrating entity types to integers.");
+
+            if (sqlite3_exec(connection,
+                             R"(update entities set type = case type when 'room' then 1 when 'device' then 2 )"
+                             R"(when 'service' then 3 else 0 end where typeof(type) = 'text')",
+                             nullptr, nullptr, &err) != SQLITE_OK)
+            {
+                LOG_ERROR("Failed to migrate entity types.\n{0}", err);
+                sqlite3_exec(connection, R"(rollback)", nullptr, nullptr, nullptr);
+                return false;
+            }
+        }
+
+        // Update version
+        std::string commit = "pragma user_version = " + std::to_string(SQLITE_DATABASE_VERSION) + "; commit";
+        if (sqlite3_exec(connection, commit.c_str(), nullptr, nullptr, &err) != SQLITE_OK)
+        {
+            LOG_ERROR("Failed to commit migration.\n{0}", err);
+            sqlite3_exec(connection, R"(rollback)", nullptr, nullptr, nullptr);
+            return false;
+        }
+
+        return true;
+    }
 }
\ No newline at end of file
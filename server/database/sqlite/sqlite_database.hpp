@@ -3,12 +3,48 @@
 #include "../common.hpp"
 #include <sqlite3.h>
 
+#define SQLITE_DATABASE_VERSION 2
+#define SQLITE_DATABASE_DEFAULT_PRAGMAS "pragma journal_mode = wal; pragma synchronous = normal"
+
 namespace server
 {
     class SQLiteDatabase : public Database
     {
       private:
-        sqlite3* connection;
+        /// @brief Read/write connection (used by the database thread)
+        ///
+        sqlite3* connection = nullptr;
+
+        /// @brief Read-only connection for loads and queries (WAL allows reading while the database thread writes)
+        ///
+        sqlite3* readConnection = nullptr;
+
+        struct BackupTask;
+
+        /// @brief Backup is running
+        ///
+        boost::atomic_bool backupActive = false;
+
+        /// @brief Abort running backup (set on shutdown)
+        ///
+        boost::atomic_bool backupCancelled = false;
+
+        void StepBackup(const Ref<BackupTask>& task);
+        void CompressBackup(const Ref<BackupTask>& task);
+        void FinishBackup(const Ref<BackupTask>& task, bool success);
+        void ReportBackup(const Ref<BackupTask>& task, DatabaseBackupStatus status, size_t progress, size_t total);
+
+        /// @brief Insert reserved entries (executed on the database thread, see Reserve*)
+        ///
+        /// @return Id of the new entry or zero if the insert failed
+        identifier_t InsertScriptSource(const std::string& language);
+        identifier_t InsertEntity(uint8_t type);
+        identifier_t InsertUser(const std::string& name);
+
+        /// @brief Migrate database to SQLITE_DATABASE_VERSION (tracked with 'pragma user_version')
+        ///
+        /// @return Successfulness
+        bool Migrate();
 
       public:
         SQLiteDatabase();
@@ -17,8 +53,9 @@ namespace server
         /// @brief Create SQLite database instance
         ///
         /// @param db Database location
+        /// @param pragmas Pragmas executed on the write connection (empty for SQLITE_DATABASE_DEFAULT_PRAGMAS)
         /// @return SQLite database
-        static Ref<SQLiteDatabase> Create(std::string db = "");
+        static Ref<SQLiteDatabase> Create(std::string db = "", const std::string& pragmas = "");
 
         /// @brief Load script sources from database
         ///
@@ -67,18 +104,19 @@ namespace server
 
         /// @brief Load entities from database
         ///
-        /// @param callback Entry callback
+        /// @param callback Entry callback (views are only valid during the call, state is binary, see
+        /// DecodeBinaryState)
         /// @return Successfulness
         virtual bool LoadEntities(
-            const boost::function<bool(identifier_t id, const std::string& type, const std::string& name,
+            const boost::function<bool(identifier_t id, uint8_t type, const std::string_view& name,
                                        identifier_t scriptSourceID, const std::string_view& attributes,
                                        const std::string_view& state)>& callback) override;
 
         /// @brief Reserve entity entry in database
         ///
-        /// @param type Entity type
+        /// @param type Entity type (numeric value of main::EntityType)
         /// @return identifier_t Entity id or zero if reservation failed
-        virtual identifier_t ReserveEntity(const std::string& type) override;
+        virtual identifier_t ReserveEntity(uint8_t type) override;
 
         /// @brief Update entity without pushing to history
         ///
@@ -90,10 +128,10 @@ namespace server
         virtual bool UpdateEntity(identifier_t id, const std::string& name, identifier_t scriptSourceID,
                                   const std::string_view& attributes) override;
 
-        /// @brief Update entity script data
+        /// @brief Update entity state
         ///
         /// @param id Entity data
-        /// @param data Script data
+        /// @param state Binary state (see EncodeBinaryState)
         /// @return Successfulness
         virtual bool UpdateEntityState(identifier_t id, const std::string_view& state) override;
 
@@ -108,6 +146,41 @@ namespace server
         /// @return size_t Entity count
         virtual size_t GetEntityCount() override;
 
+        //! History
+
+        /// @brief Add compressed history block
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param begin Timestamp of the first sample
+        /// @param end Timestamp of the last sample
+        /// @param count Sample count
+        /// @param data Compressed samples
+        /// @return Successfulness
+        virtual bool AddHistoryBlock(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                     int64_t begin, int64_t end, size_t count, const std::string_view& data) override;
+
+        /// @brief Load history blocks overlapping a time range
+        ///
+        /// @param entityId Entity id
+        /// @param property Property name
+        /// @param resolution History resolution (zero for raw samples)
+        /// @param from Range begin
+        /// @param to Range end
+        /// @param callback Block callback (ordered by begin)
+        /// @return Successfulness
+        virtual bool LoadHistoryBlocks(
+            identifier_t entityId, const std::string& property, uint8_t resolution, int64_t from, int64_t to,
+            const boost::function<void(int64_t begin, int64_t end, size_t count, const std::string_view& data)>&
+                callback) override;
+
+        /// @brief Remove history of an entity
+        ///
+        /// @param entityId Entity id
+        /// @return Successfulness
+        virtual bool RemoveHistory(identifier_t entityId) override;
+
         //! User
 
         /// @brief Load users from database
@@ -150,6 +223,16 @@ namespace server
         /// @return size_t User count
         virtual size_t GetUserCount() override;
 
+        //! Backup
+
+        /// @brief Start online backup into a gzip compressed file
+        /// @note Fails early if there is not enough free space for the snapshot and the output (twice the database
+        /// size)
+        ///
+        /// @param path Output file
+        /// @param callback Progress callback (called on the worker)
+        /// @return Backup was started (false if not supported or already running)
+        virtual bool Backup(const std::string& path, const DatabaseBackupCallback& callback) override;
         //! Testing
 
         /// @brief Only used in tests
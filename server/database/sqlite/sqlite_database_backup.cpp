@@ -0,0 +1,248 @@
+#include "sqlite_database.hpp"
+#include <common/worker.hpp>
+#include <zlib.h>
+
+// Pages copied per step (the database thread executes pending writes between two steps)
+#define SQLITE_BACKUP_STEP_PAGES 64
+#define SQLITE_BACKUP_STEP_DELAY 10
+
+// Bytes compressed per step
+#define SQLITE_BACKUP_CHUNK_SIZE 65536
+
+namespace server
+{
+    struct SQLiteDatabase::BackupTask
+    {
+        std::string path;
+        std::string snapshotPath;
+        DatabaseBackupCallback callback;
+
+        sqlite3* snapshot = nullptr;
+        sqlite3_backup* backup = nullptr;
+
+        std::ifstream input;
+        gzFile output = nullptr;
+        size_t inputSize = 0;
+        size_t inputOffset = 0;
+
+        size_t lastPercent = 0;
+
+        boost::asio::steady_timer timer;
+
+        BackupTask(boost::asio::io_context& context) : timer(context)
+        {
+        }
+    };
+
+    bool SQLiteDatabase::Backup(const std::string& path, const DatabaseBackupCallback& callback)
+    {
+        if (backupActive.exchange(true))
+        {
+            LOG_ERROR("Backup is already running.");
+            return false;
+        }
+
+        Ref<BackupTask> task = boost::make_shared<BackupTask>(GetIOContext());
+        if (task == nullptr)
+        {
+            backupActive = false;
+            return false;
+        }
+
+        task->path = path;
+        task->snapshotPath = path + ".snapshot";
+        task->callback = callback;
+
+        boost::asio::post(GetIOContext(),
+                          [this, task]() -> void
+                          {
+                              // The snapshot is compressed once it is complete, so both may need the database size
+                              boost::system::error_code ec;
+                              boost::system::error_code sizeError;
+                              boost::filesystem::space_info space = boost::filesystem::space(
+                                  boost::filesystem::absolute(task->path).parent_path(), ec);
+                              uintmax_t databaseSize =
+                                  boost::filesystem::file_size(sqlite3_db_filename(connection, "main"), sizeError);
+                              if (!ec && !sizeError && space.available < 2 * databaseSize)
+                              {
+                                  LOG_ERROR("Not enough disk space for backup '{0}' ({1} bytes needed).", task->path,
+                                            2 * databaseSize);
+                                  FinishBackup(task, false);
+                                  return;
+                              }
+
+                              // Open snapshot database
+                              if (sqlite3_open_v2(task->snapshotPath.c_str(), &task->snapshot,
+                                                  SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK)
+                              {
+                                  LOG_ERROR("Failed to create backup snapshot '{0}'.", task->snapshotPath);
+                                  FinishBackup(task, false);
+                                  return;
+                              }
+
+                              // Initialize backup
+                              task->backup = sqlite3_backup_init(task->snapshot, "main", connection, "main");
+                              if (task->backup == nullptr)
+                              {
+                                  LOG_ERROR("Failed to initialize backup.\n{0}", sqlite3_errmsg(task->snapshot));
+                                  FinishBackup(task, false);
+                                  return;
+                              }
+
+                              LOG_INFO("Starting database backup '{0}'.", task->path);
+
+                              StepBackup(task);
+                          });
+
+        return true;
+    }
+
+    void SQLiteDatabase::StepBackup(const Ref<BackupTask>& task)
+    {
+        if (backupCancelled)
+        {
+            FinishBackup(task, false);
+            return;
+        }
+
+        // Pages modified through the same connection are updated in the snapshot, so the backup never restarts
+        int result = sqlite3_backup_step(task->backup, SQLITE_BACKUP_STEP_PAGES);
+        switch (result)
+        {
+        case SQLITE_OK:
+        case SQLITE_BUSY:
+        case SQLITE_LOCKED:
+        {
+            size_t total = sqlite3_backup_pagecount(task->backup);
+            ReportBackup(task, DatabaseBackupStatus::kCopyingDatabaseBackupStatus,
+                         total - sqlite3_backup_remaining(task->backup), total);
+
+            // Wait for next step
+            task->timer.expires_after(boost::asio::chrono::milliseconds(SQLITE_BACKUP_STEP_DELAY));
+            task->timer.async_wait(
+                [this, task](const boost::system::error_code& ec) -> void
+                {
+                    if (ec)
+                        FinishBackup(task, false);
+                    else
+                        StepBackup(task);
+                });
+            break;
+        }
+        case SQLITE_DONE:
+        {
+            sqlite3_backup_finish(task->backup);
+            task->backup = nullptr;
+            sqlite3_close(task->snapshot);
+            task->snapshot = nullptr;
+
+            // Open snapshot and compressed output
+            task->input = std::ifstream(task->snapshotPath, std::ios::binary | std::ios::ate);
+            if (!task->input.is_open())
+            {
+                LOG_ERROR("Failed to open backup snapshot '{0}'.", task->snapshotPath);
+                FinishBackup(task, false);
+                return;
+            }
+            task->inputSize = task->input.tellg();
+            task->input.seekg(0);
+
+            task->output = gzopen(task->path.c_str(), "wb");
+            if (task->output == nullptr)
+            {
+                LOG_ERROR("Failed to create backup '{0}'.", task->path);
+                FinishBackup(task, false);
+                return;
+            }
+
+            task->lastPercent = 0;
+            boost::asio::post(GetIOContext(), boost::bind(&SQLiteDatabase::CompressBackup, this, task));
+            break;
+        }
+        default:
+            LOG_ERROR("Failed to execute backup step.\n{0}", sqlite3_errstr(result));
+            FinishBackup(task, false);
+            break;
+        }
+    }
+
+    void SQLiteDatabase::CompressBackup(const Ref<BackupTask>& task)
+    {
+        if (backupCancelled)
+        {
+            FinishBackup(task, false);
+            return;
+        }
+
+        char buffer[SQLITE_BACKUP_CHUNK_SIZE];
+        task->input.read(buffer, sizeof(buffer));
+        size_t size = task->input.gcount();
+
+        if (size > 0 && gzwrite(task->output, buffer, size) != (int)size)
+        {
+            LOG_ERROR("Failed to compress backup '{0}'.", task->path);
+            FinishBackup(task, false);
+            return;
+        }
+
+        task->inputOffset += size;
+        ReportBackup(task, DatabaseBackupStatus::kCompressingDatabaseBackupStatus, task->inputOffset,
+                     task->inputSize);
+
+        if (task->input.eof() || size == 0)
+            FinishBackup(task, true);
+        else
+            boost::asio::post(GetIOContext(), boost::bind(&SQLiteDatabase::CompressBackup, this, task));
+    }
+
+    void SQLiteDatabase::FinishBackup(const Ref<BackupTask>& task, bool success)
+    {
+        if (task->backup != nullptr)
+            sqlite3_backup_finish(task->backup);
+        if (task->snapshot != nullptr)
+            sqlite3_close(task->snapshot);
+        task->input.close();
+        if (task->output != nullptr && gzclose(task->output) != Z_OK)
+            success = false;
+
+        // Remove snapshot and incomplete output
+        boost::system::error_code ec;
+        boost::filesystem::remove(task->snapshotPath, ec);
+        if (!success)
+            boost::filesystem::remove(task->path, ec);
+
+        if (success)
+            LOG_INFO("Finished database backup '{0}'.", task->path);
+        else
+            LOG_ERROR("Failed database backup '{0}'.", task->path);
+
+        ReportBackup(task,
+                     success ? DatabaseBackupStatus::kFinishedDatabaseBackupStatus
+                             : DatabaseBackupStatus::kFailedDatabaseBackupStatus,
+                     task->inputSize, task->inputSize);
+
+        backupActive = false;
+    }
+
+    void SQLiteDatabase::ReportBackup(const Ref<BackupTask>& task, DatabaseBackupStatus status, size_t progress,
+                                      size_t total)
+    {
+        if (!task->callback)
+            return;
+
+        // Report progress in whole percent steps
+        if (status == DatabaseBackupStatus::kCopyingDatabaseBackupStatus ||
+            status == DatabaseBackupStatus::kCompressingDatabaseBackupStatus)
+        {
+            size_t percent = total > 0 ? progress * 100 / total : 0;
+            if (percent == task->lastPercent && progress != 0)
+                return;
+            task->lastPercent = percent;
+        }
+
+        Ref<Worker> worker = Worker::GetInstance();
+        if (worker != nullptr)
+            worker->Post(WorkerHandlerKind::kDatabaseWorkerHandlerKind, "backup-callback", 0,
+                         boost::bind(task->callback, status, progress, total));
+    }
+}
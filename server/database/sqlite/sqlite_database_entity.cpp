@@ -3,17 +3,17 @@
 namespace server
 {
     bool SQLiteDatabase::LoadEntities(
-        const boost::function<bool(identifier_t id, const std::string& type, const std::string& name,
+        const boost::function<bool(identifier_t id, uint8_t type, const std::string_view& name,
                                    identifier_t scriptSourceID, const std::string_view& attributes,
                                    const std::string_view& state)>& callback)
     {
         // Insert into database
         sqlite3_stmt* statement;
 
-        if (sqlite3_prepare_v2(connection, R"(select id, type, name, scriptsourceid, attributes, state from entities)",
+        if (sqlite3_prepare_v2(readConnection, R"(select id, type, name, scriptsourceid, attributes, state from entities)",
                                -1, &statement, nullptr) != SQLITE_OK)
         {
-            LOG_ERROR("Failed to prepare sql load entities statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to prepare sql load entities statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return false;
         }
@@ -22,15 +22,14 @@ namespace server
         {
             identifier_t id = sqlite3_column_int64(statement, 0);
 
-            //! Type field
+            //! Type field (migrated databases keep the text affinity, sqlite converts the value)
             if (sqlite3_column_type(statement, 1) == SQLITE_NULL)
             {
                 LOG_ERROR("Invalid type field of entity {0}", id);
                 continue;
             }
 
-            const unsigned char* type = sqlite3_column_text(statement, 1);
-            size_t typeSize = sqlite3_column_bytes(statement, 1);
+            uint8_t type = sqlite3_column_int(statement, 1);
 
             //! Name field
             if (sqlite3_column_type(statement, 2) == SQLITE_NULL)
@@ -54,17 +53,18 @@ namespace server
                 attributesSize = 0;
             }
 
-            //! State field
-            const unsigned char* state = sqlite3_column_text(statement, 5);
+            //! State field (binary)
+            const void* state = sqlite3_column_blob(statement, 5);
             size_t stateSize = sqlite3_column_bytes(statement, 5);
             if (state == nullptr)
             {
-                state = (const uint8_t*)"";
+                state = "";
                 stateSize = 0;
             }
 
-            callback(id, std::string((const char*)type, typeSize), std::string((const char*)name, nameSize),
-                     scriptSourceId, std::string_view((const char*)attributes, attributesSize),
+            // Column buffers are passed without copies (valid until the next step)
+            callback(id, type, std::string_view((const char*)name, nameSize), scriptSourceId,
+                     std::string_view((const char*)attributes, attributesSize),
                      std::string_view((const char*)state, stateSize));
         }
 
@@ -72,14 +72,19 @@ namespace server
         return true;
     }
 
-    identifier_t SQLiteDatabase::ReserveEntity(const std::string& type)
+    identifier_t SQLiteDatabase::ReserveEntity(uint8_t type)
+    {
+        // Run on the database thread, the write connection is not shared with the worker
+        return RunSync<identifier_t>([this, type]() -> identifier_t { return InsertEntity(type); });
+    }
+    identifier_t SQLiteDatabase::InsertEntity(uint8_t type)
     {
         // Insert into database
         sqlite3_stmt* statement;
 
         if (sqlite3_prepare_v2(
                 connection,
-                R"(insert into entities values((select ifnull((select (id+1) from entities where (id+1) not in (select id from entities) order by id asc limit 1), 1)), ?, "no name", 0, null, null))",
+                R"(insert into entities values((select ifnull((select (id+1) from entities where (id+1) not in (select id from entities) order by id asc limit 1), 1)), ?, "no name", 0, null, null) returning id)",
                 -1, &statement, nullptr) != SQLITE_OK)
         {
             LOG_ERROR("Failed to prepare sql reserve entity statement.\n{0}", sqlite3_errmsg(connection));
@@ -87,21 +92,21 @@ namespace server
             return 0;
         }
 
-        if (sqlite3_bind_text(statement, 1, type.data(), type.size(), nullptr) != SQLITE_OK) // type
+        if (sqlite3_bind_int(statement, 1, type) != SQLITE_OK) // type
         {
             LOG_ERROR("Failed to bind sql parameters.\n{0}", sqlite3_errmsg(connection));
             sqlite3_finalize(statement);
             return false;
         }
 
-        if (sqlite3_step(statement) != SQLITE_DONE)
+        if (sqlite3_step(statement) != SQLITE_ROW)
         {
             LOG_ERROR("Failed to execute sql reserve entity statement.\n{0}", sqlite3_errmsg(connection));
             sqlite3_finalize(statement);
             return 0;
         }
 
-        identifier_t entityId = sqlite3_last_insert_rowid(connection);
+        identifier_t entityId = sqlite3_column_int64(statement, 0);
 
         sqlite3_finalize(statement);
         return entityId;
@@ -155,7 +160,7 @@ namespace server
             return false;
         }
 
-        if (sqlite3_bind_text(statement, 1, state.data(), state.size(), nullptr) != SQLITE_OK ||
+        if (sqlite3_bind_blob(statement, 1, state.data(), state.size(), nullptr) != SQLITE_OK ||
             sqlite3_bind_int64(statement, 2, id) != SQLITE_OK)
         {
             LOG_ERROR("Failed to bind sql parameters.\n{0}", sqlite3_errmsg(connection));
@@ -211,16 +216,16 @@ namespace server
         // Insert into database
         sqlite3_stmt* statement;
 
-        if (sqlite3_prepare_v2(connection, R"(select count(*) from entities)", -1, &statement, nullptr) != SQLITE_OK)
+        if (sqlite3_prepare_v2(readConnection, R"(select count(*) from entities)", -1, &statement, nullptr) != SQLITE_OK)
         {
-            LOG_ERROR("Failed to prepare sql count entities statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to prepare sql count entities statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return 0;
         }
 
         if (sqlite3_step(statement) != SQLITE_ROW)
         {
-            LOG_ERROR("Failed to execute sql count entities statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to execute sql count entities statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return 0;
         }
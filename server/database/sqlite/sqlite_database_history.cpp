@@ -0,0 +1,118 @@
+#include "sqlite_database.hpp"
+
+namespace server
+{
+    bool SQLiteDatabase::AddHistoryBlock(identifier_t entityId, const std::string& property, uint8_t resolution,
+                                         int64_t begin, int64_t end, size_t count, const std::string_view& data)
+    {
+        // Insert into database
+        sqlite3_stmt* statement;
+
+        if (sqlite3_prepare_v2(connection, R"(insert into history values(?, ?, ?, ?, ?, ?, ?))", -1, &statement,
+                               nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR("Failed to prepare sql add history block statement.\n{0}", sqlite3_errmsg(connection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        if (sqlite3_bind_int64(statement, 1, entityId) != SQLITE_OK ||                                 // entityid
+            sqlite3_bind_text(statement, 2, property.data(), property.size(), nullptr) != SQLITE_OK || // property
+            sqlite3_bind_int(statement, 3, resolution) != SQLITE_OK ||                                 // resolution
+            sqlite3_bind_int64(statement, 4, begin) != SQLITE_OK ||                                    // firsttime
+            sqlite3_bind_int64(statement, 5, end) != SQLITE_OK ||                                      // lasttime
+            sqlite3_bind_int64(statement, 6, count) != SQLITE_OK ||                                    // count
+            sqlite3_bind_blob(statement, 7, data.data(), data.size(), nullptr) != SQLITE_OK)          // data
+        {
+            LOG_ERROR("Failed to bind sql parameters.\n{0}", sqlite3_errmsg(connection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        if (sqlite3_step(statement) != SQLITE_DONE)
+        {
+            LOG_ERROR("Failed to execute sql add history block statement.\n{0}", sqlite3_errmsg(connection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        sqlite3_finalize(statement);
+        return true;
+    }
+
+    bool SQLiteDatabase::LoadHistoryBlocks(
+        identifier_t entityId, const std::string& property, uint8_t resolution, int64_t from, int64_t to,
+        const boost::function<void(int64_t begin, int64_t end, size_t count, const std::string_view& data)>& callback)
+    {
+        sqlite3_stmt* statement;
+
+        if (sqlite3_prepare_v2(
+                readConnection,
+                R"(select firsttime, lasttime, count, data from history where entityid = ? and property = ? and resolution = ? and lasttime >= ? and firsttime <= ? order by firsttime asc)",
+                -1, &statement, nullptr) != SQLITE_OK)
+        {
+            LOG_ERROR("Failed to prepare sql load history blocks statement.\n{0}", sqlite3_errmsg(readConnection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        if (sqlite3_bind_int64(statement, 1, entityId) != SQLITE_OK ||
+            sqlite3_bind_text(statement, 2, property.data(), property.size(), nullptr) != SQLITE_OK ||
+            sqlite3_bind_int(statement, 3, resolution) != SQLITE_OK ||
+            sqlite3_bind_int64(statement, 4, from) != SQLITE_OK ||
+            sqlite3_bind_int64(statement, 5, to) != SQLITE_OK)
+        {
+            LOG_ERROR("Failed to bind sql parameters.\n{0}", sqlite3_errmsg(readConnection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        while (sqlite3_step(statement) == SQLITE_ROW)
+        {
+            int64_t begin = sqlite3_column_int64(statement, 0);
+            int64_t end = sqlite3_column_int64(statement, 1);
+            size_t count = sqlite3_column_int64(statement, 2);
+
+            //! Data field
+            const void* data = sqlite3_column_blob(statement, 3);
+            size_t dataSize = sqlite3_column_bytes(statement, 3);
+            if (data == nullptr)
+                continue;
+
+            callback(begin, end, count, std::string_view((const char*)data, dataSize));
+        }
+
+        sqlite3_finalize(statement);
+        return true;
+    }
+
+    bool SQLiteDatabase::RemoveHistory(identifier_t entityId)
+    {
+        sqlite3_stmt* statement;
+
+        if (sqlite3_prepare_v2(connection, R"(delete from history where entityid = ?)", -1, &statement, nullptr) !=
+            SQLITE_OK)
+        {
+            LOG_ERROR("Failed to prepare sql remove history statement.\n{0}", sqlite3_errmsg(connection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        if (sqlite3_bind_int64(statement, 1, entityId) != SQLITE_OK)
+        {
+            LOG_ERROR("Failed to bind sql parameters.\n{0}", sqlite3_errmsg(connection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        if (sqlite3_step(statement) != SQLITE_DONE)
+        {
+            LOG_ERROR("Failed to execute sql remove history statement.\n{0}", sqlite3_errmsg(connection));
+            sqlite3_finalize(statement);
+            return false;
+        }
+
+        sqlite3_finalize(statement);
+        return true;
+    }
+}
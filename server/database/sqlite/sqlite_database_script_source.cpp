@@ -8,10 +8,10 @@ namespace server
     {
         sqlite3_stmt* statement;
 
-        if (sqlite3_prepare_v2(connection, R"(select id, language, name, config, content from scriptsources)", -1,
+        if (sqlite3_prepare_v2(readConnection, R"(select id, language, name, config, content from scriptsources)", -1,
                                &statement, nullptr) != SQLITE_OK)
         {
-            LOG_ERROR("Failed to prepare sql load script sources statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to prepare sql load script sources statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return false;
         }
@@ -73,12 +73,17 @@ namespace server
     }
 
     identifier_t SQLiteDatabase::ReserveScriptSource(const std::string& language)
+    {
+        // Run on the database thread, the write connection is not shared with the worker
+        return RunSync<identifier_t>([this, language]() -> identifier_t { return InsertScriptSource(language); });
+    }
+    identifier_t SQLiteDatabase::InsertScriptSource(const std::string& language)
     {
         sqlite3_stmt* statement;
 
         if (sqlite3_prepare_v2(
                 connection,
-                R"(insert into scriptsources values((select ifnull((select id+1 from scriptsources where (id+1) not in (select id from scriptsources) order by id asc limit 1), 1)), ?, "no name", null, null))",
+                R"(insert into scriptsources values((select ifnull((select id+1 from scriptsources where (id+1) not in (select id from scriptsources) order by id asc limit 1), 1)), ?, "no name", null, null) returning id)",
                 -1, &statement, nullptr) != SQLITE_OK)
         {
             LOG_ERROR("Failed to prepare sql reserve script source statement.\n{0}", sqlite3_errmsg(connection));
@@ -93,14 +98,14 @@ namespace server
             return false;
         }
 
-        if (sqlite3_step(statement) != SQLITE_DONE)
+        if (sqlite3_step(statement) != SQLITE_ROW)
         {
             LOG_ERROR("Failed to execute sql reserve script source statement\n{0}", sqlite3_errmsg(connection));
             sqlite3_finalize(statement);
             return 0;
         }
 
-        identifier_t scriptSourceId = sqlite3_last_insert_rowid(connection);
+        identifier_t scriptSourceId = sqlite3_column_int64(statement, 0);
 
         sqlite3_finalize(statement);
         return scriptSourceId;
@@ -204,17 +209,17 @@ namespace server
     {
         sqlite3_stmt* statement;
 
-        if (sqlite3_prepare_v2(connection, R"(select count(*) from scriptsources)", -1, &statement, nullptr) !=
+        if (sqlite3_prepare_v2(readConnection, R"(select count(*) from scriptsources)", -1, &statement, nullptr) !=
             SQLITE_OK)
         {
-            LOG_ERROR("Failed to prepare sql count script sources statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to prepare sql count script sources statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return 0;
         }
 
         if (sqlite3_step(statement) != SQLITE_ROW)
         {
-            LOG_ERROR("Failed to execute sql count script sources statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to execute sql count script sources statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return 0;
         }
@@ -9,10 +9,10 @@ namespace server
     {
         sqlite3_stmt* statement;
 
-        if (sqlite3_prepare_v2(connection, R"(select id, name, hash, salt, accesslevel, config from users)", -1,
+        if (sqlite3_prepare_v2(readConnection, R"(select id, name, hash, salt, accesslevel, config from users)", -1,
                                &statement, nullptr) != SQLITE_OK)
         {
-            LOG_ERROR("Failed to prepare sql load users statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to prepare sql load users statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return false;
         }
@@ -137,12 +137,17 @@ namespace server
     }
 
     identifier_t SQLiteDatabase::ReserveUser(const std::string& name)
+    {
+        // Run on the database thread, the write connection is not shared with the worker
+        return RunSync<identifier_t>([this, name]() -> identifier_t { return InsertUser(name); });
+    }
+    identifier_t SQLiteDatabase::InsertUser(const std::string& name)
     {
         sqlite3_stmt* statement;
 
         if (sqlite3_prepare_v2(
                 connection,
-                R"(insert into users values((select ifnull((select id+1 from users where (id+1) not in (select id from users) order by id asc limit 1), 1)), ?, "", "", "", "{}"))",
+                R"(insert into users values((select ifnull((select id+1 from users where (id+1) not in (select id from users) order by id asc limit 1), 1)), ?, "", "", "", "{}") returning id)",
                 -1, &statement, nullptr) != SQLITE_OK)
         {
             LOG_ERROR("Failed to prepare sql reserve user statement.\n{0}", sqlite3_errmsg(connection));
@@ -157,14 +162,14 @@ namespace server
             return false;
         }
 
-        if (sqlite3_step(statement) != SQLITE_DONE)
+        if (sqlite3_step(statement) != SQLITE_ROW)
         {
             LOG_ERROR("Failed to execute sql reserve user statement.\n{0}", sqlite3_errmsg(connection));
             sqlite3_finalize(statement);
             return 0;
         }
 
-        identifier_t id = sqlite3_last_insert_rowid(connection);
+        identifier_t id = sqlite3_column_int64(statement, 0);
 
         sqlite3_finalize(statement);
         return id;
@@ -270,16 +275,16 @@ namespace server
     {
         sqlite3_stmt* statement;
 
-        if (sqlite3_prepare_v2(connection, R"(select count(*) from users)", -1, &statement, nullptr) != SQLITE_OK)
+        if (sqlite3_prepare_v2(readConnection, R"(select count(*) from users)", -1, &statement, nullptr) != SQLITE_OK)
         {
-            LOG_ERROR("Failed to prepare sql count users statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to prepare sql count users statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return 0;
         }
 
         if (sqlite3_step(statement) != SQLITE_ROW)
         {
-            LOG_ERROR("Failed to execute sql count users statement.\n{0}", sqlite3_errmsg(connection));
+            LOG_ERROR("Failed to execute sql count users statement.\n{0}", sqlite3_errmsg(readConnection));
             sqlite3_finalize(statement);
             return 0;
         }
@@ -10,6 +10,7 @@ target("server-database")
         "robin-hood-hashing", 
         "xxhash",
         "sqlite3",
+        "zlib",
         "cppcodec"
     )
 
@@ -38,14 +38,29 @@ namespace server
         void Device::SetRoom(const Ref<Room>& v)
         {
             room = v;
+            Invalidate();
+
+            // The new room may be subscribed
+            WakeLazyUpdateIfSubscribed();
         }
 
-        identifier_t Device::GetRoomID()
+        identifier_t Device::GetRoomID() const
         {
             Ref<Room> roomRef = room.lock();
             return roomRef != nullptr ? roomRef->GetID() : 0;
         }
 
+        size_t Device::GetTopics(api::topic_t* topics) const
+        {
+            size_t topicCount = Entity::GetTopics(topics);
+
+            identifier_t roomId = GetRoomID();
+            if (roomId != 0)
+                topics[topicCount++] = api::MakeTopic(api::TopicType::kRoomTopic, roomId);
+
+            return topicCount;
+        }
+
         void Device::JsonGetAttributes(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const
         {
             assert(output.IsObject());
@@ -80,6 +95,9 @@ namespace server
                 update = true;
             }
 
+            if (update)
+                Invalidate();
+
             return update;
         }
 
@@ -129,5 +147,11 @@ namespace server
             if (Ref<Device> r = device.lock())
                 r->PublishState();
         }
+
+        void DeviceView::Invalidate()
+        {
+            if (Ref<Device> r = device.lock())
+                r->Invalidate();
+        }
     }
 }
\ No newline at end of file
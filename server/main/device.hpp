@@ -44,7 +44,13 @@ namespace server
             /// @brief Get room id
             ///
             /// @return identifier_t Room id or zero
-            identifier_t GetRoomID();
+            identifier_t GetRoomID() const;
+
+            /// @brief Get subscription topics (includes the room topic)
+            ///
+            /// @param topics Topic list (at least ENTITY_MAX_TOPIC_COUNT entries)
+            /// @return size_t Topic count
+            virtual size_t GetTopics(api::topic_t* topics) const override;
 
             /// @brief Get view
             ///
@@ -85,6 +91,7 @@ namespace server
 
             virtual void Publish() override;
             virtual void PublishState() override;
+            virtual void Invalidate() override;
         };
     }
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "home.hpp"
 #include "room.hpp"
 #include "service.hpp"
+#include "state_publisher.hpp"
+#include <api/websocket_session.hpp>
+#include <database/binary_state.hpp>
 #include <database/database.hpp>
 #include <scripting/script.hpp>
 #include <scripting/script_manager.hpp>
@@ -103,29 +106,30 @@ namespace server
         }
         Ref<Entity> Entity::Create(identifier_t id, EntityType type, const std::string& name,
                                    identifier_t scriptSourceID, const std::string_view& attributes,
-                                   const std::string_view& state)
+                                   const std::string_view& state, rapidjson::Document::AllocatorType* allocator)
         {
-            rapidjson::Document configJson, stateJson;
+            // Parse into the caller's allocator if provided (reused between entities while loading)
+            rapidjson::Document configJson = rapidjson::Document(allocator);
+            rapidjson::Document stateJson = rapidjson::Document(allocator);
 
-            // Parse attributes
+            // Parse attributes (views are not null terminated)
             {
-                rapidjson::StringStream stream = rapidjson::StringStream(attributes.data());
-                configJson.ParseStream(stream);
+                configJson.Parse(attributes.data(), attributes.size());
                 if (configJson.HasParseError() || !configJson.IsObject())
                 {
                     LOG_WARNING("Failed to parse attributes of entity '{0}'.", id);
-                    configJson = rapidjson::Document(rapidjson::kObjectType);
+                    configJson.SetObject();
                 }
             }
 
-            // Parse script state
+            // Decode script state
             {
-                rapidjson::StringStream stream = rapidjson::StringStream(state.data());
-                stateJson.ParseStream(stream);
-                if (configJson.HasParseError() || !configJson.IsObject())
+                if (state.empty())
+                    stateJson.SetObject();
+                else if (!DecodeBinaryState(state, stateJson, stateJson.GetAllocator()) || !stateJson.IsObject())
                 {
-                    LOG_WARNING("Failed to parse state of entity '{0}'.", id);
-                    stateJson = rapidjson::Document(rapidjson::kObjectType);
+                    LOG_WARNING("Failed to decode state of entity '{0}'.", id);
+                    stateJson.SetObject();
                 }
             }
 
@@ -159,41 +163,86 @@ namespace server
             {
                 script = nullptr;
             }
+
+            Invalidate();
+        }
+
+        size_t Entity::GetTopics(api::topic_t* topics) const
+        {
+            topics[0] = api::MakeTopic(api::TopicType::kEntityTopic, id);
+            topics[1] = api::MakeTopic(api::TopicType::kEntityTypeTopic, (uint64_t)GetType());
+            return 2;
         }
 
         void Entity::Subscribe(const Ref<api::WebSocketSession>& session)
         {
-            if (sessions.AddSession(session))
+            Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+            assert(subscriptionManager != nullptr);
+
+            if (subscriptionManager->Subscribe(session->GetID(), api::MakeTopic(api::TopicType::kEntityTopic, id)))
+                WakeLazyUpdate();
+        }
+
+        void Entity::WakeLazyUpdate()
+        {
+            if (lazyUpdateInterval > 0 && !lazyUpdateActive)
             {
-                if (lazyUpdateInterval > 0)
-                {
-                    lazyUpdateTimer.expires_from_now(boost::posix_time::seconds(0));
-                    lazyUpdateTimer.async_wait(
-                        boost::bind(&Entity::WaitLazyUpdateTimer, shared_from_this(), boost::placeholders::_1));
-                }
+                lazyUpdateActive = true;
+
+                lazyUpdateTimer.expires_from_now(boost::posix_time::seconds(0));
+                lazyUpdateTimer.async_wait(
+                    boost::bind(&Entity::WaitLazyUpdateTimer, shared_from_this(), boost::placeholders::_1));
             }
         }
 
+        void Entity::WakeLazyUpdateIfSubscribed()
+        {
+            if (lazyUpdateInterval == 0 || lazyUpdateActive)
+                return;
+
+            Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+            assert(subscriptionManager != nullptr);
+
+            // Wildcard subscriptions cover entities added or moved after the subscription
+            api::topic_t topics[ENTITY_MAX_TOPIC_COUNT];
+            size_t topicCount = GetTopics(topics);
+            if (subscriptionManager->HasSubscribers(topics, topicCount))
+                WakeLazyUpdate();
+        }
+
         void Entity::WaitLazyUpdateTimer(const boost::system::error_code& ec)
         {
             if (!ec)
             {
+                WorkerHandlerScope scope(WorkerHandlerKind::kTimerWorkerHandlerKind, "entity-lazy-update", id);
+
                 if (script != nullptr)
                     script->LazyUpdate();
 
+                Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+                assert(subscriptionManager != nullptr);
+
                 // Only reset timer if there are subscriptions left
-                if (sessions.GetSessionCount() > 0)
+                api::topic_t topics[ENTITY_MAX_TOPIC_COUNT];
+                size_t topicCount = GetTopics(topics);
+                if (subscriptionManager->HasSubscribers(topics, topicCount))
                 {
                     lazyUpdateTimer.expires_from_now(boost::posix_time::seconds(std::max(lazyUpdateInterval, 1ul)));
                     lazyUpdateTimer.async_wait(
                         boost::bind(&Entity::WaitLazyUpdateTimer, shared_from_this(), boost::placeholders::_1));
+                    return;
                 }
             }
+
+            lazyUpdateActive = false;
         }
 
         void Entity::Unsubscribe(const Ref<api::WebSocketSession>& session)
         {
-            sessions.RemoveSession(session);
+            Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+            assert(subscriptionManager != nullptr);
+
+            subscriptionManager->Unsubscribe(session->GetID(), api::MakeTopic(api::TopicType::kEntityTopic, id));
         }
 
         void Entity::Invoke(const std::string& method, const scripting::sdk::Value& parameter)
@@ -205,28 +254,27 @@ namespace server
         void Entity::Publish()
         {
             api::ApiBroadcastMessage message = api::ApiBroadcastMessage("set-entity");
-            JsonGet(message.GetJsonDocument(), message.GetJsonAllocator());
 
-            sessions.Send(message);
+            Ref<const rapidjson::StringBuffer> json = GetJson();
+            message.AddRawMembers(std::string_view(json->GetString(), json->GetSize()));
+
+            Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+            assert(subscriptionManager != nullptr);
+
+            api::topic_t topics[ENTITY_MAX_TOPIC_COUNT];
+            size_t topicCount = GetTopics(topics);
+            subscriptionManager->Send(topics, topicCount, message);
         }
 
         void Entity::PublishState()
         {
-            api::ApiBroadcastMessage message = api::ApiBroadcastMessage("set-entity-state");
-            {
+            Ref<StatePublisher> statePublisher = StatePublisher::GetInstance();
+            assert(statePublisher != nullptr);
 
-                rapidjson::Document& output = message.GetJsonDocument();
-                rapidjson::Document::AllocatorType& allocator = message.GetJsonAllocator();
-
-                rapidjson::Value stateJson = rapidjson::Value(rapidjson::kObjectType);
-                JsonGetState(stateJson, allocator);
-                output.AddMember("state", stateJson, allocator);
-            }
-
-            sessions.Send(message);
+            statePublisher->Publish(shared_from_this());
         }
 
-        bool Entity::Save()
+        void Entity::Save()
         {
             Ref<Database> database = Database::GetInstance();
             assert(database != nullptr);
@@ -245,30 +293,39 @@ namespace server
             }
 
             // Update database
-            return database->UpdateEntity(id, name, GetScriptSourceId(),
-                                          std::string_view(attributes.GetString(), attributes.GetSize()));
+            database->UpdateEntityAsync(id, name, GetScriptSourceId(),
+                                        std::string_view(attributes.GetString(), attributes.GetSize()),
+                                        [id = id](bool result) -> void
+                                        {
+                                            if (!result)
+                                                LOG_ERROR("Failed to save entity '{0}'.", id);
+                                        });
         }
 
-        bool Entity::SaveState()
+        void Entity::SaveState()
         {
             Ref<Database> database = Database::GetInstance();
             assert(database != nullptr);
 
-            // Generate json state
-            rapidjson::StringBuffer state = rapidjson::StringBuffer();
+            // Generate binary state
+            std::string state;
             {
                 // Generate json
                 rapidjson::Document document = rapidjson::Document(rapidjson::kObjectType);
                 if (script != nullptr)
                     script->JsonGetProperties(document, document.GetAllocator(), scripting::kPropertyFlag_Store);
 
-                // Stringify json
-                rapidjson::Writer<rapidjson::StringBuffer> writer = rapidjson::Writer<rapidjson::StringBuffer>(state);
-                document.Accept(writer);
+                // Encode json
+                EncodeBinaryState(document, state);
             }
 
             // Update database
-            return database->UpdateEntityState(id, std::string_view(state.GetString(), state.GetSize()));
+            database->UpdateEntityStateAsync(id, state,
+                                             [id = id](bool result) -> void
+                                             {
+                                                 if (!result)
+                                                     LOG_ERROR("Failed to save state of entity '{0}'.", id);
+                                             });
         }
 
         void Entity::JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const
@@ -295,6 +352,86 @@ namespace server
 
             output.AddMember("attributes", attributesJson, allocator);
         }
+        void Entity::Invalidate()
+        {
+            version++;
+
+            Ref<Home> home = Home::GetInstance();
+            assert(home != nullptr);
+
+            home->RecordChange(id);
+        }
+
+        Ref<const rapidjson::StringBuffer> Entity::GetJson() const
+        {
+            boost::lock_guard lock(jsonCacheMutex);
+
+            size_t currentVersion = version;
+            if (jsonCache == nullptr || jsonCacheVersion != currentVersion)
+            {
+                // Rebuild cache (previous buffers stay valid for their current users)
+                Ref<rapidjson::StringBuffer> buffer = boost::make_shared<rapidjson::StringBuffer>();
+                JsonGet(*buffer);
+
+                jsonCache = buffer;
+                jsonCacheVersion = currentVersion;
+            }
+
+            return jsonCache;
+        }
+
+        void Entity::JsonGet(rapidjson::StringBuffer& buffer) const
+        {
+            rapidjson::Writer<rapidjson::StringBuffer> writer = rapidjson::Writer<rapidjson::StringBuffer>(buffer);
+
+            writer.StartObject();
+
+            writer.Key("id", 2);
+            writer.Uint64(id);
+
+            std::string type = StringifyEntityType(GetType());
+            writer.Key("type", 4);
+            writer.String(type.data(), type.size(), true);
+
+            writer.Key("name", 4);
+            writer.String(name.data(), name.size(), true);
+
+            writer.Key("scriptsourceid", 14);
+            if (script != nullptr)
+                writer.Uint64(script->GetSourceID());
+            else
+                writer.Null();
+
+            // Attributes field
+            {
+                writer.Key("attributes", 10);
+                writer.StartObject();
+
+                rapidjson::Document attributesJson = rapidjson::Document(rapidjson::kObjectType);
+                JsonGetAttributes(attributesJson, attributesJson.GetAllocator());
+
+                // Splice script attributes (the writer does not know about them, so add the separator manually)
+                if (script != nullptr)
+                {
+                    std::string_view scriptAttributes = rapidjson::GetRawMembers(script->GetAttributesJson());
+                    rapidjson::PutRawMembers(buffer, scriptAttributes, false);
+
+                    if (!scriptAttributes.empty() && attributesJson.MemberCount() > 0)
+                        buffer.Put(',');
+                }
+
+                for (rapidjson::Value::ConstMemberIterator memberIt = attributesJson.MemberBegin();
+                     memberIt != attributesJson.MemberEnd(); memberIt++)
+                {
+                    writer.Key(memberIt->name.GetString(), memberIt->name.GetStringLength());
+                    memberIt->value.Accept(writer);
+                }
+
+                writer.EndObject();
+            }
+
+            writer.EndObject();
+        }
         bool Entity::JsonSet(const rapidjson::Value& input)
         {
             assert(input.IsObject());
@@ -305,6 +442,7 @@ namespace server
             if (nameIt != input.MemberEnd() && nameIt->value.IsString())
             {
                 name.assign(nameIt->value.GetString(), nameIt->value.GetStringLength());
+                Invalidate();
                 update = true;
             }
 
@@ -312,6 +450,7 @@ namespace server
             if (scriptSourceIDIt != input.MemberEnd() && scriptSourceIDIt->value.IsUint())
             {
                 SetScript(scriptSourceIDIt->value.GetUint());
+                WakeLazyUpdateIfSubscribed();
                 update = true;
             }
 
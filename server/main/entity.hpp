@@ -1,9 +1,11 @@
 #pragma once
 #include "common.hpp"
-#include <api/websocket_session_set.hpp>
+#include <api/subscription_manager.hpp>
 #include <scripting/script.hpp>
 #include <scripting_sdk/view/view.hpp>
 
+#define ENTITY_MAX_TOPIC_COUNT 3
+
 namespace server
 {
     namespace main
@@ -34,12 +36,19 @@ namespace server
             // A lazy update timer is executed when there is at least one subscription
             size_t lazyUpdateInterval;
             boost::asio::deadline_timer lazyUpdateTimer;
+            bool lazyUpdateActive = false;
 
             void WaitLazyUpdateTimer(const boost::system::error_code& ec);
 
-            /// @brief Update subscriptions
+            /// @brief Entity version (changes whenever the serialized entity changes)
+            ///
+            boost::atomic<size_t> version = 1;
+
+            /// @brief Serialized entity of a specific version
             ///
-            api::WebSocketSessionSet sessions;
+            mutable boost::mutex jsonCacheMutex;
+            mutable Ref<const rapidjson::StringBuffer> jsonCache;
+            mutable size_t jsonCacheVersion = 0;
 
           public:
             Entity(identifier_t id, const std::string& name);
@@ -49,7 +58,8 @@ namespace server
                                       const rapidjson::Value& stateJson);
             static Ref<Entity> Create(identifier_t id, EntityType type, const std::string& name,
                                       identifier_t scriptSourceID, const std::string_view& attributes,
-                                      const std::string_view& state);
+                                      const std::string_view& state,
+                                      rapidjson::Document::AllocatorType* allocator = nullptr);
 
             /// @brief Get entity type
             ///
@@ -78,8 +88,26 @@ namespace server
             void SetName(const std::string& v)
             {
                 name = v;
+                Invalidate();
+            }
+
+            /// @brief Get entity version
+            ///
+            /// @return size_t Entity version
+            inline size_t GetVersion() const
+            {
+                return version;
             }
 
+            /// @brief Invalidate serialized entity and record the change in the home change log
+            ///
+            void Invalidate();
+
+            /// @brief Get serialized entity (rebuilt when the version changed)
+            ///
+            /// @return Ref<const rapidjson::StringBuffer> Serialized entity
+            Ref<const rapidjson::StringBuffer> GetJson() const;
+
             /// @brief Get script
             ///
             /// @return Ref<scripting::Script> Script or null
@@ -111,6 +139,20 @@ namespace server
             /// @param event Method name
             void Invoke(const std::string& method, const scripting::sdk::Value& parameter);
 
+            /// @brief Get subscription topics of this entity
+            ///
+            /// @param topics Topic list (at least ENTITY_MAX_TOPIC_COUNT entries)
+            /// @return size_t Topic count
+            virtual size_t GetTopics(api::topic_t* topics) const;
+
+            /// @brief Start lazy update timer if it is not running already
+            ///
+            void WakeLazyUpdate();
+
+            /// @brief Start lazy update timer if a topic of this entity has subscribers (after its topics changed)
+            ///
+            void WakeLazyUpdateIfSubscribed();
+
             /// @brief Make session subscribe to entity
             ///
             /// @param session Api session
@@ -126,24 +168,29 @@ namespace server
             void Publish();
 
             /// @brief Push state changes to client
+            /// @note Changes are collected and sent once per worker tick
             ///
             void PublishState();
 
-            /// @brief Save/update entity in database
+            /// @brief Save/update entity in database (written asynchronously)
             ///
-            /// @return Successfulness
-            bool Save();
+            void Save();
 
-            /// @brief Save/update entity state in database
+            /// @brief Save/update entity state in database (written asynchronously)
             ///
-            /// @return Successfulness
-            bool SaveState();
+            void SaveState();
 
             virtual void JsonGetAttributes(rapidjson::Value& output,
                                            rapidjson::Document::AllocatorType& allocator) const = 0;
             virtual bool JsonSetAttributes(const rapidjson::Value& input) = 0;
 
             void JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const;
+
+            /// @brief Serialize entity directly into a buffer
+            /// @note Script attributes are spliced in from their cached serialization
+            ///
+            /// @param buffer Output buffer
+            void JsonGet(rapidjson::StringBuffer& buffer) const;
             bool JsonSet(const rapidjson::Value& input);
 
             void JsonGetState(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const;
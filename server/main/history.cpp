@@ -0,0 +1,401 @@
+#include "history.hpp"
+#include <common/worker.hpp>
+#include <database/database.hpp>
+#include <cmath>
+
+#define HISTORY_ROLLUP_INTERVAL 60
+
+namespace server
+{
+    namespace main
+    {
+        // Rollup bucket sizes in seconds (minute, hour, day)
+        static const int64_t rollupIntervals[HISTORY_ROLLUP_COUNT] = {60, 3600, 86400};
+
+        // Samples per block (raw, minute, hour, day)
+        static const size_t blockSizes[HISTORY_ROLLUP_COUNT + 1] = {512, 60, 24, 31};
+
+        // Maximum block age in seconds (raw, minute, hour, day)
+        static const int64_t blockAges[HISTORY_ROLLUP_COUNT + 1] = {3600, 3600, 86400, 31 * 86400};
+
+        std::string StringifyHistoryResolution(HistoryResolution resolution)
+        {
+            switch (resolution)
+            {
+            case HistoryResolution::kRawHistoryResolution:
+                return "raw";
+            case HistoryResolution::kMinuteHistoryResolution:
+                return "minute";
+            case HistoryResolution::kHourHistoryResolution:
+                return "hour";
+            case HistoryResolution::kDayHistoryResolution:
+                return "day";
+            default:
+                return "unknown";
+            }
+        }
+        HistoryResolution ParseHistoryResolution(const std::string& resolution)
+        {
+            switch (crc32(resolution.data(), resolution.size()))
+            {
+            case CRC32("raw"):
+                return HistoryResolution::kRawHistoryResolution;
+            case CRC32("minute"):
+                return HistoryResolution::kMinuteHistoryResolution;
+            case CRC32("hour"):
+                return HistoryResolution::kHourHistoryResolution;
+            case CRC32("day"):
+                return HistoryResolution::kDayHistoryResolution;
+            default:
+                return HistoryResolution::kUnknownHistoryResolution;
+            }
+        }
+
+        WeakRef<History> instanceHistory;
+
+        History::History() : rollupTimer(Worker::GetInstance()->GetContext())
+        {
+        }
+        History::~History()
+        {
+            Flush();
+        }
+        Ref<History> History::Create()
+        {
+            if (!instanceHistory.expired())
+                return Ref<History>(instanceHistory);
+
+            Ref<History> history = boost::make_shared<History>();
+            if (history == nullptr)
+                return nullptr;
+
+            instanceHistory = history;
+
+            // Start rollup timer
+            history->rollupTimer.expires_from_now(boost::posix_time::seconds(HISTORY_ROLLUP_INTERVAL));
+            history->rollupTimer.async_wait(
+                boost::bind(&History::WaitRollupTimer, WeakRef<History>(history), boost::placeholders::_1));
+
+            return history;
+        }
+        Ref<History> History::GetInstance()
+        {
+            return Ref<History>(instanceHistory);
+        }
+
+        void History::Record(identifier_t entityId, int64_t timestamp, const rapidjson::Value& state)
+        {
+            assert(state.IsObject());
+
+            boost::lock_guard lock(mutex);
+
+            for (rapidjson::Value::ConstMemberIterator memberIt = state.MemberBegin(); memberIt != state.MemberEnd();
+                 memberIt++)
+            {
+                double value;
+                if (memberIt->value.IsNumber())
+                    value = memberIt->value.GetDouble();
+                else if (memberIt->value.IsBool())
+                    value = memberIt->value.GetBool() ? 1.0 : 0.0;
+                else
+                    continue;
+
+                std::string property = std::string(memberIt->name.GetString(), memberIt->name.GetStringLength());
+                Series& series = seriesMap[entityId][property];
+
+                // Raw sample
+                if (series.raw.encoder.GetCount() == 0)
+                    series.raw.begin = timestamp;
+                else if (timestamp < series.raw.end)
+                    continue; // Clock went backwards
+
+                series.raw.encoder.Append(timestamp, &value);
+                series.raw.end = timestamp;
+
+                if (series.raw.encoder.GetCount() >= blockSizes[0])
+                    FlushBlock(entityId, property, HistoryResolution::kRawHistoryResolution, series, series.raw);
+
+                // Rollup buckets
+                for (size_t rollup = 0; rollup < HISTORY_ROLLUP_COUNT; rollup++)
+                {
+                    Bucket& bucket = series.buckets[rollup];
+
+                    int64_t begin = timestamp - timestamp % rollupIntervals[rollup];
+                    if (bucket.count > 0 && bucket.begin != begin)
+                        CloseBucket(entityId, property, series, rollup);
+
+                    if (bucket.count == 0)
+                    {
+                        bucket.begin = begin;
+                        bucket.sum = 0.0;
+                        bucket.min = value;
+                        bucket.max = value;
+                    }
+
+                    bucket.sum += value;
+                    bucket.min = std::min(bucket.min, value);
+                    bucket.max = std::max(bucket.max, value);
+                    bucket.count++;
+                }
+            }
+        }
+
+        void History::CloseBucket(identifier_t entityId, const std::string& property, Series& series, size_t rollup)
+        {
+            Bucket& bucket = series.buckets[rollup];
+            Block& block = series.rollups[rollup];
+
+            if (bucket.count == 0)
+                return;
+
+            double values[3] = {bucket.sum / bucket.count, bucket.min, bucket.max};
+
+            if (block.encoder.GetCount() == 0)
+                block.begin = bucket.begin;
+
+            block.encoder.Append(bucket.begin, values);
+            block.end = bucket.begin;
+            bucket.count = 0;
+
+            if (block.encoder.GetCount() >= blockSizes[rollup + 1])
+                FlushBlock(entityId, property, (HistoryResolution)(rollup + 1), series, block);
+        }
+
+        void History::FlushBlock(identifier_t entityId, const std::string& property, HistoryResolution resolution,
+                                 Series& series, Block& block)
+        {
+            if (block.encoder.GetCount() == 0)
+                return;
+
+            Ref<Database> database = Database::GetInstance();
+            assert(database != nullptr);
+
+            RemoveWrittenBlocks(series);
+
+            // Keep block readable until it is written
+            Ref<boost::atomic_bool> written = boost::make_shared<boost::atomic_bool>(false);
+            series.pendingBlocks.push_back(PendingBlock{
+                .written = written,
+                .resolution = resolution,
+                .begin = block.begin,
+                .count = block.encoder.GetCount(),
+                .data = block.encoder.GetData(),
+            });
+
+            database->AddHistoryBlockAsync(entityId, property, (uint8_t)resolution, block.begin, block.end,
+                                           block.encoder.GetCount(), block.encoder.GetData(),
+                                           [entityId, written](bool result) -> void
+                                           {
+                                               if (!result)
+                                                   LOG_ERROR("Failed to write history block of entity '{0}'.",
+                                                             entityId);
+
+                                               written->store(true);
+                                           });
+
+            block.encoder.Clear();
+        }
+        void History::RemoveWrittenBlocks(Series& series)
+        {
+            series.pendingBlocks.remove_if([](const PendingBlock& pendingBlock) -> bool
+                                           { return pendingBlock.written->load(); });
+        }
+
+        void History::WaitRollupTimer(const WeakRef<History>& historyRef, const boost::system::error_code& ec)
+        {
+            if (ec)
+                return;
+
+            Ref<History> history = historyRef.lock();
+            if (history == nullptr)
+                return;
+
+            WorkerHandlerScope scope(WorkerHandlerKind::kTimerWorkerHandlerKind, "history-rollup");
+
+            const int64_t now = time(nullptr);
+
+            {
+                boost::lock_guard lock(history->mutex);
+
+                for (auto& [entityId, propertyMap] : history->seriesMap)
+                {
+                    for (auto& [property, series] : propertyMap)
+                    {
+                        // Close finished buckets
+                        for (size_t rollup = 0; rollup < HISTORY_ROLLUP_COUNT; rollup++)
+                        {
+                            const Bucket& bucket = series.buckets[rollup];
+                            if (bucket.count > 0 && bucket.begin + rollupIntervals[rollup] <= now)
+                                history->CloseBucket(entityId, property, series, rollup);
+                        }
+
+                        // Flush old blocks
+                        if (series.raw.encoder.GetCount() > 0 && now - series.raw.begin >= blockAges[0])
+                            history->FlushBlock(entityId, property, HistoryResolution::kRawHistoryResolution,
+                                                series, series.raw);
+                        for (size_t rollup = 0; rollup < HISTORY_ROLLUP_COUNT; rollup++)
+                        {
+                            Block& block = series.rollups[rollup];
+                            if (block.encoder.GetCount() > 0 && now - block.begin >= blockAges[rollup + 1])
+                                history->FlushBlock(entityId, property, (HistoryResolution)(rollup + 1), series, block);
+                        }
+                    }
+                }
+            }
+
+            history->rollupTimer.expires_from_now(boost::posix_time::seconds(HISTORY_ROLLUP_INTERVAL));
+            history->rollupTimer.async_wait(
+                boost::bind(&History::WaitRollupTimer, historyRef, boost::placeholders::_1));
+        }
+
+        void History::Flush()
+        {
+            boost::lock_guard lock(mutex);
+
+            for (auto& [entityId, propertyMap] : seriesMap)
+            {
+                for (auto& [property, series] : propertyMap)
+                {
+                    FlushBlock(entityId, property, HistoryResolution::kRawHistoryResolution, series, series.raw);
+                    for (size_t rollup = 0; rollup < HISTORY_ROLLUP_COUNT; rollup++)
+                        FlushBlock(entityId, property, (HistoryResolution)(rollup + 1), series,
+                                   series.rollups[rollup]);
+                }
+            }
+        }
+
+        void History::Remove(identifier_t entityId)
+        {
+            {
+                boost::lock_guard lock(mutex);
+                seriesMap.erase(entityId);
+            }
+
+            Ref<Database> database = Database::GetInstance();
+            assert(database != nullptr);
+
+            database->RemoveHistoryAsync(entityId);
+        }
+
+        void History::JsonGet(identifier_t entityId, const std::string& property, HistoryResolution resolution,
+                              int64_t from, int64_t to, rapidjson::StringBuffer& buffer)
+        {
+            const uint8_t channelCount = resolution == HistoryResolution::kRawHistoryResolution ? 1 : 3;
+
+            rapidjson::Writer<rapidjson::StringBuffer> writer = rapidjson::Writer<rapidjson::StringBuffer>(buffer);
+
+            const auto writeSamples = [&](const std::string_view& data, size_t count) -> void
+            {
+                HistoryDecoder decoder = HistoryDecoder(data, count, channelCount);
+
+                int64_t timestamp;
+                double values[HISTORY_MAX_CHANNEL_COUNT];
+                while (decoder.Next(timestamp, values))
+                {
+                    if (timestamp < from)
+                        continue;
+                    if (timestamp > to)
+                        break;
+
+                    writer.StartArray();
+                    writer.Int64(timestamp);
+                    for (uint8_t i = 0; i < channelCount; i++)
+                    {
+                        if (std::isfinite(values[i]))
+                            writer.Double(values[i]);
+                        else
+                            writer.Null();
+                    }
+                    writer.EndArray();
+                }
+            };
+
+            writer.StartObject();
+
+            writer.Key("id", 2);
+            writer.Uint64(entityId);
+
+            writer.Key("property", 8);
+            writer.String(property.data(), property.size(), true);
+
+            std::string resolutionString = StringifyHistoryResolution(resolution);
+            writer.Key("resolution", 10);
+            writer.String(resolutionString.data(), resolutionString.size(), true);
+
+            writer.Key("samples", 7);
+            writer.StartArray();
+
+            // Written blocks are loaded from the database
+            {
+                boost::lock_guard lock(mutex);
+
+                robin_hood::unordered_node_map<identifier_t,
+                                               robin_hood::unordered_node_map<std::string, Series>>::iterator it =
+                    seriesMap.find(entityId);
+                if (it != seriesMap.end())
+                {
+                    robin_hood::unordered_node_map<std::string, Series>::iterator seriesIt = it->second.find(property);
+                    if (seriesIt != it->second.end())
+                        RemoveWrittenBlocks(seriesIt->second);
+                }
+            }
+
+            // Stored blocks
+            boost::container::vector<int64_t> storedBlocks;
+            {
+                Ref<Database> database = Database::GetInstance();
+                assert(database != nullptr);
+
+                database->LoadHistoryBlocks(entityId, property, (uint8_t)resolution, from, to,
+                                            [&](int64_t begin, int64_t end, size_t count,
+                                                const std::string_view& data) -> void
+                                            {
+                                                (void)end;
+                                                storedBlocks.push_back(begin);
+                                                writeSamples(data, count);
+                                            });
+            }
+
+            // Pending and open blocks
+            {
+                boost::container::vector<std::pair<std::string, size_t>> blocks;
+                {
+                    boost::lock_guard lock(mutex);
+
+                    robin_hood::unordered_node_map<identifier_t,
+                                                   robin_hood::unordered_node_map<std::string, Series>>::iterator it =
+                        seriesMap.find(entityId);
+                    if (it != seriesMap.end())
+                    {
+                        robin_hood::unordered_node_map<std::string, Series>::iterator seriesIt =
+                            it->second.find(property);
+                        if (seriesIt != it->second.end())
+                        {
+                            // Pending blocks may already be stored (written after the blocks were loaded)
+                            for (const PendingBlock& pendingBlock : seriesIt->second.pendingBlocks)
+                            {
+                                if (pendingBlock.resolution == resolution &&
+                                    std::find(storedBlocks.begin(), storedBlocks.end(), pendingBlock.begin) ==
+                                        storedBlocks.end())
+                                    blocks.emplace_back(pendingBlock.data, pendingBlock.count);
+                            }
+
+                            const Block& block = resolution == HistoryResolution::kRawHistoryResolution
+                                                     ? seriesIt->second.raw
+                                                     : seriesIt->second.rollups[(size_t)resolution - 1];
+                            if (block.encoder.GetCount() > 0)
+                                blocks.emplace_back(block.encoder.GetData(), block.encoder.GetCount());
+                        }
+                    }
+                }
+
+                for (const std::pair<std::string, size_t>& block : blocks)
+                    writeSamples(block.first, block.second);
+            }
+
+            writer.EndArray();
+
+            writer.EndObject();
+        }
+    }
+}
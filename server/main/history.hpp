@@ -0,0 +1,120 @@
+#pragma once
+#include "common.hpp"
+#include "history_codec.hpp"
+
+#define HISTORY_ROLLUP_COUNT 3
+
+namespace server
+{
+    namespace main
+    {
+        enum class HistoryResolution : uint8_t
+        {
+            kRawHistoryResolution = 0,
+            kMinuteHistoryResolution = 1,
+            kHourHistoryResolution = 2,
+            kDayHistoryResolution = 3,
+            kUnknownHistoryResolution = 0xFF,
+        };
+
+        std::string StringifyHistoryResolution(HistoryResolution resolution);
+        HistoryResolution ParseHistoryResolution(const std::string& resolution);
+
+        /// @brief Append-only time-series store of numeric entity state properties
+        ///
+        /// Raw samples and 1-minute, 1-hour and 1-day rollups (average, minimum, maximum) are compressed into blocks
+        /// that are written through the database once they are full.
+        class History : public boost::enable_shared_from_this<History>
+        {
+          private:
+            struct Block
+            {
+                int64_t begin = 0;
+                int64_t end = 0;
+                HistoryEncoder encoder;
+
+                Block(uint8_t channelCount) : encoder(channelCount)
+                {
+                }
+            };
+
+            struct Bucket
+            {
+                int64_t begin = 0;
+                double sum = 0.0;
+                double min = 0.0;
+                double max = 0.0;
+                size_t count = 0;
+            };
+
+            /// @brief Flushed block that is not written to the database yet
+            ///
+            struct PendingBlock
+            {
+                /// @brief Set by the write callback (the block is removed by the next flush or query)
+                ///
+                Ref<boost::atomic_bool> written;
+                HistoryResolution resolution;
+                int64_t begin;
+                size_t count;
+                std::string data;
+            };
+
+            struct Series
+            {
+                Block raw = Block(1);
+                Block rollups[HISTORY_ROLLUP_COUNT] = {Block(3), Block(3), Block(3)};
+                Bucket buckets[HISTORY_ROLLUP_COUNT];
+
+                /// @brief Flushed blocks (readable until their write finished)
+                ///
+                boost::container::list<PendingBlock> pendingBlocks;
+            };
+
+            boost::mutex mutex;
+            robin_hood::unordered_node_map<identifier_t, robin_hood::unordered_node_map<std::string, Series>> seriesMap;
+
+            boost::asio::deadline_timer rollupTimer;
+
+            static void WaitRollupTimer(const WeakRef<History>& historyRef, const boost::system::error_code& ec);
+
+            void CloseBucket(identifier_t entityId, const std::string& property, Series& series, size_t rollup);
+            void FlushBlock(identifier_t entityId, const std::string& property, HistoryResolution resolution,
+                            Series& series, Block& block);
+            static void RemoveWrittenBlocks(Series& series);
+
+          public:
+            History();
+            virtual ~History();
+            static Ref<History> Create();
+            static Ref<History> GetInstance();
+
+            /// @brief Record all numeric properties of an entity state
+            ///
+            /// @param entityId Entity id
+            /// @param timestamp Timestamp
+            /// @param state Entity state
+            void Record(identifier_t entityId, int64_t timestamp, const rapidjson::Value& state);
+
+            /// @brief Write all open blocks to the database
+            ///
+            void Flush();
+
+            /// @brief Remove history of entity
+            ///
+            /// @param entityId Entity id
+            void Remove(identifier_t entityId);
+
+            /// @brief Serialize samples of a time range
+            ///
+            /// @param entityId Entity id
+            /// @param property Property name
+            /// @param resolution Resolution
+            /// @param from Range begin
+            /// @param to Range end
+            /// @param buffer Output buffer
+            void JsonGet(identifier_t entityId, const std::string& property, HistoryResolution resolution,
+                         int64_t from, int64_t to, rapidjson::StringBuffer& buffer);
+        };
+    }
+}
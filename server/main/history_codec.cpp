@@ -0,0 +1,274 @@
+#include "history_codec.hpp"
+
+namespace server
+{
+    namespace main
+    {
+        HistoryEncoder::HistoryEncoder(uint8_t channelCount) : channelCount(channelCount)
+        {
+            assert(channelCount > 0 && channelCount <= HISTORY_MAX_CHANNEL_COUNT);
+        }
+
+        void HistoryEncoder::WriteBits(uint64_t value, uint8_t bits)
+        {
+            while (bits > 0)
+            {
+                if (freeBits == 0)
+                {
+                    data.push_back(0);
+                    freeBits = 8;
+                }
+
+                uint8_t take = std::min(bits, freeBits);
+                uint8_t chunk = (value >> (bits - take)) & ((1u << take) - 1);
+
+                data.back() |= chunk << (freeBits - take);
+                freeBits -= take;
+                bits -= take;
+            }
+        }
+
+        void HistoryEncoder::Append(int64_t timestamp, const double* values)
+        {
+            if (count == 0)
+            {
+                // First sample is stored uncompressed
+                WriteBits(timestamp, 64);
+                previousTimestamp = timestamp;
+                previousDelta = 0;
+
+                for (uint8_t i = 0; i < channelCount; i++)
+                {
+                    uint64_t bits;
+                    std::memcpy(&bits, &values[i], sizeof(uint64_t));
+
+                    WriteBits(bits, 64);
+                    previousValues[i] = bits;
+                    previousLeading[i] = 0xFF;
+                    previousTrailing[i] = 0;
+                }
+
+                count++;
+                return;
+            }
+
+            // Timestamp (delta of deltas)
+            {
+                int64_t delta = timestamp - previousTimestamp;
+                int64_t deltaOfDelta = delta - previousDelta;
+
+                if (deltaOfDelta == 0)
+                    WriteBits(0b0, 1);
+                else if (deltaOfDelta >= -63 && deltaOfDelta <= 64)
+                {
+                    WriteBits(0b10, 2);
+                    WriteBits(deltaOfDelta + 63, 7);
+                }
+                else if (deltaOfDelta >= -255 && deltaOfDelta <= 256)
+                {
+                    WriteBits(0b110, 3);
+                    WriteBits(deltaOfDelta + 255, 9);
+                }
+                else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048)
+                {
+                    WriteBits(0b1110, 4);
+                    WriteBits(deltaOfDelta + 2047, 12);
+                }
+                else
+                {
+                    WriteBits(0b1111, 4);
+                    WriteBits(deltaOfDelta, 64);
+                }
+
+                previousTimestamp = timestamp;
+                previousDelta = delta;
+            }
+
+            // Values (xor against previous value)
+            for (uint8_t i = 0; i < channelCount; i++)
+            {
+                uint64_t bits;
+                std::memcpy(&bits, &values[i], sizeof(uint64_t));
+
+                uint64_t xorValue = bits ^ previousValues[i];
+                previousValues[i] = bits;
+
+                if (xorValue == 0)
+                {
+                    WriteBits(0b0, 1);
+                    continue;
+                }
+
+                uint8_t leading = std::min(__builtin_clzll(xorValue), 31);
+                uint8_t trailing = __builtin_ctzll(xorValue);
+
+                if (previousLeading[i] != 0xFF && leading >= previousLeading[i] && trailing >= previousTrailing[i])
+                {
+                    // Reuse previous window
+                    uint8_t meaningful = 64 - previousLeading[i] - previousTrailing[i];
+
+                    WriteBits(0b10, 2);
+                    WriteBits(xorValue >> previousTrailing[i], meaningful);
+                }
+                else
+                {
+                    uint8_t meaningful = 64 - leading - trailing;
+
+                    WriteBits(0b11, 2);
+                    WriteBits(leading, 5);
+                    WriteBits(meaningful - 1, 6);
+                    WriteBits(xorValue >> trailing, meaningful);
+
+                    previousLeading[i] = leading;
+                    previousTrailing[i] = trailing;
+                }
+            }
+
+            count++;
+        }
+
+        void HistoryEncoder::Clear()
+        {
+            data.clear();
+            freeBits = 0;
+            count = 0;
+        }
+
+        HistoryDecoder::HistoryDecoder(const std::string_view& data, size_t count, uint8_t channelCount)
+            : channelCount(channelCount), data(data), count(count)
+        {
+            assert(channelCount > 0 && channelCount <= HISTORY_MAX_CHANNEL_COUNT);
+        }
+
+        bool HistoryDecoder::ReadBits(uint64_t& value, uint8_t bits)
+        {
+            if (position + bits > data.size() * 8)
+                return false;
+
+            value = 0;
+            while (bits > 0)
+            {
+                uint8_t byte = data[position / 8];
+                uint8_t available = 8 - position % 8;
+                uint8_t take = std::min(bits, available);
+
+                uint8_t chunk = (byte >> (available - take)) & ((1u << take) - 1);
+                value = (value << take) | chunk;
+
+                position += take;
+                bits -= take;
+            }
+
+            return true;
+        }
+
+        bool HistoryDecoder::Next(int64_t& timestamp, double* values)
+        {
+            if (index >= count)
+                return false;
+
+            uint64_t bits;
+
+            if (index == 0)
+            {
+                // First sample is stored uncompressed
+                if (!ReadBits(bits, 64))
+                    return false;
+                previousTimestamp = bits;
+                previousDelta = 0;
+
+                for (uint8_t i = 0; i < channelCount; i++)
+                {
+                    if (!ReadBits(bits, 64))
+                        return false;
+                    previousValues[i] = bits;
+                    previousLeading[i] = 0;
+                    previousTrailing[i] = 0;
+                }
+            }
+            else
+            {
+                // Timestamp (delta of deltas)
+                {
+                    int64_t deltaOfDelta;
+
+                    uint8_t prefix = 0;
+                    while (prefix < 4)
+                    {
+                        if (!ReadBits(bits, 1))
+                            return false;
+                        if (bits == 0)
+                            break;
+                        prefix++;
+                    }
+
+                    switch (prefix)
+                    {
+                    case 0:
+                        deltaOfDelta = 0;
+                        break;
+                    case 1:
+                        if (!ReadBits(bits, 7))
+                            return false;
+                        deltaOfDelta = (int64_t)bits - 63;
+                        break;
+                    case 2:
+                        if (!ReadBits(bits, 9))
+                            return false;
+                        deltaOfDelta = (int64_t)bits - 255;
+                        break;
+                    case 3:
+                        if (!ReadBits(bits, 12))
+                            return false;
+                        deltaOfDelta = (int64_t)bits - 2047;
+                        break;
+                    default:
+                        if (!ReadBits(bits, 64))
+                            return false;
+                        deltaOfDelta = (int64_t)bits;
+                        break;
+                    }
+
+                    previousDelta += deltaOfDelta;
+                    previousTimestamp += previousDelta;
+                }
+
+                // Values (xor against previous value)
+                for (uint8_t i = 0; i < channelCount; i++)
+                {
+                    if (!ReadBits(bits, 1))
+                        return false;
+                    if (bits == 0)
+                        continue;
+
+                    if (!ReadBits(bits, 1))
+                        return false;
+
+                    if (bits == 1)
+                    {
+                        // New window
+                        uint64_t leading, meaningful;
+                        if (!ReadBits(leading, 5) || !ReadBits(meaningful, 6))
+                            return false;
+
+                        previousLeading[i] = leading;
+                        previousTrailing[i] = 64 - leading - (meaningful + 1);
+                    }
+
+                    uint8_t meaningful = 64 - previousLeading[i] - previousTrailing[i];
+                    if (!ReadBits(bits, meaningful))
+                        return false;
+
+                    previousValues[i] ^= bits << previousTrailing[i];
+                }
+            }
+
+            timestamp = previousTimestamp;
+            for (uint8_t i = 0; i < channelCount; i++)
+                std::memcpy(&values[i], &previousValues[i], sizeof(uint64_t));
+
+            index++;
+            return true;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "common.hpp"
+
+#define HISTORY_MAX_CHANNEL_COUNT 3
+
+namespace server
+{
+    namespace main
+    {
+        /// @brief Gorilla style sample encoder
+        ///
+        /// Timestamps are stored as delta of deltas and every value channel as xor against its previous value, so
+        /// slowly changing series only need a few bits per sample.
+        class HistoryEncoder
+        {
+          private:
+            const uint8_t channelCount;
+
+            std::string data;
+            uint8_t freeBits = 0;
+            size_t count = 0;
+
+            int64_t previousTimestamp = 0;
+            int64_t previousDelta = 0;
+            uint64_t previousValues[HISTORY_MAX_CHANNEL_COUNT] = {};
+            uint8_t previousLeading[HISTORY_MAX_CHANNEL_COUNT] = {};
+            uint8_t previousTrailing[HISTORY_MAX_CHANNEL_COUNT] = {};
+
+            void WriteBits(uint64_t value, uint8_t bits);
+
+          public:
+            HistoryEncoder(uint8_t channelCount);
+
+            /// @brief Append sample
+            /// @note Timestamps have to be ascending
+            ///
+            /// @param timestamp Timestamp
+            /// @param values Values (one for each channel)
+            void Append(int64_t timestamp, const double* values);
+
+            /// @brief Get compressed samples
+            ///
+            /// @return const std::string& Compressed samples
+            inline const std::string& GetData() const
+            {
+                return data;
+            }
+
+            /// @brief Get sample count
+            ///
+            /// @return size_t Sample count
+            inline size_t GetCount() const
+            {
+                return count;
+            }
+
+            /// @brief Remove all samples
+            ///
+            void Clear();
+        };
+
+        class HistoryDecoder
+        {
+          private:
+            const uint8_t channelCount;
+
+            std::string_view data;
+            size_t position = 0;
+            size_t count;
+            size_t index = 0;
+
+            int64_t previousTimestamp = 0;
+            int64_t previousDelta = 0;
+            uint64_t previousValues[HISTORY_MAX_CHANNEL_COUNT] = {};
+            uint8_t previousLeading[HISTORY_MAX_CHANNEL_COUNT] = {};
+            uint8_t previousTrailing[HISTORY_MAX_CHANNEL_COUNT] = {};
+
+            bool ReadBits(uint64_t& value, uint8_t bits);
+
+          public:
+            HistoryDecoder(const std::string_view& data, size_t count, uint8_t channelCount);
+
+            /// @brief Decode next sample
+            ///
+            /// @param timestamp Timestamp
+            /// @param values Values (one for each channel)
+            /// @return Successfulness (false if there are no samples left or data is corrupted)
+            bool Next(int64_t& timestamp, double* values);
+        };
+    }
+}
@@ -30,16 +30,45 @@ namespace server
 
             instanceHome = home;
 
+            // Start sequence numbers at the startup time, so they keep increasing across restarts
+            home->sequence = (uint64_t)time(nullptr) << 20;
+            home->changeLogBegin = home->sequence;
+
+            // Create state publisher
+            home->statePublisher = StatePublisher::Create();
+            if (home->statePublisher == nullptr)
+            {
+                LOG_ERROR("Create state publisher.");
+                return nullptr;
+            }
+
+            // Create history
+            home->history = History::Create();
+            if (home->history == nullptr)
+            {
+                LOG_ERROR("Create history.");
+                return nullptr;
+            }
+
             // Load from database
             {
                 Ref<Database> database = Database::GetInstance();
                 assert(database != nullptr);
 
-                // Load entities
-                if (!database->LoadEntities(boost::bind(&Home::LoadEntity, home, boost::placeholders::_1,
-                                                        boost::placeholders::_2, boost::placeholders::_3,
-                                                        boost::placeholders::_4, boost::placeholders::_5,
-                                                        boost::placeholders::_6)))
+                // Avoid rehashing while loading
+                home->entityMap.reserve(database->GetEntityCount());
+
+                // Load entities (the first chunk of the parse arena is reused for every row)
+                rapidjson::Document::AllocatorType allocator;
+                home->loading = true;
+                bool result = database->LoadEntities(
+                    [&home, &allocator](identifier_t id, uint8_t type, const std::string_view& name,
+                                        identifier_t scriptSourceId, const std::string_view& attributes,
+                                        const std::string_view& state) -> bool
+                    { return home->LoadEntity(id, type, name, scriptSourceId, attributes, state, allocator); });
+                home->loading = false;
+
+                if (!result)
                 {
                     LOG_ERROR("Loading rooms.");
                     return nullptr;
@@ -65,6 +94,7 @@ namespace server
                     api::WebSocketSession::GetApiMap();
 
                 apiMap["get-home"] = Home::WebSocketProcessGetHomeMessage;
+                apiMap["sync-since"] = Home::WebSocketProcessSyncSinceMessage;
 
                 apiMap["add-entity"] = Home::WebSocketProcessAddEntityMessage;
                 apiMap["rem-entity"] = Home::WebSocketProcessRemoveEntityMessage;
@@ -74,6 +104,7 @@ namespace server
 
                 apiMap["get-entity-state"] = Home::WebSocketProcessGetEntityStateMessage;
                 apiMap["set-entity-state"] = Home::WebSocketProcessSetEntityStateMessage;
+                apiMap["get-entity-history"] = Home::WebSocketProcessGetEntityHistoryMessage;
 
                 apiMap["inv-entiy"] = Home::WebSocketProcessInvokeDeviceMethodMessage;
 
@@ -95,12 +126,121 @@ namespace server
             timestamp = ts;
         }
 
-        bool Home::LoadEntity(identifier_t id, const std::string& type, const std::string& name,
-                              identifier_t scriptSourceId, const std::string_view& attributes,
-                              const std::string_view& state)
+        //! Change log
+        uint64_t Home::RecordChange(identifier_t entityId, bool removed)
+        {
+            boost::lock_guard lock(changeLogMutex);
+
+            // Loaded entities are part of the initial state (clients fetch it with get-home)
+            if (loading)
+                return sequence;
+
+            sequence++;
+            changeLog.push_back(Change{sequence, entityId, removed});
+
+            // Drop oldest change
+            if (changeLog.size() > HOME_CHANGE_LOG_SIZE)
+            {
+                changeLogBegin = changeLog.front().sequence;
+                changeLog.pop_front();
+            }
+
+            UpdateTimestamp();
+
+            return sequence;
+        }
+
+        uint64_t Home::GetSequence() const
+        {
+            boost::lock_guard lock(changeLogMutex);
+            return sequence;
+        }
+
+        void Home::JsonGetChanges(uint64_t since, rapidjson::StringBuffer& buffer)
+        {
+            uint64_t currentSequence;
+            bool full;
+
+            // Collect changed entities (latest change wins)
+            robin_hood::unordered_flat_map<identifier_t, bool> changeMap;
+            {
+                boost::lock_guard lock(changeLogMutex);
+
+                currentSequence = sequence;
+                full = since < changeLogBegin || since > sequence;
+
+                if (!full)
+                {
+                    // Changes are ordered by sequence number
+                    boost::container::deque<Change>::const_reverse_iterator it = changeLog.rbegin();
+                    for (; it != changeLog.rend() && it->sequence > since; it++)
+                        changeMap.emplace(it->entityId, it->removed);
+                }
+            }
+
+            rapidjson::Writer<rapidjson::StringBuffer> writer = rapidjson::Writer<rapidjson::StringBuffer>(buffer);
+
+            writer.StartObject();
+
+            writer.Key("sequence", 8);
+            writer.Uint64(currentSequence);
+
+            writer.Key("timestamp", 9);
+            writer.Int64(timestamp);
+
+            writer.Key("full", 4);
+            writer.Bool(full);
+
+            writer.Key("entities", 8);
+            writer.StartArray();
+            if (full)
+            {
+                for (const auto& [id, entity] : entityMap)
+                {
+                    Ref<const rapidjson::StringBuffer> entityJson = entity->GetJson();
+                    writer.RawValue(entityJson->GetString(), entityJson->GetSize(), rapidjson::kObjectType);
+                }
+            }
+            else
+            {
+                for (const auto& [id, removed] : changeMap)
+                {
+                    if (removed)
+                        continue;
+
+                    const robin_hood::unordered_node_map<identifier_t, Ref<Entity>>::const_iterator it =
+                        entityMap.find(id);
+                    if (it == entityMap.end())
+                        continue;
+
+                    Ref<const rapidjson::StringBuffer> entityJson = it->second->GetJson();
+                    writer.RawValue(entityJson->GetString(), entityJson->GetSize(), rapidjson::kObjectType);
+                }
+            }
+            writer.EndArray();
+
+            writer.Key("removed", 7);
+            writer.StartArray();
+            for (const auto& [id, removed] : changeMap)
+            {
+                if (removed || !entityMap.contains(id))
+                    writer.Uint64(id);
+            }
+            writer.EndArray();
+
+            writer.EndObject();
+        }
+
+        bool Home::LoadEntity(identifier_t id, uint8_t type, const std::string_view& name, identifier_t scriptSourceId,
+                              const std::string_view& attributes, const std::string_view& state,
+                              rapidjson::Document::AllocatorType& allocator)
         {
             // Create new entity
-            Ref<Entity> entity = Entity::Create(id, ParseEntityType(type), name, scriptSourceId, attributes, state);
+            Ref<Entity> entity = Entity::Create(id, (EntityType)type, std::string(name), scriptSourceId, attributes,
+                                                state, &allocator);
+
+            // Release parsed documents (only the first chunk is kept for the next entity, it fits typical entities)
+            allocator.Clear();
 
             // Add entity
             if (entity != nullptr)
@@ -120,7 +260,7 @@ namespace server
             assert(database != nullptr);
 
             // Reserve room in database
-            identifier_t id = database->ReserveEntity(StringifyEntityType(type));
+            identifier_t id = database->ReserveEntity((uint8_t)type);
             if (id == 0)
                 return nullptr;
 
@@ -136,6 +276,9 @@ namespace server
                 entity->SaveState();
 
                 entityMap[entity->GetID()] = entity;
+
+                // Its room or type may be subscribed
+                entity->WakeLazyUpdateIfSubscribed();
             }
             else
             {
@@ -143,7 +286,7 @@ namespace server
                 return nullptr;
             }
 
-            UpdateTimestamp();
+            RecordChange(id);
 
             return entity;
         }
@@ -190,12 +333,29 @@ namespace server
 
         bool Home::RemoveEntity(identifier_t entityId)
         {
-            if (entityMap.erase(entityId))
+            const robin_hood::unordered_node_map<identifier_t, Ref<Entity>>::iterator it = entityMap.find(entityId);
+            if (it != entityMap.end())
             {
+                // Devices of a removed room serialize a different room id
+                if (it->second->GetType() == EntityType::kRoomEntityType)
+                {
+                    for (const auto& [id, entity] : entityMap)
+                    {
+                        if (entity->GetType() == EntityType::kDeviceEntityType &&
+                            boost::static_pointer_cast<Device>(entity)->GetRoomID() == entityId)
+                            entity->Invalidate();
+                    }
+                }
+
+                entityMap.erase(it);
+
+                RecordChange(entityId, true);
+
                 Ref<Database> database = Database::GetInstance();
                 assert(database != nullptr);
 
-                database->RemoveEntity(entityId);
+                database->RemoveEntityAsync(entityId);
+                history->Remove(entityId);
 
                 return true;
             }
@@ -206,6 +366,7 @@ namespace server
         void Home::JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const
         {
             output.AddMember("timestamp", rapidjson::Value(timestamp), allocator);
+            output.AddMember("sequence", rapidjson::Value(GetSequence()), allocator);
 
             rapidjson::Value entitiesJson = rapidjson::Value(rapidjson::kArrayType);
             entitiesJson.Reserve(entityMap.size(), allocator);
@@ -223,6 +384,34 @@ namespace server
             output.AddMember("entities", entitiesJson, allocator);
         }
 
+        void Home::JsonGet(rapidjson::StringBuffer& buffer) const
+        {
+            rapidjson::Writer<rapidjson::StringBuffer> writer = rapidjson::Writer<rapidjson::StringBuffer>(buffer);
+
+            writer.StartObject();
+
+            writer.Key("timestamp", 9);
+            writer.Int64(timestamp);
+
+            writer.Key("sequence", 8);
+            writer.Uint64(GetSequence());
+
+            writer.Key("entities", 8);
+            writer.StartArray();
+
+            for (const auto& [id, entity] : entityMap)
+            {
+                assert(entity != nullptr);
+
+                // Splice cached entity
+                Ref<const rapidjson::StringBuffer> entityJson = entity->GetJson();
+                writer.RawValue(entityJson->GetString(), entityJson->GetSize(), rapidjson::kObjectType);
+            }
+
+            writer.EndArray();
+            writer.EndObject();
+        }
+
         HomeView::HomeView(const Ref<Home>& home) : home(home)
         {
         }
@@ -1,6 +1,8 @@
 #pragma once
 #include "common.hpp"
 #include "entity.hpp"
+#include "history.hpp"
+#include "state_publisher.hpp"
 #include <api/message.hpp>
 #include <common/worker.hpp>
 #include <scripting/script.hpp>
@@ -20,18 +22,42 @@ namespace server
         class DeviceView;
         class ServiceView;
 
+#define HOME_CHANGE_LOG_SIZE 4096
+
         class Home : public boost::enable_shared_from_this<Home>
         {
           private:
             boost::atomic<time_t> timestamp = 0;
 
+            struct Change
+            {
+                uint64_t sequence;
+                identifier_t entityId;
+                bool removed;
+            };
+
+            /// @brief Change sequence number and bounded change log
+            /// @note The log contains every change after changeLogBegin
+            mutable boost::mutex changeLogMutex;
+            uint64_t sequence = 0;
+            uint64_t changeLogBegin = 0;
+            boost::container::deque<Change> changeLog;
+
+            /// @brief Entities are loaded from the database (their creation is not a change)
+            ///
+            bool loading = false;
+
             robin_hood::unordered_node_map<identifier_t, Ref<Entity>> entityMap;
 
             Ref<HomeView> view;
 
+            Ref<StatePublisher> statePublisher;
+            Ref<History> history;
+
             // Database
-            bool LoadEntity(identifier_t id, const std::string& type, const std::string& name,
-                            identifier_t scriptSourceId, const std::string_view& config, const std::string_view& state);
+            bool LoadEntity(identifier_t id, uint8_t type, const std::string_view& name, identifier_t scriptSourceId,
+                            const std::string_view& config, const std::string_view& state,
+                            rapidjson::Document::AllocatorType& allocator);
 
           public:
             Home();
@@ -51,6 +77,27 @@ namespace server
                 return timestamp;
             }
 
+            //! Change log
+
+            /// @brief Record entity change
+            ///
+            /// @param entityId Entity id
+            /// @param removed Entity was removed
+            /// @return uint64_t Sequence number of the change
+            uint64_t RecordChange(identifier_t entityId, bool removed = false);
+
+            /// @brief Get current change sequence number
+            ///
+            /// @return uint64_t Sequence number
+            uint64_t GetSequence() const;
+
+            /// @brief Serialize all changes since a sequence number
+            /// @note Writes a full snapshot if the change log does not reach back far enough
+            ///
+            /// @param since Last sequence number known by the client
+            /// @param buffer Output buffer
+            void JsonGetChanges(uint64_t since, rapidjson::StringBuffer& buffer);
+
             /// @brief Add entity
             ///
             /// @param type Entity type
@@ -100,11 +147,20 @@ namespace server
 
             void JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const;
 
+            /// @brief Serialize home directly into a buffer using the cached entities
+            ///
+            /// @param buffer Output buffer
+            void JsonGet(rapidjson::StringBuffer& buffer) const;
+
             //! WebSocket Api
             static void WebSocketProcessGetHomeMessage(const Ref<api::User>& user,
                                                        const api::ApiRequestMessage& request,
                                                        api::ApiResponseMessage& response,
                                                        const Ref<api::WebSocketSession>& session);
+            static void WebSocketProcessSyncSinceMessage(const Ref<api::User>& user,
+                                                         const api::ApiRequestMessage& request,
+                                                         api::ApiResponseMessage& response,
+                                                         const Ref<api::WebSocketSession>& session);
             static void WebSocketProcessAddEntityMessage(const Ref<api::User>& user,
                                                          const api::ApiRequestMessage& request,
                                                          api::ApiResponseMessage& response,
@@ -125,6 +181,10 @@ namespace server
                                                                   const api::ApiRequestMessage& request,
                                                                   api::ApiResponseMessage& response,
                                                                   const Ref<api::WebSocketSession>& session);
+            static void WebSocketProcessGetEntityHistoryMessage(const Ref<api::User>& user,
+                                                                const api::ApiRequestMessage& request,
+                                                                api::ApiResponseMessage& response,
+                                                                const Ref<api::WebSocketSession>& session);
             static void WebSocketProcessSubscribeToEntityStateMessage(const Ref<api::User>& user,
                                                                       const api::ApiRequestMessage& request,
                                                                       api::ApiResponseMessage& response,
@@ -6,6 +6,48 @@ namespace server
 {
     namespace main
     {
+        /// @brief Parse subscription topic from request ("id", "roomid" or "type")
+        ///
+        /// @param input Request
+        /// @param topic Topic
+        /// @return Successfulness
+        static bool ParseSubscriptionTopic(const rapidjson::Value& input, api::topic_t& topic)
+        {
+            rapidjson::Value::ConstMemberIterator entityIdIt = input.FindMember("id");
+            if (entityIdIt != input.MemberEnd())
+            {
+                if (!entityIdIt->value.IsUint())
+                    return false;
+
+                topic = api::MakeTopic(api::TopicType::kEntityTopic, entityIdIt->value.GetUint());
+                return true;
+            }
+
+            rapidjson::Value::ConstMemberIterator roomIdIt = input.FindMember("roomid");
+            if (roomIdIt != input.MemberEnd())
+            {
+                if (!roomIdIt->value.IsUint())
+                    return false;
+
+                topic = api::MakeTopic(api::TopicType::kRoomTopic, roomIdIt->value.GetUint());
+                return true;
+            }
+
+            rapidjson::Value::ConstMemberIterator typeIt = input.FindMember("type");
+            if (typeIt != input.MemberEnd() && typeIt->value.IsString())
+            {
+                EntityType type =
+                    ParseEntityType(std::string(typeIt->value.GetString(), typeIt->value.GetStringLength()));
+                if (type == EntityType::kUnknownEntityType)
+                    return false;
+
+                topic = api::MakeTopic(api::TopicType::kEntityTypeTopic, (uint64_t)type);
+                return true;
+            }
+
+            return false;
+        }
+
         void Home::WebSocketProcessGetHomeMessage(const Ref<api::User>& user, const api::ApiRequestMessage& request,
                                                   api::ApiResponseMessage& response,
                                                   const Ref<api::WebSocketSession>& session)
@@ -13,16 +55,46 @@ namespace server
             (void)user;
             (void)session;
 
+            (void)request;
+
+            // Build response
+            {
+                Ref<main::Home> home = main::Home::GetInstance();
+                assert(home != nullptr);
+
+                rapidjson::StringBuffer buffer = rapidjson::StringBuffer();
+                home->JsonGet(buffer);
+
+                response.AddRawMembers(std::string_view(buffer.GetString(), buffer.GetSize()));
+            }
+        }
+
+        void Home::WebSocketProcessSyncSinceMessage(const Ref<api::User>& user, const api::ApiRequestMessage& request,
+                                                    api::ApiResponseMessage& response,
+                                                    const Ref<api::WebSocketSession>& session)
+        {
+            (void)user;
+            (void)session;
+
             const rapidjson::Document& input = request.GetJsonDocument();
-            rapidjson::Document& output = response.GetJsonDocument();
-            rapidjson::Document::AllocatorType& allocator = response.GetJsonAllocator();
+
+            // Process request
+            rapidjson::Value::ConstMemberIterator sequenceIt = input.FindMember("sequence");
+            if (sequenceIt == input.MemberEnd() || !sequenceIt->value.IsUint64())
+            {
+                response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidArguments);
+                return;
+            }
 
             // Build response
             {
                 Ref<main::Home> home = main::Home::GetInstance();
                 assert(home != nullptr);
 
-                home->JsonGet(output, allocator);
+                rapidjson::StringBuffer buffer = rapidjson::StringBuffer();
+                home->JsonGetChanges(sequenceIt->value.GetUint64(), buffer);
+
+                response.AddRawMembers(std::string_view(buffer.GetString(), buffer.GetSize()));
             }
         }
 
@@ -39,8 +111,6 @@ namespace server
             }
 
             const rapidjson::Document& input = request.GetJsonDocument();
-            rapidjson::Document& output = response.GetJsonDocument();
-            rapidjson::Document::AllocatorType& allocator = response.GetJsonAllocator();
 
             // Process request
             rapidjson::Value::ConstMemberIterator typeIt = input.FindMember("type");
@@ -77,7 +147,9 @@ namespace server
                     return;
                 }
 
-                entity->JsonGet(output, allocator);
+                // Splice cached entity
+                Ref<const rapidjson::StringBuffer> json = entity->GetJson();
+                response.AddRawMembers(std::string_view(json->GetString(), json->GetSize()));
             }
         }
         void Home::WebSocketProcessRemoveEntityMessage(const Ref<api::User>& user,
@@ -128,8 +200,6 @@ namespace server
             (void)session;
 
             const rapidjson::Document& input = request.GetJsonDocument();
-            rapidjson::Document& output = response.GetJsonDocument();
-            rapidjson::Document::AllocatorType& allocator = response.GetJsonAllocator();
 
             // Process request
             rapidjson::Value::ConstMemberIterator entityIdIt = input.FindMember("id");
@@ -152,7 +222,9 @@ namespace server
                     return;
                 }
 
-                entity->JsonGet(output, allocator);
+                // Splice cached entity
+                Ref<const rapidjson::StringBuffer> json = entity->GetJson();
+                response.AddRawMembers(std::string_view(json->GetString(), json->GetSize()));
             }
         }
         void Home::WebSocketProcessSetEntityMessage(const Ref<api::User>& user, const api::ApiRequestMessage& request,
@@ -320,20 +392,50 @@ namespace server
             }
         }
 
-        void Home::WebSocketProcessSubscribeToEntityStateMessage(const Ref<api::User>& user,
-                                                                 const api::ApiRequestMessage& request,
-                                                                 api::ApiResponseMessage& response,
-                                                                 const Ref<api::WebSocketSession>& session)
+        void Home::WebSocketProcessGetEntityHistoryMessage(const Ref<api::User>& user,
+                                                           const api::ApiRequestMessage& request,
+                                                           api::ApiResponseMessage& response,
+                                                           const Ref<api::WebSocketSession>& session)
         {
             (void)user;
+            (void)session;
 
             const rapidjson::Document& input = request.GetJsonDocument();
-            rapidjson::Document& output = response.GetJsonDocument();
-            rapidjson::Document::AllocatorType& allocator = response.GetJsonAllocator();
 
             // Process request
             rapidjson::Value::ConstMemberIterator entityIdIt = input.FindMember("id");
-            if (entityIdIt == input.MemberEnd() || !entityIdIt->value.IsUint())
+            rapidjson::Value::ConstMemberIterator propertyIt = input.FindMember("property");
+            rapidjson::Value::ConstMemberIterator fromIt = input.FindMember("from");
+            rapidjson::Value::ConstMemberIterator toIt = input.FindMember("to");
+            rapidjson::Value::ConstMemberIterator resolutionIt = input.FindMember("resolution");
+            if (entityIdIt == input.MemberEnd() || !entityIdIt->value.IsUint() ||         // id
+                propertyIt == input.MemberEnd() || !propertyIt->value.IsString() ||       // property
+                fromIt == input.MemberEnd() || !fromIt->value.IsInt64() ||                // from
+                (toIt != input.MemberEnd() && !toIt->value.IsInt64()) ||                  // to
+                (resolutionIt != input.MemberEnd() && !resolutionIt->value.IsString()))   // resolution
+            {
+                response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidArguments);
+                return;
+            }
+
+            int64_t from = fromIt->value.GetInt64();
+            int64_t to = toIt != input.MemberEnd() ? toIt->value.GetInt64() : (int64_t)time(nullptr);
+
+            // Choose resolution that matches the range
+            HistoryResolution resolution;
+            if (resolutionIt != input.MemberEnd())
+                resolution = ParseHistoryResolution(
+                    std::string(resolutionIt->value.GetString(), resolutionIt->value.GetStringLength()));
+            else if (to - from <= 6 * 3600)
+                resolution = HistoryResolution::kRawHistoryResolution;
+            else if (to - from <= 2 * 86400)
+                resolution = HistoryResolution::kMinuteHistoryResolution;
+            else if (to - from <= 90 * 86400)
+                resolution = HistoryResolution::kHourHistoryResolution;
+            else
+                resolution = HistoryResolution::kDayHistoryResolution;
+
+            if (resolution == HistoryResolution::kUnknownHistoryResolution || from > to)
             {
                 response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidArguments);
                 return;
@@ -344,28 +446,27 @@ namespace server
                 Ref<main::Home> home = main::Home::GetInstance();
                 assert(home != nullptr);
 
-                // Get entity
-                Ref<main::Entity> entity = home->GetEntity(entityIdIt->value.GetUint());
-                if (entity == nullptr)
+                // Check entity
+                if (home->GetEntity(entityIdIt->value.GetUint()) == nullptr)
                 {
                     response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidIdentifier);
                     return;
                 }
 
-                // Add subscription
-                entity->Subscribe(session);
+                rapidjson::StringBuffer buffer = rapidjson::StringBuffer();
+                home->history->JsonGet(
+                    entityIdIt->value.GetUint(),
+                    std::string(propertyIt->value.GetString(), propertyIt->value.GetStringLength()), resolution,
+                    from, to, buffer);
 
-                // Get state
-                rapidjson::Value stateJson = rapidjson::Value(rapidjson::kObjectType);
-                entity->JsonGetState(stateJson, allocator);
-                output.AddMember("state", stateJson, allocator);
+                response.AddRawMembers(std::string_view(buffer.GetString(), buffer.GetSize()));
             }
         }
 
-        void Home::WebSocketProcessUnsubscribeFromEntityStateMessage(const Ref<api::User>& user,
-                                                                     const api::ApiRequestMessage& request,
-                                                                     api::ApiResponseMessage& response,
-                                                                     const Ref<api::WebSocketSession>& session)
+        void Home::WebSocketProcessSubscribeToEntityStateMessage(const Ref<api::User>& user,
+                                                                 const api::ApiRequestMessage& request,
+                                                                 api::ApiResponseMessage& response,
+                                                                 const Ref<api::WebSocketSession>& session)
         {
             (void)user;
 
@@ -373,9 +474,16 @@ namespace server
             rapidjson::Document& output = response.GetJsonDocument();
             rapidjson::Document::AllocatorType& allocator = response.GetJsonAllocator();
 
+            // Subscriptions belong to a websocket session (not available over http)
+            if (session == nullptr)
+            {
+                response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidArguments);
+                return;
+            }
+
             // Process request
-            rapidjson::Value::ConstMemberIterator entityIdIt = input.FindMember("id");
-            if (entityIdIt == input.MemberEnd() || !entityIdIt->value.IsUint())
+            api::topic_t topic;
+            if (!ParseSubscriptionTopic(input, topic))
             {
                 response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidArguments);
                 return;
@@ -386,17 +494,92 @@ namespace server
                 Ref<main::Home> home = main::Home::GetInstance();
                 assert(home != nullptr);
 
-                // Get entity
-                Ref<main::Entity> entity = home->GetEntity(entityIdIt->value.GetUint());
-                if (entity == nullptr)
+                rapidjson::Value::ConstMemberIterator entityIdIt = input.FindMember("id");
+                if (entityIdIt != input.MemberEnd())
+                {
+                    // Get entity
+                    Ref<main::Entity> entity = home->GetEntity(entityIdIt->value.GetUint());
+                    if (entity == nullptr)
+                    {
+                        response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidIdentifier);
+                        return;
+                    }
+
+                    // Add subscription
+                    entity->Subscribe(session);
+
+                    // Get state
+                    rapidjson::Value stateJson = rapidjson::Value(rapidjson::kObjectType);
+                    entity->JsonGetState(stateJson, allocator);
+                    output.AddMember("state", stateJson, allocator);
+                }
+                else
+                {
+                    Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+                    assert(subscriptionManager != nullptr);
+
+                    // Add wildcard subscription
+                    subscriptionManager->Subscribe(session->GetID(), topic);
+
+                    // Get states of all matching entities
+                    rapidjson::Value entitiesJson = rapidjson::Value(rapidjson::kArrayType);
+                    for (const auto& [id, entity] : home->entityMap)
+                    {
+                        api::topic_t topics[ENTITY_MAX_TOPIC_COUNT];
+                        size_t topicCount = entity->GetTopics(topics);
+                        if (std::find(topics, topics + topicCount, topic) == topics + topicCount)
+                            continue;
+
+                        entity->WakeLazyUpdate();
+
+                        rapidjson::Value stateJson = rapidjson::Value(rapidjson::kObjectType);
+                        entity->JsonGetState(stateJson, allocator);
+
+                        rapidjson::Value entityJson = rapidjson::Value(rapidjson::kObjectType);
+                        entityJson.AddMember("id", rapidjson::Value(id), allocator);
+                        entityJson.AddMember("state", stateJson, allocator);
+                        entitiesJson.PushBack(entityJson, allocator);
+                    }
+                    output.AddMember("entities", entitiesJson, allocator);
+                }
+            }
+        }
+
+        void Home::WebSocketProcessUnsubscribeFromEntityStateMessage(const Ref<api::User>& user,
+                                                                     const api::ApiRequestMessage& request,
+                                                                     api::ApiResponseMessage& response,
+                                                                     const Ref<api::WebSocketSession>& session)
+        {
+            (void)user;
+
+            const rapidjson::Document& input = request.GetJsonDocument();
+
+            // Subscriptions belong to a websocket session (not available over http)
+            if (session == nullptr)
+            {
+                response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidArguments);
+                return;
+            }
+
+            // Process request
+            api::topic_t topic;
+            if (!ParseSubscriptionTopic(input, topic))
+            {
+                response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidArguments);
+                return;
+            }
+
+            // Remove subscription
+            {
+                Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+                assert(subscriptionManager != nullptr);
+
+                if (!subscriptionManager->Unsubscribe(session->GetID(), topic))
                 {
                     response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InvalidIdentifier);
                     return;
                 }
-
-                // Add subscription
-                entity->Unsubscribe(session);
             }
         }
     }
-}
\ No newline at end of file
+}
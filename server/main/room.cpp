@@ -66,6 +66,9 @@ namespace server
                 update = true;
             }
 
+            if (update)
+                Invalidate();
+
             return update;
         }
 
@@ -116,5 +119,11 @@ namespace server
             if (Ref<Room> r = room.lock())
                 r->PublishState();
         }
+
+        void RoomView::Invalidate()
+        {
+            if (Ref<Room> r = room.lock())
+                r->Invalidate();
+        }
     }
 }
\ No newline at end of file
@@ -104,6 +104,7 @@ namespace server
 
             virtual void Publish() override;
             virtual void PublishState() override;
+            virtual void Invalidate() override;
         };
     }
 }
\ No newline at end of file
@@ -216,5 +216,11 @@ namespace server
             if (Ref<Service> r = service.lock())
                 r->PublishState();
         }
+
+        void ServiceView::Invalidate()
+        {
+            if (Ref<Service> r = service.lock())
+                r->Invalidate();
+        }
     }
 }
\ No newline at end of file
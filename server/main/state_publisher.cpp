@@ -0,0 +1,181 @@
+#include "state_publisher.hpp"
+#include "entity.hpp"
+#include "history.hpp"
+#include <api/subscription_manager.hpp>
+#include <common/worker.hpp>
+
+namespace server
+{
+    namespace main
+    {
+        WeakRef<StatePublisher> instanceStatePublisher;
+
+        StatePublisher::StatePublisher()
+        {
+        }
+        StatePublisher::~StatePublisher()
+        {
+        }
+        Ref<StatePublisher> StatePublisher::Create()
+        {
+            if (!instanceStatePublisher.expired())
+                return Ref<StatePublisher>(instanceStatePublisher);
+
+            Ref<StatePublisher> statePublisher = boost::make_shared<StatePublisher>();
+            if (statePublisher == nullptr)
+                return nullptr;
+
+            instanceStatePublisher = statePublisher;
+
+            return statePublisher;
+        }
+        Ref<StatePublisher> StatePublisher::GetInstance()
+        {
+            return Ref<StatePublisher>(instanceStatePublisher);
+        }
+
+        void StatePublisher::Publish(const Ref<Entity>& entity)
+        {
+            assert(entity != nullptr);
+
+            boost::lock_guard lock(mutex);
+
+            entityMap[entity->GetID()] = entity;
+
+            // Flush after the current worker tick
+            if (!flushPending)
+            {
+                flushPending = true;
+
+                Ref<Worker> worker = Worker::GetInstance();
+                assert(worker != nullptr);
+
+                worker->Post(WorkerHandlerKind::kPublisherWorkerHandlerKind, "flush", 0,
+                             boost::bind(&StatePublisher::Flush, shared_from_this()));
+            }
+        }
+
+        void StatePublisher::Flush()
+        {
+            // Take changed entities
+            robin_hood::unordered_flat_map<identifier_t, WeakRef<Entity>> changedEntityMap;
+            {
+                boost::lock_guard lock(mutex);
+
+                std::swap(changedEntityMap, entityMap);
+                flushPending = false;
+            }
+
+            Ref<api::SubscriptionManager> subscriptionManager = api::SubscriptionManager::GetInstance();
+            assert(subscriptionManager != nullptr);
+
+            Ref<History> history = History::GetInstance();
+            assert(history != nullptr);
+
+            const int64_t timestamp = time(nullptr);
+
+            // Record and serialize every state once and collect its subscribers
+            boost::container::vector<rapidjson::StringBuffer> fragmentList;
+            robin_hood::unordered_flat_map<api::session_id_t, boost::container::vector<uint32_t>> sessionMap;
+            boost::container::vector<api::session_id_t> sessionIdList;
+
+            fragmentList.reserve(changedEntityMap.size());
+
+            for (const auto& [id, entityRef] : changedEntityMap)
+            {
+                Ref<Entity> entity = entityRef.lock();
+                if (entity == nullptr)
+                    continue;
+
+                rapidjson::Document stateJson = rapidjson::Document(rapidjson::kObjectType);
+                entity->JsonGetState(stateJson, stateJson.GetAllocator());
+
+                // Record history
+                history->Record(id, timestamp, stateJson);
+
+                api::topic_t topics[ENTITY_MAX_TOPIC_COUNT];
+                size_t topicCount = entity->GetTopics(topics);
+
+                subscriptionManager->GetSubscribers(topics, topicCount, sessionIdList);
+                if (sessionIdList.empty())
+                    continue;
+
+                // Serialize state
+                uint32_t fragment = fragmentList.size();
+                {
+                    rapidjson::StringBuffer& buffer = fragmentList.emplace_back();
+
+                    rapidjson::Writer<rapidjson::StringBuffer> writer =
+                        rapidjson::Writer<rapidjson::StringBuffer>(buffer);
+
+                    writer.StartObject();
+                    writer.Key("id", 2);
+                    writer.Uint64(id);
+                    writer.Key("state", 5);
+                    stateJson.Accept(writer);
+                    writer.EndObject();
+                }
+
+                for (api::session_id_t sessionId : sessionIdList)
+                    sessionMap[sessionId].push_back(fragment);
+            }
+
+            // Build one frame per distinct set of fragments
+            robin_hood::unordered_node_map<std::string, boost::container::vector<api::session_id_t>> frameSessionMap;
+
+            for (const auto& [sessionId, sessionFragmentList] : sessionMap)
+            {
+                std::string frameKey = std::string((const char*)sessionFragmentList.data(),
+                                                   sessionFragmentList.size() * sizeof(uint32_t));
+                frameSessionMap[frameKey].push_back(sessionId);
+            }
+
+            for (const auto& [frameKey, frameSessionIdList] : frameSessionMap)
+            {
+                const uint32_t* frameFragmentList = (const uint32_t*)frameKey.data();
+                size_t frameFragmentCount = frameKey.size() / sizeof(uint32_t);
+
+                Ref<rapidjson::StringBuffer> frame = boost::make_shared<rapidjson::StringBuffer>();
+                if (frame == nullptr)
+                {
+                    LOG_ERROR("Failed to create string buffer.");
+                    return;
+                }
+
+                // Build message
+                {
+                    rapidjson::Writer<rapidjson::StringBuffer> writer =
+                        rapidjson::Writer<rapidjson::StringBuffer>(*frame);
+
+                    writer.StartObject();
+
+                    // Message id field
+                    writer.Key("msgid", 5);
+                    writer.Uint64(0);
+
+                    // Message type field
+                    writer.Key("msg", 3);
+                    writer.String("set-entity-states", 17);
+
+                    // Content field
+                    writer.Key("entities", 8);
+                    writer.StartArray();
+                    for (size_t i = 0; i < frameFragmentCount; i++)
+                    {
+                        uint32_t fragment;
+                        std::memcpy(&fragment, frameFragmentList + i, sizeof(uint32_t));
+
+                        const rapidjson::StringBuffer& buffer = fragmentList[fragment];
+                        writer.RawValue(buffer.GetString(), buffer.GetSize(), rapidjson::kObjectType);
+                    }
+                    writer.EndArray();
+
+                    writer.EndObject();
+                }
+
+                // Shared payload
+                subscriptionManager->Send(frameSessionIdList, frame);
+            }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "common.hpp"
+
+namespace server
+{
+    namespace main
+    {
+        class Entity;
+
+        /// @brief Collects entity state changes and publishes them once per worker tick
+        ///
+        /// Every session receives a single "set-entity-states" frame containing all changed entities it is subscribed
+        /// to. Sessions with the same set of changed subscriptions share one serialized payload.
+        class StatePublisher : public boost::enable_shared_from_this<StatePublisher>
+        {
+          private:
+            boost::mutex mutex;
+
+            /// @brief Entities changed since the last flush
+            ///
+            robin_hood::unordered_flat_map<identifier_t, WeakRef<Entity>> entityMap;
+            bool flushPending = false;
+
+            /// @brief Publish all collected state changes
+            ///
+            void Flush();
+
+          public:
+            StatePublisher();
+            virtual ~StatePublisher();
+            static Ref<StatePublisher> Create();
+            static Ref<StatePublisher> GetInstance();
+
+            /// @brief Mark entity state as changed
+            /// @note The state is serialized when the publisher is flushed on the worker
+            ///
+            /// @param entity Entity
+            void Publish(const Ref<Entity>& entity);
+        };
+    }
+}
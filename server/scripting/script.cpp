@@ -1,4 +1,5 @@
 #include "script.hpp"
+#include <common/metrics.hpp>
 #include <common/worker.hpp>
 
 namespace server
@@ -6,7 +7,10 @@ namespace server
     namespace scripting
     {
         Script::Script(const Ref<sdk::View>& view, const Ref<ScriptSource>& scriptSource)
-            : view(view), scriptSource(scriptSource)
+            : view(view), scriptSource(scriptSource),
+              invokeHistogram(metrics::Registry::GetInstance().GetHistogram(
+                  "home_script_invoke_duration_seconds", "Duration of script method invocations",
+                  metrics::MakeLabel("scriptsource", std::to_string(scriptSource->GetID()))))
         {
             assert(view != nullptr);
             assert(scriptSource != nullptr);
@@ -40,21 +44,32 @@ namespace server
             // Reset references
             attributeMap.clear();
             eventMap.clear();
+            UpdateAttributesJson();
 
             return true;
         }
 
+        bool Script::MeasureInvoke(const std::string& name, const Value& parameter)
+        {
+            WorkerHandlerScope scope(WorkerHandlerKind::kScriptWorkerHandlerKind, name, GetSourceID());
+            boost::chrono::steady_clock::time_point begin = boost::chrono::steady_clock::now();
+            bool result = Invoke(name, parameter);
+            invokeHistogram.ObserveSince(begin);
+
+            return result;
+        }
+
         void Script::PostInvoke(const std::string& name, const Value& parameter)
         {
             Ref<Worker> worker = Worker::GetInstance();
             assert(worker != nullptr);
 
-            worker->GetContext().dispatch(boost::bind(&Script::Invoke, shared_from_this(), name, parameter));
+            worker->GetContext().dispatch(boost::bind(&Script::MeasureInvoke, shared_from_this(), name, parameter));
         }
 
         bool Script::LazyUpdate()
         {
-            return Invoke("lazy-update", Value());
+            return MeasureInvoke("lazy-update", Value());
         }
 
         void Script::PostLazyUpdate()
@@ -67,7 +82,7 @@ namespace server
 
         bool Script::Update()
         {
-            return Invoke("update", Value());
+            return MeasureInvoke("update", Value());
         }
 
         void Script::PostUpdate()
@@ -99,5 +114,24 @@ namespace server
                                  rapidjson::Value(attribute, allocator, true), allocator);
             }
         }
+
+        void Script::UpdateAttributesJson()
+        {
+            rapidjson::StringBuffer buffer;
+            rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+            writer.StartObject();
+            for (auto& [id, attribute] : attributeMap)
+            {
+                writer.Key(id.data(), id.size());
+                attribute.Accept(writer);
+            }
+            writer.EndObject();
+
+            attributesJson.assign(buffer.GetString(), buffer.GetSize());
+
+            // The serialized parent object contains the attributes
+            view->Invalidate();
+        }
     }
 }
\ No newline at end of file
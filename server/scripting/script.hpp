@@ -9,6 +9,11 @@
 
 namespace server
 {
+    namespace metrics
+    {
+        class Histogram;
+    }
+
     namespace scripting
     {
         class ScriptSource;
@@ -19,6 +24,10 @@ namespace server
             const Ref<sdk::View> view;
             const Ref<ScriptSource> scriptSource;
 
+            /// @brief Invoke duration histogram (shared by all scripts of the script source)
+            ///
+            metrics::Histogram& invokeHistogram;
+
             /// @brief Script attributes
             ///
             robin_hood::unordered_node_map<std::string, rapidjson::Document> attributeMap;
@@ -27,6 +36,14 @@ namespace server
             ///
             robin_hood::unordered_node_map<std::string, sdk::Event> eventMap;
 
+            /// @brief Serialized script attributes
+            /// @note Attributes only change on (re-)initialization, so they are serialized once
+            std::string attributesJson = "{}";
+
+            /// @brief Serialize attribute map into attributes json and invalidate the parent object
+            ///
+            void UpdateAttributesJson();
+
           public:
             Script(const Ref<sdk::View>& view, const Ref<ScriptSource>& scriptSource);
             virtual ~Script();
@@ -81,6 +98,13 @@ namespace server
             /// @return Successfulness
             virtual bool Invoke(const std::string& name, const Value& parameter) = 0;
 
+            /// @brief Invoke method and record its duration
+            ///
+            /// @param name Method name
+            /// @param parameter Parameter
+            /// @return Successfulness
+            bool MeasureInvoke(const std::string& name, const Value& parameter);
+
             /// @brief Post invoke method
             ///
             /// @param name Method name
@@ -119,6 +143,14 @@ namespace server
 
             void JsonGetAttributes(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator);
 
+            /// @brief Get serialized attributes
+            ///
+            /// @return Attributes json object
+            inline std::string_view GetAttributesJson() const
+            {
+                return attributesJson;
+            }
+
             virtual void JsonGetProperties(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator,
                                            PropertyFlags flags = kPropertyFlag_Visible) = 0;
             virtual PropertyFlags JsonSetProperties(const rapidjson::Value& input,
@@ -183,7 +183,7 @@ namespace server
                 Ref<Database> database = Database::GetInstance();
                 assert(database != nullptr);
 
-                database->RemoveScriptSource(id);
+                database->RemoveScriptSourceAsync(id);
 
                 return true;
             }
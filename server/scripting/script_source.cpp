@@ -40,7 +40,7 @@ namespace server
         {
         }
 
-        bool ScriptSource::Save() const
+        void ScriptSource::Save() const
         {
             Ref<Database> database = Database::GetInstance();
             assert(database != nullptr);
@@ -58,16 +58,27 @@ namespace server
             }
 
             // Update database
-            return database->UpdateScriptSource(id, name, std::string_view(config.GetString(), config.GetSize()));
+            database->UpdateScriptSourceAsync(id, name, std::string_view(config.GetString(), config.GetSize()),
+                                              [id = id](bool result) -> void
+                                              {
+                                                  if (!result)
+                                                      LOG_ERROR("Failed to save script source '{0}'.", id);
+                                              });
         }
 
-        bool ScriptSource::SaveContent() const
+        void ScriptSource::SaveContent() const
         {
             Ref<Database> database = Database::GetInstance();
             assert(database != nullptr);
 
             // Update database
-            return database->UpdateScriptSourceContent(id, std::string_view(content.data(), content.size()));
+            database->UpdateScriptSourceContentAsync(id, std::string_view(content.data(), content.size()),
+                                                     [id = id](bool result) -> void
+                                                     {
+                                                         if (!result)
+                                                             LOG_ERROR("Failed to save content of script source '{0}'.",
+                                                                       id);
+                                                     });
         }
 
         void ScriptSource::JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const
@@ -107,15 +107,13 @@ namespace server
             /// @return Script
             virtual Ref<Script> CreateScript(const Ref<sdk::View>& view) = 0;
 
-            /// @brief Save/update entity data in database
+            /// @brief Save/update script source data in database (written asynchronously)
             ///
-            /// @return Successfulness
-            bool Save() const;
+            void Save() const;
 
-            /// @brief Save/update entity content in database
+            /// @brief Save/update script source content in database (written asynchronously)
             ///
-            /// @return Successfulness
-            bool SaveContent() const;
+            void SaveContent() const;
 
             void JsonGet(rapidjson::Value& output, rapidjson::Document::AllocatorType& allocator) const;
             bool JsonSet(const rapidjson::Value& input);
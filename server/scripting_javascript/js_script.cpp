@@ -171,19 +171,11 @@ namespace server
                         std::string name = std::string(nameStr, nameLength);
 
                         // Convert attribute to json
-                        duk_json_encode(context, -1); // [ object enum key json ]
-
-                        size_t jsonLength;
-                        const char* jsonStr = duk_to_lstring(context, -1, &jsonLength);
-
-                        // Add attribute
                         {
                             rapidjson::Document document;
 
-                            document.Parse(jsonStr, jsonLength);
-
                             // Add attribute to list
-                            if (!document.HasParseError())
+                            if (duk_get_json(context, -1, document, document.GetAllocator()))
                             {
                                 // Insert attribute
                                 attributeMap[name] = std::move(document);
@@ -192,7 +184,7 @@ namespace server
                                 duk_error(context, DUK_ERR_ERROR, "Invalid json.");
                         }
 
-                        // Pop json, and key
+                        // Pop value, and key
                         duk_pop_2(context); // [ object enum ]
                     }
 
@@ -206,6 +198,9 @@ namespace server
                 DUK_TEST_LEAVE(context, 0);
 
                 attributeMap.compact();
+
+                // Serialize attributes once
+                UpdateAttributesJson();
             }
             void JSScript::InitializeProperties()
             {
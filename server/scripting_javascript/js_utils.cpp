@@ -1,7 +1,11 @@
 #include "js_utils.hpp"
 #include "js_script.hpp"
+#include <cmath>
 #include <common/worker.hpp>
 
+// Deeper values are most likely cyclic references
+#define DUK_JSON_MAX_DEPTH (32)
+
 namespace server
 {
     namespace scripting
@@ -126,6 +130,133 @@ namespace server
 
                 return true;
             }
+        
+            bool duk_get_json_impl(duk_context* context, duk_idx_t idx, rapidjson::Value& output,
+                                   rapidjson::Document::AllocatorType& allocator, size_t depth)
+            {
+                if (depth > DUK_JSON_MAX_DEPTH)
+                    return false;
+
+                switch (duk_get_type(context, idx))
+                {
+                case DUK_TYPE_BOOLEAN:
+                    output.SetBool(duk_get_boolean(context, idx));
+                    return true;
+                case DUK_TYPE_NUMBER:
+                {
+                    double number = duk_get_number(context, idx);
+
+                    // Keep integral numbers as integers, so that they can be read back as such
+                    if (std::trunc(number) == number && std::abs(number) < 9007199254740992.0)
+                    {
+                        if (number >= 0.0)
+                            output.SetUint64((uint64_t)number);
+                        else
+                            output.SetInt64((int64_t)number);
+                    }
+                    else if (std::isfinite(number))
+                        output.SetDouble(number);
+                    else
+                        output.SetNull(); // Json cannot represent NaN or infinity
+
+                    return true;
+                }
+                case DUK_TYPE_STRING:
+                {
+                    size_t stringLength;
+                    const char* string = duk_get_lstring(context, idx, &stringLength);
+
+                    output.SetString(string, stringLength, allocator);
+                    return true;
+                }
+                case DUK_TYPE_OBJECT:
+                {
+                    idx = duk_normalize_index(context, idx);
+
+                    if (duk_is_function(context, idx))
+                    {
+                        output.SetNull();
+                        return true;
+                    }
+
+                    if (duk_is_array(context, idx))
+                    {
+                        size_t length = duk_get_length(context, idx);
+
+                        output.SetArray();
+                        output.Reserve(length, allocator);
+
+                        for (size_t index = 0; index < length; index++)
+                        {
+                            duk_get_prop_index(context, idx, index); // [ ... value ]
+
+                            rapidjson::Value valueJson;
+                            bool result = duk_get_json_impl(context, -1, valueJson, allocator, depth + 1);
+
+                            // Pop value
+                            duk_pop(context); // [ ... ]
+
+                            if (!result)
+                                return false;
+
+                            output.PushBack(valueJson, allocator);
+                        }
+
+                        return true;
+                    }
+
+                    output.SetObject();
+
+                    // Iterate over own properties
+                    duk_enum(context, idx, DUK_ENUM_OWN_PROPERTIES_ONLY); // [ ... enum ]
+
+                    while (duk_next(context, -1, 1)) // [ ... enum key value ]
+                    {
+                        // Skip values without json representation (like JSON.stringify)
+                        if (!duk_is_undefined(context, -1) && !duk_is_function(context, -1))
+                        {
+                            size_t nameLength;
+                            const char* nameStr = duk_to_lstring(context, -2, &nameLength);
+
+                            rapidjson::Value valueJson;
+                            if (!duk_get_json_impl(context, -1, valueJson, allocator, depth + 1))
+                            {
+                                // Pop value, key, and enum
+                                duk_pop_3(context); // [ ... ]
+                                return false;
+                            }
+
+                            output.AddMember(rapidjson::Value(nameStr, nameLength, allocator), valueJson, allocator);
+                        }
+
+                        // Pop value, and key
+                        duk_pop_2(context); // [ ... enum ]
+                    }
+
+                    // Pop enum
+                    duk_pop(context); // [ ... ]
+
+                    return true;
+                }
+                default:
+                    output.SetNull();
+                    return true;
+                }
+            }
+
+            bool duk_get_json(duk_context* context, duk_idx_t idx, rapidjson::Value& output,
+                              rapidjson::Document::AllocatorType& allocator)
+            {
+                assert(context != nullptr);
+
+                DUK_TEST_ENTER(context);
+
+                bool result = duk_get_json_impl(context, idx, output, allocator, 0);
+
+                DUK_TEST_LEAVE(context, 0);
+
+                return result;
+            }
         }
     }
 }
\ No newline at end of file
@@ -12,6 +12,17 @@ namespace server
             /// @param context
             /// @return Successfulness
             bool duk_import_utils(duk_context* context);
+
+            /// @brief Convert duktape value to json without encoding it to a string first
+            /// @note Functions and undefined values are skipped inside objects and converted to null otherwise
+            ///
+            /// @param context Duktape context
+            /// @param idx Value index
+            /// @param output Json output
+            /// @param allocator Json allocator
+            /// @return Successfulness
+            bool duk_get_json(duk_context* context, duk_idx_t idx, rapidjson::Value& output,
+                              rapidjson::Document::AllocatorType& allocator);
         }
     }
 }
\ No newline at end of file
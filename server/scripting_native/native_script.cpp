@@ -61,6 +61,7 @@ namespace server
                     if (!document.HasParseError())
                     {
                         attributeMap[name] = std::move(document);
+                        UpdateAttributesJson();
                         return true;
                     }
                 }
@@ -69,11 +70,18 @@ namespace server
             }
             bool NativeScript::RemoveAttribute(const std::string& name)
             {
-                return attributeMap.erase(name);
+                if (attributeMap.erase(name))
+                {
+                    UpdateAttributesJson();
+                    return true;
+                }
+
+                return false;
             }
             void NativeScript::ClearAttributes()
             {
                 attributeMap.clear();
+                UpdateAttributesJson();
             }
 
             bool NativeScript::AddProperty(const std::string& name, UniqueRef<sdk::Property> property)
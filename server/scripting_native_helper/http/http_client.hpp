@@ -1,7 +1,5 @@
 #pragma once
-#include <common/common.hpp>
-
-#include <boost/beast.hpp>
+#include "http_connection_pool.hpp"
 
 namespace server
 {
@@ -11,24 +9,126 @@ namespace server
         {
             namespace http
             {
+                /// @brief Asynchronous http/1.1 client owned by a native script
+                ///
+                /// Requests run on the pooled connections of the worker, responses are passed to a method of the
+                /// caller. The caller is only referenced weakly, responses arriving after it was destroyed are
+                /// dropped. Every method must be called from the worker.
                 template <class Caller>
                 class HttpClient
                 {
+                  public:
+                    /// @brief Response method of the caller
+                    ///
+                    typedef void (Caller::*ResponseHandler)(HttpError error, const HttpResponse& response);
+
+                    /// @brief Body method of the caller (streams the body instead of buffering it)
+                    ///
+                    typedef void (Caller::*BodyHandler)(const char* data, size_t size);
+
                   private:
-                    boost::beast::tcp_stream stream;
-                    boost::beast::flat_buffer buffer;
+                    Ref<HttpConnectionPool> pool;
+                    WeakRef<Caller> caller;
 
-                    // boost::beast::http::request<boost::beast::string>
+                    std::string host;
+                    uint16_t port;
+                    size_t timeout;
 
-                    void OnResolve();
+                  public:
+                    /// @brief Create client on the shared pool of the worker
+                    ///
+                    /// @param caller Owning script
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @param timeout Request timeout in milliseconds
+                    HttpClient(const Ref<Caller>& caller, const std::string& host, uint16_t port = 80,
+                               size_t timeout = HTTP_CLIENT_DEFAULT_TIMEOUT)
+                        : HttpClient(HttpConnectionPool::GetInstance(), caller, host, port, timeout)
+                    {
+                    }
 
-                    void OnConnect();
-                    void OnWrite();
-                    void OnRead();
+                    /// @brief Create client on a pool
+                    ///
+                    /// @param pool Connection pool
+                    /// @param caller Owning script
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @param timeout Request timeout in milliseconds
+                    HttpClient(const Ref<HttpConnectionPool>& pool, const Ref<Caller>& caller, const std::string& host,
+                               uint16_t port = 80, size_t timeout = HTTP_CLIENT_DEFAULT_TIMEOUT)
+                        : pool(pool), caller(caller), host(host), port(port), timeout(timeout)
+                    {
+                        assert(pool != nullptr);
+                    }
 
-                  private:
+                    inline const std::string& GetHost() const
+                    {
+                        return host;
+                    }
+                    inline uint16_t GetPort() const
+                    {
+                        return port;
+                    }
+
+                    /// @brief Send request
+                    ///
+                    /// @param request Request
+                    /// @param responseHandler Response method
+                    /// @param bodyHandler Body method (optional)
+                    void Send(HttpRequest request, ResponseHandler responseHandler, BodyHandler bodyHandler = nullptr)
+                    {
+                        assert(responseHandler != nullptr);
+
+                        WeakRef<Caller> callerRef = caller;
+
+                        HttpBodyCallback bodyCallback;
+                        if (bodyHandler != nullptr)
+                        {
+                            bodyCallback = [callerRef, bodyHandler](const char* data, size_t size) -> void
+                            {
+                                if (Ref<Caller> caller = callerRef.lock())
+                                    ((*caller).*bodyHandler)(data, size);
+                            };
+                        }
+
+                        pool->Send(
+                            host, port, std::move(request),
+                            [callerRef, responseHandler](HttpError error, const HttpResponse& response) -> void
+                            {
+                                if (Ref<Caller> caller = callerRef.lock())
+                                    ((*caller).*responseHandler)(error, response);
+                            },
+                            bodyCallback, timeout);
+                    }
+
+                    /// @brief Send get request
+                    ///
+                    /// @param target Request target
+                    /// @param responseHandler Response method
+                    /// @param bodyHandler Body method (optional)
+                    void Get(const std::string& target, ResponseHandler responseHandler,
+                             BodyHandler bodyHandler = nullptr)
+                    {
+                        Send(HttpRequest(boost::beast::http::verb::get, target, 11), responseHandler, bodyHandler);
+                    }
+
+                    /// @brief Send post request
+                    ///
+                    /// @param target Request target
+                    /// @param body Request body
+                    /// @param contentType Content type of the body
+                    /// @param responseHandler Response method
+                    /// @param bodyHandler Body method (optional)
+                    void Post(const std::string& target, const std::string& body, const std::string& contentType,
+                              ResponseHandler responseHandler, BodyHandler bodyHandler = nullptr)
+                    {
+                        HttpRequest request = HttpRequest(boost::beast::http::verb::post, target, 11);
+                        request.set(boost::beast::http::field::content_type, contentType);
+                        request.body() = body;
+                        Send(std::move(request), responseHandler, bodyHandler);
+                    }
                 };
             }
         }
     }
-}
\ No newline at end of file
+}
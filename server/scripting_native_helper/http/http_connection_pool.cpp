@@ -0,0 +1,537 @@
+#include "http_connection_pool.hpp"
+#include <common/worker.hpp>
+
+// Size of the buffer body parts are read into
+#define HTTP_CLIENT_READ_BUFFER_SIZE 8192
+
+namespace server
+{
+    namespace scripting
+    {
+        namespace native
+        {
+            namespace http
+            {
+                std::string StringifyHttpError(HttpError error)
+                {
+                    switch (error)
+                    {
+                    case HttpError::kNoHttpError:
+                        return "no error";
+                    case HttpError::kResolveHttpError:
+                        return "resolve failed";
+                    case HttpError::kConnectHttpError:
+                        return "connect failed";
+                    case HttpError::kWriteHttpError:
+                        return "write failed";
+                    case HttpError::kReadHttpError:
+                        return "read failed";
+                    case HttpError::kTimeoutHttpError:
+                        return "timeout";
+                    case HttpError::kBodyLimitHttpError:
+                        return "body limit exceeded";
+                    default:
+                        return "unknown error";
+                    }
+                }
+
+                static inline std::string MakeEndpoint(const std::string& host, uint16_t port)
+                {
+                    return host + ":" + std::to_string(port);
+                }
+
+                /// @brief Check whether sending a request twice has the same effect as sending it once
+                ///
+                /// @param method Request method
+                /// @return Request may be sent again
+                static inline bool IsIdempotent(boost::beast::http::verb method)
+                {
+                    switch (method)
+                    {
+                    case boost::beast::http::verb::get:
+                    case boost::beast::http::verb::head:
+                    case boost::beast::http::verb::put:
+                    case boost::beast::http::verb::delete_:
+                    case boost::beast::http::verb::options:
+                    case boost::beast::http::verb::trace:
+                        return true;
+                    default:
+                        return false;
+                    }
+                }
+
+                /// @brief Single request and response on a pooled connection
+                ///
+                class HttpExchange : public boost::enable_shared_from_this<HttpExchange>
+                {
+                  private:
+                    Ref<HttpConnectionPool> pool;
+                    std::string host;
+                    uint16_t port;
+
+                    HttpRequest request;
+                    HttpResponseCallback callback;
+                    HttpBodyCallback bodyCallback;
+                    std::chrono::steady_clock::time_point deadline;
+
+                    Ref<boost::beast::tcp_stream> stream;
+
+                    /// @brief Connection was taken from the pool (retried on a new connection if it fails early)
+                    ///
+                    bool reused = false;
+
+                    boost::beast::flat_buffer buffer;
+                    boost::optional<boost::beast::http::response_parser<boost::beast::http::buffer_body>> parser;
+                    char chunk[HTTP_CLIENT_READ_BUFFER_SIZE];
+                    std::string body;
+
+                    void Resolve()
+                    {
+                        pool->Resolve(host, port, deadline,
+                                      boost::bind(&HttpExchange::OnResolve, shared_from_this(),
+                                                  boost::placeholders::_1, boost::placeholders::_2));
+                    }
+                    void OnResolve(const boost::system::error_code& ec,
+                                   const boost::asio::ip::tcp::resolver::results_type& results)
+                    {
+                        if (ec)
+                        {
+                            if (std::chrono::steady_clock::now() >= deadline)
+                            {
+                                Finish(HttpError::kTimeoutHttpError);
+                                return;
+                            }
+
+                            LOG_ERROR("Resolve http host '{0}': {1}", host, ec.message());
+                            Finish(HttpError::kResolveHttpError);
+                            return;
+                        }
+
+                        if (std::chrono::steady_clock::now() >= deadline)
+                        {
+                            Finish(HttpError::kTimeoutHttpError);
+                            return;
+                        }
+
+                        stream = boost::make_shared<boost::beast::tcp_stream>(pool->GetContext());
+                        stream->expires_at(deadline);
+                        stream->async_connect(results, boost::bind(&HttpExchange::OnConnect, shared_from_this(),
+                                                                   boost::placeholders::_1, boost::placeholders::_2));
+                    }
+                    void OnConnect(const boost::system::error_code& ec,
+                                   const boost::asio::ip::tcp::endpoint& endpoint)
+                    {
+                        (void)endpoint;
+
+                        if (ec)
+                        {
+                            if (ec == boost::beast::error::timeout)
+                            {
+                                Finish(HttpError::kTimeoutHttpError);
+                                return;
+                            }
+
+                            // The host may have moved
+                            LOG_ERROR("Connect to http host '{0}:{1}': {2}", host, port, ec.message());
+                            pool->InvalidateHost(host, port);
+                            Finish(HttpError::kConnectHttpError);
+                            return;
+                        }
+
+                        boost::system::error_code error;
+                        stream->socket().set_option(boost::asio::ip::tcp::no_delay(true), error);
+
+                        Write();
+                    }
+
+                    void Write()
+                    {
+                        stream->expires_at(deadline);
+                        boost::beast::http::async_write(*stream, request,
+                                                        boost::bind(&HttpExchange::OnWrite, shared_from_this(),
+                                                                    boost::placeholders::_1, boost::placeholders::_2));
+                    }
+                    void OnWrite(const boost::system::error_code& ec, size_t sentBytes)
+                    {
+                        (void)sentBytes;
+
+                        if (ec)
+                        {
+                            if (Retry(ec))
+                                return;
+
+                            Finish(ec == boost::beast::error::timeout ? HttpError::kTimeoutHttpError
+                                                                      : HttpError::kWriteHttpError);
+                            return;
+                        }
+
+                        // The response to a head request has no body, even if it has a content length
+                        parser.emplace();
+                        parser->skip(request.method() == boost::beast::http::verb::head);
+                        parser->body_limit(bodyCallback ? std::numeric_limits<uint64_t>::max()
+                                                        : HTTP_CLIENT_MAX_BODY_SIZE);
+                        Read();
+                    }
+
+                    void Read()
+                    {
+                        parser->get().body().data = chunk;
+                        parser->get().body().size = sizeof(chunk);
+
+                        stream->expires_at(deadline);
+                        boost::beast::http::async_read_some(*stream, buffer, *parser,
+                                                            boost::bind(&HttpExchange::OnRead, shared_from_this(),
+                                                                        boost::placeholders::_1,
+                                                                        boost::placeholders::_2));
+                    }
+                    void OnRead(boost::system::error_code ec, size_t receivedBytes)
+                    {
+                        (void)receivedBytes;
+
+                        // The chunk buffer is full
+                        if (ec == boost::beast::http::error::need_buffer)
+                            ec = {};
+
+                        if (ec)
+                        {
+                            // A reused connection closed by the server fails before anything is received
+                            if (!parser->got_some() && Retry(ec))
+                                return;
+
+                            if (ec == boost::beast::error::timeout)
+                                Finish(HttpError::kTimeoutHttpError);
+                            else if (ec == boost::beast::http::error::body_limit)
+                                Finish(HttpError::kBodyLimitHttpError);
+                            else
+                                Finish(HttpError::kReadHttpError);
+                            return;
+                        }
+
+                        // Deliver body part
+                        size_t size = sizeof(chunk) - parser->get().body().size;
+                        if (size != 0)
+                        {
+                            if (bodyCallback)
+                                bodyCallback(chunk, size);
+                            else
+                                body.append(chunk, size);
+                        }
+
+                        if (!parser->is_done())
+                        {
+                            Read();
+                            return;
+                        }
+
+                        // Keep connection for the next request
+                        if (parser->keep_alive() && buffer.size() == 0)
+                            pool->Release(host, port, stream);
+                        else
+                            Close();
+                        stream = nullptr;
+
+                        HttpResponse response = HttpResponse(std::move(parser->get().base()));
+                        response.body() = std::move(body);
+                        callback(HttpError::kNoHttpError, response);
+                    }
+
+                    /// @brief Send request again on a new connection if the pooled connection failed
+                    /// @note Only idempotent requests are sent again, the server may have processed the first one
+                    ///
+                    /// @param ec Error code
+                    /// @return True if the request is sent again
+                    bool Retry(const boost::system::error_code& ec)
+                    {
+                        if (!reused || ec == boost::beast::error::timeout || !IsIdempotent(request.method()))
+                            return false;
+
+                        reused = false;
+                        Close();
+                        stream = nullptr;
+                        buffer.clear();
+                        parser.reset();
+
+                        Resolve();
+                        return true;
+                    }
+
+                    void Close()
+                    {
+                        if (stream == nullptr)
+                            return;
+
+                        boost::system::error_code ec;
+                        stream->socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+                        stream->close();
+                    }
+
+                    void Finish(HttpError error)
+                    {
+                        Close();
+                        stream = nullptr;
+
+                        callback(error, HttpResponse());
+                    }
+
+                  public:
+                    HttpExchange(const Ref<HttpConnectionPool>& pool, const std::string& host, uint16_t port,
+                                 HttpRequest&& request, const HttpResponseCallback& callback,
+                                 const HttpBodyCallback& bodyCallback, size_t timeout)
+                        : pool(pool), host(host), port(port), request(std::move(request)), callback(callback),
+                          bodyCallback(bodyCallback),
+                          deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout))
+                    {
+                    }
+
+                    void Start()
+                    {
+                        // Reuse idle connection
+                        stream = pool->Acquire(host, port);
+                        if (stream != nullptr)
+                        {
+                            reused = true;
+                            Write();
+                            return;
+                        }
+
+                        Resolve();
+                    }
+                };
+
+                WeakRef<HttpConnectionPool> instanceHttpConnectionPool;
+
+                HttpConnectionPool::HttpConnectionPool(boost::asio::io_context& context, size_t maxIdleConnections,
+                                                       size_t idleTimeout)
+                    : context(context), maxIdleConnections(maxIdleConnections), idleTimeout(idleTimeout)
+                {
+                }
+                HttpConnectionPool::~HttpConnectionPool()
+                {
+                    Clear();
+                }
+
+                Ref<HttpConnectionPool> HttpConnectionPool::Create()
+                {
+                    if (!instanceHttpConnectionPool.expired())
+                        return Ref<HttpConnectionPool>(instanceHttpConnectionPool);
+
+                    Ref<Worker> worker = Worker::GetInstance();
+                    assert(worker != nullptr);
+
+                    Ref<HttpConnectionPool> pool = Create(worker->GetContext());
+                    if (pool == nullptr)
+                        return nullptr;
+
+                    instanceHttpConnectionPool = pool;
+
+                    return pool;
+                }
+                Ref<HttpConnectionPool> HttpConnectionPool::Create(boost::asio::io_context& context,
+                                                                   size_t maxIdleConnections, size_t idleTimeout)
+                {
+                    Ref<HttpConnectionPool> pool =
+                        boost::make_shared<HttpConnectionPool>(context, maxIdleConnections, idleTimeout);
+                    if (pool == nullptr)
+                    {
+                        LOG_ERROR("Create http connection pool.");
+                        return nullptr;
+                    }
+
+                    return pool;
+                }
+
+                Ref<HttpConnectionPool> HttpConnectionPool::GetInstance()
+                {
+                    return Ref<HttpConnectionPool>(instanceHttpConnectionPool);
+                }
+
+                //! Resolving
+
+                void HttpConnectionPool::Resolve(const std::string& host, uint16_t port,
+                                                 std::chrono::steady_clock::time_point deadline,
+                                                 const HttpResolveCallback& callback)
+                {
+                    std::string endpoint = MakeEndpoint(host, port);
+
+                    robin_hood::unordered_node_map<std::string, DnsEntry>::iterator it = dnsCache.find(endpoint);
+                    if (it != dnsCache.end())
+                    {
+                        if (std::chrono::steady_clock::now() < it->second.expiry)
+                        {
+                            callback(boost::system::error_code(), it->second.results);
+                            return;
+                        }
+
+                        dnsCache.erase(it);
+                    }
+
+                    // Every resolve has its own resolver, so a timed out resolve can be cancelled on its own
+                    Ref<boost::asio::ip::tcp::resolver> resolver =
+                        boost::make_shared<boost::asio::ip::tcp::resolver>(context);
+                    Ref<boost::asio::steady_timer> timer =
+                        boost::make_shared<boost::asio::steady_timer>(context, deadline);
+                    timer->async_wait(
+                        [resolver](const boost::system::error_code& ec) -> void
+                        {
+                            if (!ec)
+                                resolver->cancel();
+                        });
+
+                    resolver->async_resolve(host, std::to_string(port),
+                                            boost::bind(&HttpConnectionPool::OnResolve, shared_from_this(),
+                                                        boost::placeholders::_1, boost::placeholders::_2, endpoint,
+                                                        timer, callback));
+                }
+                void HttpConnectionPool::OnResolve(const boost::system::error_code& ec,
+                                                   const boost::asio::ip::tcp::resolver::results_type& results,
+                                                   const std::string& endpoint,
+                                                   const Ref<boost::asio::steady_timer>& timer,
+                                                   const HttpResolveCallback& callback)
+                {
+                    timer->cancel();
+
+                    if (!ec)
+                    {
+                        DnsEntry& entry = dnsCache[endpoint];
+                        entry.results = results;
+                        entry.expiry =
+                            std::chrono::steady_clock::now() + std::chrono::milliseconds(HTTP_CLIENT_DNS_CACHE_TTL);
+                    }
+
+                    callback(ec, results);
+                }
+
+                void HttpConnectionPool::InvalidateHost(const std::string& host, uint16_t port)
+                {
+                    dnsCache.erase(MakeEndpoint(host, port));
+                }
+
+                //! Connections
+
+                Ref<boost::beast::tcp_stream> HttpConnectionPool::Acquire(const std::string& host, uint16_t port)
+                {
+                    robin_hood::unordered_node_map<std::string,
+                                                   boost::container::vector<Ref<boost::beast::tcp_stream>>>::iterator
+                        it = idleMap.find(MakeEndpoint(host, port));
+                    if (it == idleMap.end())
+                        return nullptr;
+
+                    boost::container::vector<Ref<boost::beast::tcp_stream>>& connectionList = it->second;
+                    while (!connectionList.empty())
+                    {
+                        Ref<boost::beast::tcp_stream> stream = std::move(connectionList.back());
+                        connectionList.pop_back();
+
+                        if (stream->socket().is_open())
+                        {
+                            // Stop the idle read (its handler ignores connections that are not idle anymore)
+                            stream->cancel();
+                            return stream;
+                        }
+                    }
+
+                    idleMap.erase(it);
+                    return nullptr;
+                }
+
+                void HttpConnectionPool::Release(const std::string& host, uint16_t port,
+                                                 const Ref<boost::beast::tcp_stream>& stream)
+                {
+                    std::string endpoint = MakeEndpoint(host, port);
+                    boost::container::vector<Ref<boost::beast::tcp_stream>>& connectionList = idleMap[endpoint];
+
+                    // Close the oldest connection if the pool is full
+                    if (connectionList.size() >= maxIdleConnections)
+                    {
+                        if (connectionList.empty())
+                        {
+                            stream->close();
+                            return;
+                        }
+
+                        connectionList.front()->close();
+                        connectionList.erase(connectionList.begin());
+                    }
+
+                    connectionList.push_back(stream);
+
+                    // Notice the server closing the connection and close it after the idle timeout
+                    stream->expires_after(std::chrono::milliseconds(idleTimeout));
+                    stream->async_read_some(boost::asio::buffer(idleBuffer),
+                                            boost::bind(&HttpConnectionPool::OnIdleRead,
+                                                        WeakRef<HttpConnectionPool>(shared_from_this()), endpoint,
+                                                        stream, boost::placeholders::_1, boost::placeholders::_2));
+                }
+                void HttpConnectionPool::OnIdleRead(const WeakRef<HttpConnectionPool>& poolRef,
+                                                    const std::string& endpoint,
+                                                    const Ref<boost::beast::tcp_stream>& stream,
+                                                    const boost::system::error_code& ec, size_t receivedBytes)
+                {
+                    (void)receivedBytes;
+
+                    // The connection was taken for a request or the pool was cleared
+                    Ref<HttpConnectionPool> pool = poolRef.lock();
+                    if (pool == nullptr || ec == boost::asio::error::operation_aborted)
+                        return;
+
+                    robin_hood::unordered_node_map<std::string,
+                                                   boost::container::vector<Ref<boost::beast::tcp_stream>>>::iterator
+                        it = pool->idleMap.find(endpoint);
+                    if (it == pool->idleMap.end())
+                        return;
+
+                    // The read may have completed before the connection was taken
+                    boost::container::vector<Ref<boost::beast::tcp_stream>>& connectionList = it->second;
+                    boost::container::vector<Ref<boost::beast::tcp_stream>>::iterator connectionIt =
+                        std::find(connectionList.begin(), connectionList.end(), stream);
+                    if (connectionIt == connectionList.end())
+                        return;
+
+                    // Closed by the server, expired or unexpected data
+                    stream->close();
+                    connectionList.erase(connectionIt);
+                    if (connectionList.empty())
+                        pool->idleMap.erase(it);
+                }
+
+                size_t HttpConnectionPool::GetIdleCount() const
+                {
+                    size_t count = 0;
+                    for (const auto& [endpoint, connectionList] : idleMap)
+                        count += connectionList.size();
+                    return count;
+                }
+
+                void HttpConnectionPool::Clear()
+                {
+                    for (auto& [endpoint, connectionList] : idleMap)
+                    {
+                        for (const Ref<boost::beast::tcp_stream>& stream : connectionList)
+                            stream->close();
+                    }
+                    idleMap.clear();
+                    dnsCache.clear();
+                }
+
+                //! Requests
+
+                void HttpConnectionPool::Send(const std::string& host, uint16_t port, HttpRequest&& request,
+                                              const HttpResponseCallback& callback,
+                                              const HttpBodyCallback& bodyCallback, size_t timeout)
+                {
+                    assert(callback);
+
+                    if (request.find(boost::beast::http::field::host) == request.end())
+                        request.set(boost::beast::http::field::host, port == 80 ? host : MakeEndpoint(host, port));
+                    request.version(11);
+                    request.keep_alive(true);
+                    request.prepare_payload();
+
+                    Ref<HttpExchange> exchange = boost::make_shared<HttpExchange>(
+                        shared_from_this(), host, port, std::move(request), callback, bodyCallback, timeout);
+                    exchange->Start();
+                }
+            }
+        }
+    }
+}
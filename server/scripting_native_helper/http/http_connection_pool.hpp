@@ -0,0 +1,190 @@
+#pragma once
+#include <common/common.hpp>
+
+#include <boost/beast.hpp>
+
+// Default request timeout (in milliseconds), covers resolving, connecting, writing and reading
+#define HTTP_CLIENT_DEFAULT_TIMEOUT 10000
+
+// Time (in milliseconds) resolved endpoints are reused
+#define HTTP_CLIENT_DNS_CACHE_TTL 60000
+
+// Idle keep-alive connections kept per host and the time (in milliseconds) they are kept
+#define HTTP_CLIENT_MAX_IDLE_CONNECTIONS 4
+#define HTTP_CLIENT_IDLE_TIMEOUT 30000
+
+// Maximum body size of buffered responses (streamed bodies are not limited)
+#define HTTP_CLIENT_MAX_BODY_SIZE (8 * 1024 * 1024)
+
+namespace server
+{
+    namespace scripting
+    {
+        namespace native
+        {
+            namespace http
+            {
+                typedef boost::beast::http::request<boost::beast::http::string_body> HttpRequest;
+                typedef boost::beast::http::response<boost::beast::http::string_body> HttpResponse;
+
+                enum class HttpError
+                {
+                    kNoHttpError,
+                    kResolveHttpError,
+                    kConnectHttpError,
+                    kWriteHttpError,
+                    kReadHttpError,
+                    kTimeoutHttpError,
+                    kBodyLimitHttpError,
+                };
+
+                std::string StringifyHttpError(HttpError error);
+
+                /// @brief Response callback
+                ///
+                /// @param error Error
+                /// @param response Response (the body is empty if it was streamed)
+                typedef boost::function<void(HttpError error, const HttpResponse& response)> HttpResponseCallback;
+
+                /// @brief Body callback, called for every received part of the body
+                ///
+                /// @param data Body data (chunked bodies are already decoded)
+                /// @param size Body data size
+                typedef boost::function<void(const char* data, size_t size)> HttpBodyCallback;
+
+                /// @brief Resolve callback
+                ///
+                /// @param ec Error code
+                /// @param results Resolved endpoints
+                typedef boost::function<void(const boost::system::error_code& ec,
+                                             const boost::asio::ip::tcp::resolver::results_type& results)>
+                    HttpResolveCallback;
+
+                /// @brief Keep-alive connections and resolved endpoints shared by every http client on a context
+                ///
+                /// Requests reuse idle connections to the same host, a reused connection the server closed in the
+                /// meantime is transparently replaced by a new one for idempotent requests (others fail, as they may
+                /// have been processed). Every method must be called from the context and every callback is called on
+                /// the context.
+                class HttpConnectionPool : public boost::enable_shared_from_this<HttpConnectionPool>
+                {
+                  private:
+                    struct DnsEntry
+                    {
+                        boost::asio::ip::tcp::resolver::results_type results;
+                        std::chrono::steady_clock::time_point expiry;
+                    };
+
+                    boost::asio::io_context& context;
+                    size_t maxIdleConnections;
+                    size_t idleTimeout;
+
+                    /// @brief Resolved endpoints by host and port
+                    ///
+                    robin_hood::unordered_node_map<std::string, DnsEntry> dnsCache;
+
+                    /// @brief Idle connections by host and port (the most recently used is last)
+                    ///
+                    /// Every idle connection has a read pending, that closes it when the server closes it, sends
+                    /// unexpected data or the idle timeout expires.
+                    robin_hood::unordered_node_map<std::string, boost::container::vector<Ref<boost::beast::tcp_stream>>>
+                        idleMap;
+
+                    /// @brief Target of the idle reads (anything received is discarded)
+                    ///
+                    char idleBuffer[1];
+
+                    void OnResolve(const boost::system::error_code& ec,
+                                   const boost::asio::ip::tcp::resolver::results_type& results,
+                                   const std::string& endpoint, const Ref<boost::asio::steady_timer>& timer,
+                                   const HttpResolveCallback& callback);
+
+                    static void OnIdleRead(const WeakRef<HttpConnectionPool>& poolRef, const std::string& endpoint,
+                                           const Ref<boost::beast::tcp_stream>& stream,
+                                           const boost::system::error_code& ec, size_t receivedBytes);
+
+                  public:
+                    HttpConnectionPool(boost::asio::io_context& context, size_t maxIdleConnections, size_t idleTimeout);
+                    virtual ~HttpConnectionPool();
+
+                    /// @brief Create shared pool of the worker (owned by the core, released before the worker)
+                    ///
+                    /// @return Pool
+                    static Ref<HttpConnectionPool> Create();
+
+                    /// @brief Create pool that is not shared
+                    ///
+                    /// @param context IO context
+                    /// @param maxIdleConnections Idle connections kept per host
+                    /// @param idleTimeout Time in milliseconds idle connections are kept
+                    /// @return Pool
+                    static Ref<HttpConnectionPool> Create(boost::asio::io_context& context,
+                                                          size_t maxIdleConnections = HTTP_CLIENT_MAX_IDLE_CONNECTIONS,
+                                                          size_t idleTimeout = HTTP_CLIENT_IDLE_TIMEOUT);
+
+                    /// @brief Get shared pool of the worker
+                    ///
+                    /// @return Pool
+                    static Ref<HttpConnectionPool> GetInstance();
+
+                    inline boost::asio::io_context& GetContext()
+                    {
+                        return context;
+                    }
+
+                    /// @brief Resolve host (cached)
+                    ///
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @param deadline Deadline (the resolve fails with operation aborted afterwards)
+                    /// @param callback Callback
+                    void Resolve(const std::string& host, uint16_t port, std::chrono::steady_clock::time_point deadline,
+                                 const HttpResolveCallback& callback);
+
+                    /// @brief Forget resolved endpoints of a host (after they failed)
+                    ///
+                    /// @param host Host name or address
+                    /// @param port Port
+                    void InvalidateHost(const std::string& host, uint16_t port);
+
+                    /// @brief Take idle connection
+                    ///
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @return Connection or null if there is no idle connection
+                    Ref<boost::beast::tcp_stream> Acquire(const std::string& host, uint16_t port);
+
+                    /// @brief Return connection for reuse (closed if too many connections are idle)
+                    ///
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @param stream Connection
+                    void Release(const std::string& host, uint16_t port, const Ref<boost::beast::tcp_stream>& stream);
+
+                    /// @brief Get number of idle connections
+                    ///
+                    /// @return Idle connection count
+                    size_t GetIdleCount() const;
+
+                    /// @brief Send request
+                    ///
+                    /// The host header, keep-alive and the payload size are set before sending.
+                    ///
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @param request Request
+                    /// @param callback Response callback
+                    /// @param bodyCallback Body callback (streams the body instead of buffering it)
+                    /// @param timeout Timeout in milliseconds
+                    void Send(const std::string& host, uint16_t port, HttpRequest&& request,
+                              const HttpResponseCallback& callback, const HttpBodyCallback& bodyCallback = {},
+                              size_t timeout = HTTP_CLIENT_DEFAULT_TIMEOUT);
+
+                    /// @brief Close idle connections and drop resolved endpoints
+                    ///
+                    void Clear();
+                };
+            }
+        }
+    }
+}
@@ -1,11 +1,14 @@
-target("server-home-scripting-native")
+target("server-scripting-native-http")
     set_kind("static")
+    add_files("./**.cpp")
     add_packages(
         "spdlog", 
-        "openssl", 
         "boost", 
+        "rapidjson", 
+        "robin-hood-hashing", 
+        "xxhash"
     )
 
     add_deps(
-        "server-common",
-    )
\ No newline at end of file
+        "server-common"
+    )
@@ -0,0 +1,623 @@
+#include "modbus_client.hpp"
+#include <common/worker.hpp>
+
+namespace server
+{
+    namespace scripting
+    {
+        namespace native
+        {
+            namespace modbus
+            {
+                std::string StringifyModbusError(ModbusError error)
+                {
+                    switch (error)
+                    {
+                    case ModbusError::kNoModbusError:
+                        return "no error";
+                    case ModbusError::kIllegalFunctionModbusError:
+                        return "illegal function";
+                    case ModbusError::kIllegalAddressModbusError:
+                        return "illegal address";
+                    case ModbusError::kIllegalValueModbusError:
+                        return "illegal value";
+                    case ModbusError::kServerFailureModbusError:
+                        return "server failure";
+                    case ModbusError::kAcknowledgeModbusError:
+                        return "acknowledge";
+                    case ModbusError::kServerBusyModbusError:
+                        return "server busy";
+                    case ModbusError::kNegativeAcknowledgeModbusError:
+                        return "negative acknowledge";
+                    case ModbusError::kMemoryParityModbusError:
+                        return "memory parity error";
+                    case ModbusError::kGatewayPathUnavailableModbusError:
+                        return "gateway path unavailable";
+                    case ModbusError::kGatewayTargetFailedModbusError:
+                        return "gateway target device failed to respond";
+                    case ModbusError::kNoConnectionModbusError:
+                        return "no connection";
+                    case ModbusError::kTimeoutModbusError:
+                        return "timeout";
+                    case ModbusError::kInvalidResponseModbusError:
+                        return "invalid response";
+                    case ModbusError::kInvalidRequestModbusError:
+                        return "invalid request";
+                    default:
+                        return "unknown error";
+                    }
+                }
+
+                ModbusClient::ModbusClient(boost::asio::io_context& context, const std::string& host, uint16_t port)
+                    : host(host), port(port), resolver(context), socket(context), timeoutTimer(context),
+                      reconnectTimer(context)
+                {
+                }
+                ModbusClient::~ModbusClient()
+                {
+                }
+
+                Ref<ModbusClient> ModbusClient::Create(const std::string& host, uint16_t port)
+                {
+                    Ref<Worker> worker = Worker::GetInstance();
+                    assert(worker != nullptr);
+
+                    return Create(worker->GetContext(), host, port);
+                }
+                Ref<ModbusClient> ModbusClient::Create(boost::asio::io_context& context, const std::string& host,
+                                                       uint16_t port)
+                {
+                    Ref<ModbusClient> client = boost::make_shared<ModbusClient>(context, host, port);
+                    if (client == nullptr)
+                    {
+                        LOG_ERROR("Create modbus client.");
+                        return nullptr;
+                    }
+
+                    return client;
+                }
+
+                //! Connection
+
+                void ModbusClient::Connect()
+                {
+                    connecting = true;
+
+                    // Wait for the backoff of the last failed connection
+                    if (std::chrono::steady_clock::now() < retryTime)
+                    {
+                        reconnectTimer.expires_at(retryTime);
+                        reconnectTimer.async_wait(boost::bind(&ModbusClient::OnReconnect, shared_from_this(),
+                                                              boost::placeholders::_1, generation));
+                        return;
+                    }
+
+                    resolver.async_resolve(host, std::to_string(port),
+                                           boost::bind(&ModbusClient::OnResolve, shared_from_this(),
+                                                       boost::placeholders::_1, boost::placeholders::_2, generation));
+                }
+                void ModbusClient::OnReconnect(const boost::system::error_code& ec, size_t connection)
+                {
+                    if (ec || connection != generation)
+                        return;
+
+                    Connect();
+                }
+                void ModbusClient::OnResolve(const boost::system::error_code& ec,
+                                             const boost::asio::ip::tcp::resolver::results_type& results,
+                                             size_t connection)
+                {
+                    if (connection != generation)
+                        return;
+
+                    if (ec)
+                    {
+                        LOG_ERROR("Resolve modbus host '{0}': {1}", host, ec.message());
+                        Disconnect(ModbusError::kNoConnectionModbusError);
+                        return;
+                    }
+
+                    boost::asio::async_connect(socket, results,
+                                               boost::bind(&ModbusClient::OnConnect, shared_from_this(),
+                                                           boost::placeholders::_1, connection));
+                }
+                void ModbusClient::OnConnect(const boost::system::error_code& ec, size_t connection)
+                {
+                    if (connection != generation)
+                        return;
+
+                    if (ec)
+                    {
+                        LOG_ERROR("Connect to modbus host '{0}:{1}': {2}", host, port, ec.message());
+                        Disconnect(ModbusError::kNoConnectionModbusError);
+                        return;
+                    }
+
+                    connecting = false;
+                    connected = true;
+                    backoff = std::chrono::milliseconds(0);
+
+                    boost::system::error_code error;
+                    socket.set_option(boost::asio::ip::tcp::no_delay(true), error);
+
+                    DoReadHeader();
+                    Dispatch();
+                }
+
+                void ModbusClient::Fail(ModbusError error)
+                {
+                    generation++;
+
+                    boost::system::error_code ec;
+                    resolver.cancel();
+                    reconnectTimer.cancel();
+                    socket.close(ec);
+
+                    // Every request fails below, the timeout would keep the client alive until its deadline
+                    timeoutTimer.cancel();
+                    timeoutTimerActive = false;
+
+                    connected = false;
+                    connecting = false;
+                    writing = false;
+                    writeQueue.clear();
+
+                    // Take callbacks first, they may send new requests
+                    boost::container::vector<ModbusResponseCallback> callbackList;
+                    callbackList.reserve(transactionMap.size() + requestQueue.size());
+                    for (auto& [id, transaction] : transactionMap)
+                        callbackList.push_back(std::move(transaction.callback));
+                    for (Request& request : requestQueue)
+                        callbackList.push_back(std::move(request.callback));
+                    transactionMap.clear();
+                    requestQueue.clear();
+
+                    for (const ModbusResponseCallback& callback : callbackList)
+                        callback(error, nullptr, 0);
+                }
+
+                void ModbusClient::Disconnect(ModbusError error)
+                {
+                    backoff = std::min(std::max(backoff * 2, std::chrono::milliseconds(MODBUS_CLIENT_MIN_BACKOFF)),
+                                       std::chrono::milliseconds(MODBUS_CLIENT_MAX_BACKOFF));
+                    retryTime = std::chrono::steady_clock::now() + backoff;
+
+                    Fail(error);
+                }
+
+                void ModbusClient::Close()
+                {
+                    Fail(ModbusError::kNoConnectionModbusError);
+                }
+
+                void ModbusClient::PostError(const ModbusResponseCallback& callback, ModbusError error)
+                {
+                    boost::asio::post(socket.get_executor(),
+                                      boost::bind(callback, error, (const uint8_t*)nullptr, (size_t)0));
+                }
+
+                //! Requests
+
+                void ModbusClient::Send(uint8_t unit, uint8_t function, const uint8_t* data, size_t size,
+                                        const ModbusResponseCallback& callback, size_t timeout)
+                {
+                    assert(callback);
+
+                    if (size + 1 > MODBUS_MAX_PDU_SIZE)
+                    {
+                        PostError(callback, ModbusError::kInvalidRequestModbusError);
+                        return;
+                    }
+
+                    Request request;
+                    request.transactionId = transactionId++;
+                    request.unit = unit;
+                    request.function = function;
+                    request.callback = callback;
+                    request.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+                    // Build frame (mbap header, function and data)
+                    uint16_t length = (uint16_t)(size + 2);
+                    request.frame.reserve(8 + size);
+                    request.frame.push_back((uint8_t)(request.transactionId >> 8));
+                    request.frame.push_back((uint8_t)(request.transactionId & 0xFF));
+                    request.frame.push_back(0);
+                    request.frame.push_back(0);
+                    request.frame.push_back((uint8_t)(length >> 8));
+                    request.frame.push_back((uint8_t)(length & 0xFF));
+                    request.frame.push_back(unit);
+                    request.frame.push_back(function);
+                    request.frame.insert(request.frame.end(), data, data + size);
+
+                    ArmTimeout(request.deadline);
+                    requestQueue.push_back(std::move(request));
+
+                    if (connected)
+                        Dispatch();
+                    else if (!connecting)
+                        Connect();
+                }
+
+                void ModbusClient::Dispatch()
+                {
+                    while (!requestQueue.empty() && transactionMap.size() < MODBUS_CLIENT_MAX_OUTSTANDING)
+                    {
+                        Request& request = requestQueue.front();
+
+                        Transaction& transaction = transactionMap[request.transactionId];
+                        transaction.unit = request.unit;
+                        transaction.function = request.function;
+                        transaction.callback = std::move(request.callback);
+                        transaction.deadline = request.deadline;
+
+                        writeQueue.push_back(std::move(request.frame));
+                        requestQueue.pop_front();
+                    }
+
+                    if (!writing && !writeQueue.empty())
+                        DoWrite();
+                }
+
+                void ModbusClient::DoWrite()
+                {
+                    writing = true;
+
+                    const boost::container::vector<uint8_t>& frame = writeQueue.front();
+                    boost::asio::async_write(socket, boost::asio::buffer(frame.data(), frame.size()),
+                                             boost::bind(&ModbusClient::OnWrite, shared_from_this(),
+                                                         boost::placeholders::_1, boost::placeholders::_2,
+                                                         generation));
+                }
+                void ModbusClient::OnWrite(const boost::system::error_code& ec, size_t sentBytes, size_t connection)
+                {
+                    (void)sentBytes;
+
+                    if (connection != generation)
+                        return;
+
+                    if (ec)
+                    {
+                        Disconnect(ModbusError::kNoConnectionModbusError);
+                        return;
+                    }
+
+                    writing = false;
+                    writeQueue.pop_front();
+
+                    if (!writeQueue.empty())
+                        DoWrite();
+                }
+
+                //! Responses
+
+                void ModbusClient::DoReadHeader()
+                {
+                    boost::asio::async_read(socket, boost::asio::buffer(header, sizeof(header)),
+                                            boost::bind(&ModbusClient::OnReadHeader, shared_from_this(),
+                                                        boost::placeholders::_1, boost::placeholders::_2, generation));
+                }
+                void ModbusClient::OnReadHeader(const boost::system::error_code& ec, size_t receivedBytes,
+                                                size_t connection)
+                {
+                    (void)receivedBytes;
+
+                    if (connection != generation)
+                        return;
+
+                    if (ec)
+                    {
+                        Disconnect(ModbusError::kNoConnectionModbusError);
+                        return;
+                    }
+
+                    // Verify protocol and length (unit id, function code and data)
+                    uint16_t length = (uint16_t)header[4] << 8 | (uint16_t)header[5];
+                    if (header[2] != 0 || header[3] != 0 || length < 2 || length > MODBUS_MAX_PDU_SIZE + 1)
+                    {
+                        LOG_ERROR("Invalid modbus response from '{0}:{1}'.", host, port);
+                        Disconnect(ModbusError::kInvalidResponseModbusError);
+                        return;
+                    }
+
+                    body.resize(length - 1);
+                    boost::asio::async_read(socket, boost::asio::buffer(body.data(), body.size()),
+                                            boost::bind(&ModbusClient::OnReadBody, shared_from_this(),
+                                                        boost::placeholders::_1, boost::placeholders::_2, connection));
+                }
+                void ModbusClient::OnReadBody(const boost::system::error_code& ec, size_t receivedBytes,
+                                              size_t connection)
+                {
+                    (void)receivedBytes;
+
+                    if (connection != generation)
+                        return;
+
+                    if (ec)
+                    {
+                        Disconnect(ModbusError::kNoConnectionModbusError);
+                        return;
+                    }
+
+                    // Match transaction (responses of timed out transactions are dropped)
+                    uint16_t id = (uint16_t)header[0] << 8 | (uint16_t)header[1];
+                    robin_hood::unordered_node_map<uint16_t, Transaction>::iterator it = transactionMap.find(id);
+                    if (it != transactionMap.end())
+                    {
+                        ModbusResponseCallback callback = std::move(it->second.callback);
+                        bool valid = header[6] == it->second.unit && (body[0] & 0x7F) == it->second.function;
+                        transactionMap.erase(it);
+
+                        if (!valid)
+                            callback(ModbusError::kInvalidResponseModbusError, nullptr, 0);
+                        else if (body[0] & 0x80)
+                            callback(body.size() > 1 ? (ModbusError)body[1] : ModbusError::kInvalidResponseModbusError,
+                                     nullptr, 0);
+                        else
+                            callback(ModbusError::kNoModbusError, body.data() + 1, body.size() - 1);
+
+                        // The callback may have closed the connection
+                        if (connection != generation)
+                            return;
+
+                        Dispatch();
+                    }
+
+                    DoReadHeader();
+                }
+
+                //! Timeouts
+
+                void ModbusClient::ArmTimeout(std::chrono::steady_clock::time_point deadline)
+                {
+                    if (timeoutTimerActive && timeoutTimer.expiry() <= deadline)
+                        return;
+
+                    timeoutTimerActive = true;
+                    timeoutTimer.expires_at(deadline);
+                    timeoutTimer.async_wait(
+                        boost::bind(&ModbusClient::OnTimeout, shared_from_this(), boost::placeholders::_1));
+                }
+                void ModbusClient::OnTimeout(const boost::system::error_code& ec)
+                {
+                    // Cancelled by an earlier deadline
+                    if (ec)
+                        return;
+
+                    timeoutTimerActive = false;
+
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+
+                    // Take expired callbacks first, they may send new requests
+                    boost::container::vector<ModbusResponseCallback> callbackList;
+                    for (robin_hood::unordered_node_map<uint16_t, Transaction>::iterator it = transactionMap.begin();
+                         it != transactionMap.end();)
+                    {
+                        if (it->second.deadline <= now)
+                        {
+                            callbackList.push_back(std::move(it->second.callback));
+                            it = transactionMap.erase(it);
+                        }
+                        else
+                        {
+                            next = std::min(next, it->second.deadline);
+                            it++;
+                        }
+                    }
+                    for (boost::container::deque<Request>::iterator it = requestQueue.begin();
+                         it != requestQueue.end();)
+                    {
+                        if (it->deadline <= now)
+                        {
+                            callbackList.push_back(std::move(it->callback));
+                            it = requestQueue.erase(it);
+                        }
+                        else
+                        {
+                            next = std::min(next, it->deadline);
+                            it++;
+                        }
+                    }
+
+                    if (next != std::chrono::steady_clock::time_point::max())
+                        ArmTimeout(next);
+
+                    // Give up connecting once nobody waits for it anymore
+                    if (connecting && transactionMap.empty() && requestQueue.empty())
+                    {
+                        if (now < retryTime)
+                            Fail(ModbusError::kTimeoutModbusError);
+                        else
+                            Disconnect(ModbusError::kTimeoutModbusError);
+                    }
+
+                    for (const ModbusResponseCallback& callback : callbackList)
+                        callback(ModbusError::kTimeoutModbusError, nullptr, 0);
+
+                    // Timed out transactions free their slots
+                    if (connected)
+                        Dispatch();
+                }
+
+                //! Functions
+
+                void ModbusClient::ReadRegisters(uint8_t unit, ModbusFunction function, uint16_t address,
+                                                 uint16_t count, const ModbusRegistersCallback& callback,
+                                                 size_t timeout)
+                {
+                    ModbusResponseCallback responseCallback =
+                        [count, callback](ModbusError error, const uint8_t* data, size_t size) -> void
+                    {
+                        if (error != ModbusError::kNoModbusError)
+                        {
+                            callback(error, nullptr, 0);
+                            return;
+                        }
+
+                        if (size != 1 + count * 2u || data[0] != count * 2u)
+                        {
+                            callback(ModbusError::kInvalidResponseModbusError, nullptr, 0);
+                            return;
+                        }
+
+                        uint16_t values[MODBUS_MAX_READ_REGISTERS];
+                        for (size_t i = 0; i < count; i++)
+                            values[i] = (uint16_t)data[1 + i * 2] << 8 | (uint16_t)data[2 + i * 2];
+
+                        callback(ModbusError::kNoModbusError, values, count);
+                    };
+
+                    if (count == 0 || count > MODBUS_MAX_READ_REGISTERS)
+                    {
+                        PostError(responseCallback, ModbusError::kInvalidRequestModbusError);
+                        return;
+                    }
+
+                    uint8_t data[4] = {(uint8_t)(address >> 8), (uint8_t)(address & 0xFF), (uint8_t)(count >> 8),
+                                       (uint8_t)(count & 0xFF)};
+                    Send(unit, (uint8_t)function, data, sizeof(data), responseCallback, timeout);
+                }
+
+                void ModbusClient::ReadBits(uint8_t unit, ModbusFunction function, uint16_t address, uint16_t count,
+                                            const ModbusBitsCallback& callback, size_t timeout)
+                {
+                    ModbusResponseCallback responseCallback =
+                        [count, callback](ModbusError error, const uint8_t* data, size_t size) -> void
+                    {
+                        if (error != ModbusError::kNoModbusError)
+                        {
+                            callback(error, nullptr, 0);
+                            return;
+                        }
+
+                        size_t byteCount = (count + 7) / 8;
+                        if (size != 1 + byteCount || data[0] != byteCount)
+                        {
+                            callback(ModbusError::kInvalidResponseModbusError, nullptr, 0);
+                            return;
+                        }
+
+                        bool values[MODBUS_MAX_READ_BITS];
+                        for (size_t i = 0; i < count; i++)
+                            values[i] = (data[1 + i / 8] >> (i % 8)) & 0x01;
+
+                        callback(ModbusError::kNoModbusError, values, count);
+                    };
+
+                    if (count == 0 || count > MODBUS_MAX_READ_BITS)
+                    {
+                        PostError(responseCallback, ModbusError::kInvalidRequestModbusError);
+                        return;
+                    }
+
+                    uint8_t data[4] = {(uint8_t)(address >> 8), (uint8_t)(address & 0xFF), (uint8_t)(count >> 8),
+                                       (uint8_t)(count & 0xFF)};
+                    Send(unit, (uint8_t)function, data, sizeof(data), responseCallback, timeout);
+                }
+
+                void ModbusClient::ReadCoils(uint8_t unit, uint16_t address, uint16_t count,
+                                             const ModbusBitsCallback& callback, size_t timeout)
+                {
+                    ReadBits(unit, ModbusFunction::kReadCoilsModbusFunction, address, count, callback, timeout);
+                }
+                void ModbusClient::ReadDiscreteInputs(uint8_t unit, uint16_t address, uint16_t count,
+                                                      const ModbusBitsCallback& callback, size_t timeout)
+                {
+                    ReadBits(unit, ModbusFunction::kReadDiscreteInputsModbusFunction, address, count, callback,
+                             timeout);
+                }
+                void ModbusClient::ReadHoldingRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                                        const ModbusRegistersCallback& callback, size_t timeout)
+                {
+                    ReadRegisters(unit, ModbusFunction::kReadHoldingRegistersModbusFunction, address, count, callback,
+                                  timeout);
+                }
+                void ModbusClient::ReadInputRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                                      const ModbusRegistersCallback& callback, size_t timeout)
+                {
+                    ReadRegisters(unit, ModbusFunction::kReadInputRegistersModbusFunction, address, count, callback,
+                                  timeout);
+                }
+
+                /// @brief Wrap write callback (the echoed response is not verified)
+                ///
+                /// @param callback Write callback
+                /// @return Response callback
+                static ModbusResponseCallback MakeWriteCallback(const ModbusWriteCallback& callback)
+                {
+                    return [callback](ModbusError error, const uint8_t* data, size_t size) -> void
+                    {
+                        (void)data;
+                        (void)size;
+
+                        if (callback)
+                            callback(error);
+                    };
+                }
+
+                void ModbusClient::WriteSingleCoil(uint8_t unit, uint16_t address, bool value,
+                                                   const ModbusWriteCallback& callback, size_t timeout)
+                {
+                    uint8_t data[4] = {(uint8_t)(address >> 8), (uint8_t)(address & 0xFF),
+                                       (uint8_t)(value ? 0xFF : 0x00), 0x00};
+                    Send(unit, (uint8_t)ModbusFunction::kWriteSingleCoilModbusFunction, data, sizeof(data),
+                         MakeWriteCallback(callback), timeout);
+                }
+                void ModbusClient::WriteSingleRegister(uint8_t unit, uint16_t address, uint16_t value,
+                                                       const ModbusWriteCallback& callback, size_t timeout)
+                {
+                    uint8_t data[4] = {(uint8_t)(address >> 8), (uint8_t)(address & 0xFF), (uint8_t)(value >> 8),
+                                       (uint8_t)(value & 0xFF)};
+                    Send(unit, (uint8_t)ModbusFunction::kWriteSingleRegisterModbusFunction, data, sizeof(data),
+                         MakeWriteCallback(callback), timeout);
+                }
+                void ModbusClient::WriteMultipleCoils(uint8_t unit, uint16_t address, const bool* values,
+                                                      uint16_t count, const ModbusWriteCallback& callback,
+                                                      size_t timeout)
+                {
+                    if (count == 0 || count > MODBUS_MAX_WRITE_BITS)
+                    {
+                        PostError(MakeWriteCallback(callback), ModbusError::kInvalidRequestModbusError);
+                        return;
+                    }
+
+                    uint8_t byteCount = (uint8_t)((count + 7) / 8);
+
+                    uint8_t data[5 + (MODBUS_MAX_WRITE_BITS + 7) / 8] = {
+                        (uint8_t)(address >> 8), (uint8_t)(address & 0xFF), (uint8_t)(count >> 8),
+                        (uint8_t)(count & 0xFF), byteCount};
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        if (values[i])
+                            data[5 + i / 8] |= (uint8_t)(1 << (i % 8));
+                    }
+
+                    Send(unit, (uint8_t)ModbusFunction::kWriteMultipleCoilsModbusFunction, data, 5 + byteCount,
+                         MakeWriteCallback(callback), timeout);
+                }
+                void ModbusClient::WriteMultipleRegisters(uint8_t unit, uint16_t address, const uint16_t* values,
+                                                          uint16_t count, const ModbusWriteCallback& callback,
+                                                          size_t timeout)
+                {
+                    if (count == 0 || count > MODBUS_MAX_WRITE_REGISTERS)
+                    {
+                        PostError(MakeWriteCallback(callback), ModbusError::kInvalidRequestModbusError);
+                        return;
+                    }
+
+                    uint8_t data[5 + MODBUS_MAX_WRITE_REGISTERS * 2] = {
+                        (uint8_t)(address >> 8), (uint8_t)(address & 0xFF), (uint8_t)(count >> 8),
+                        (uint8_t)(count & 0xFF), (uint8_t)(count * 2)};
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        data[5 + i * 2] = (uint8_t)(values[i] >> 8);
+                        data[6 + i * 2] = (uint8_t)(values[i] & 0xFF);
+                    }
+
+                    Send(unit, (uint8_t)ModbusFunction::kWriteMultipleRegistersModbusFunction, data, 5 + count * 2,
+                         MakeWriteCallback(callback), timeout);
+                }
+            }
+        }
+    }
+}
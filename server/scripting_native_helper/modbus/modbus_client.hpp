@@ -0,0 +1,302 @@
+#pragma once
+#include <common/common.hpp>
+
+// Transactions sent on a connection without waiting for their responses (further requests are queued)
+#define MODBUS_CLIENT_MAX_OUTSTANDING 8
+
+// Default request timeout (in milliseconds), covers queueing and the round trip
+#define MODBUS_CLIENT_DEFAULT_TIMEOUT 2000
+
+// Reconnect backoff (in milliseconds), doubled after every failed connection
+#define MODBUS_CLIENT_MIN_BACKOFF 100
+#define MODBUS_CLIENT_MAX_BACKOFF 10000
+
+// Protocol data unit limits
+#define MODBUS_MAX_READ_REGISTERS 125
+#define MODBUS_MAX_READ_BITS 2000
+#define MODBUS_MAX_WRITE_REGISTERS 123
+#define MODBUS_MAX_WRITE_BITS 1968
+#define MODBUS_MAX_PDU_SIZE 253
+
+namespace server
+{
+    namespace scripting
+    {
+        namespace native
+        {
+            namespace modbus
+            {
+                enum class ModbusFunction : uint8_t
+                {
+                    kReadCoilsModbusFunction = 0x01,
+                    kReadDiscreteInputsModbusFunction = 0x02,
+                    kReadHoldingRegistersModbusFunction = 0x03,
+                    kReadInputRegistersModbusFunction = 0x04,
+                    kWriteSingleCoilModbusFunction = 0x05,
+                    kWriteSingleRegisterModbusFunction = 0x06,
+                    kWriteMultipleCoilsModbusFunction = 0x0F,
+                    kWriteMultipleRegistersModbusFunction = 0x10,
+                };
+
+                enum class ModbusError : uint8_t
+                {
+                    kNoModbusError = 0x00,
+
+                    // Modbus exceptions
+                    kIllegalFunctionModbusError = 0x01,
+                    kIllegalAddressModbusError = 0x02,
+                    kIllegalValueModbusError = 0x03,
+                    kServerFailureModbusError = 0x04,
+                    kAcknowledgeModbusError = 0x05,
+                    kServerBusyModbusError = 0x06,
+                    kNegativeAcknowledgeModbusError = 0x07,
+                    kMemoryParityModbusError = 0x08,
+                    kGatewayPathUnavailableModbusError = 0x0A,
+                    kGatewayTargetFailedModbusError = 0x0B,
+
+                    // Not defined by modbus (no connection matches the toolkit client)
+                    kNoConnectionModbusError = 0x09,
+                    kTimeoutModbusError = 0xF0,
+                    kInvalidResponseModbusError = 0xF1,
+                    kInvalidRequestModbusError = 0xF2,
+                };
+
+                std::string StringifyModbusError(ModbusError error);
+
+                /// @brief Response callback
+                ///
+                /// @param error Error
+                /// @param data Response data following the function code
+                /// @param size Response data size
+                typedef boost::function<void(ModbusError error, const uint8_t* data, size_t size)>
+                    ModbusResponseCallback;
+
+                /// @brief Register read callback
+                ///
+                /// @param error Error
+                /// @param values Registers (only valid during the call)
+                /// @param count Register count
+                typedef boost::function<void(ModbusError error, const uint16_t* values, size_t count)>
+                    ModbusRegistersCallback;
+
+                /// @brief Coil or discrete input read callback
+                ///
+                /// @param error Error
+                /// @param values Bits (only valid during the call)
+                /// @param count Bit count
+                typedef boost::function<void(ModbusError error, const bool* values, size_t count)>
+                    ModbusBitsCallback;
+
+                /// @brief Write callback
+                ///
+                /// @param error Error
+                typedef boost::function<void(ModbusError error)> ModbusWriteCallback;
+
+                /// @brief Asynchronous modbus tcp client
+                ///
+                /// Requests are pipelined on a single connection and matched to their responses by the transaction
+                /// id, so one slow slave does not block the caller. The client lives on the worker, every method must
+                /// be called from the worker and every callback is called on the worker.
+                class ModbusClient : public boost::enable_shared_from_this<ModbusClient>
+                {
+                  private:
+                    struct Request
+                    {
+                        uint16_t transactionId;
+                        uint8_t unit;
+                        uint8_t function;
+                        boost::container::vector<uint8_t> frame;
+                        ModbusResponseCallback callback;
+                        std::chrono::steady_clock::time_point deadline;
+                    };
+
+                    struct Transaction
+                    {
+                        uint8_t unit;
+                        uint8_t function;
+                        ModbusResponseCallback callback;
+                        std::chrono::steady_clock::time_point deadline;
+                    };
+
+                    std::string host;
+                    uint16_t port;
+
+                    boost::asio::ip::tcp::resolver resolver;
+                    boost::asio::ip::tcp::socket socket;
+                    boost::asio::steady_timer timeoutTimer;
+                    bool timeoutTimerActive = false;
+
+                    /// @brief Reconnect backoff (connecting is delayed until the retry time)
+                    ///
+                    boost::asio::steady_timer reconnectTimer;
+                    std::chrono::milliseconds backoff = std::chrono::milliseconds(0);
+                    std::chrono::steady_clock::time_point retryTime;
+
+                    bool connected = false;
+                    bool connecting = false;
+                    bool writing = false;
+
+                    /// @brief Connection generation (handlers of a closed connection are ignored)
+                    ///
+                    size_t generation = 0;
+
+                    uint16_t transactionId = 0;
+
+                    /// @brief Requests waiting for a free transaction slot
+                    ///
+                    boost::container::deque<Request> requestQueue;
+
+                    /// @brief Sent requests waiting for their response
+                    ///
+                    robin_hood::unordered_node_map<uint16_t, Transaction> transactionMap;
+
+                    /// @brief Frames waiting to be written (the front frame is being written)
+                    ///
+                    boost::container::deque<boost::container::vector<uint8_t>> writeQueue;
+
+                    uint8_t header[7];
+                    boost::container::vector<uint8_t> body;
+
+                    void Connect();
+                    void OnReconnect(const boost::system::error_code& ec, size_t connection);
+                    void OnResolve(const boost::system::error_code& ec,
+                                   const boost::asio::ip::tcp::resolver::results_type& results, size_t connection);
+                    void OnConnect(const boost::system::error_code& ec, size_t connection);
+
+                    /// @brief Send queued requests while transaction slots are free
+                    ///
+                    void Dispatch();
+
+                    void DoWrite();
+                    void OnWrite(const boost::system::error_code& ec, size_t sentBytes, size_t connection);
+
+                    void DoReadHeader();
+                    void OnReadHeader(const boost::system::error_code& ec, size_t receivedBytes, size_t connection);
+                    void OnReadBody(const boost::system::error_code& ec, size_t receivedBytes, size_t connection);
+
+                    /// @brief Arm timeout timer for a deadline (if it is earlier than the current one)
+                    ///
+                    /// @param deadline Deadline
+                    void ArmTimeout(std::chrono::steady_clock::time_point deadline);
+                    void OnTimeout(const boost::system::error_code& ec);
+
+                    /// @brief Close connection and fail every request
+                    ///
+                    /// @param error Error passed to the callbacks
+                    void Fail(ModbusError error);
+
+                    /// @brief Close broken connection and delay the next connection attempt
+                    ///
+                    /// @param error Error passed to the callbacks
+                    void Disconnect(ModbusError error);
+
+                    /// @brief Call callback with an error after the current handler
+                    ///
+                    /// @param callback Callback
+                    /// @param error Error
+                    void PostError(const ModbusResponseCallback& callback, ModbusError error);
+
+                    void ReadRegisters(uint8_t unit, ModbusFunction function, uint16_t address, uint16_t count,
+                                       const ModbusRegistersCallback& callback, size_t timeout);
+                    void ReadBits(uint8_t unit, ModbusFunction function, uint16_t address, uint16_t count,
+                                  const ModbusBitsCallback& callback, size_t timeout);
+
+                  public:
+                    ModbusClient(boost::asio::io_context& context, const std::string& host, uint16_t port);
+                    virtual ~ModbusClient();
+
+                    /// @brief Create client on the worker context
+                    ///
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @return Client
+                    static Ref<ModbusClient> Create(const std::string& host, uint16_t port = 502);
+
+                    /// @brief Create client on a context
+                    ///
+                    /// @param context IO context
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @return Client
+                    static Ref<ModbusClient> Create(boost::asio::io_context& context, const std::string& host,
+                                                    uint16_t port = 502);
+
+                    inline const std::string& GetHost() const
+                    {
+                        return host;
+                    }
+                    inline uint16_t GetPort() const
+                    {
+                        return port;
+                    }
+
+                    inline boost::asio::ip::tcp::socket::executor_type GetExecutor()
+                    {
+                        return socket.get_executor();
+                    }
+
+                    inline bool IsConnected() const
+                    {
+                        return connected;
+                    }
+
+                    /// @brief Check whether the last connection failed (the client reconnects after its backoff)
+                    ///
+                    /// @return Connection failed and was not established again
+                    inline bool IsReconnecting() const
+                    {
+                        return !connected && backoff.count() > 0;
+                    }
+
+                    /// @brief Get number of requests waiting for a response or for a transaction slot
+                    ///
+                    /// @return Pending request count
+                    inline size_t GetPendingCount() const
+                    {
+                        return requestQueue.size() + transactionMap.size();
+                    }
+
+                    /// @brief Send raw request (connects on demand)
+                    ///
+                    /// @param unit Unit id (slave id)
+                    /// @param function Function code
+                    /// @param data Request data following the function code
+                    /// @param size Request data size
+                    /// @param callback Response callback
+                    /// @param timeout Timeout in milliseconds
+                    void Send(uint8_t unit, uint8_t function, const uint8_t* data, size_t size,
+                              const ModbusResponseCallback& callback, size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+
+                    void ReadCoils(uint8_t unit, uint16_t address, uint16_t count, const ModbusBitsCallback& callback,
+                                   size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+                    void ReadDiscreteInputs(uint8_t unit, uint16_t address, uint16_t count,
+                                            const ModbusBitsCallback& callback,
+                                            size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+                    void ReadHoldingRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                              const ModbusRegistersCallback& callback,
+                                              size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+                    void ReadInputRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                            const ModbusRegistersCallback& callback,
+                                            size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+
+                    void WriteSingleCoil(uint8_t unit, uint16_t address, bool value,
+                                         const ModbusWriteCallback& callback = {},
+                                         size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+                    void WriteSingleRegister(uint8_t unit, uint16_t address, uint16_t value,
+                                             const ModbusWriteCallback& callback = {},
+                                             size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+                    void WriteMultipleCoils(uint8_t unit, uint16_t address, const bool* values, uint16_t count,
+                                            const ModbusWriteCallback& callback = {},
+                                            size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+                    void WriteMultipleRegisters(uint8_t unit, uint16_t address, const uint16_t* values,
+                                                uint16_t count, const ModbusWriteCallback& callback = {},
+                                                size_t timeout = MODBUS_CLIENT_DEFAULT_TIMEOUT);
+
+                    /// @brief Close connection (pending requests fail with no connection)
+                    ///
+                    void Close();
+                };
+            }
+        }
+    }
+}
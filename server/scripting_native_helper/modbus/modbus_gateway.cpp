@@ -0,0 +1,473 @@
+#include "modbus_gateway.hpp"
+#include <common/worker.hpp>
+
+namespace server
+{
+    namespace scripting
+    {
+        namespace native
+        {
+            namespace modbus
+            {
+                /// @brief Shared gateways by host and port (only accessed from the worker)
+                ///
+                static robin_hood::unordered_node_map<std::string, WeakRef<ModbusGateway>> gatewayMap;
+
+                ModbusGateway::ModbusGateway(boost::asio::io_context& context, const std::string& host, uint16_t port,
+                                             size_t maxConnections)
+                    : context(context), host(host), port(port), maxConnections(std::max(maxConnections, (size_t)1))
+                {
+                }
+                ModbusGateway::~ModbusGateway()
+                {
+                    // The pending read of every connection keeps it alive otherwise
+                    Close();
+                }
+
+                Ref<ModbusGateway> ModbusGateway::Create(boost::asio::io_context& context, const std::string& host,
+                                                         uint16_t port, size_t maxConnections)
+                {
+                    Ref<ModbusGateway> gateway = boost::make_shared<ModbusGateway>(context, host, port, maxConnections);
+                    if (gateway == nullptr)
+                    {
+                        LOG_ERROR("Create modbus gateway.");
+                        return nullptr;
+                    }
+
+                    return gateway;
+                }
+
+                Ref<ModbusGateway> ModbusGateway::Get(const std::string& host, uint16_t port, size_t maxConnections)
+                {
+                    std::string endpoint = host + ":" + std::to_string(port);
+
+                    robin_hood::unordered_node_map<std::string, WeakRef<ModbusGateway>>::iterator it =
+                        gatewayMap.find(endpoint);
+                    if (it != gatewayMap.end())
+                    {
+                        Ref<ModbusGateway> gateway = it->second.lock();
+                        if (gateway != nullptr)
+                            return gateway;
+                    }
+
+                    // Remove gateways nobody uses anymore
+                    for (it = gatewayMap.begin(); it != gatewayMap.end();)
+                    {
+                        if (it->second.expired())
+                            it = gatewayMap.erase(it);
+                        else
+                            it++;
+                    }
+
+                    Ref<Worker> worker = Worker::GetInstance();
+                    assert(worker != nullptr);
+
+                    Ref<ModbusGateway> gateway = Create(worker->GetContext(), host, port, maxConnections);
+                    if (gateway != nullptr)
+                        gatewayMap[endpoint] = gateway;
+
+                    return gateway;
+                }
+
+                //! Scheduling
+
+                void ModbusGateway::Enqueue(uint8_t unit, Operation&& operation)
+                {
+                    boost::container::deque<Operation>& queue = unitQueueMap[unit];
+                    if (queue.empty())
+                        unitList.push_back(unit);
+                    queue.push_back(std::move(operation));
+                }
+
+                void ModbusGateway::Schedule()
+                {
+                    while (!unitList.empty())
+                    {
+                        Ref<ModbusClient> client = GetFreeClient();
+                        if (client == nullptr)
+                            return;
+
+                        // Take one operation of the next unit
+                        uint8_t unit = unitList.front();
+                        unitList.pop_front();
+
+                        robin_hood::unordered_node_map<uint8_t, boost::container::deque<Operation>>::iterator it =
+                            unitQueueMap.find(unit);
+                        assert(it != unitQueueMap.end() && !it->second.empty());
+
+                        Operation operation = std::move(it->second.front());
+                        it->second.pop_front();
+
+                        if (it->second.empty())
+                            unitQueueMap.erase(it);
+                        else
+                            unitList.push_back(unit);
+
+                        operation(client);
+                    }
+                }
+
+                Ref<ModbusClient> ModbusGateway::GetFreeClient()
+                {
+                    // Least busy working connection with a free transaction slot
+                    Ref<ModbusClient> freeClient = nullptr;
+
+                    // Least busy broken connection (waiting for its reconnect backoff)
+                    Ref<ModbusClient> brokenClient = nullptr;
+
+                    for (const Ref<ModbusClient>& client : clientList)
+                    {
+                        size_t pendingCount = client->GetPendingCount();
+                        if (pendingCount >= MODBUS_CLIENT_MAX_OUTSTANDING)
+                            continue;
+
+                        Ref<ModbusClient>& bestClient = client->IsReconnecting() ? brokenClient : freeClient;
+                        if (bestClient == nullptr || pendingCount < bestClient->GetPendingCount())
+                            bestClient = client;
+                    }
+
+                    // Open another connection once every connection is busy or broken
+                    if (freeClient == nullptr && clientList.size() < maxConnections)
+                    {
+                        freeClient = ModbusClient::Create(context, host, port);
+                        if (freeClient != nullptr)
+                            clientList.push_back(freeClient);
+                    }
+
+                    // Queue on a broken connection only if there is no other
+                    if (freeClient == nullptr)
+                        freeClient = brokenClient;
+
+                    return freeClient;
+                }
+
+                void ModbusGateway::Close()
+                {
+                    boost::container::vector<Ref<ModbusClient>> closeList;
+                    std::swap(closeList, clientList);
+
+                    for (const Ref<ModbusClient>& client : closeList)
+                        client->Close();
+                }
+
+                //! Reads
+
+                void ModbusGateway::Read(uint8_t unit, ModbusFunction function, uint16_t address, uint16_t count,
+                                         const ModbusRegistersCallback& callback, size_t maxAge)
+                {
+                    assert(callback);
+
+                    if (count == 0 || count > MODBUS_MAX_READ_REGISTERS || (uint32_t)address + count > 0x10000)
+                    {
+                        boost::asio::post(context.get_executor(),
+                                          boost::bind(callback, ModbusError::kInvalidRequestModbusError,
+                                                      (const uint16_t*)nullptr, (size_t)0));
+                        return;
+                    }
+
+                    // Serve from cache if every register is fresh
+                    if (maxAge > 0)
+                    {
+                        std::chrono::steady_clock::time_point oldest =
+                            std::chrono::steady_clock::now() - std::chrono::milliseconds(maxAge);
+
+                        boost::container::vector<uint16_t> values;
+                        values.reserve(count);
+                        for (uint16_t i = 0; i < count; i++)
+                        {
+                            robin_hood::unordered_flat_map<uint32_t, CacheEntry>::const_iterator it =
+                                cacheMap.find(MakeCacheKey(unit, function, address + i));
+                            if (it == cacheMap.end() || it->second.time < oldest)
+                                break;
+
+                            values.push_back(it->second.value);
+                        }
+
+                        if (values.size() == count)
+                        {
+                            boost::asio::post(context.get_executor(),
+                                              [callback, values = std::move(values)]() -> void
+                                              { callback(ModbusError::kNoModbusError, values.data(), values.size()); });
+                            return;
+                        }
+                    }
+
+                    // Merge with the other reads of this tick
+                    pendingMap[MakeReadKey(unit, function)].push_back(PendingRead{address, count, callback});
+
+                    if (!flushPending)
+                    {
+                        flushPending = true;
+                        boost::asio::post(context.get_executor(),
+                                          boost::bind(&ModbusGateway::Flush, shared_from_this()));
+                    }
+                }
+
+                void ModbusGateway::ReadHoldingRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                                         const ModbusRegistersCallback& callback, size_t maxAge)
+                {
+                    Read(unit, ModbusFunction::kReadHoldingRegistersModbusFunction, address, count, callback, maxAge);
+                }
+                void ModbusGateway::ReadInputRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                                       const ModbusRegistersCallback& callback, size_t maxAge)
+                {
+                    Read(unit, ModbusFunction::kReadInputRegistersModbusFunction, address, count, callback, maxAge);
+                }
+
+                void ModbusGateway::ReadCoils(uint8_t unit, uint16_t address, uint16_t count,
+                                              const ModbusBitsCallback& callback)
+                {
+                    Ref<ModbusGateway> gateway = shared_from_this();
+                    ModbusBitsCallback bitsCallback = [gateway, callback](ModbusError error, const bool* values,
+                                                                          size_t valueCount) -> void
+                    {
+                        callback(error, values, valueCount);
+                        gateway->Schedule();
+                    };
+
+                    Enqueue(unit, [unit, address, count, bitsCallback](const Ref<ModbusClient>& client) -> void
+                            { client->ReadCoils(unit, address, count, bitsCallback); });
+
+                    Schedule();
+                }
+                void ModbusGateway::ReadDiscreteInputs(uint8_t unit, uint16_t address, uint16_t count,
+                                                       const ModbusBitsCallback& callback)
+                {
+                    Ref<ModbusGateway> gateway = shared_from_this();
+                    ModbusBitsCallback bitsCallback = [gateway, callback](ModbusError error, const bool* values,
+                                                                          size_t valueCount) -> void
+                    {
+                        callback(error, values, valueCount);
+                        gateway->Schedule();
+                    };
+
+                    Enqueue(unit, [unit, address, count, bitsCallback](const Ref<ModbusClient>& client) -> void
+                            { client->ReadDiscreteInputs(unit, address, count, bitsCallback); });
+
+                    Schedule();
+                }
+
+                void ModbusGateway::Flush()
+                {
+                    flushPending = false;
+
+                    robin_hood::unordered_node_map<uint16_t, boost::container::vector<PendingRead>> readMap;
+                    std::swap(readMap, pendingMap);
+
+                    for (auto& [key, readList] : readMap)
+                    {
+                        uint8_t unit = (uint8_t)(key >> 8);
+                        ModbusFunction function = (ModbusFunction)(key & 0xFF);
+
+                        std::sort(readList.begin(), readList.end(),
+                                  [](const PendingRead& a, const PendingRead& b) -> bool
+                                  { return a.address < b.address; });
+
+                        // Merge overlapping and adjacent reads as long as the range fits into one request
+                        Ref<boost::container::vector<PendingRead>> rangeList = nullptr;
+                        uint32_t begin = 0;
+                        uint32_t end = 0;
+                        for (PendingRead& read : readList)
+                        {
+                            uint32_t readEnd = (uint32_t)read.address + read.count;
+
+                            if (rangeList != nullptr && read.address <= end &&
+                                std::max(end, readEnd) - begin <= MODBUS_MAX_READ_REGISTERS)
+                            {
+                                end = std::max(end, readEnd);
+                                rangeList->push_back(std::move(read));
+                                continue;
+                            }
+
+                            if (rangeList != nullptr)
+                                ReadRange(unit, function, (uint16_t)begin, (uint16_t)(end - begin), rangeList);
+
+                            rangeList = boost::make_shared<boost::container::vector<PendingRead>>();
+                            begin = read.address;
+                            end = readEnd;
+                            rangeList->push_back(std::move(read));
+                        }
+
+                        if (rangeList != nullptr)
+                            ReadRange(unit, function, (uint16_t)begin, (uint16_t)(end - begin), rangeList);
+                    }
+
+                    Schedule();
+                }
+
+                void ModbusGateway::ReadRange(uint8_t unit, ModbusFunction function, uint16_t address,
+                                              uint16_t count,
+                                              const Ref<boost::container::vector<PendingRead>>& readList)
+                {
+                    ModbusRegistersCallback callback = boost::bind(
+                        &ModbusGateway::OnReadRange, shared_from_this(), unit, function, address, writeSequence,
+                        readList, boost::placeholders::_1, boost::placeholders::_2, boost::placeholders::_3);
+
+                    Enqueue(unit,
+                            [unit, function, address, count, callback](const Ref<ModbusClient>& client) -> void
+                            {
+                                if (function == ModbusFunction::kReadHoldingRegistersModbusFunction)
+                                    client->ReadHoldingRegisters(unit, address, count, callback);
+                                else
+                                    client->ReadInputRegisters(unit, address, count, callback);
+                            });
+                }
+
+                void ModbusGateway::OnReadRange(uint8_t unit, ModbusFunction function, uint16_t address,
+                                                uint64_t sequence,
+                                                const Ref<boost::container::vector<PendingRead>>& readList,
+                                                ModbusError error, const uint16_t* values, size_t count)
+                {
+                    if (error == ModbusError::kNoModbusError)
+                    {
+                        UpdateCache(unit, function, address, values, count, sequence);
+
+                        for (const PendingRead& read : *readList)
+                            read.callback(ModbusError::kNoModbusError, values + (read.address - address), read.count);
+                    }
+                    else if (error == ModbusError::kIllegalAddressModbusError && readList->size() > 1)
+                    {
+                        // A merged range may span registers the slave does not have, read separately
+                        for (const PendingRead& read : *readList)
+                        {
+                            ReadRange(unit, function, read.address, read.count,
+                                      boost::make_shared<boost::container::vector<PendingRead>>(1, read));
+                        }
+                    }
+                    else
+                    {
+                        for (const PendingRead& read : *readList)
+                            read.callback(error, nullptr, 0);
+                    }
+
+                    Schedule();
+                }
+
+                void ModbusGateway::UpdateCache(uint8_t unit, ModbusFunction function, uint16_t address,
+                                                const uint16_t* values, size_t count, uint64_t sequence)
+                {
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        CacheEntry& entry = cacheMap[MakeCacheKey(unit, function, (uint16_t)(address + i))];
+
+                        // The read may have been served before a write that completed (or was sent) after it
+                        if (entry.sequence > sequence || entry.time == std::chrono::steady_clock::time_point::min())
+                            continue;
+
+                        entry.value = values[i];
+                        entry.time = now;
+                    }
+                }
+
+                void ModbusGateway::CompleteWrite(uint8_t unit, uint16_t address, const uint16_t* values,
+                                                  size_t count, uint64_t sequence)
+                {
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    uint64_t completeSequence = ++writeSequence;
+
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        CacheEntry& entry = cacheMap[MakeCacheKey(
+                            unit, ModbusFunction::kReadHoldingRegistersModbusFunction, (uint16_t)(address + i))];
+
+                        // A later write is still pending
+                        if (entry.sequence != sequence)
+                            continue;
+
+                        // The value of a failed write is unknown, only reads sent from now on are cached
+                        if (values != nullptr)
+                            entry = CacheEntry{values[i], now, completeSequence};
+                        else
+                            entry = CacheEntry{0, std::chrono::steady_clock::time_point(), completeSequence};
+                    }
+                }
+
+                //! Writes
+
+                void ModbusGateway::WriteSingleRegister(uint8_t unit, uint16_t address, uint16_t value,
+                                                        const ModbusWriteCallback& callback)
+                {
+                    WriteMultipleRegisters(unit, address, &value, 1, callback);
+                }
+
+                void ModbusGateway::WriteMultipleRegisters(uint8_t unit, uint16_t address, const uint16_t* values,
+                                                           uint16_t count, const ModbusWriteCallback& callback)
+                {
+                    // Expire the written registers until the write is confirmed (reads are not cached meanwhile)
+                    uint64_t sequence = ++writeSequence;
+                    for (uint16_t i = 0; i < count; i++)
+                    {
+                        cacheMap[MakeCacheKey(unit, ModbusFunction::kReadHoldingRegistersModbusFunction,
+                                              (uint16_t)(address + i))] =
+                            CacheEntry{0, std::chrono::steady_clock::time_point::min(), sequence};
+                    }
+
+                    Ref<ModbusGateway> gateway = shared_from_this();
+                    Ref<boost::container::vector<uint16_t>> valueList =
+                        boost::make_shared<boost::container::vector<uint16_t>>(values, values + count);
+
+                    ModbusWriteCallback writeCallback = [gateway, unit, address, sequence, valueList,
+                                                         callback](ModbusError error) -> void
+                    {
+                        gateway->CompleteWrite(unit, address,
+                                               error == ModbusError::kNoModbusError ? valueList->data() : nullptr,
+                                               valueList->size(), sequence);
+
+                        if (callback)
+                            callback(error);
+
+                        gateway->Schedule();
+                    };
+
+                    Enqueue(unit,
+                            [unit, address, valueList, writeCallback](const Ref<ModbusClient>& client) -> void
+                            {
+                                if (valueList->size() == 1)
+                                    client->WriteSingleRegister(unit, address, valueList->front(), writeCallback);
+                                else
+                                    client->WriteMultipleRegisters(unit, address, valueList->data(),
+                                                                   (uint16_t)valueList->size(), writeCallback);
+                            });
+
+                    Schedule();
+                }
+
+                void ModbusGateway::WriteSingleCoil(uint8_t unit, uint16_t address, bool value,
+                                                    const ModbusWriteCallback& callback)
+                {
+                    WriteMultipleCoils(unit, address, &value, 1, callback);
+                }
+
+                void ModbusGateway::WriteMultipleCoils(uint8_t unit, uint16_t address, const bool* values,
+                                                       uint16_t count, const ModbusWriteCallback& callback)
+                {
+                    Ref<ModbusGateway> gateway = shared_from_this();
+                    Ref<boost::container::vector<bool>> valueList =
+                        boost::make_shared<boost::container::vector<bool>>(values, values + count);
+
+                    ModbusWriteCallback writeCallback = [gateway, callback](ModbusError error) -> void
+                    {
+                        if (callback)
+                            callback(error);
+
+                        gateway->Schedule();
+                    };
+
+                    Enqueue(unit,
+                            [unit, address, valueList, writeCallback](const Ref<ModbusClient>& client) -> void
+                            {
+                                if (valueList->size() == 1)
+                                    client->WriteSingleCoil(unit, address, valueList->front(), writeCallback);
+                                else
+                                    client->WriteMultipleCoils(unit, address, valueList->data(),
+                                                               (uint16_t)valueList->size(), writeCallback);
+                            });
+
+                    Schedule();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include "modbus_client.hpp"
+
+// Default age (in milliseconds) up to which cached registers are returned instead of being read again
+#define MODBUS_GATEWAY_DEFAULT_MAX_AGE 1000
+
+// Default number of connections opened to a gateway (many gateways only accept 1-4)
+#define MODBUS_GATEWAY_DEFAULT_CONNECTIONS 2
+
+namespace server
+{
+    namespace scripting
+    {
+        namespace native
+        {
+            namespace modbus
+            {
+                /// @brief Modbus gateway shared by every script talking to the same host
+                ///
+                /// Requests for every unit are multiplexed over a small pool of connections. Each unit has its own
+                /// queue and the queues are served round robin, so a unit with many requests does not starve the
+                /// others. A connection is only handed a request when it has a free transaction slot, further
+                /// connections are opened when the existing ones are busy.
+                ///
+                /// Register reads issued during one worker tick are collected per unit and function, overlapping and
+                /// adjacent ranges are merged into as few requests as the pdu limit allows. Read registers are cached,
+                /// reads only covering fresh registers are served from the cache. Writes through the gateway update
+                /// the cache.
+                class ModbusGateway : public boost::enable_shared_from_this<ModbusGateway>
+                {
+                  private:
+                    struct PendingRead
+                    {
+                        uint16_t address;
+                        uint16_t count;
+                        ModbusRegistersCallback callback;
+                    };
+
+                    struct CacheEntry
+                    {
+                        uint16_t value;
+                        std::chrono::steady_clock::time_point time;
+
+                        /// @brief Write sequence number when the register was last written or confirmed
+                        ///
+                        uint64_t sequence;
+                    };
+
+                    /// @brief Queued operation, sends its request on the given connection
+                    ///
+                    typedef boost::function<void(const Ref<ModbusClient>& client)> Operation;
+
+                    boost::asio::io_context& context;
+                    std::string host;
+                    uint16_t port;
+
+                    /// @brief Connection pool (opened on demand)
+                    ///
+                    size_t maxConnections;
+                    boost::container::vector<Ref<ModbusClient>> clientList;
+
+                    /// @brief Queued operations by unit
+                    ///
+                    robin_hood::unordered_node_map<uint8_t, boost::container::deque<Operation>> unitQueueMap;
+
+                    /// @brief Units with queued operations in round robin order
+                    ///
+                    boost::container::deque<uint8_t> unitList;
+
+                    /// @brief Reads waiting for the next flush by unit and function
+                    ///
+                    robin_hood::unordered_node_map<uint16_t, boost::container::vector<PendingRead>> pendingMap;
+                    bool flushPending = false;
+
+                    /// @brief Cached registers by unit, function and address
+                    ///
+                    robin_hood::unordered_flat_map<uint32_t, CacheEntry> cacheMap;
+
+                    /// @brief Write sequence number (increased when a write is sent and when it is confirmed)
+                    ///
+                    uint64_t writeSequence = 0;
+
+                    static inline uint16_t MakeReadKey(uint8_t unit, ModbusFunction function)
+                    {
+                        return (uint16_t)unit << 8 | (uint16_t)function;
+                    }
+                    static inline uint32_t MakeCacheKey(uint8_t unit, ModbusFunction function, uint16_t address)
+                    {
+                        return (uint32_t)unit << 24 | (uint32_t)function << 16 | (uint32_t)address;
+                    }
+
+                    /// @brief Queue operation of a unit (sent by the next schedule)
+                    ///
+                    /// @param unit Unit id
+                    /// @param operation Operation
+                    void Enqueue(uint8_t unit, Operation&& operation);
+
+                    /// @brief Hand queued operations to connections with free transaction slots
+                    ///
+                    void Schedule();
+
+                    /// @brief Get connection with a free transaction slot (opens a connection if needed)
+                    /// @note Broken connections are only used when no other connection is free and no further
+                    /// connection may be opened
+                    ///
+                    /// @return Connection or null if every connection is busy
+                    Ref<ModbusClient> GetFreeClient();
+
+                    void Read(uint8_t unit, ModbusFunction function, uint16_t address, uint16_t count,
+                              const ModbusRegistersCallback& callback, size_t maxAge);
+
+                    /// @brief Merge and send pending reads
+                    ///
+                    void Flush();
+
+                    /// @brief Read merged range
+                    ///
+                    /// @param unit Unit id
+                    /// @param function Read function
+                    /// @param address First register of the range
+                    /// @param count Register count of the range
+                    /// @param readList Reads covered by the range
+                    void ReadRange(uint8_t unit, ModbusFunction function, uint16_t address, uint16_t count,
+                                   const Ref<boost::container::vector<PendingRead>>& readList);
+                    void OnReadRange(uint8_t unit, ModbusFunction function, uint16_t address, uint64_t sequence,
+                                     const Ref<boost::container::vector<PendingRead>>& readList, ModbusError error,
+                                     const uint16_t* values, size_t count);
+
+                    /// @brief Cache read registers
+                    /// @note Registers with a pending write or written after the read was sent are skipped
+                    ///
+                    /// @param unit Unit id
+                    /// @param function Read function
+                    /// @param address First register
+                    /// @param values Registers
+                    /// @param count Register count
+                    /// @param sequence Write sequence number when the read was sent
+                    void UpdateCache(uint8_t unit, ModbusFunction function, uint16_t address, const uint16_t* values,
+                                     size_t count, uint64_t sequence);
+
+                    /// @brief Cache written holding registers once the write completed
+                    /// @note Registers written again after this write are skipped
+                    ///
+                    /// @param unit Unit id
+                    /// @param address First register
+                    /// @param values Written registers (null if the write failed)
+                    /// @param count Register count
+                    /// @param sequence Write sequence number of the write
+                    void CompleteWrite(uint8_t unit, uint16_t address, const uint16_t* values, size_t count,
+                                       uint64_t sequence);
+
+                  public:
+                    ModbusGateway(boost::asio::io_context& context, const std::string& host, uint16_t port,
+                                  size_t maxConnections);
+                    virtual ~ModbusGateway();
+
+                    /// @brief Create gateway
+                    ///
+                    /// @param context IO context
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @param maxConnections Maximum connections opened to the gateway
+                    /// @return Gateway
+                    static Ref<ModbusGateway> Create(boost::asio::io_context& context, const std::string& host,
+                                                     uint16_t port = 502,
+                                                     size_t maxConnections = MODBUS_GATEWAY_DEFAULT_CONNECTIONS);
+
+                    /// @brief Get shared gateway of a host on the worker (created on first use)
+                    ///
+                    /// @param host Host name or address
+                    /// @param port Port
+                    /// @param maxConnections Maximum connections opened to the gateway (only used on creation)
+                    /// @return Gateway
+                    static Ref<ModbusGateway> Get(const std::string& host, uint16_t port = 502,
+                                                  size_t maxConnections = MODBUS_GATEWAY_DEFAULT_CONNECTIONS);
+
+                    inline const std::string& GetHost() const
+                    {
+                        return host;
+                    }
+                    inline uint16_t GetPort() const
+                    {
+                        return port;
+                    }
+
+                    /// @brief Get number of open (or opening) connections
+                    ///
+                    /// @return Connection count
+                    inline size_t GetConnectionCount() const
+                    {
+                        return clientList.size();
+                    }
+
+                    /// @brief Read holding registers (coalesced and cached)
+                    ///
+                    /// @param unit Unit id (slave id)
+                    /// @param address First register
+                    /// @param count Register count
+                    /// @param callback Callback
+                    /// @param maxAge Maximum age of cached registers in milliseconds (0 always reads)
+                    void ReadHoldingRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                              const ModbusRegistersCallback& callback,
+                                              size_t maxAge = MODBUS_GATEWAY_DEFAULT_MAX_AGE);
+
+                    /// @brief Read input registers (coalesced and cached)
+                    ///
+                    /// @param unit Unit id (slave id)
+                    /// @param address First register
+                    /// @param count Register count
+                    /// @param callback Callback
+                    /// @param maxAge Maximum age of cached registers in milliseconds (0 always reads)
+                    void ReadInputRegisters(uint8_t unit, uint16_t address, uint16_t count,
+                                            const ModbusRegistersCallback& callback,
+                                            size_t maxAge = MODBUS_GATEWAY_DEFAULT_MAX_AGE);
+
+                    void ReadCoils(uint8_t unit, uint16_t address, uint16_t count, const ModbusBitsCallback& callback);
+                    void ReadDiscreteInputs(uint8_t unit, uint16_t address, uint16_t count,
+                                            const ModbusBitsCallback& callback);
+
+                    void WriteSingleCoil(uint8_t unit, uint16_t address, bool value,
+                                         const ModbusWriteCallback& callback = {});
+                    void WriteMultipleCoils(uint8_t unit, uint16_t address, const bool* values, uint16_t count,
+                                            const ModbusWriteCallback& callback = {});
+                    void WriteSingleRegister(uint8_t unit, uint16_t address, uint16_t value,
+                                             const ModbusWriteCallback& callback = {});
+                    void WriteMultipleRegisters(uint8_t unit, uint16_t address, const uint16_t* values,
+                                                uint16_t count, const ModbusWriteCallback& callback = {});
+
+                    /// @brief Drop cached registers
+                    ///
+                    inline void ClearCache()
+                    {
+                        cacheMap.clear();
+                    }
+
+                    /// @brief Close every connection (sent requests fail with no connection)
+                    ///
+                    void Close();
+                };
+            }
+        }
+    }
+}
@@ -0,0 +1,14 @@
+target("server-scripting-native-modbus")
+    set_kind("static")
+    add_files("./**.cpp")
+    add_packages(
+        "spdlog", 
+        "boost", 
+        "rapidjson", 
+        "robin-hood-hashing", 
+        "xxhash"
+    )
+
+    add_deps(
+        "server-common"
+    )
@@ -68,6 +68,10 @@ namespace server
                 {
                     // Do nothing
                 }
+                virtual void Invalidate() final override
+                {
+                    // Do nothing
+                }
             };
         }
     }
@@ -54,6 +54,10 @@ namespace server
                 /// @brief Push state changes to clients
                 ///
                 virtual void PublishState() = 0;
+
+                /// @brief Invalidate serialized object (e.g. after the script attributes changed)
+                ///
+                virtual void Invalidate() = 0;
             };
         }
     }
@@ -16,12 +16,22 @@ namespace server
     }
     Core::~Core()
     {
+        if (backupTimer != nullptr)
+            backupTimer->cancel();
+        backupTimer = nullptr;
+
         home = nullptr;
         scriptManager = nullptr;
         userManager = nullptr;
         networkManager = nullptr;
+        subscriptionManager = nullptr;
         database = nullptr;
 
+        // Close idle connections while the worker context still exists
+        if (httpConnectionPool != nullptr)
+            httpConnectionPool->Clear();
+        httpConnectionPool = nullptr;
+
         if (worker != nullptr)
             worker->Stop();
 
@@ -30,6 +40,20 @@ namespace server
         LOG_INFO("Terminating core server");
     }
     Ref<Core> Core::Create()
+    {
+        if (!instanceCore.expired())
+            return Ref<Core>(instanceCore);
+
+        CoreConfig config;
+        if (!Load(config))
+        {
+            LOG_ERROR("Load configurations.");
+            return nullptr;
+        }
+
+        return Create(config);
+    }
+    Ref<Core> Core::Create(const CoreConfig& config)
     {
         if (!instanceCore.expired())
             return Ref<Core>(instanceCore);
@@ -41,13 +65,6 @@ namespace server
         {
             LOG_INFO("Initializing core server");
 
-            CoreConfig config;
-            if (!core->Load(config))
-            {
-                LOG_ERROR("Load configurations.");
-                return nullptr;
-            }
-
             // Initialize core
             core->name = config.name;
             LOG_INFO("This server is called '{0}'", core->name);
@@ -83,6 +100,14 @@ namespace server
                     return nullptr;
                 }
 
+                // Initialize subscription manager
+                core->subscriptionManager = api::SubscriptionManager::Create();
+                if (core->subscriptionManager == nullptr)
+                {
+                    LOG_ERROR("Initialize subscription manager.");
+                    return nullptr;
+                }
+
                 // Initialize networking
                 core->networkManager = api::NetworkManager::Create(config.networking.address, config.networking.port,
                                                                    config.networking.externalURL);
@@ -95,6 +120,14 @@ namespace server
 
             // Initialize scripting
             {
+                // Initialize http connection pool of the native scripts
+                core->httpConnectionPool = scripting::native::http::HttpConnectionPool::Create();
+                if (core->httpConnectionPool == nullptr)
+                {
+                    LOG_ERROR("Initialize http connection pool.");
+                    return nullptr;
+                }
+
                 // Initialize default script provider
                 boost::container::vector<Ref<scripting::ScriptProvider>> scriptProviderList = {
                     // NativeScript
@@ -130,6 +163,32 @@ namespace server
                 LOG_ERROR("Initialize home.");
                 return nullptr;
             }
+
+            // Initialize backup
+            {
+                core->backupInterval = config.database.backupInterval;
+                core->backupCount = config.database.backupCount;
+
+                if (core->backupInterval != 0)
+                {
+                    core->backupTimer = boost::make_shared<boost::asio::deadline_timer>(core->worker->GetContext());
+                    if (core->backupTimer == nullptr)
+                    {
+                        LOG_ERROR("Initialize backup timer.");
+                        return nullptr;
+                    }
+
+                    core->backupTimer->expires_from_now(boost::posix_time::hours(core->backupInterval));
+                    core->backupTimer->async_wait(
+                        boost::bind(&Core::WaitBackupTimer, WeakRef<Core>(core), boost::placeholders::_1));
+                }
+
+                // Register websocket backup api
+                robin_hood::unordered_node_map<std::string, api::WebSocketApiCallDefinition>& apiMap =
+                    api::WebSocketSession::GetApiMap();
+
+                apiMap["backup"] = Core::WebSocketProcessBackupMessage;
+            }
         }
 
         LOG_FLUSH();
@@ -241,6 +300,20 @@ namespace server
                         std::string(passwordIt->value.GetString(), passwordIt->value.GetStringLength());
                 else
                     databaseConfig.password = "";
+
+                // Load backup interval
+                rapidjson::Value::MemberIterator backupIntervalIt = databaseJson.FindMember("backup-interval");
+                if (backupIntervalIt != databaseJson.MemberEnd() && backupIntervalIt->value.IsUint())
+                    databaseConfig.backupInterval = backupIntervalIt->value.GetUint();
+                else
+                    databaseConfig.backupInterval = 0;
+
+                // Load backup count
+                rapidjson::Value::MemberIterator backupCountIt = databaseJson.FindMember("backup-count");
+                if (backupCountIt != databaseJson.MemberEnd() && backupCountIt->value.IsUint())
+                    databaseConfig.backupCount = backupCountIt->value.GetUint();
+                else
+                    databaseConfig.backupCount = 7;
             }
             else
             {
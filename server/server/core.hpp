@@ -1,11 +1,14 @@
 #pragma once
 #include "common.hpp"
 #include <api/network_manager.hpp>
+#include <api/subscription_manager.hpp>
 #include <api/user_manager.hpp>
+#include <api/websocket_session.hpp>
 #include <common/worker.hpp>
 #include <database/database.hpp>
 #include <main/home.hpp>
 #include <scripting/script_manager.hpp>
+#include <scripting_native_helper/http/http_connection_pool.hpp>
 
 namespace server
 {
@@ -19,6 +22,13 @@ namespace server
             std::string location;
             std::string username;
             std::string password;
+
+            /// @brief Hours between periodic backups (zero disables periodic backups)
+            /// @note Backups need free space of up to twice the database size while they run
+            uint32_t backupInterval = 0;
+
+            /// @brief Number of kept backups
+            size_t backupCount = 7;
         } database;
 
         struct NetworkingConfig
@@ -50,22 +60,47 @@ namespace server
         Ref<scripting::ScriptManager> scriptManager;
         Ref<main::Home> home;
         Ref<api::UserManager> userManager;
+        Ref<api::SubscriptionManager> subscriptionManager;
         Ref<api::NetworkManager> networkManager;
+        Ref<scripting::native::http::HttpConnectionPool> httpConnectionPool;
+
+        // Backup
+        Ref<boost::asio::deadline_timer> backupTimer;
+        uint32_t backupInterval = 0;
+        size_t backupCount = 0;
 
         /// @brief Load configurations from file
         ///
+        /// @param config Core config
         /// @return Successfulness
-        bool Load(CoreConfig& config);
+        static bool Load(CoreConfig& config);
+
+        static void WaitBackupTimer(const WeakRef<Core>& coreRef, const boost::system::error_code& ec);
+
+        /// @brief Remove old backups exceeding the backup count
+        ///
+        void PruneBackups();
+
+        // Websocket API
+        static void WebSocketProcessBackupMessage(const Ref<api::User>& user, const api::ApiRequestMessage& request,
+                                                  api::ApiResponseMessage& response,
+                                                  const Ref<api::WebSocketSession>& session);
 
       public:
         Core();
         virtual ~Core();
 
-        /// @brief Create core instance
+        /// @brief Create core instance from the configuration file
         ///
         /// @return Core singleton
         static Ref<Core> Create();
 
+        /// @brief Create core instance
+        ///
+        /// @param config Core config
+        /// @return Core singleton
+        static Ref<Core> Create(const CoreConfig& config);
+
         /// @brief Get core instance
         ///
         /// @return Core singleton
@@ -88,6 +123,12 @@ namespace server
             return name;
         }
 
+        /// @brief Start online database backup into the backup directory
+        ///
+        /// @param callback Progress callback (optional)
+        /// @return Backup file name or empty string if the backup could not be started
+        std::string Backup(const DatabaseBackupCallback& callback = {});
+
         /// @brief Run server
         ///
         void Run();
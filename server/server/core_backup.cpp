@@ -0,0 +1,159 @@
+#include "core.hpp"
+
+namespace server
+{
+    std::string Core::Backup(const DatabaseBackupCallback& callback)
+    {
+        // Generate file name
+        char name[64];
+        {
+            time_t now = time(nullptr);
+            struct tm utc;
+            gmtime_r(&now, &utc);
+            strftime(name, sizeof(name), "home-%Y%m%d-%H%M%S.sqlite3.gz", &utc);
+        }
+
+        std::string path = (config::GetBackupDirectory() / name).string();
+
+        if (!database->Backup(path,
+                              [coreRef = WeakRef<Core>(shared_from_this()), callback](DatabaseBackupStatus status,
+                                                                                      size_t progress, size_t total)
+                              {
+                                  if (status == DatabaseBackupStatus::kFinishedDatabaseBackupStatus)
+                                  {
+                                      Ref<Core> core = coreRef.lock();
+                                      if (core != nullptr)
+                                          core->PruneBackups();
+                                  }
+
+                                  if (callback)
+                                      callback(status, progress, total);
+                              }))
+            return "";
+
+        return name;
+    }
+
+    void Core::PruneBackups()
+    {
+        if (backupCount == 0)
+            return;
+
+        boost::system::error_code ec;
+
+        // Find backups (names contain the creation time, so they are sorted by age)
+        boost::container::vector<boost::filesystem::path> backupList;
+        for (boost::filesystem::directory_iterator it =
+                 boost::filesystem::directory_iterator(config::GetBackupDirectory(), ec);
+             !ec && it != boost::filesystem::directory_iterator(); it.increment(ec))
+        {
+            const boost::filesystem::path& path = it->path();
+            if (boost::starts_with(path.filename().string(), "home-") && path.extension() == ".gz")
+                backupList.push_back(path);
+        }
+
+        if (backupList.size() <= backupCount)
+            return;
+
+        std::sort(backupList.begin(), backupList.end());
+
+        // Remove oldest backups
+        for (size_t i = 0; i < backupList.size() - backupCount; i++)
+        {
+            LOG_INFO("Removing old backup '{0}'.", backupList[i].string());
+            boost::filesystem::remove(backupList[i], ec);
+        }
+    }
+
+    void Core::WaitBackupTimer(const WeakRef<Core>& coreRef, const boost::system::error_code& ec)
+    {
+        if (ec)
+            return;
+
+        Ref<Core> core = coreRef.lock();
+        if (core == nullptr)
+            return;
+
+        WorkerHandlerScope scope(WorkerHandlerKind::kTimerWorkerHandlerKind, "backup");
+
+        if (core->Backup().empty())
+            LOG_ERROR("Failed to start periodic backup.");
+
+        core->backupTimer->expires_from_now(boost::posix_time::hours(core->backupInterval));
+        core->backupTimer->async_wait(boost::bind(&Core::WaitBackupTimer, coreRef, boost::placeholders::_1));
+    }
+
+    void Core::WebSocketProcessBackupMessage(const Ref<api::User>& user, const api::ApiRequestMessage& request,
+                                             api::ApiResponseMessage& response,
+                                             const Ref<api::WebSocketSession>& session)
+    {
+        (void)request;
+
+        if (user->GetAccessLevel() < api::UserAccessLevel::kAdministratorUserAccessLevel)
+        {
+            response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_AccessLevelToLow);
+            return;
+        }
+
+        Ref<Core> core = Core::GetInstance();
+        assert(core != nullptr);
+
+        // Start backup and report progress to the session
+        Ref<std::string> file = boost::make_shared<std::string>();
+        *file = core->Backup(
+            [sessionRef = WeakRef<api::WebSocketSession>(session), file](DatabaseBackupStatus status, size_t progress,
+                                                                        size_t total)
+            {
+                Ref<api::WebSocketSession> session = sessionRef.lock();
+                if (session == nullptr)
+                    return;
+
+                Ref<rapidjson::StringBuffer> buffer = boost::make_shared<rapidjson::StringBuffer>();
+                if (buffer == nullptr)
+                    return;
+
+                // Build message
+                {
+                    rapidjson::Writer<rapidjson::StringBuffer> writer =
+                        rapidjson::Writer<rapidjson::StringBuffer>(*buffer);
+
+                    writer.StartObject();
+
+                    writer.Key("msgid", 5);
+                    writer.Uint64(0);
+
+                    writer.Key("msg", 3);
+                    writer.String("backup-progress", 15);
+
+                    writer.Key("file", 4);
+                    writer.String(file->data(), file->size(), true);
+
+                    std::string statusString = StringifyDatabaseBackupStatus(status);
+                    writer.Key("status", 6);
+                    writer.String(statusString.data(), statusString.size(), true);
+
+                    writer.Key("progress", 8);
+                    writer.Uint64(progress);
+
+                    writer.Key("total", 5);
+                    writer.Uint64(total);
+
+                    writer.EndObject(6);
+                }
+
+                session->Send(buffer);
+            });
+
+        if (file->empty())
+        {
+            response.SetErrorCode(api::ApiErrorCodes::kApiErrorCode_InternalError);
+            return;
+        }
+
+        // Build response
+        rapidjson::Document& output = response.GetJsonDocument();
+        rapidjson::Document::AllocatorType& allocator = response.GetJsonAllocator();
+
+        output.AddMember("file", rapidjson::Value(file->data(), file->size(), allocator), allocator);
+    }
+}
@@ -18,6 +18,7 @@ int main(int argc, char** argv)
         boost::filesystem::create_directories(config::GetRootDirectory());
         boost::filesystem::create_directories(config::GetDataDirectory());
         boost::filesystem::create_directories(config::GetScriptDirectory());
+        boost::filesystem::create_directories(config::GetBackupDirectory());
         boost::filesystem::create_directories(config::GetLogDirectory());
     }
     catch (std::exception e)
@@ -18,5 +18,6 @@ target("server")
         "server-scripting",
         "server-scripting-javascript",
         "server-scripting-native",
+        "server-scripting-native-http",
         "server-api"
     )
\ No newline at end of file
@@ -1,262 +1,190 @@
-#include "Testdatabase.hpp"
+#include "TestDatabase.hpp"
 #include "../helper/random/String-random.hpp"
 
-const boost::filesystem::path databaseFilepath = "test.sqlite3";
-Ref<server::Database> database = nullptr;
-
-robin_hood::unordered_map<identifier_t, ScriptSource> scriptSources;
-robin_hood::unordered_map<identifier_t, Room> rooms;
-robin_hood::unordered_map<identifier_t, Device> devices;
-robin_hood::unordered_map<identifier_t, User> users;
-
 #define TEST_SIZE (50)
 
-BOOST_AUTO_TEST_CASE(test_database_initialize)
+/// @brief Run database test suite against a backend
+///
+/// @param type Database type
+/// @param databaseFilepath Database file (sqlite database or memory database snapshot)
+void TestDatabase(server::DatabaseType type, const boost::filesystem::path& databaseFilepath)
 {
+    robin_hood::unordered_map<identifier_t, ScriptSource> scriptSources;
+    robin_hood::unordered_map<identifier_t, Entity> entities;
+    robin_hood::unordered_map<identifier_t, User> users;
+
     // Delete any old database
     boost::filesystem::remove(databaseFilepath);
+    boost::filesystem::remove(databaseFilepath.string() + "-wal");
+    boost::filesystem::remove(databaseFilepath.string() + "-shm");
 
     // Create new database
-    database = server::Database::Create(server::DatabaseType::kSQLiteDatabaseType, databaseFilepath.string());
-    BOOST_CHECK_MESSAGE(database != nullptr, "Create database.");
-}
+    Ref<server::Database> database = server::Database::Create(type, databaseFilepath.string());
+    BOOST_REQUIRE_MESSAGE(database != nullptr, "Create database.");
 
-BOOST_AUTO_TEST_CASE(test_database_reserve_object)
-{
-    for (size_t id = 1; id <= TEST_SIZE; id++)
+    // Reserve objects
     {
-        // Test script source
-        BOOST_CHECK_MESSAGE(database->ReserveScriptSource() == id, "Reserve script source.");
-        scriptSources[id] = ScriptSource{
-            "", // Type
-            "", // Name
-            "", // Usage
-            "", // Content
-        };
-
-        // Test room
-        BOOST_CHECK_MESSAGE(database->ReserveRoom() == id, "Reserve room.");
-        rooms[id] = Room{
-            "", // Type
-            "", // Name
-        };
+        for (size_t id = 1; id <= TEST_SIZE; id++)
+        {
+            // Test script source
+            BOOST_CHECK_MESSAGE(database->ReserveScriptSource("javascript") == id, "Reserve script source.");
+            scriptSources[id] = ScriptSource{
+                "javascript", // Language
+                "no name",    // Name
+                "",           // Config
+                "",           // Content
+            };
+
+            // Test entity
+            BOOST_CHECK_MESSAGE(database->ReserveEntity(id % 3 + 1) == id, "Reserve entity.");
+            entities[id] = Entity{
+                (uint8_t)(id % 3 + 1), // Type
+                "no name", // Name
+                0,         // Script source id
+                "",        // Attributes
+                "",        // State
+            };
+
+            // Test user
+            BOOST_CHECK_MESSAGE(database->ReserveUser("user") == id, "Reserve user.");
+        }
 
-        // Test device
-        BOOST_CHECK_MESSAGE(database->ReserveDevice() == id, "Reserve device.");
-        devices[id] = Device{
-            "",   // Type
-            0,    // Script Source ID
-            0,    // Controller ID
-            0,    // Room ID
-            "{}", // Data
-        };
+        CheckScriptSources(database, scriptSources);
+        CheckEntities(database, entities);
 
-        // Test user
-        BOOST_CHECK_MESSAGE(database->ReserveUser() == id, "Reserve user.");
-        users[id] = User{
-            "", // Name
-            {}, // Hash
-            {}, // Salt
-            "", // Access Level
-        };
+        // Users without hash are not loaded
+        CheckUsers(database, robin_hood::unordered_map<identifier_t, User>());
     }
 
-    CheckScriptSources(database, robin_hood::unordered_map<identifier_t, ScriptSource>());
-    CheckRooms(database, robin_hood::unordered_map<identifier_t, Room>());
-    CheckDevices(database, robin_hood::unordered_map<identifier_t, Device>());
-    CheckUsers(database, robin_hood::unordered_map<identifier_t, User>());
-}
-
-BOOST_AUTO_TEST_CASE(test_database_update_object)
-{
-    size_t seed = time(nullptr);
-
-    for (size_t id = 1; id <= TEST_SIZE; id++)
+    // Update objects
     {
-        // Test script source
-        {
-            ScriptSource& scriptSource = scriptSources.at(id);
-            scriptSource.type = GenerateReadableRandomString(id % 20, seed + id + 11);
-            scriptSource.name = GenerateReadableRandomString(id % 20, seed + id + 12);
-            scriptSource.usage = GenerateReadableRandomString(id % 20, seed + id + 13);
-            scriptSource.content = GenerateReadableRandomString(2000, seed + id + 14);
-
-            BOOST_CHECK_MESSAGE(database->UpdateScriptSource(id, scriptSource.type, scriptSource.name,
-                                                             scriptSource.usage, scriptSource.content) == true,
-                                "Update script source.");
-        }
+        uint32_t seed = time(nullptr);
 
-        // Test room
+        for (size_t id = 1; id <= TEST_SIZE; id++)
         {
-            Room& room = rooms.at(id);
-            room.type = GenerateReadableRandomString(id % 20, seed + id + 21);
-            room.name = GenerateReadableRandomString(id % 20, seed + id + 22);
-
-            BOOST_CHECK_MESSAGE(database->UpdateRoom(id, room.type, room.name) == true, "Update room.");
+            // Test script source
+            {
+                ScriptSource& scriptSource = scriptSources.at(id);
+                scriptSource.name = GenerateReadableRandomString(id % 20, seed + id + 12);
+                scriptSource.config = "{}";
+                scriptSource.content = GenerateReadableRandomString(2000, seed + id + 14);
+
+                BOOST_CHECK_MESSAGE(database->UpdateScriptSource(id, scriptSource.name, scriptSource.config) == true,
+                                    "Update script source.");
+                BOOST_CHECK_MESSAGE(database->UpdateScriptSourceContent(id, scriptSource.content) == true,
+                                    "Update script source content.");
+            }
+
+            // Test entity
+            {
+                Entity& entity = entities.at(id);
+                entity.name = GenerateReadableRandomString(id % 20, seed + id + 31);
+                entity.scriptSourceID = id;
+                entity.attributes = "{\"room\":" + std::to_string(id) + "}";
+                entity.state = GenerateRandomString(id % 64, seed + id + 34);
+
+                BOOST_CHECK_MESSAGE(database->UpdateEntity(id, entity.name, entity.scriptSourceID,
+                                                           entity.attributes) == true,
+                                    "Update entity.");
+                BOOST_CHECK_MESSAGE(database->UpdateEntityState(id, entity.state) == true, "Update entity state.");
+            }
+
+            // Test user
+            {
+                User& user = users[id];
+                user.name = "user";
+                memcpy(user.hash, GenerateRandomString(SHA256_SIZE, seed + id + 42).data(), SHA256_SIZE);
+                memcpy(user.salt, GenerateRandomString(SALT_SIZE, seed + id + 43).data(), SALT_SIZE);
+                user.accessLevel = id % 2 ? "normal" : "admin";
+
+                BOOST_CHECK_MESSAGE(database->UpdateUserHash(id, user.hash, user.salt) == true, "Update user hash.");
+                BOOST_CHECK_MESSAGE(database->UpdateUserAccessLevel(id, user.accessLevel) == true,
+                                    "Update user access level.");
+            }
         }
 
-        // Test device
-        {
-            Device& device = devices.at(id);
-            device.name = GenerateReadableRandomString(id % 20, seed + id + 31);
-            device.scriptSourceID = seed + id + 32;
-            device.controllerID = seed + id + 33;
-            device.roomID = seed + id + 34;
-
-            BOOST_CHECK_MESSAGE(database->UpdateDevice(id, device.name, device.scriptSourceID, device.controllerID,
-                                                       device.roomID) == true,
-                                "Update device.");
-        }
-
-        // Test user
-        {
-            User& user = users.at(id);
-            user.name = GenerateReadableRandomString(id % 20, seed + id + 41);
-            memcpy(user.hash, GenerateReadableRandomString(SHA256_SIZE, seed + id + 42).data(), SHA256_SIZE);
-            memcpy(user.salt, GenerateReadableRandomString(SALT_SIZE, seed + id + 43).data(), SALT_SIZE);
-            user.accessLevel = GenerateReadableRandomString(2000, seed + id + 44);
-
-            BOOST_CHECK_MESSAGE(database->UpdateUser(id, user.name, user.hash, user.salt, user.accessLevel) == true,
-                                "Update user.");
-        }
+        CheckScriptSources(database, scriptSources);
+        CheckEntities(database, entities);
+        CheckUsers(database, users);
     }
 
-    CheckScriptSources(database, scriptSources);
-    CheckRooms(database, rooms);
-    CheckDevices(database, devices);
-    CheckUsers(database, users);
-}
-
-BOOST_AUTO_TEST_CASE(test_database_reopen)
-{
-    // Close database
-    database = nullptr;
-
-    // Open database
-    database = server::Database::Create(server::DatabaseType::kSQLiteDatabaseType, databaseFilepath.string());
-    BOOST_CHECK_MESSAGE(database != nullptr, "Open database.");
-
-    CheckScriptSources(database, scriptSources);
-    CheckRooms(database, rooms);
-    CheckDevices(database, devices);
-    CheckUsers(database, users);
-}
-
-BOOST_AUTO_TEST_CASE(test_database_update_object_property)
-{
-    size_t seed = time(nullptr);
-
-    for (size_t id = 1; id <= TEST_SIZE; id++)
+    // Update objects asynchronously
     {
-        // Test script source
+        for (size_t id = 1; id <= TEST_SIZE; id++)
         {
-            ScriptSource& scriptSource = scriptSources.at(id);
+            Entity& entity = entities.at(id);
+            entity.state = std::to_string(id);
 
-            std::string oldName = scriptSource.name;
-            scriptSource.name = GenerateReadableRandomString((seed * id) % 20, seed + id + 12);
-
-            scriptSource.content = GenerateReadableRandomString(2000, seed + id + 14);
-
-            BOOST_CHECK_MESSAGE(database->UpdateScriptSourcePropName(id, oldName, scriptSource.name) == true,
-                                "Update script source name.");
-
-            BOOST_CHECK_MESSAGE(database->UpdateScriptSourcePropContent(id, scriptSource.content) == true,
-                                "Update script source content.");
+            database->UpdateEntityStateAsync(id, entity.state);
         }
+    }
 
-        // Test room
-        {
-            Room& room = rooms.at(id);
-
-            std::string oldType = room.type;
-            room.type = GenerateReadableRandomString((seed * id) % 20, seed + id + 21);
+    // Reopen database (pending writes are executed before closing)
+    {
+        database = nullptr;
 
-            std::string oldName = room.name;
-            room.name = GenerateReadableRandomString((seed * id) % 20, seed + id + 22);
+        database = server::Database::Create(type, databaseFilepath.string());
+        BOOST_REQUIRE_MESSAGE(database != nullptr, "Open database.");
 
-            BOOST_CHECK_MESSAGE(database->UpdateRoomPropType(id, oldType, room.type) == true, "Update room type.");
+        CheckScriptSources(database, scriptSources);
+        CheckEntities(database, entities);
+        CheckUsers(database, users);
+    }
 
-            BOOST_CHECK_MESSAGE(database->UpdateRoomPropName(id, oldName, room.name) == true, "Update room name.");
-        }
+    // History
+    {
+        BOOST_CHECK_MESSAGE(database->AddHistoryBlock(1, "value", 0, 100, 200, 2, "b") == true, "Add history block.");
+        BOOST_CHECK_MESSAGE(database->AddHistoryBlock(1, "value", 0, 0, 99, 2, "a") == true, "Add history block.");
+        BOOST_CHECK_MESSAGE(database->AddHistoryBlock(1, "value", 1, 0, 200, 2, "c") == true, "Add history block.");
+
+        std::string blocks;
+        database->LoadHistoryBlocks(1, "value", 0, 50, 150,
+                                    [&](int64_t begin, int64_t end, size_t count, const std::string_view& data) -> void
+                                    {
+                                        (void)begin;
+                                        (void)end;
+                                        (void)count;
+                                        blocks.append(data);
+                                    });
+        BOOST_CHECK_MESSAGE(blocks == "ab", "Load history blocks.");
+
+        BOOST_CHECK_MESSAGE(database->RemoveHistory(1) == true, "Remove history.");
+
+        blocks.clear();
+        database->LoadHistoryBlocks(1, "value", 0, 0, 200,
+                                    [&](int64_t begin, int64_t end, size_t count, const std::string_view& data) -> void
+                                    {
+                                        (void)begin;
+                                        (void)end;
+                                        (void)count;
+                                        blocks.append(data);
+                                    });
+        BOOST_CHECK_MESSAGE(blocks.empty(), "Remove history blocks.");
+    }
 
-        // Test device
+    // Remove objects
+    {
+        for (size_t id = 1; id <= TEST_SIZE; id++)
         {
-            Device& device = devices.at(id);
-
-            std::string oldName = device.name;
-            device.name = GenerateReadableRandomString((seed * id) % 20, seed + id + 31);
-
-            device.scriptSourceID = seed + id + 32;
-
-            identifier_t oldControllerID = device.controllerID;
-            device.controllerID = seed + id + 33;
-
-            identifier_t oldRoomID = device.roomID;
-            device.roomID = seed + id + 34;
-
-            BOOST_CHECK_MESSAGE(database->UpdateDevicePropName(id, oldName, device.name) == true,
-                                "Update device name.");
-
-            BOOST_CHECK_MESSAGE(database->UpdateDevicePropScriptSource(id, device.scriptSourceID) == true,
-                                "Update device script source id.");
-
-            BOOST_CHECK_MESSAGE(database->UpdateDevicePropController(id, oldControllerID, device.controllerID) == true,
-                                "Update device controller id.");
-
-            BOOST_CHECK_MESSAGE(database->UpdateDevicePropRoom(id, oldRoomID, device.roomID) == true,
-                                "Update device room id.");
+            BOOST_CHECK_MESSAGE(database->RemoveScriptSource(id) == true, "Remove script source.");
+            BOOST_CHECK_MESSAGE(database->RemoveEntity(id) == true, "Remove entity.");
+            BOOST_CHECK_MESSAGE(database->RemoveUser(id) == true, "Remove user.");
         }
 
-        // Test user
-        {
-            User& user = users.at(id);
-
-            user.name = GenerateReadableRandomString((seed * id) % 20, seed + id + 41);
-
-            memcpy(user.hash, GenerateReadableRandomString(SHA256_SIZE, seed + id + 42).data(), SHA256_SIZE);
-
-            memcpy(user.salt, GenerateReadableRandomString(SALT_SIZE, seed + id + 43).data(), SALT_SIZE);
-
-            user.accessLevel = GenerateReadableRandomString((seed * id) % 20, seed + id + 44);
-
-            BOOST_CHECK_MESSAGE(database->UpdateUserPropName(id, user.name) == true, "Update user name.");
-
-            BOOST_CHECK_MESSAGE(database->UpdateUserPropHash(id, user.hash) == true, "Update user hash.");
-
-            BOOST_CHECK_MESSAGE(database->UpdateUserPropSalt(id, user.salt) == true, "Update user salt.");
-
-            BOOST_CHECK_MESSAGE(database->UpdateUserPropAccessLevel(id, user.accessLevel) == true,
-                                "Update user access level.");
-        }
+        CheckScriptSources(database, robin_hood::unordered_map<identifier_t, ScriptSource>());
+        CheckEntities(database, robin_hood::unordered_map<identifier_t, Entity>());
+        CheckUsers(database, robin_hood::unordered_map<identifier_t, User>());
     }
 
-    CheckScriptSources(database, scriptSources);
-    CheckRooms(database, rooms);
-    CheckDevices(database, devices);
-    CheckUsers(database, users);
+    database = nullptr;
 }
 
-BOOST_AUTO_TEST_CASE(test_database_remove_object)
+BOOST_AUTO_TEST_CASE(test_sqlite_database)
 {
-    size_t seed = time(nullptr);
-
-    for (size_t id = 1; id <= TEST_SIZE; id++)
-    {
-        // Test script source
-        BOOST_CHECK_MESSAGE(database->RemoveScriptSource(id) == true, "Remove script source.");
-
-        // Test room
-        BOOST_CHECK_MESSAGE(database->RemoveRoom(id) == true, "Remove room.");
-
-        // Test device
-        BOOST_CHECK_MESSAGE(database->RemoveDevice(id) == true, "Remove device.");
-
-        // Test user
-        BOOST_CHECK_MESSAGE(database->RemoveUser(id) == true, "Remove user.");
-    }
+    TestDatabase(server::DatabaseType::kSQLiteDatabaseType, boost::filesystem::absolute("test.sqlite3"));
+}
 
-    CheckScriptSources(database, robin_hood::unordered_map<identifier_t, ScriptSource>());
-    CheckRooms(database, robin_hood::unordered_map<identifier_t, Room>());
-    CheckDevices(database, robin_hood::unordered_map<identifier_t, Device>());
-    CheckUsers(database, robin_hood::unordered_map<identifier_t, User>());
-}
\ No newline at end of file
+BOOST_AUTO_TEST_CASE(test_memory_database)
+{
+    TestDatabase(server::DatabaseType::kMemoryDatabaseType, boost::filesystem::absolute("test.memory"));
+}
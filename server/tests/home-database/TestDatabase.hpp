@@ -4,9 +4,9 @@
 
 struct ScriptSource
 {
-    std::string type;
+    std::string language;
     std::string name;
-    std::string usage;
+    std::string config;
     std::string content;
 };
 
@@ -16,7 +16,7 @@ void CheckScriptSources(Ref<server::Database> database,
     size_t count = 0;
 
     database->LoadScriptSources(
-        [&](identifier_t id, const std::string& type, const std::string& name, const std::string& usage,
+        [&](identifier_t id, const std::string& language, const std::string& name, const std::string_view& config,
             const std::string_view& content) -> void
         {
             robin_hood::unordered_map<identifier_t, ScriptSource>::const_iterator it = scriptSources.find(id);
@@ -24,9 +24,9 @@ void CheckScriptSources(Ref<server::Database> database,
             {
                 const ScriptSource& scriptSource = it->second;
 
-                BOOST_CHECK_MESSAGE(scriptSource.type == type, "Script source type does not match.");
+                BOOST_CHECK_MESSAGE(scriptSource.language == language, "Script source language does not match.");
                 BOOST_CHECK_MESSAGE(scriptSource.name == name, "Script source name does not match.");
-                BOOST_CHECK_MESSAGE(scriptSource.usage == usage, "Script source usage does not match.");
+                BOOST_CHECK_MESSAGE(scriptSource.config == config, "Script source config does not match.");
                 BOOST_CHECK_MESSAGE(scriptSource.content == content, "Script source content does not match.");
             }
             else
@@ -39,74 +39,40 @@ void CheckScriptSources(Ref<server::Database> database,
 
     BOOST_CHECK_MESSAGE(count >= scriptSources.size(), "Too few script sources.");
     BOOST_CHECK_MESSAGE(count <= scriptSources.size(), "Too many script sources.");
+    BOOST_CHECK_MESSAGE(database->GetScriptSourceCount() == scriptSources.size(), "Script source count.");
 }
 
-struct Room
-{
-    std::string type;
-    std::string name;
-};
-
-void CheckRooms(Ref<server::Database> database, robin_hood::unordered_map<identifier_t, Room> rooms)
-{
-    size_t count = 0;
-
-    database->LoadRooms(
-        [&](identifier_t id, const std::string& type, const std::string& name) -> bool
-        {
-            robin_hood::unordered_map<identifier_t, Room>::const_iterator it = rooms.find(id);
-            if (it != rooms.end())
-            {
-                const Room& room = it->second;
-
-                BOOST_CHECK_MESSAGE(room.type == type, "Room type does not match.");
-                BOOST_CHECK_MESSAGE(room.name == name, "Room name does not match.");
-            }
-            else
-            {
-                BOOST_WARN_MESSAGE(it != rooms.end(), "Room does not exist.");
-            }
-
-            count++;
-
-            return true;
-        });
-
-    BOOST_CHECK_MESSAGE(count >= rooms.size(), "Too few rooms.");
-    BOOST_CHECK_MESSAGE(count <= rooms.size(), "Too many rooms.");
-}
-
-struct Device
+struct Entity
 {
+    uint8_t type;
     std::string name;
     identifier_t scriptSourceID;
-    identifier_t controllerID;
-    identifier_t roomID;
-    std::string data;
+    std::string attributes;
+    std::string state;
 };
 
-void CheckDevices(Ref<server::Database> database, robin_hood::unordered_map<identifier_t, Device> devices)
+void CheckEntities(Ref<server::Database> database, robin_hood::unordered_map<identifier_t, Entity> entities)
 {
     size_t count = 0;
 
-    database->LoadDevices(
-        [&](identifier_t id, const std::string& name, identifier_t scriptSourceID, identifier_t controllerID,
-            identifier_t roomID, const std::string_view& data) -> bool
+    database->LoadEntities(
+        [&](identifier_t id, uint8_t type, const std::string_view& name, identifier_t scriptSourceID,
+            const std::string_view& attributes, const std::string_view& state) -> bool
         {
-            robin_hood::unordered_map<identifier_t, Device>::const_iterator it = devices.find(id);
-            if (it != devices.end())
+            robin_hood::unordered_map<identifier_t, Entity>::const_iterator it = entities.find(id);
+            if (it != entities.end())
             {
-                const Device& device = it->second;
+                const Entity& entity = it->second;
 
-                BOOST_CHECK_MESSAGE(device.name == name, "Device name does not match.");
-                BOOST_CHECK_MESSAGE(device.scriptSourceID == scriptSourceID, "Device script source id does not match.");
-                BOOST_CHECK_MESSAGE(device.controllerID == controllerID, "Device controller id does not match.");
-                BOOST_CHECK_MESSAGE(device.roomID == roomID, "Device room id does not match.");
-                BOOST_CHECK_MESSAGE(device.data == data, "Device data does not match.");
+                BOOST_CHECK_MESSAGE(entity.type == type, "Entity type does not match.");
+                BOOST_CHECK_MESSAGE(entity.name == name, "Entity name does not match.");
+                BOOST_CHECK_MESSAGE(entity.scriptSourceID == scriptSourceID, "Entity script source id does not match.");
+                BOOST_CHECK_MESSAGE(entity.attributes == attributes, "Entity attributes do not match.");
+                BOOST_CHECK_MESSAGE(entity.state == state, "Entity state does not match.");
             }
             else
             {
-                BOOST_WARN_MESSAGE(it != devices.end(), "Device does not exist.");
+                BOOST_WARN_MESSAGE(it != entities.end(), "Entity does not exist.");
             }
 
             count++;
@@ -114,8 +80,9 @@ void CheckDevices(Ref<server::Database> database, robin_hood::unordered_map<iden
             return true;
         });
 
-    BOOST_CHECK_MESSAGE(count >= devices.size(), "Too few devices.");
-    BOOST_CHECK_MESSAGE(count <= devices.size(), "Too many devices.");
+    BOOST_CHECK_MESSAGE(count >= entities.size(), "Too few entities.");
+    BOOST_CHECK_MESSAGE(count <= entities.size(), "Too many entities.");
+    BOOST_CHECK_MESSAGE(database->GetEntityCount() == entities.size(), "Entity count.");
 }
 
 struct User
@@ -132,7 +99,7 @@ void CheckUsers(Ref<server::Database> database, robin_hood::unordered_map<identi
 
     database->LoadUsers(
         [&](identifier_t id, const std::string& name, uint8_t hash[SHA256_SIZE], uint8_t salt[SALT_SIZE],
-            const std::string& accessLevel) -> bool
+            const std::string& accessLevel) -> void
         {
             robin_hood::unordered_map<identifier_t, User>::const_iterator it = users.find(id);
             if (it != users.end())
@@ -150,10 +117,8 @@ void CheckUsers(Ref<server::Database> database, robin_hood::unordered_map<identi
             }
 
             count++;
-
-            return true;
         });
 
     BOOST_CHECK_MESSAGE(count >= users.size(), "Too few users.");
     BOOST_CHECK_MESSAGE(count <= users.size(), "Too many users.");
-}
\ No newline at end of file
+}
@@ -0,0 +1,345 @@
+#include "TestHttpClient.hpp"
+#include <scripting_native_helper/http/http_client.hpp>
+
+using namespace server::scripting::native::http;
+
+/// @brief Local echo server (one thread per connection)
+///
+/// Echoes method, target and body (head requests only get the header). /chunked answers with a chunked body, /slow
+/// answers after 500ms, /close closes the connection after the response and /drop closes it without telling the
+/// client.
+class EchoServer
+{
+  private:
+    boost::asio::io_context context;
+    boost::asio::ip::tcp::acceptor acceptor;
+    boost::thread thread;
+
+    /// @brief Connections and their threads (only changed by the accept thread)
+    ///
+    boost::container::vector<Ref<boost::asio::ip::tcp::socket>> socketList;
+    boost::thread_group connectionThreads;
+
+    static void Serve(const Ref<boost::asio::ip::tcp::socket>& stream)
+    {
+        Respond(*stream);
+
+        // Close the connection (the socket itself is closed by the server)
+        boost::system::error_code ec;
+        stream->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+    }
+    static void Respond(boost::asio::ip::tcp::socket& socket)
+    {
+        boost::beast::flat_buffer buffer;
+        boost::system::error_code ec;
+        while (true)
+        {
+            boost::beast::http::request<boost::beast::http::string_body> request;
+            boost::beast::http::read(socket, buffer, request, ec);
+            if (ec)
+                return;
+
+            std::string target = std::string(request.target());
+            if (target == "/slow")
+                boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+
+            if (target == "/chunked")
+            {
+                boost::beast::http::response<boost::beast::http::empty_body> response =
+                    boost::beast::http::response<boost::beast::http::empty_body>(boost::beast::http::status::ok, 11);
+                response.chunked(true);
+                response.keep_alive(true);
+
+                boost::beast::http::response_serializer<boost::beast::http::empty_body> serializer =
+                    boost::beast::http::response_serializer<boost::beast::http::empty_body>(response);
+                boost::beast::http::write_header(socket, serializer, ec);
+                for (size_t i = 0; i < 64 && !ec; i++)
+                {
+                    std::string part = std::string(1000, (char)('a' + i % 26));
+                    boost::asio::write(socket, boost::beast::http::make_chunk(boost::asio::buffer(part)), ec);
+                }
+                boost::asio::write(socket, boost::beast::http::make_chunk_last(), ec);
+                if (ec)
+                    return;
+                continue;
+            }
+
+            boost::beast::http::response<boost::beast::http::string_body> response =
+                boost::beast::http::response<boost::beast::http::string_body>(boost::beast::http::status::ok, 11);
+            response.body() = std::string(request.method_string()) + " " + target + " " + request.body();
+            response.keep_alive(target != "/close" && request.keep_alive());
+            response.prepare_payload();
+            if (request.method() == boost::beast::http::verb::head)
+            {
+                // Keep the content length of the body that is not sent
+                boost::beast::http::response_serializer<boost::beast::http::string_body> serializer =
+                    boost::beast::http::response_serializer<boost::beast::http::string_body>(response);
+                boost::beast::http::write_header(socket, serializer, ec);
+            }
+            else
+                boost::beast::http::write(socket, response, ec);
+            if (ec || !response.keep_alive() || target == "/drop")
+                return;
+        }
+    }
+
+    void Accept()
+    {
+        acceptor.async_accept(
+            [this](const boost::system::error_code& ec, boost::asio::ip::tcp::socket socket) -> void
+            {
+                if (ec)
+                    return;
+
+                connectionCount++;
+                Ref<boost::asio::ip::tcp::socket> stream =
+                    boost::make_shared<boost::asio::ip::tcp::socket>(std::move(socket));
+                socketList.push_back(stream);
+                connectionThreads.create_thread(boost::bind(&EchoServer::Serve, stream));
+                Accept();
+            });
+    }
+
+  public:
+    boost::atomic_size_t connectionCount = 0;
+
+    EchoServer() : acceptor(context, boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0))
+    {
+        Accept();
+        thread = boost::thread([this]() -> void { context.run(); });
+    }
+    ~EchoServer()
+    {
+        context.stop();
+        thread.join();
+
+        // Wake up blocked connection threads, the sockets must not outlive the context
+        for (const Ref<boost::asio::ip::tcp::socket>& socket : socketList)
+        {
+            boost::system::error_code ec;
+            socket->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+        }
+        connectionThreads.join_all();
+    }
+
+    uint16_t GetPort() const
+    {
+        return acceptor.local_endpoint().port();
+    }
+};
+
+/// @brief Native script stand-in receiving the responses
+///
+class TestCaller
+{
+  public:
+    size_t responseCount = 0;
+    HttpError error = HttpError::kNoHttpError;
+    std::string body;
+    std::string streamedBody;
+    size_t partCount = 0;
+
+    void OnResponse(HttpError error, const HttpResponse& response)
+    {
+        responseCount++;
+        this->error = error;
+        body = response.body();
+    }
+    void OnBody(const char* data, size_t size)
+    {
+        partCount++;
+        streamedBody.append(data, size);
+    }
+
+    /// @brief Run the context until the next response (idle connections keep the context busy)
+    ///
+    /// @param context IO context
+    void Wait(boost::asio::io_context& context)
+    {
+        size_t count = responseCount;
+        while (responseCount == count && context.run_one() != 0)
+        {
+        }
+
+        if (context.stopped())
+            context.restart();
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_http_client_keep_alive)
+{
+    LOG_INFO("Test http client keep-alive");
+
+    EchoServer server;
+    boost::asio::io_context context;
+    Ref<HttpConnectionPool> pool = HttpConnectionPool::Create(context);
+    Ref<TestCaller> caller = boost::make_shared<TestCaller>();
+    HttpClient<TestCaller> client = HttpClient<TestCaller>(pool, caller, "127.0.0.1", server.GetPort());
+
+    // Get
+    client.Get("/first", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->responseCount == 1, "Receive response");
+    BOOST_CHECK_MESSAGE(caller->error == HttpError::kNoHttpError, "Get failed");
+    BOOST_CHECK_MESSAGE(caller->body == "GET /first ", "Invalid get response");
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 1, "Keep connection");
+
+    // Post on the same connection
+    client.Post("/second", "payload", "text/plain", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->body == "POST /second payload", "Invalid post response");
+    BOOST_CHECK_MESSAGE(server.connectionCount == 1, "Reuse connection");
+
+    // Connection closed by the server
+    client.Get("/close", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->error == HttpError::kNoHttpError, "Get failed");
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 0, "Drop closed connection");
+}
+
+BOOST_AUTO_TEST_CASE(test_http_client_head)
+{
+    LOG_INFO("Test http client head");
+
+    EchoServer server;
+    boost::asio::io_context context;
+    Ref<HttpConnectionPool> pool = HttpConnectionPool::Create(context);
+    Ref<TestCaller> caller = boost::make_shared<TestCaller>();
+    HttpClient<TestCaller> client = HttpClient<TestCaller>(pool, caller, "127.0.0.1", server.GetPort(), 1000);
+
+    // The response has a content length but no body
+    client.Send(HttpRequest(boost::beast::http::verb::head, "/head", 11), &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->responseCount == 1, "Receive response");
+    BOOST_CHECK_MESSAGE(caller->error == HttpError::kNoHttpError, "Head failed");
+    BOOST_CHECK_MESSAGE(caller->body.empty(), "Head response has a body");
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 1, "Keep connection");
+
+    // Get on the same connection
+    client.Get("/next", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->body == "GET /next ", "Invalid get response");
+    BOOST_CHECK_MESSAGE(server.connectionCount == 1, "Reuse connection");
+}
+
+BOOST_AUTO_TEST_CASE(test_http_client_stale_connection)
+{
+    LOG_INFO("Test http client stale connection");
+
+    EchoServer server;
+    boost::asio::io_context context;
+    Ref<HttpConnectionPool> pool = HttpConnectionPool::Create(context);
+    Ref<TestCaller> caller = boost::make_shared<TestCaller>();
+    HttpClient<TestCaller> client = HttpClient<TestCaller>(pool, caller, "127.0.0.1", server.GetPort());
+
+    // The server closes the connection without telling the client
+    client.Get("/drop", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 1, "Keep connection");
+
+    // The request is sent again on a new connection
+    client.Get("/again", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->responseCount == 2, "Receive response");
+    BOOST_CHECK_MESSAGE(caller->error == HttpError::kNoHttpError, "Retry on a new connection");
+    BOOST_CHECK_MESSAGE(caller->body == "GET /again ", "Invalid get response");
+    BOOST_CHECK_MESSAGE(server.connectionCount == 2, "Open new connection");
+
+    // A post is not sent again, the server may have processed it
+    client.Get("/drop", &TestCaller::OnResponse);
+    caller->Wait(context);
+    client.Post("/again", "payload", "text/plain", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->responseCount == 4, "Receive response");
+    BOOST_CHECK_MESSAGE(caller->error != HttpError::kNoHttpError, "Retry post on a new connection");
+    BOOST_CHECK_MESSAGE(server.connectionCount == 2, "Open new connection for a post");
+}
+
+BOOST_AUTO_TEST_CASE(test_http_client_chunked)
+{
+    LOG_INFO("Test http client chunked body");
+
+    EchoServer server;
+    boost::asio::io_context context;
+    Ref<HttpConnectionPool> pool = HttpConnectionPool::Create(context);
+    Ref<TestCaller> caller = boost::make_shared<TestCaller>();
+    HttpClient<TestCaller> client = HttpClient<TestCaller>(pool, caller, "127.0.0.1", server.GetPort());
+
+    // Buffered
+    client.Get("/chunked", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->error == HttpError::kNoHttpError, "Get failed");
+    BOOST_CHECK_MESSAGE(caller->body.size() == 64000, "Invalid buffered body");
+
+    // Streamed
+    client.Get("/chunked", &TestCaller::OnResponse, &TestCaller::OnBody);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->body.empty(), "Streamed body is buffered");
+    BOOST_CHECK_MESSAGE(caller->streamedBody.size() == 64000, "Invalid streamed body");
+    BOOST_CHECK_MESSAGE(caller->streamedBody.substr(1000, 3) == "bbb", "Invalid streamed body");
+    BOOST_CHECK_MESSAGE(caller->partCount > 1, "Body is not streamed");
+    BOOST_CHECK_MESSAGE(server.connectionCount == 1, "Reuse connection");
+}
+
+BOOST_AUTO_TEST_CASE(test_http_client_timeout)
+{
+    LOG_INFO("Test http client timeout");
+
+    EchoServer server;
+    boost::asio::io_context context;
+    Ref<HttpConnectionPool> pool = HttpConnectionPool::Create(context);
+    Ref<TestCaller> caller = boost::make_shared<TestCaller>();
+    HttpClient<TestCaller> client = HttpClient<TestCaller>(pool, caller, "127.0.0.1", server.GetPort(), 100);
+
+    client.Get("/slow", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(caller->error == HttpError::kTimeoutHttpError, "Request did not time out");
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 0, "Keep timed out connection");
+}
+
+BOOST_AUTO_TEST_CASE(test_http_client_idle_connection)
+{
+    LOG_INFO("Test http client idle connection");
+
+    EchoServer server;
+    boost::asio::io_context context;
+    Ref<HttpConnectionPool> pool = HttpConnectionPool::Create(context, HTTP_CLIENT_MAX_IDLE_CONNECTIONS, 100);
+    Ref<TestCaller> caller = boost::make_shared<TestCaller>();
+    HttpClient<TestCaller> client = HttpClient<TestCaller>(pool, caller, "127.0.0.1", server.GetPort());
+
+    // The server closes the connection while it is idle
+    client.Get("/drop", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 1, "Keep connection");
+    context.run_for(std::chrono::milliseconds(50));
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 0, "Keep connection closed by the server");
+    context.restart();
+
+    // The idle timeout expires (nothing keeps the context busy afterwards)
+    client.Get("/", &TestCaller::OnResponse);
+    caller->Wait(context);
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 1, "Keep connection");
+    context.run_for(std::chrono::seconds(5));
+    BOOST_CHECK_MESSAGE(pool->GetIdleCount() == 0, "Keep expired connection");
+    BOOST_CHECK_MESSAGE(context.stopped(), "Idle connection keeps the context busy");
+}
+
+BOOST_AUTO_TEST_CASE(test_http_client_destroyed_caller)
+{
+    LOG_INFO("Test http client destroyed caller");
+
+    EchoServer server;
+    boost::asio::io_context context;
+    Ref<HttpConnectionPool> pool = HttpConnectionPool::Create(context);
+    Ref<TestCaller> caller = boost::make_shared<TestCaller>();
+    WeakRef<TestCaller> callerRef = caller;
+    HttpClient<TestCaller> client = HttpClient<TestCaller>(pool, caller, "127.0.0.1", server.GetPort());
+
+    // The response must not reach the destroyed caller
+    client.Get("/", &TestCaller::OnResponse);
+    caller = nullptr;
+    while (pool->GetIdleCount() == 0 && context.run_one() != 0)
+    {
+    }
+    BOOST_CHECK_MESSAGE(callerRef.expired(), "Caller kept alive by the request");
+}
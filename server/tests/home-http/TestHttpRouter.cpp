@@ -0,0 +1,67 @@
+#include "TestHttpRouter.hpp"
+#include <api/http_router.hpp>
+
+using namespace server::api;
+
+static void FirstHandler(const Ref<User>& user, const http_request_t& request, http_response_t& response,
+                         const Ref<HttpSession>& session)
+{
+    (void)user;
+    (void)request;
+    (void)response;
+    (void)session;
+}
+static void SecondHandler(const Ref<User>& user, const http_request_t& request, http_response_t& response,
+                          const Ref<HttpSession>& session)
+{
+    (void)user;
+    (void)request;
+    (void)response;
+    (void)session;
+}
+
+BOOST_AUTO_TEST_CASE(test_http_router_exact)
+{
+    HttpRouter router;
+    router.Add("/ping", FirstHandler, false);
+    router.Add("/auth", SecondHandler);
+
+    const HttpRoute* route = router.Find("/ping");
+    BOOST_REQUIRE_MESSAGE(route != nullptr, "Find exact route");
+    BOOST_CHECK_MESSAGE(route->callback == FirstHandler, "Invalid handler");
+    BOOST_CHECK_MESSAGE(!route->authenticate, "Invalid authentication");
+
+    route = router.Find("/auth");
+    BOOST_REQUIRE_MESSAGE(route != nullptr, "Find exact route");
+    BOOST_CHECK_MESSAGE(route->authenticate, "Invalid authentication");
+
+    BOOST_CHECK_MESSAGE(router.Find("/pin") == nullptr, "Exact route matches prefix");
+    BOOST_CHECK_MESSAGE(router.Find("/ping/") == nullptr, "Exact route matches longer path");
+
+    // Replace handler
+    router.Add("/ping", SecondHandler);
+    route = router.Find("/ping");
+    BOOST_CHECK_MESSAGE(route->callback == SecondHandler && route->authenticate, "Replace handler");
+}
+
+BOOST_AUTO_TEST_CASE(test_http_router_prefix)
+{
+    HttpRouter router;
+    router.AddPrefix("/api/", FirstHandler);
+    router.AddPrefix("/api/home/", SecondHandler);
+    router.Add("/api/help", SecondHandler, false);
+
+    const HttpRoute* route = router.Find("/api/get-users");
+    BOOST_REQUIRE_MESSAGE(route != nullptr, "Find prefix route");
+    BOOST_CHECK_MESSAGE(route->callback == FirstHandler, "Invalid handler");
+
+    route = router.Find("/api/home/get-home");
+    BOOST_REQUIRE_MESSAGE(route != nullptr, "Find prefix route");
+    BOOST_CHECK_MESSAGE(route->path == "/api/home/", "Longest prefix is not preferred");
+
+    route = router.Find("/api/help");
+    BOOST_REQUIRE_MESSAGE(route != nullptr, "Find exact route");
+    BOOST_CHECK_MESSAGE(!route->authenticate, "Exact route is not preferred");
+
+    BOOST_CHECK_MESSAGE(router.Find("/api") == nullptr, "Prefix route matches shorter path");
+}
@@ -0,0 +1 @@
+#include "../common.hpp"
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "TestHttpSession.hpp"
+#include <api/http_session.hpp>
+
+using namespace server::api;
+
+static void TargetHandler(const Ref<User>& user, const http_request_t& request, http_response_t& response,
+                          const Ref<HttpSession>& session)
+{
+    (void)user;
+    (void)session;
+
+    response.set(boost::beast::http::field::content_type, "text/plain");
+    response.body() = std::string(request.target());
+}
+
+BOOST_AUTO_TEST_CASE(test_http_session_pipelining)
+{
+    LOG_INFO("Test http session pipelining");
+
+    HttpSession::GetRouter().AddPrefix("/test/", TargetHandler, false);
+
+    boost::asio::io_context context;
+    boost::asio::ip::tcp::acceptor acceptor = boost::asio::ip::tcp::acceptor(
+        context, boost::asio::ip::tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+
+    boost::asio::io_context clientContext;
+    boost::asio::ip::tcp::socket client = boost::asio::ip::tcp::socket(clientContext);
+    client.connect(acceptor.local_endpoint());
+
+    Ref<tcp_socket_t> socket = boost::make_shared<tcp_socket_t>(acceptor.accept());
+    boost::make_shared<HttpSession>(socket)->Run();
+    boost::thread thread = boost::thread([&context]() -> void { context.run(); });
+
+    // Send more requests at once than the session can answer before it stops reading
+    size_t requestCount = HTTP_SESSION_PIPELINE_SIZE * 2 + 2;
+    std::string requests;
+    for (size_t i = 0; i < requestCount; i++)
+    {
+        requests += "GET /test/" + std::to_string(i) + " HTTP/1.1\r\nHost: localhost\r\n";
+        if (i == requestCount - 1)
+            requests += "Connection: close\r\n";
+        requests += "\r\n";
+    }
+    boost::asio::write(client, boost::asio::buffer(requests));
+
+    // Responses are written in request order
+    boost::beast::flat_buffer buffer;
+    boost::system::error_code ec;
+    size_t responseCount = 0;
+    for (; responseCount < requestCount; responseCount++)
+    {
+        http_response_t response;
+        boost::beast::http::read(client, buffer, response, ec);
+        if (ec)
+            break;
+
+        BOOST_CHECK_MESSAGE(response.body() == "/test/" + std::to_string(responseCount),
+                            "Invalid response order " << response.body());
+    }
+    BOOST_CHECK_MESSAGE(responseCount == requestCount, "Receive every response");
+
+    // The connection is closed after the last response
+    http_response_t response;
+    boost::beast::http::read(client, buffer, response, ec);
+    BOOST_CHECK_MESSAGE(ec == boost::beast::http::error::end_of_stream, "Keep closed connection");
+
+    thread.join();
+}
@@ -0,0 +1,141 @@
+#include "TestModbusGateway.hpp"
+#include <benchmarks/modbus_simulator/simulator.hpp>
+#include <scripting_native_helper/modbus/modbus_gateway.hpp>
+
+using namespace server::benchmark;
+using namespace server::scripting::native::modbus;
+
+// Port of the local modbus simulator
+#define TEST_MODBUS_PORT 15502
+
+// Register count of the simulated slave (higher addresses answer with illegal address)
+#define TEST_MODBUS_ADDRESS_COUNT 1000
+
+struct TestRead
+{
+    uint16_t address;
+    uint16_t count;
+
+    ModbusError error = ModbusError::kNoModbusError;
+
+    /// @brief Every register was read and holds its address
+    ///
+    bool valid = false;
+};
+
+/// @brief Local simulator with a gateway using one connection
+///
+class TestGateway
+{
+  public:
+    boost::asio::io_context context;
+    Ref<ModbusSimulator> simulator;
+    Ref<ModbusGateway> gateway;
+
+    TestGateway()
+    {
+        ModbusSimulatorConfig config;
+        config.port = TEST_MODBUS_PORT;
+        config.addressCount = TEST_MODBUS_ADDRESS_COUNT;
+
+        simulator = ModbusSimulator::Create(context, config);
+        gateway = ModbusGateway::Create(context, "127.0.0.1", TEST_MODBUS_PORT, 1);
+    }
+
+    /// @brief Issue reads during one tick and wait for every response (bypasses the cache)
+    ///
+    /// @param readList Reads
+    void Read(boost::container::vector<TestRead>& readList)
+    {
+        size_t pendingCount = readList.size();
+        for (TestRead& read : readList)
+        {
+            gateway->ReadHoldingRegisters(
+                1, read.address, read.count,
+                [this, &read, &pendingCount](ModbusError error, const uint16_t* values, size_t count) -> void
+                {
+                    read.error = error;
+                    read.valid = error == ModbusError::kNoModbusError && count == read.count;
+                    for (size_t i = 0; read.valid && i < count; i++)
+                        read.valid = values[i] == read.address + i;
+
+                    // Stop once every read completed
+                    if (--pendingCount == 0)
+                    {
+                        boost::asio::post(context,
+                                          [this]() -> void
+                                          {
+                                              gateway->Close();
+                                              simulator->Close();
+                                          });
+                    }
+                },
+                0);
+        }
+
+        context.run();
+        context.restart();
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_modbus_gateway_merge)
+{
+    LOG_INFO("Test modbus gateway merge");
+
+    TestGateway test;
+    BOOST_REQUIRE_MESSAGE(test.simulator != nullptr, "Create modbus simulator");
+
+    boost::container::vector<TestRead> readList = {
+        TestRead{0, 10},   // Adjacent
+        TestRead{10, 10},  //
+        TestRead{100, 20}, // Overlapping
+        TestRead{110, 20}, //
+        TestRead{105, 5},  // Contained
+    };
+    test.Read(readList);
+
+    for (const TestRead& read : readList)
+        BOOST_CHECK_MESSAGE(read.valid, "Invalid registers at " << read.address);
+    BOOST_CHECK_MESSAGE(test.simulator->GetRequestCount() == 2, "Merge adjacent and overlapping reads");
+}
+
+BOOST_AUTO_TEST_CASE(test_modbus_gateway_read_limit)
+{
+    LOG_INFO("Test modbus gateway read limit");
+
+    TestGateway test;
+    BOOST_REQUIRE_MESSAGE(test.simulator != nullptr, "Create modbus simulator");
+
+    boost::container::vector<TestRead> readList = {
+        TestRead{0, 100},   // Exactly one full request
+        TestRead{100, 25},  //
+        TestRead{200, 100}, // One register more than a request may read
+        TestRead{300, 26},  //
+        TestRead{500, MODBUS_MAX_READ_REGISTERS + 1},
+    };
+    test.Read(readList);
+
+    for (size_t i = 0; i < 4; i++)
+        BOOST_CHECK_MESSAGE(readList[i].valid, "Invalid registers at " << readList[i].address);
+    BOOST_CHECK_MESSAGE(readList[4].error == ModbusError::kInvalidRequestModbusError, "Oversized read is sent");
+    BOOST_CHECK_MESSAGE(test.simulator->GetRequestCount() == 3, "Merged range exceeds the pdu limit");
+}
+
+BOOST_AUTO_TEST_CASE(test_modbus_gateway_illegal_address)
+{
+    LOG_INFO("Test modbus gateway illegal address");
+
+    TestGateway test;
+    BOOST_REQUIRE_MESSAGE(test.simulator != nullptr, "Create modbus simulator");
+
+    // The merged range reaches past the last register of the slave
+    boost::container::vector<TestRead> readList = {
+        TestRead{TEST_MODBUS_ADDRESS_COUNT - 10, 5},
+        TestRead{TEST_MODBUS_ADDRESS_COUNT - 5, 10},
+    };
+    test.Read(readList);
+
+    BOOST_CHECK_MESSAGE(readList[0].valid, "Valid read fails with the merged range");
+    BOOST_CHECK_MESSAGE(readList[1].error == ModbusError::kIllegalAddressModbusError, "Invalid read succeeds");
+    BOOST_CHECK_MESSAGE(test.simulator->GetRequestCount() == 3, "Merged range is not read separately");
+}
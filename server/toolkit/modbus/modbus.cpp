@@ -425,7 +425,7 @@ ssize_t Modbus::ReceiveResponse(uint8_t* msg, uint16_t transactionID)
         timeout.tv_sec = 2;
         timeout.tv_usec = 0;
 
-        if (select(sock + 1, &set, nullptr, nullptr, &timeout) < 0)
+        if (select(sock + 1, &set, nullptr, nullptr, &timeout) <= 0)
             return -1;
 
         ssize_t r = recv(sock, (char*)msg + receivedBytes, static_cast<int>(leftBytes), 0);
@@ -5,7 +5,10 @@ includes("api")
 includes("scripting")
 includes("scripting_javascript")
 includes("scripting_native")
+includes("scripting_native_helper/http")
+includes("scripting_native_helper/modbus")
 includes("main")
 includes("server")
 
-includes("scripts")
\ No newline at end of file
+includes("scripts")
+includes("benchmarks")
\ No newline at end of file
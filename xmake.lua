@@ -66,6 +66,7 @@ add_requires("conan::boost/1.82.0", {
 })
 add_requires("rapidjson", { alias = "rapidjson" })
 add_requires("conan::sqlite3/3.42.0", { alias = "sqlite3" })
+add_requires("conan::zlib/1.2.13", { alias = "zlib" })
 add_requires("conan::robin-hood-hashing/3.11.5", { alias = "robin-hood-hashing" })
 add_requires("conan::xxhash/0.8.1", { alias = "xxhash" })
 add_requires("conan::cppcodec/0.2", { alias = "cppcodec" })